@@ -7,4 +7,5 @@ SUBDIRS += hellowindow \
            hellomultisample \
            hellogpumipmap \
            hellocompressedtexture \
-           hellodevicereset
+           hellodevicereset \
+           hellosprites
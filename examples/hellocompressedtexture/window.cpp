@@ -41,7 +41,7 @@
 #include "window.h"
 #include "shader_vs.h"
 #include "shader_ps.h"
-#include <QFile>
+#include <QD3D12DdsTexture>
 
 Window::Window()
     : f(Q_NULLPTR),
@@ -58,107 +58,12 @@ Window::~Window()
     delete f;
 }
 
-static const quint32 DDS_MAGIC = 0x20534444; // 'DDS '
-static const quint32 DDS_FOURCC = 4;
-
-#define FOURCC(c0, c1, c2, c3) ((c0) | ((c1) << 8) | ((c2) << 16) | ((c3 << 24)))
-
-struct DDS_PIXELFORMAT {
-    quint32 size;
-    quint32 flags;
-    quint32 fourCC;
-    quint32 rgbBitCount;
-    quint32 rBitMask;
-    quint32 gBitMask;
-    quint32 bBitMask;
-    quint32 aBitMask;
-};
-
-struct DDS_HEADER {
-    quint32 size;
-    quint32 flags;
-    quint32 height;
-    quint32 width;
-    quint32 pitch;
-    quint32 depth;
-    quint32 mipMapCount;
-    quint32 reserved1[11];
-    DDS_PIXELFORMAT pixelFormat;
-    quint32 caps;
-    quint32 caps2;
-    quint32 caps3;
-    quint32 caps4;
-    quint32 reserved2;
-};
-
-static quint32 unalignedDxt1Size(const QSize &size, quint32 *bpl = Q_NULLPTR, quint32 *vertBlocks = Q_NULLPTR)
-{
-    static const quint32 blockSize = 8; // 8 bytes for BC1
-    const quint32 bytesPerLine = qMax<quint32>(1, (size.width() + 3) / 4) * blockSize;
-    const quint32 ySize = qMax<quint32>(1, (size.height() + 3) / 4);
-    if (bpl)
-        *bpl = bytesPerLine;
-    if (vertBlocks)
-        *vertBlocks = ySize;
-    return bytesPerLine * ySize;
-}
-
-// We only support DXT1 (BC1) for the demo's purposes.
-static QByteArrayList loadDXT1(const QString &filename, DXGI_FORMAT *format, QSize *size, int *mipLevelCount)
-{
-    QFile f(filename);
-    if (!f.open(QIODevice::ReadOnly)) {
-        qWarning("Failed to open %s", qPrintable(filename));
-        return QByteArrayList();
-    }
-
-    quint32 magic = 0;
-    f.read(reinterpret_cast<char *>(&magic), sizeof(magic));
-    if (magic != DDS_MAGIC) {
-        qWarning("%s is not a DDS file", qPrintable(filename));
-        return QByteArrayList();
-    }
-    DDS_HEADER header;
-    f.read(reinterpret_cast<char *>(&header), sizeof(header));
-    if (header.size != sizeof(DDS_HEADER)) {
-        qWarning("Invalid DDS header size");
-        return QByteArrayList();
-    }
-    if (header.pixelFormat.size != sizeof(DDS_PIXELFORMAT)) {
-        qWarning("Invalid DDS pixel format size");
-        return QByteArrayList();
-    }
-    if (!(header.pixelFormat.flags & DDS_FOURCC)) {
-        qWarning("Invalid DDS pixel format");
-        return QByteArrayList();
-    }
-    if (header.pixelFormat.fourCC != FOURCC('D', 'X', 'T', '1')) {
-        qWarning("Only DXT1 (BC1) is supported");
-        return QByteArrayList();
-    }
-
-    QByteArrayList data;
-    QSize sz(header.width, header.height);
-    for (quint32 level = 0; level < header.mipMapCount; ++level) {
-        data.append(f.read(unalignedDxt1Size(sz)));
-        sz.setWidth(qMax(1, sz.width() / 2));
-        sz.setHeight(qMax(1, sz.height() / 2));
-    }
-
-    *format = DXGI_FORMAT_BC1_UNORM;
-    *size = QSize(header.width, header.height);
-    *mipLevelCount = header.mipMapCount;
-
-    return data;
-}
-
 void Window::initializeD3D()
 {
-    DXGI_FORMAT textureFormat;
-    QSize textureSize;
-    int mipLevels;
-    QByteArrayList texData = loadDXT1(QStringLiteral(":/qt.dds"), &textureFormat, &textureSize, &mipLevels);
-    if (texData.isEmpty())
+    // The DDS file is memory mapped, the data is only copied once, straight
+    // into the upload buffer.
+    QD3D12DdsTexture dds;
+    if (!dds.load(QStringLiteral(":/qt.dds")))
         return;
 
     f = createFence();
@@ -335,15 +240,7 @@ void Window::initializeD3D()
     cbPtr = p; // won't Unmap() this here
 
     // Texture (with mipmaps, if the DDS file provided them)
-    D3D12_RESOURCE_DESC textureDesc = {};
-    textureDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
-    textureDesc.Width = textureSize.width();
-    textureDesc.Height = textureSize.height();
-    textureDesc.DepthOrArraySize = 1;
-    textureDesc.MipLevels = mipLevels;
-    textureDesc.Format = textureFormat;
-    textureDesc.SampleDesc.Count = 1;
-    textureDesc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
+    const D3D12_RESOURCE_DESC textureDesc = dds.resourceDesc();
 
     // Ignore UMA for now and do the discrete-friendly upload via an upload buffer (no CPU access to the texture).
     if (FAILED(dev->CreateCommittedResource(&defaultHeapProp, D3D12_HEAP_FLAG_NONE, &textureDesc,
@@ -352,29 +249,11 @@ void Window::initializeD3D()
         return;
     }
 
+    // GetCopyableFootprints gives the properly aligned offset and pitch for each mip level.
+    quint64 uploadSize = 0;
+    const QVector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> textureLayout = dds.footprints(dev, &uploadSize);
     ComPtr<ID3D12Resource> textureUploadBuffer;
-    const int MAX_MIP_LEVELS = 16;
-    Q_ASSERT(mipLevels <= MAX_MIP_LEVELS);
-    D3D12_PLACED_SUBRESOURCE_FOOTPRINT textureLayout[MAX_MIP_LEVELS];
-    quint32 unalignedPitch[MAX_MIP_LEVELS], pitch[MAX_MIP_LEVELS], vertBlocks[MAX_MIP_LEVELS];
-    int mipOffset = 0;
-    QSize mipSize = textureSize;
-    // Fill out the offset and footprint info ourselves as GetCopyableFootprints does not seem to work with compressed formats.
-    // Offset and pitch must be aligned as required.
-    for (int level = 0; level < mipLevels; ++level) {
-        unalignedDxt1Size(mipSize, &unalignedPitch[level], &vertBlocks[level]);
-        pitch[level] = alignedTexturePitch(unalignedPitch[level]);
-        textureLayout[level].Offset = mipOffset;
-        textureLayout[level].Footprint.Format = DXGI_FORMAT_BC1_UNORM;
-        textureLayout[level].Footprint.Width = mipSize.width();
-        textureLayout[level].Footprint.Height = mipSize.height();
-        textureLayout[level].Footprint.Depth = 1;
-        textureLayout[level].Footprint.RowPitch = pitch[level];
-        mipOffset += alignedTextureOffset(pitch[level] * vertBlocks[level]);
-        mipSize.setWidth(qMax(1, mipSize.width() / 2));
-        mipSize.setHeight(qMax(1, mipSize.height() / 2));
-    }
-    bufDesc.Width = mipOffset;
+    bufDesc.Width = uploadSize;
     if (FAILED(dev->CreateCommittedResource(&uploadHeapProp, D3D12_HEAP_FLAG_NONE, &bufDesc,
                                             D3D12_RESOURCE_STATE_GENERIC_READ, Q_NULLPTR, IID_PPV_ARGS(&textureUploadBuffer)))) {
         qWarning("Failed to create texture upload buffer resource");
@@ -385,27 +264,18 @@ void Window::initializeD3D()
         qWarning("Map failed (texture upload buffer)");
         return;
     }
-    // Have to copy line-by-line to account for the potentially bigger row pitch in the upload buffer.
-    for (int level = 0; level < mipLevels; ++level) {
-        quint8 *dst = p + textureLayout[level].Offset;
-        const quint8 *src = (const quint8 *) texData[level].constData();
-        for (quint32 y = 0; y < vertBlocks[level]; ++y) {
-            memcpy(dst, src, unalignedPitch[level]);
-            src += unalignedPitch[level];
-            dst += pitch[level];
-        }
-    }
+    dds.writeSubresources(p, textureLayout);
     textureUploadBuffer->Unmap(0, Q_NULLPTR);
 
-    for (int level = 0; level < mipLevels; ++level) {
+    for (int i = 0; i < textureLayout.count(); ++i) {
         D3D12_TEXTURE_COPY_LOCATION dstLoc;
         dstLoc.pResource = texture.Get();
         dstLoc.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
-        dstLoc.SubresourceIndex = level;
+        dstLoc.SubresourceIndex = i;
         D3D12_TEXTURE_COPY_LOCATION srcLoc;
         srcLoc.pResource = textureUploadBuffer.Get();
         srcLoc.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
-        srcLoc.PlacedFootprint = textureLayout[level];
+        srcLoc.PlacedFootprint = textureLayout[i];
         commandList->CopyTextureRegion(&dstLoc, 0, 0, 0, &srcLoc, Q_NULLPTR);
     }
 
@@ -430,11 +300,7 @@ void Window::initializeD3D()
     dev->CreateConstantBufferView(&cbvDesc, cbvSrvHandle);
     cbvSrvHandle.ptr += cbvSrvStride;
 
-    D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
-    srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-    srvDesc.Format = textureDesc.Format;
-    srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
-    srvDesc.Texture2D.MipLevels = mipLevels;
+    const D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = dds.shaderResourceViewDesc();
     dev->CreateShaderResourceView(texture.Get(), &srvDesc, cbvSrvHandle);
 
     // Execute the texture upload.
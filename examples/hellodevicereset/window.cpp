@@ -41,6 +41,16 @@
 #include "window.h"
 #include "tdr.h"
 
+Window::Window()
+    : staticResources(new QD3D12StaticResources(this)),
+      computeRootSignatureId(-1),
+      computePipelineId(-1),
+      green(0)
+{
+    // Keep the compiled pipelines across runs, not just across resets.
+    staticResources->setPipelineCacheFileName(QStringLiteral("hellodevicereset.psocache"));
+}
+
 void Window::initializeD3D()
 {
     f.reset(createFence());
@@ -53,49 +63,42 @@ void Window::initializeD3D()
     }
     commandList->Close();
 
-    D3D12_DESCRIPTOR_RANGE descRange[2];
-    descRange[0].RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_CBV;
-    descRange[0].NumDescriptors = 1;
-    descRange[0].BaseShaderRegister = 0;
-    descRange[0].RegisterSpace = 0;
-    descRange[0].OffsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND;
-    descRange[1].RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_UAV;
-    descRange[1].NumDescriptors = 1;
-    descRange[1].BaseShaderRegister = 0;
-    descRange[1].RegisterSpace = 0;
-    descRange[1].OffsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND;
-
-    D3D12_ROOT_PARAMETER param;
-    param.ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
-    param.ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
-    param.DescriptorTable.NumDescriptorRanges = 2;
-    param.DescriptorTable.pDescriptorRanges = descRange;
-
-    D3D12_ROOT_SIGNATURE_DESC desc = {};
-    desc.NumParameters = 1;
-    desc.pParameters = &param;
-
-    ComPtr<ID3DBlob> signature;
-    ComPtr<ID3DBlob> error;
-    if (FAILED(D3D12SerializeRootSignature(&desc, D3D_ROOT_SIGNATURE_VERSION_1, &signature, &error))) {
-        QByteArray msg(static_cast<const char *>(error->GetBufferPointer()), error->GetBufferSize());
-        qWarning("Failed to serialize compute root signature: %s", qPrintable(msg));
-        return;
-    }
-    if (FAILED(dev->CreateRootSignature(0, signature->GetBufferPointer(), signature->GetBufferSize(),
-                                        IID_PPV_ARGS(&computeRootSignature)))) {
-        qWarning("Failed to create compute root signature");
-        return;
-    }
-
-    D3D12_COMPUTE_PIPELINE_STATE_DESC psoDesc = {};
-    psoDesc.pRootSignature = computeRootSignature.Get();
-    psoDesc.CS.pShaderBytecode = g_timeout;
-    psoDesc.CS.BytecodeLength = sizeof(g_timeout);
-
-    if (FAILED(dev->CreateComputePipelineState(&psoDesc, IID_PPV_ARGS(&computeState)))) {
-        qWarning("Failed to create compute pipeline state");
-        return;
+    // After a device reset the root signature and the pipeline have already
+    // been rebuilt from their CPU side copies by the time we get here.
+    if (staticResources->isEmpty()) {
+        D3D12_DESCRIPTOR_RANGE descRange[2];
+        descRange[0].RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_CBV;
+        descRange[0].NumDescriptors = 1;
+        descRange[0].BaseShaderRegister = 0;
+        descRange[0].RegisterSpace = 0;
+        descRange[0].OffsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND;
+        descRange[1].RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_UAV;
+        descRange[1].NumDescriptors = 1;
+        descRange[1].BaseShaderRegister = 0;
+        descRange[1].RegisterSpace = 0;
+        descRange[1].OffsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND;
+
+        D3D12_ROOT_PARAMETER param;
+        param.ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
+        param.ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+        param.DescriptorTable.NumDescriptorRanges = 2;
+        param.DescriptorTable.pDescriptorRanges = descRange;
+
+        D3D12_ROOT_SIGNATURE_DESC desc = {};
+        desc.NumParameters = 1;
+        desc.pParameters = &param;
+
+        computeRootSignatureId = staticResources->addRootSignature(desc);
+
+        D3D12_COMPUTE_PIPELINE_STATE_DESC psoDesc = {};
+        psoDesc.CS.pShaderBytecode = g_timeout;
+        psoDesc.CS.BytecodeLength = sizeof(g_timeout);
+        computePipelineId = staticResources->addComputePipeline(psoDesc, computeRootSignatureId);
+
+        if (!staticResources->create()) {
+            qWarning("Failed to create compute pipeline");
+            return;
+        }
     }
 }
 
@@ -103,8 +106,6 @@ void Window::releaseD3D()
 {
     // Release all resources. initializeD3D() will get invoked later on.
     commandList = Q_NULLPTR;
-    computeState = Q_NULLPTR;
-    computeRootSignature = Q_NULLPTR;
     f.reset();
 }
 
@@ -142,9 +143,9 @@ void Window::afterPresent()
 void Window::timeout()
 {
     commandAllocator()->Reset();
-    commandList->Reset(commandAllocator(), computeState.Get());
+    commandList->Reset(commandAllocator(), staticResources->pipelineState(computePipelineId));
 
-    commandList->SetComputeRootSignature(computeRootSignature.Get());
+    commandList->SetComputeRootSignature(staticResources->rootSignature(computeRootSignatureId));
     commandList->Dispatch(256, 1, 1);
 
     commandList->Close();
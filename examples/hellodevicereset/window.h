@@ -39,13 +39,14 @@
 ****************************************************************************/
 
 #include <QD3D12Window>
+#include <QD3D12StaticResources>
 
 class Window : public QD3D12Window
 {
     Q_OBJECT
 
 public:
-    Window() : green(0) { }
+    Window();
 
     void initializeD3D() Q_DECL_OVERRIDE;
     void releaseD3D() Q_DECL_OVERRIDE;
@@ -61,8 +62,9 @@ private:
 
     QScopedPointer<Fence> f;
     ComPtr<ID3D12GraphicsCommandList> commandList;
-    ComPtr<ID3D12PipelineState> computeState;
-    ComPtr<ID3D12RootSignature> computeRootSignature;
+    QD3D12StaticResources *staticResources;
+    int computeRootSignatureId;
+    int computePipelineId;
 
     float green;
 };
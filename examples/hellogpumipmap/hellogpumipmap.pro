@@ -8,7 +8,6 @@ RESOURCES = hellogpumipmap.qrc
 LIBS = -ld3d12
 
 VSPS = shader.hlsl
-CS = mipmapgen.hlsl
 
 vshader.input = VSPS
 vshader.header = shader_vs.h
@@ -20,10 +19,5 @@ pshader.header = shader_ps.h
 pshader.entry = PS_Texture
 pshader.type = ps_5_0
 
-cshader.input = CS
-cshader.header = shader_cs.h
-cshader.entry = CS_Generate4MipMaps
-cshader.type = cs_5_0
-
-HLSL_SHADERS = vshader pshader cshader
+HLSL_SHADERS = vshader pshader
 load(hlsl)
@@ -41,13 +41,7 @@
 #include "window.h"
 #include "shader_vs.h"
 #include "shader_ps.h"
-#include "shader_cs.h"
-
-// size must be a power of two due to the way mipmap generation is done
-static const int TEXTURE_WIDTH = 512;
-static const int TEXTURE_HEIGHT = 512;
-
-static const int TEXTURE_MIP_LEVELS = 10; // ceil(log2(max(width, height))) + 1
+#include <QD3D12GpuMipmapGenerator>
 
 Window::Window()
     : f(Q_NULLPTR),
@@ -66,11 +60,15 @@ Window::~Window()
 
 void Window::initializeD3D()
 {
-    QImage qtLogo = QImage(QStringLiteral(":/qt.png")).convertToFormat(QImage::Format_RGBA8888).scaled(TEXTURE_WIDTH, TEXTURE_HEIGHT);
+    // Any size will do, the generator handles non-power-of-two levels too.
+    QImage qtLogo = QImage(QStringLiteral(":/qt.png")).convertToFormat(QImage::Format_RGBA8888);
     if (qtLogo.isNull()) {
         qWarning("Failed to load image data");
         return;
     }
+    int mipLevels = 1;
+    for (int s = qMax(qtLogo.width(), qtLogo.height()); s > 1; s >>= 1)
+        ++mipLevels;
 
     f = createFence();
     ID3D12Device *dev = device();
@@ -249,8 +247,8 @@ void Window::initializeD3D()
     // Constant buffer view and shader resource view descriptors are stored in the same heap.
     cbvSrvUavStride = dev->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
     D3D12_DESCRIPTOR_HEAP_DESC cbvSrvUavHeapDesc = {};
-    // CBV + SRV + (TEXTURE_MIP_LEVELS - 1) * UAV
-    cbvSrvUavHeapDesc.NumDescriptors = 1 + 1 + (TEXTURE_MIP_LEVELS - 1);
+    // CBV + SRV
+    cbvSrvUavHeapDesc.NumDescriptors = 1 + 1;
     cbvSrvUavHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
     cbvSrvUavHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
     if (FAILED(dev->CreateDescriptorHeap(&cbvSrvUavHeapDesc, IID_PPV_ARGS(&cbvSrvUavHeap)))) {
@@ -269,10 +267,10 @@ void Window::initializeD3D()
     // Texture (with mipmaps and allowing read/write via UAVs)
     D3D12_RESOURCE_DESC textureDesc = {};
     textureDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
-    textureDesc.Width = TEXTURE_WIDTH;
-    textureDesc.Height = TEXTURE_HEIGHT;
+    textureDesc.Width = qtLogo.width();
+    textureDesc.Height = qtLogo.height();
     textureDesc.DepthOrArraySize = 1;
-    textureDesc.MipLevels = TEXTURE_MIP_LEVELS;
+    textureDesc.MipLevels = mipLevels;
     textureDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
     textureDesc.SampleDesc.Count = 1;
     textureDesc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
@@ -284,24 +282,13 @@ void Window::initializeD3D()
         return;
     }
 
-    // Shader resource view for exposing the texture to the compute and pixel shaders
+    // Shader resource view for exposing the texture to the pixel shader
     D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
     srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
     srvDesc.Format = textureDesc.Format;
     srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
-    srvDesc.Texture2D.MipLevels = TEXTURE_MIP_LEVELS;
+    srvDesc.Texture2D.MipLevels = mipLevels;
     dev->CreateShaderResourceView(texture.Get(), &srvDesc, cbvSrvUavHandle);
-    cbvSrvUavHandle.ptr += cbvSrvUavStride;
-
-    // Mipmap generation will need an UAV for each level that needs to be generated.
-    for (int level = 1; level < TEXTURE_MIP_LEVELS; ++level) {
-        D3D12_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
-        uavDesc.Format = textureDesc.Format;
-        uavDesc.ViewDimension = D3D12_UAV_DIMENSION_TEXTURE2D;
-        uavDesc.Texture2D.MipSlice = level;
-        dev->CreateUnorderedAccessView(texture.Get(), Q_NULLPTR, &uavDesc, cbvSrvUavHandle);
-        cbvSrvUavHandle.ptr += cbvSrvUavStride;
-    }
 
     ComPtr<ID3D12Resource> textureUploadBuffer;
     UINT64 textureUploadBufferSize;
@@ -320,8 +307,8 @@ void Window::initializeD3D()
         return;
     }
     p += textureLayout.Offset;
-    for (int y = 0; y < TEXTURE_HEIGHT; ++y) {
-        memcpy(p, qtLogo.scanLine(y), TEXTURE_WIDTH * 4);
+    for (int y = 0; y < qtLogo.height(); ++y) {
+        memcpy(p, qtLogo.scanLine(y), qtLogo.width() * 4);
         p += textureLayout.Footprint.RowPitch;
     }
     textureUploadBuffer->Unmap(0, Q_NULLPTR);
@@ -336,16 +323,14 @@ void Window::initializeD3D()
     srcLoc.PlacedFootprint = textureLayout;
     commandList->CopyTextureRegion(&dstLoc, 0, 0, 0, &srcLoc, Q_NULLPTR);
 
-    // once the copy is done, the texture is ready to be used in the compute shader...
-    transitionResource(texture.Get(), commandList.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
-    uavBarrier(texture.Get(), commandList.Get());
-
-    initMipMaps();
-    generateMipMaps();
+    transitionResource(texture.Get(), commandList.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 
-    // ...and then in the pixel shader
-    uavBarrier(texture.Get(), commandList.Get());
-    transitionResource(texture.Get(), commandList.Get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+    // Fill the rest of the levels with a compute shader. The generator takes
+    // care of its own transitions and returns the texture in the given state.
+    QD3D12GpuMipmapGenerator mipmapGenerator;
+    if (!mipmapGenerator.create(dev))
+        return;
+    mipmapGenerator.generate(commandList.Get(), texture.Get(), 0, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 
     // Execute the texture upload and mipmap generation.
     commandList->Close();
@@ -358,108 +343,6 @@ void Window::initializeD3D()
     setupProjection();
 }
 
-void Window::initMipMaps()
-{
-    ID3D12Device *dev = device();
-
-    D3D12_STATIC_SAMPLER_DESC sampler = {};
-    sampler.Filter = D3D12_FILTER_MIN_MAG_MIP_LINEAR;
-    sampler.AddressU = D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
-    sampler.AddressV = D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
-    sampler.AddressW = D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
-    sampler.MinLOD = 0.0f;
-    sampler.MaxLOD = D3D12_FLOAT32_MAX;
-
-    D3D12_DESCRIPTOR_RANGE descRange[2];
-    descRange[0].RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_SRV;
-    descRange[0].NumDescriptors = 1;
-    descRange[0].BaseShaderRegister = 0; // t0
-    descRange[0].RegisterSpace = 0;
-    descRange[0].OffsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND;
-    descRange[1].RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_UAV;
-    descRange[1].NumDescriptors = 4;
-    descRange[1].BaseShaderRegister = 0; // u0..u3
-    descRange[1].RegisterSpace = 0;
-    descRange[1].OffsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND;
-
-    // Split into two to allow switching between the first and second set of UAVs later.
-    D3D12_ROOT_PARAMETER rootParameters[3];
-    rootParameters[0].ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
-    rootParameters[0].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
-    rootParameters[0].DescriptorTable.NumDescriptorRanges = 1;
-    rootParameters[0].DescriptorTable.pDescriptorRanges = &descRange[0];
-
-    rootParameters[1].ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
-    rootParameters[1].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
-    rootParameters[1].DescriptorTable.NumDescriptorRanges = 1;
-    rootParameters[1].DescriptorTable.pDescriptorRanges = &descRange[1];
-
-    rootParameters[2].ParameterType = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;
-    rootParameters[2].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
-    rootParameters[2].Constants.Num32BitValues = 4; // uint2 mip1Size, uint sampleLevel, uint totalMips
-    rootParameters[2].Constants.ShaderRegister = 0; // b0
-    rootParameters[2].Constants.RegisterSpace = 0;
-
-    D3D12_ROOT_SIGNATURE_DESC desc = {};
-    desc.NumParameters = 3;
-    desc.pParameters = rootParameters;
-    desc.NumStaticSamplers = 1;
-    desc.pStaticSamplers = &sampler;
-
-    ComPtr<ID3DBlob> signature;
-    ComPtr<ID3DBlob> error;
-    if (FAILED(D3D12SerializeRootSignature(&desc, D3D_ROOT_SIGNATURE_VERSION_1, &signature, &error))) {
-        QByteArray msg(static_cast<const char *>(error->GetBufferPointer()), error->GetBufferSize());
-        qWarning("Failed to serialize compute root signature: %s", qPrintable(msg));
-        return;
-    }
-    if (FAILED(dev->CreateRootSignature(0, signature->GetBufferPointer(), signature->GetBufferSize(),
-                                        IID_PPV_ARGS(&computeRootSignature)))) {
-        qWarning("Failed to create compute root signature");
-        return;
-    }
-
-    D3D12_COMPUTE_PIPELINE_STATE_DESC psoDesc = {};
-    psoDesc.pRootSignature = computeRootSignature.Get();
-    psoDesc.CS.pShaderBytecode = g_CS_Generate4MipMaps;
-    psoDesc.CS.BytecodeLength = sizeof(g_CS_Generate4MipMaps);
-
-    if (FAILED(dev->CreateComputePipelineState(&psoDesc, IID_PPV_ARGS(&computeState)))) {
-        qWarning("Failed to create compute pipeline state");
-        return;
-    }
-}
-
-void Window::generateMipMaps()
-{
-    commandList->SetPipelineState(computeState.Get());
-    commandList->SetComputeRootSignature(computeRootSignature.Get());
-
-    ID3D12DescriptorHeap *heaps[] = { cbvSrvUavHeap.Get() };
-    commandList->SetDescriptorHeaps(_countof(heaps), heaps);
-
-    D3D12_GPU_DESCRIPTOR_HANDLE h = cbvSrvUavHeap->GetGPUDescriptorHandleForHeapStart(); // CBV, not needed here
-    h.ptr += cbvSrvUavStride; // SRV
-    commandList->SetComputeRootDescriptorTable(0, h);
-
-    h.ptr += cbvSrvUavStride; // now points to the first of (TEXTURE_MIP_LEVELS - 1) UAV descriptors
-
-    for (quint32 level = 1; level < TEXTURE_MIP_LEVELS; level += 4, h.ptr += cbvSrvUavStride * 4) {
-        commandList->SetComputeRootDescriptorTable(1, h);
-
-        QSize sz(TEXTURE_WIDTH, TEXTURE_HEIGHT);
-        sz.setWidth(qMax(1, sz.width() >> level));
-        sz.setHeight(qMax(1, sz.height() >> level));
-
-        const quint32 constants[4] = { quint32(sz.width()), quint32(sz.height()),
-                                       level - 1,
-                                       TEXTURE_MIP_LEVELS - 1 };
-        commandList->SetComputeRoot32BitConstants(2, 4, constants, 0);
-
-        commandList->Dispatch(sz.width(), sz.height(), 1);
-    }
-}
-
 void Window::resizeD3D(const QSize &)
 {
     setupProjection();
@@ -54,8 +54,6 @@ public:
 
 private:
     void setupProjection();
-    void initMipMaps();
-    void generateMipMaps();
 
     Fence *f;
     ComPtr<ID3D12GraphicsCommandList> commandList;
@@ -68,9 +66,6 @@ private:
     UINT cbvSrvUavStride;
     D3D12_VERTEX_BUFFER_VIEW vertexBufferView;
 
-    ComPtr<ID3D12PipelineState> computeState;
-    ComPtr<ID3D12RootSignature> computeRootSignature;
-
     QMatrix4x4 projection;
     QMatrix4x4 modelview;
     quint8 *cbPtr;
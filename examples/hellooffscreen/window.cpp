@@ -56,6 +56,14 @@ Window::Window()
     : f(Q_NULLPTR)
 {
     setExtraRenderTargetCount(1);
+
+    // Report the GPU time spent in the two passes every now and then.
+    setGpuProfilingEnabled(true);
+    connect(gpuProfiler(), &QD3D12GpuProfiler::timingsReady, [this]() {
+        if (gpuProfiler()->timingsFrame() % 300 == 0)
+            qDebug("GPU time: offscreen pass %.3f ms, onscreen pass %.3f ms",
+                   gpuProfiler()->milliseconds("offscreen"), gpuProfiler()->milliseconds("onscreen"));
+    });
 }
 
 Window::~Window()
@@ -469,6 +477,8 @@ void Window::paintD3D()
 
 void Window::paintOffscreen()
 {
+    QD3D12GpuScope scope(gpuProfiler(), commandList.Get(), "offscreen");
+
     QMatrix4x4 modelview;
     modelview.translate(0, 0, -2);
     modelview.rotate(offscreen.rotationAngle, 0, 0, 1);
@@ -493,6 +503,8 @@ void Window::paintOffscreen()
 
 void Window::paintOnscreen()
 {
+    QD3D12GpuScope scope(gpuProfiler(), commandList.Get(), "onscreen");
+
     QMatrix4x4 modelview;
     modelview.translate(0, 0, -2);
     modelview.rotate(onscreen.rotationAngle, 1, 0.5, 0);
@@ -39,6 +39,7 @@
 ****************************************************************************/
 
 #include <QD3D12Window>
+#include <QD3D12GpuProfiler>
 #include <QMatrix4x4>
 
 class Window : public QD3D12Window
@@ -0,0 +1,8 @@
+TEMPLATE = app
+QT += d3d12window
+
+SOURCES = main.cpp window.cpp
+HEADERS = window.h
+RESOURCES = hellosprites.qrc
+
+LIBS = -ld3d12
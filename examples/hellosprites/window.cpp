@@ -0,0 +1,144 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the examples of the QtD3D12Window module
+**
+** $QT_BEGIN_LICENSE:BSD$
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**   * Neither the name of The Qt Company Ltd nor the names of its
+**     contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "window.h"
+
+static const int SPRITE_COUNT = 200000;
+static const float SPRITE_SIZE = 16.0f;
+
+Window::Window()
+    : f(Q_NULLPTR),
+      spriteTexture(-1)
+{
+    // 32 bytes per sprite and frame.
+    setStreamingBufferSize(SPRITE_COUNT * 32 + 1024 * 1024);
+
+    // Solid rectangles are drawn until the texture is ready, then every
+    // other sprite switches over to it. Both kinds still end up in the same
+    // draw call.
+    textureLoader = new QD3D12TextureLoader(this);
+    textureId = textureLoader->load(QStringLiteral(":/qt.png"), 0);
+    QObject::connect(textureLoader, &QD3D12TextureLoader::textureReady, [this](int id) {
+        if (id == textureId && batcher.isCreated())
+            spriteTexture = batcher.addTexture(textureLoader->texture(id),
+                                               textureLoader->shaderResourceViewDesc(id).Format);
+    });
+
+    sprites.resize(SPRITE_COUNT);
+    for (int i = 0; i < SPRITE_COUNT; ++i) {
+        Sprite &s(sprites[i]);
+        s.pos = QVector2D(qrand() % 1024, qrand() % 768);
+        s.velocity = QVector2D((qrand() % 200 - 100) / 50.0f, (qrand() % 200 - 100) / 50.0f);
+        s.color = QColor::fromHsv(i % 360, 200, 255, 200);
+    }
+}
+
+Window::~Window()
+{
+    delete f;
+}
+
+void Window::initializeD3D()
+{
+    f = createFence();
+
+    if (FAILED(device()->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, commandAllocator(), Q_NULLPTR, IID_PPV_ARGS(&commandList)))) {
+        qWarning("Failed to create command list");
+        return;
+    }
+    commandList->Close();
+
+    batcher.create(this);
+    spriteTexture = -1;
+    if (textureLoader->isReady(textureId))
+        spriteTexture = batcher.addTexture(textureLoader->texture(textureId),
+                                           textureLoader->shaderResourceViewDesc(textureId).Format);
+}
+
+void Window::paintD3D()
+{
+    commandAllocator()->Reset();
+    commandList->Reset(commandAllocator(), Q_NULLPTR);
+
+    D3D12_VIEWPORT viewport = { 0, 0, float(width()), float(height()), 0, 1 };
+    commandList->RSSetViewports(1, &viewport);
+    D3D12_RECT scissorRect = { 0, 0, width() - 1, height() - 1 };
+    commandList->RSSetScissorRects(1, &scissorRect);
+
+    transitionResource(backBufferRenderTarget(), commandList.Get(), D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET);
+
+    D3D12_CPU_DESCRIPTOR_HANDLE rtvHandle = backBufferRenderTargetCPUHandle();
+    D3D12_CPU_DESCRIPTOR_HANDLE dsvHandle = depthStencilCPUHandle();
+    commandList->OMSetRenderTargets(1, &rtvHandle, FALSE, &dsvHandle);
+
+    const float clearColor[] = { 0.0f, 0.2f, 0.4f, 1.0f };
+    commandList->ClearRenderTargetView(rtvHandle, clearColor, 0, Q_NULLPTR);
+
+    const float w = width() - SPRITE_SIZE;
+    const float h = height() - SPRITE_SIZE;
+    batcher.begin(size());
+    for (int i = 0; i < sprites.count(); ++i) {
+        Sprite &s(sprites[i]);
+        s.pos += s.velocity;
+        if (s.pos.x() < 0 || s.pos.x() > w)
+            s.velocity.setX(-s.velocity.x());
+        if (s.pos.y() < 0 || s.pos.y() > h)
+            s.velocity.setY(-s.velocity.y());
+        const QRectF r(s.pos.x(), s.pos.y(), SPRITE_SIZE, SPRITE_SIZE);
+        if (spriteTexture >= 0 && (i & 1))
+            batcher.draw(r, spriteTexture, QRectF(0, 0, 1, 1), Qt::white);
+        else
+            batcher.fillRect(r, s.color);
+    }
+    batcher.end(commandList.Get());
+
+    transitionResource(backBufferRenderTarget(), commandList.Get(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT);
+    commandList->Close();
+
+    ID3D12CommandList *commandLists[] = { commandList.Get() };
+    commandQueue()->ExecuteCommandLists(_countof(commandLists), commandLists);
+
+    update();
+}
+
+void Window::afterPresent()
+{
+    waitForGPU(f);
+}
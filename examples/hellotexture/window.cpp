@@ -42,15 +42,20 @@
 #include "shader_vs.h"
 #include "shader_ps.h"
 
-static const int TEXTURE_WIDTH = 512;
-static const int TEXTURE_HEIGHT = 512;
-static const int TEXTURE_MIP_LEVELS = 8;
-
 Window::Window()
     : f(Q_NULLPTR),
       cbPtr(Q_NULLPTR),
       rotationAngle(0)
 {
+    // Decoding, mipmap generation and the upload all happen in the
+    // background. Until the texture is ready a transparent placeholder is
+    // shown, then the shader resource view is switched over.
+    textureLoader = new QD3D12TextureLoader(this);
+    textureId = textureLoader->load(QStringLiteral(":/qt.png"), 0);
+    QObject::connect(textureLoader, &QD3D12TextureLoader::textureReady, [this](int id) {
+        if (id == textureId)
+            updateTextureView();
+    });
 }
 
 Window::~Window()
@@ -63,12 +68,6 @@ Window::~Window()
 
 void Window::initializeD3D()
 {
-    QImage qtLogo = QImage(QStringLiteral(":/qt.png")).convertToFormat(QImage::Format_RGBA8888).scaled(TEXTURE_WIDTH, TEXTURE_HEIGHT);
-    if (qtLogo.isNull()) {
-        qWarning("Failed to load image data");
-        return;
-    }
-
     f = createFence();
     ID3D12Device *dev = device();
 
@@ -242,71 +241,7 @@ void Window::initializeD3D()
     }
     cbPtr = p; // won't Unmap() this here
 
-    // Texture (with mipmaps, to make it more exciting)
-    D3D12_RESOURCE_DESC textureDesc = {};
-    textureDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
-    textureDesc.Width = TEXTURE_WIDTH;
-    textureDesc.Height = TEXTURE_HEIGHT;
-    textureDesc.DepthOrArraySize = 1;
-    textureDesc.MipLevels = TEXTURE_MIP_LEVELS;
-    textureDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-    textureDesc.SampleDesc.Count = 1;
-    textureDesc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
-
-    // Ignore UMA for now and do the discrete-friendly upload via an upload buffer (no CPU access to the texture).
-    if (FAILED(dev->CreateCommittedResource(&defaultHeapProp, D3D12_HEAP_FLAG_NONE, &textureDesc,
-                                            D3D12_RESOURCE_STATE_COPY_DEST, Q_NULLPTR, IID_PPV_ARGS(&texture)))) {
-        qWarning("Failed to create texture resource");
-        return;
-    }
-
-    ComPtr<ID3D12Resource> textureUploadBuffer;
-    UINT64 textureUploadBufferSize;
-    D3D12_PLACED_SUBRESOURCE_FOOTPRINT textureLayout[TEXTURE_MIP_LEVELS];
-    dev->GetCopyableFootprints(&textureDesc, 0, TEXTURE_MIP_LEVELS, 0, textureLayout,
-                               Q_NULLPTR, Q_NULLPTR, &textureUploadBufferSize);
-    bufDesc.Width = textureUploadBufferSize;
-    if (FAILED(dev->CreateCommittedResource(&uploadHeapProp, D3D12_HEAP_FLAG_NONE, &bufDesc,
-                                            D3D12_RESOURCE_STATE_GENERIC_READ, Q_NULLPTR, IID_PPV_ARGS(&textureUploadBuffer)))) {
-        qWarning("Failed to create texture upload buffer resource");
-        return;
-    }
-
-    if (FAILED(textureUploadBuffer->Map(0, &readRange, reinterpret_cast<void **>(&p)))) {
-        qWarning("Map failed (texture upload buffer)");
-        return;
-    }
-    int mipW = qtLogo.width(), mipH = qtLogo.height();
-    for (int level = 0; level < TEXTURE_MIP_LEVELS; ++level) {
-        quint8 *mipP = p + textureLayout[level].Offset;
-        // This is not quite how mipmaps are created ideally, but will do for now...
-        QImage img = qtLogo.scaled(mipW, mipH);
-        for (int y = 0; y < mipH; ++y) {
-            memcpy(mipP, img.scanLine(y), mipW * 4);
-            mipP += textureLayout[level].Footprint.RowPitch; // stride is at least 256 here
-        }
-        mipW /= 2;
-        mipH /= 2;
-    }
-    textureUploadBuffer->Unmap(0, Q_NULLPTR);
-
-    for (int level = 0; level < TEXTURE_MIP_LEVELS; ++level) {
-        D3D12_TEXTURE_COPY_LOCATION dstLoc;
-        dstLoc.pResource = texture.Get();
-        dstLoc.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
-        dstLoc.SubresourceIndex = level;
-        D3D12_TEXTURE_COPY_LOCATION srcLoc;
-        srcLoc.pResource = textureUploadBuffer.Get();
-        srcLoc.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
-        srcLoc.PlacedFootprint = textureLayout[level];
-        commandList->CopyTextureRegion(&dstLoc, 0, 0, 0, &srcLoc, Q_NULLPTR); // upload buffer -> texture
-    }
-
-    // once the copy is done the texture is ready to be used from the pixel shader
-    transitionResource(texture.Get(), commandList.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-
     // Constant buffer view and shader resource view descriptors are stored in the same heap.
-    const UINT cbvSrvStride = dev->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
     D3D12_DESCRIPTOR_HEAP_DESC cbvSrvHeapDesc = {};
     cbvSrvHeapDesc.NumDescriptors = 2;
     cbvSrvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
@@ -321,26 +256,29 @@ void Window::initializeD3D()
     cbvDesc.BufferLocation = constantBuffer->GetGPUVirtualAddress();
     cbvDesc.SizeInBytes = CB_SIZE;
     dev->CreateConstantBufferView(&cbvDesc, cbvSrvHandle);
-    cbvSrvHandle.ptr += cbvSrvStride;
 
-    D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
-    srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-    srvDesc.Format = textureDesc.Format;
-    srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
-    srvDesc.Texture2D.MipLevels = TEXTURE_MIP_LEVELS;
-    dev->CreateShaderResourceView(texture.Get(), &srvDesc, cbvSrvHandle);
+    updateTextureView();
 
-    // Execute the texture upload.
+    // Nothing to record here, paintD3D() expects the list to be closed.
     commandList->Close();
-    ID3D12CommandList *commandLists[] = { commandList.Get() };
-    commandQueue()->ExecuteCommandLists(_countof(commandLists), commandLists);
-
-    // Block until all the above has finished.
-    waitForGPU(f);
 
     setupProjection();
 }
 
+// Points the SRV to the placeholder or, once it is ready, the texture itself.
+// Rewriting the descriptor is safe here since afterPresent() waits for the
+// GPU, so no frame using it is in flight.
+void Window::updateTextureView()
+{
+    if (!cbvSrvHeap)
+        return;
+
+    D3D12_CPU_DESCRIPTOR_HANDLE srvHandle = cbvSrvHeap->GetCPUDescriptorHandleForHeapStart();
+    srvHandle.ptr += device()->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+    const D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = textureLoader->shaderResourceViewDesc(textureId);
+    device()->CreateShaderResourceView(textureLoader->texture(textureId), &srvDesc, srvHandle);
+}
+
 void Window::resizeD3D(const QSize &)
 {
     setupProjection();
@@ -39,6 +39,7 @@
 ****************************************************************************/
 
 #include <QD3D12Window>
+#include <QD3D12TextureLoader>
 #include <QMatrix4x4>
 
 class Window : public QD3D12Window
@@ -54,6 +55,7 @@ public:
 
 private:
     void setupProjection();
+    void updateTextureView();
 
     Fence *f;
     ComPtr<ID3D12GraphicsCommandList> commandList;
@@ -61,8 +63,9 @@ private:
     ComPtr<ID3D12RootSignature> rootSignature;
     ComPtr<ID3D12Resource> vertexBuffer;
     ComPtr<ID3D12Resource> constantBuffer;
-    ComPtr<ID3D12Resource> texture;
     ComPtr<ID3D12DescriptorHeap> cbvSrvHeap;
+    QD3D12TextureLoader *textureLoader;
+    int textureId;
     D3D12_VERTEX_BUFFER_VIEW vertexBufferView;
 
     QMatrix4x4 projection;
@@ -6,6 +6,8 @@ HEADERS = window.h
 
 LIBS = -ld3d12
 
+DEFINES += SRCDIR=\\\"$$PWD/\\\"
+
 VSPS = shader.hlsl
 
 vshader.input = VSPS
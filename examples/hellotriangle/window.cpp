@@ -44,6 +44,8 @@
 
 Window::Window()
     : f(Q_NULLPTR),
+      shaderWatcher(new QD3D12ShaderWatcher(this)),
+      pipelineId(-1),
       cbPtr(Q_NULLPTR),
       rotationAngle(0)
 {
@@ -91,12 +93,11 @@ void Window::initializeD3D()
         { "COLOR", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 }
     };
 
-    D3D12_SHADER_BYTECODE vshader;
-    vshader.pShaderBytecode = g_VS_Simple;
-    vshader.BytecodeLength = sizeof(g_VS_Simple);
-    D3D12_SHADER_BYTECODE pshader;
-    pshader.pShaderBytecode = g_PS_Simple;
-    pshader.BytecodeLength = sizeof(g_PS_Simple);
+    // Run with QT_D3D12_SHADER_HOT_RELOAD=1 and edit shader.hlsl while the
+    // application is running to see the changes without a rebuild.
+    const QString shaderSource = QStringLiteral(SRCDIR "shader.hlsl");
+    const int vs = shaderWatcher->addShader(shaderSource, "VS_Simple", "vs_5_0", g_VS_Simple, sizeof(g_VS_Simple));
+    const int ps = shaderWatcher->addShader(shaderSource, "PS_Simple", "ps_5_0", g_PS_Simple, sizeof(g_PS_Simple));
 
     D3D12_RASTERIZER_DESC rastDesc = {};
     rastDesc.FillMode = D3D12_FILL_MODE_SOLID;
@@ -116,8 +117,6 @@ void Window::initializeD3D()
     D3D12_GRAPHICS_PIPELINE_STATE_DESC psoDesc = {};
     psoDesc.InputLayout = { inputElementDescs, _countof(inputElementDescs) };
     psoDesc.pRootSignature = rootSignature.Get();
-    psoDesc.VS = vshader;
-    psoDesc.PS = pshader;
     psoDesc.RasterizerState = rastDesc;
     psoDesc.BlendState = blendDesc;
     psoDesc.DepthStencilState.DepthEnable = TRUE;
@@ -130,10 +129,9 @@ void Window::initializeD3D()
     psoDesc.RTVFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM;
     psoDesc.DSVFormat = DXGI_FORMAT_D32_FLOAT;
     psoDesc.SampleDesc.Count = 1;
-    if (FAILED(dev->CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(&pipelineState)))) {
-        qWarning("Failed to create graphics pipeline state");
+    pipelineId = shaderWatcher->addGraphicsPipeline(psoDesc, vs, ps);
+    if (pipelineId < 0)
         return;
-    }
 
     if (FAILED(dev->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, commandAllocator(), Q_NULLPTR, IID_PPV_ARGS(&commandList)))) {
         qWarning("Failed to create command list");
@@ -223,7 +221,7 @@ void Window::paintD3D()
     memcpy(cbPtr + 16 * sizeof(float), projection.constData(), 16 * sizeof(float));
 
     commandAllocator()->Reset();
-    commandList->Reset(commandAllocator(), pipelineState.Get());
+    commandList->Reset(commandAllocator(), shaderWatcher->pipelineState(pipelineId));
 
     commandList->SetGraphicsRootSignature(rootSignature.Get()); // invalidates bindings
 
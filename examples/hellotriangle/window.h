@@ -39,6 +39,7 @@
 ****************************************************************************/
 
 #include <QD3D12Window>
+#include <QD3D12ShaderWatcher>
 #include <QMatrix4x4>
 
 class Window : public QD3D12Window
@@ -56,8 +57,9 @@ private:
     void setupProjection();
 
     Fence *f;
+    QD3D12ShaderWatcher *shaderWatcher;
+    int pipelineId;
     ComPtr<ID3D12GraphicsCommandList> commandList;
-    ComPtr<ID3D12PipelineState> pipelineState;
     ComPtr<ID3D12RootSignature> rootSignature;
     ComPtr<ID3D12Resource> vertexBuffer;
     ComPtr<ID3D12Resource> constantBuffer;
@@ -1 +1,2 @@
+# qt_parts builds src, and tests through tests/tests.pro.
 load(qt_parts)
@@ -6,9 +6,139 @@ load(qt_module)
 
 DEFINES += QD3D12_BUILD_DLL
 
-SOURCES += $$PWD/qd3d12window.cpp
+# Frame phase instrumentation (frameTimeStatistics(), exportFrameTrace()).
+d3d12_frame_trace: DEFINES += QD3D12_FRAME_TRACE
+
+SOURCES += $$PWD/qd3d12window.cpp \
+           $$PWD/qd3d12shaderwatcher.cpp \
+           $$PWD/qd3d12gpuprofiler.cpp \
+           $$PWD/qd3d12frametrace.cpp \
+           $$PWD/qd3d12util.cpp \
+           $$PWD/qd3d12offscreenrenderer.cpp \
+           $$PWD/qd3d12adapter.cpp \
+           $$PWD/qd3d12devicecontext.cpp \
+           $$PWD/qd3d12staticresources.cpp \
+           $$PWD/qd3d12residencymanager.cpp \
+           $$PWD/qd3d12ddstexture.cpp \
+           $$PWD/qd3d12ktx2texture.cpp \
+           $$PWD/qd3d12textureloader.cpp \
+           $$PWD/qd3d12cpumipmapgenerator.cpp \
+           $$PWD/qd3d12gpumipmapgenerator.cpp \
+           $$PWD/qd3d12bcencoder.cpp \
+           $$PWD/qd3d12gpubcencoder.cpp \
+           $$PWD/qd3d12formatinfo.cpp \
+           $$PWD/qd3d12streamingbuffer.cpp \
+           $$PWD/qd3d12meshuploader.cpp \
+           $$PWD/qd3d12indirectdrawer.cpp \
+           $$PWD/qd3d12gpuculler.cpp \
+           $$PWD/qd3d12spritebatcher.cpp \
+           $$PWD/qd3d12paintengine.cpp \
+           $$PWD/qd3d12glyphatlas.cpp
 
 HEADERS += $$PWD/qd3d12window.h \
-           $$PWD/qd3d12windowglobal.h
+           $$PWD/qd3d12window_p.h \
+           $$PWD/qd3d12windowglobal.h \
+           $$PWD/qd3d12shaderwatcher.h \
+           $$PWD/qd3d12gpuprofiler.h \
+           $$PWD/qd3d12gpuprofiler_p.h \
+           $$PWD/qd3d12frametrace_p.h \
+           $$PWD/qd3d12util_p.h \
+           $$PWD/qd3d12offscreenrenderer.h \
+           $$PWD/qd3d12adapter.h \
+           $$PWD/qd3d12adapter_p.h \
+           $$PWD/qd3d12devicecontext.h \
+           $$PWD/qd3d12devicecontext_p.h \
+           $$PWD/qd3d12staticresources.h \
+           $$PWD/qd3d12staticresources_p.h \
+           $$PWD/qd3d12residencymanager.h \
+           $$PWD/qd3d12residencymanager_p.h \
+           $$PWD/qd3d12ddstexture.h \
+           $$PWD/qd3d12ddstexture_p.h \
+           $$PWD/qd3d12ktx2texture.h \
+           $$PWD/qd3d12ktx2texture_p.h \
+           $$PWD/qd3d12textureloader.h \
+           $$PWD/qd3d12textureloader_p.h \
+           $$PWD/qd3d12cpumipmapgenerator.h \
+           $$PWD/qd3d12gpumipmapgenerator.h \
+           $$PWD/qd3d12gpumipmapgenerator_p.h \
+           $$PWD/qd3d12bcencoder.h \
+           $$PWD/qd3d12gpubcencoder.h \
+           $$PWD/qd3d12gpubcencoder_p.h \
+           $$PWD/qd3d12formatinfo.h \
+           $$PWD/qd3d12streamingbuffer.h \
+           $$PWD/qd3d12streamingbuffer_p.h \
+           $$PWD/qd3d12meshuploader.h \
+           $$PWD/qd3d12meshuploader_p.h \
+           $$PWD/qd3d12indirectdrawer.h \
+           $$PWD/qd3d12indirectdrawer_p.h \
+           $$PWD/qd3d12gpuculler.h \
+           $$PWD/qd3d12gpuculler_p.h \
+           $$PWD/qd3d12spritebatcher.h \
+           $$PWD/qd3d12spritebatcher_p.h \
+           $$PWD/qd3d12paintengine.h \
+           $$PWD/qd3d12paintengine_p.h \
+           $$PWD/qd3d12glyphatlas.h \
+           $$PWD/qd3d12glyphatlas_p.h
+
+LIBS += -ldxgi -ld3d12 -ld3dcompiler
+
+# Compute shaders used by the module, compiled with the rule from features/hlsl.prf.
+MIPMAPGEN = $$PWD/qd3d12gpumipmapgenerator.hlsl
+
+mipmapgen.input = MIPMAPGEN
+mipmapgen.header = qd3d12gpumipmapgenerator_cs.h
+mipmapgen.entry = CS_GenerateMipMaps
+mipmapgen.type = cs_5_0
+
+BCENCODER = $$PWD/qd3d12gpubcencoder.hlsl
+
+bcencoder_bc1.input = BCENCODER
+bcencoder_bc1.header = qd3d12gpubcencoder_bc1_cs.h
+bcencoder_bc1.entry = CS_EncodeBC1
+bcencoder_bc1.type = cs_5_0
+
+bcencoder_bc7.input = BCENCODER
+bcencoder_bc7.header = qd3d12gpubcencoder_bc7_cs.h
+bcencoder_bc7.entry = CS_EncodeBC7
+bcencoder_bc7.type = cs_5_0
+
+GPUCULLER = $$PWD/qd3d12gpuculler.hlsl
+
+gpuculler_reduce.input = GPUCULLER
+gpuculler_reduce.header = qd3d12gpuculler_reduce_cs.h
+gpuculler_reduce.entry = CS_ReduceDepth
+gpuculler_reduce.type = cs_5_0
+
+gpuculler_cull.input = GPUCULLER
+gpuculler_cull.header = qd3d12gpuculler_cull_cs.h
+gpuculler_cull.entry = CS_Cull
+gpuculler_cull.type = cs_5_0
+
+# Shader model 5.1 for the unbounded texture array.
+SPRITEBATCHER = $$PWD/qd3d12spritebatcher.hlsl
+
+spritebatcher_vs.input = SPRITEBATCHER
+spritebatcher_vs.header = qd3d12spritebatcher_vs.h
+spritebatcher_vs.entry = VS_Sprite
+spritebatcher_vs.type = vs_5_1
+
+spritebatcher_ps.input = SPRITEBATCHER
+spritebatcher_ps.header = qd3d12spritebatcher_ps.h
+spritebatcher_ps.entry = PS_Sprite
+spritebatcher_ps.type = ps_5_1
+
+PAINTENGINE = $$PWD/qd3d12paintengine.hlsl
+
+paintengine_vs.input = PAINTENGINE
+paintengine_vs.header = qd3d12paintengine_vs.h
+paintengine_vs.entry = VS_Paint
+paintengine_vs.type = vs_5_0
+
+paintengine_ps.input = PAINTENGINE
+paintengine_ps.header = qd3d12paintengine_ps.h
+paintengine_ps.entry = PS_Paint
+paintengine_ps.type = ps_5_0
 
-LIBS += -ldxgi -ld3d12
+HLSL_SHADERS = mipmapgen bcencoder_bc1 bcencoder_bc7 gpuculler_reduce gpuculler_cull spritebatcher_vs spritebatcher_ps \
+               paintengine_vs paintengine_ps
+include($$PWD/../../features/hlsl.prf)
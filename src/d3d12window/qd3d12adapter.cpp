@@ -0,0 +1,215 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtD3D12Window module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qd3d12adapter_p.h"
+#include <QtCore/QHash>
+#include <QtCore/QMutex>
+#include <dxgi1_6.h>
+
+QT_BEGIN_NAMESPACE
+
+struct QD3D12AdapterProbeCache
+{
+    QMutex mutex;
+    QHash<quint64, bool> supported;
+};
+
+Q_GLOBAL_STATIC(QD3D12AdapterProbeCache, probeCache)
+
+bool QD3D12AdapterSelection::isSupported(IDXGIAdapter1 *adapter, const DXGI_ADAPTER_DESC1 &desc)
+{
+    const quint64 luid = toQuint64(desc.AdapterLuid);
+    QD3D12AdapterProbeCache *cache = probeCache();
+    QMutexLocker locker(&cache->mutex);
+
+    QHash<quint64, bool>::const_iterator it = cache->supported.constFind(luid);
+    if (it != cache->supported.constEnd())
+        return *it;
+
+    // With a null output pointer this only checks whether creation would
+    // succeed, no device is created.
+    const bool supported = SUCCEEDED(D3D12CreateDevice(adapter, D3D_FEATURE_LEVEL_11_0, _uuidof(ID3D12Device), Q_NULLPTR));
+    cache->supported.insert(luid, supported);
+    return supported;
+}
+
+// QT_D3D12_ADAPTER=high-performance|minimum-power|most-memory|software|luid:<hex>|<index>
+static bool adapterOverride(QD3D12Adapter::Preference *preference, quint64 *luid, int *index)
+{
+    const QByteArray value = qgetenv("QT_D3D12_ADAPTER").trimmed().toLower();
+    if (value.isEmpty())
+        return false;
+
+    QD3D12Adapter::Preference p = QD3D12Adapter::DefaultPreference;
+    quint64 l = 0;
+    int i = -1;
+    bool ok = true;
+    if (value == "high-performance")
+        p = QD3D12Adapter::HighPerformance;
+    else if (value == "minimum-power")
+        p = QD3D12Adapter::MinimumPower;
+    else if (value == "most-memory")
+        p = QD3D12Adapter::MostVideoMemory;
+    else if (value == "software" || value == "warp")
+        p = QD3D12Adapter::Software;
+    else if (value.startsWith("luid:"))
+        l = value.mid(5).toULongLong(&ok, 16);
+    else
+        i = value.toInt(&ok);
+
+    if (!ok) {
+        qWarning("Invalid QT_D3D12_ADAPTER value '%s'", value.constData());
+        return false;
+    }
+
+    *preference = p;
+    *luid = l;
+    *index = i;
+    return true;
+}
+
+static bool isUsableHardwareAdapter(IDXGIAdapter1 *adapter, DXGI_ADAPTER_DESC1 *desc)
+{
+    if (FAILED(adapter->GetDesc1(desc)))
+        return false;
+    if (desc->Flags & DXGI_ADAPTER_FLAG_SOFTWARE)
+        return false;
+    return QD3D12AdapterSelection::isSupported(adapter, *desc);
+}
+
+static ComPtr<IDXGIAdapter1> useAdapter(const ComPtr<IDXGIAdapter1> &adapter, const DXGI_ADAPTER_DESC1 &desc)
+{
+    qDebug("Using adapter '%s'", qPrintable(QString::fromWCharArray(desc.Description)));
+    return adapter;
+}
+
+ComPtr<IDXGIAdapter1> QD3D12AdapterSelection::select(IDXGIFactory4 *factory, QD3D12Adapter::Preference preference,
+                                                     quint64 luid)
+{
+    int index = -1;
+    if (adapterOverride(&preference, &luid, &index))
+        qDebug("Adapter selection overridden by QT_D3D12_ADAPTER");
+
+    if (preference == QD3D12Adapter::Software)
+        return ComPtr<IDXGIAdapter1>();
+
+    ComPtr<IDXGIAdapter1> adapter;
+    DXGI_ADAPTER_DESC1 desc;
+
+    if (luid) {
+        LUID l;
+        l.LowPart = DWORD(luid);
+        l.HighPart = LONG(luid >> 32);
+        if (SUCCEEDED(factory->EnumAdapterByLuid(l, IID_PPV_ARGS(&adapter))) && isUsableHardwareAdapter(adapter.Get(), &desc))
+            return useAdapter(adapter, desc);
+        qWarning("Adapter with LUID 0x%llx is not usable, falling back to the default", luid);
+    }
+
+    if (index >= 0) {
+        if (factory->EnumAdapters1(index, &adapter) != DXGI_ERROR_NOT_FOUND && isUsableHardwareAdapter(adapter.Get(), &desc))
+            return useAdapter(adapter, desc);
+        qWarning("Adapter %d is not usable, falling back to the default", index);
+    }
+
+    if (preference == QD3D12Adapter::HighPerformance || preference == QD3D12Adapter::MinimumPower) {
+        ComPtr<IDXGIFactory6> factory6;
+        if (SUCCEEDED(factory->QueryInterface(IID_PPV_ARGS(&factory6)))) {
+            const DXGI_GPU_PREFERENCE gpuPreference = preference == QD3D12Adapter::HighPerformance
+                    ? DXGI_GPU_PREFERENCE_HIGH_PERFORMANCE : DXGI_GPU_PREFERENCE_MINIMUM_POWER;
+            for (UINT i = 0; SUCCEEDED(factory6->EnumAdapterByGpuPreference(i, gpuPreference, IID_PPV_ARGS(&adapter))); ++i) {
+                if (isUsableHardwareAdapter(adapter.Get(), &desc))
+                    return useAdapter(adapter, desc);
+            }
+        } else if (preference == QD3D12Adapter::HighPerformance) {
+            // Pre-1803 Windows: the discrete GPU is the one with more memory.
+            preference = QD3D12Adapter::MostVideoMemory;
+        }
+    }
+
+    ComPtr<IDXGIAdapter1> best;
+    DXGI_ADAPTER_DESC1 bestDesc = {};
+    for (UINT i = 0; factory->EnumAdapters1(i, &adapter) != DXGI_ERROR_NOT_FOUND; ++i) {
+        if (!isUsableHardwareAdapter(adapter.Get(), &desc))
+            continue;
+        if (preference != QD3D12Adapter::MostVideoMemory)
+            return useAdapter(adapter, desc);
+        if (!best || desc.DedicatedVideoMemory > bestDesc.DedicatedVideoMemory) {
+            best = adapter;
+            bestDesc = desc;
+        }
+    }
+
+    if (best)
+        return useAdapter(best, bestDesc);
+
+    qWarning("No usable hardware adapters found");
+    return ComPtr<IDXGIAdapter1>();
+}
+
+// Lists all adapters, including WARP, together with whether they support
+// D3D12. Probing does not create devices and is cached.
+QVector<QD3D12Adapter::Info> QD3D12Adapter::adapters()
+{
+    QVector<Info> result;
+
+    ComPtr<IDXGIFactory4> factory;
+    if (FAILED(CreateDXGIFactory2(0, IID_PPV_ARGS(&factory)))) {
+        qWarning("Failed to create DXGI");
+        return result;
+    }
+
+    ComPtr<IDXGIAdapter1> adapter;
+    for (UINT i = 0; factory->EnumAdapters1(i, &adapter) != DXGI_ERROR_NOT_FOUND; ++i) {
+        DXGI_ADAPTER_DESC1 desc;
+        if (FAILED(adapter->GetDesc1(&desc)))
+            continue;
+
+        Info info;
+        info.description = QString::fromWCharArray(desc.Description);
+        info.luid = QD3D12AdapterSelection::toQuint64(desc.AdapterLuid);
+        info.vendorId = desc.VendorId;
+        info.deviceId = desc.DeviceId;
+        info.dedicatedVideoMemory = desc.DedicatedVideoMemory;
+        info.sharedSystemMemory = desc.SharedSystemMemory;
+        info.software = desc.Flags & DXGI_ADAPTER_FLAG_SOFTWARE;
+        info.supported = QD3D12AdapterSelection::isSupported(adapter.Get(), desc);
+        result.append(info);
+    }
+
+    return result;
+}
+
+QT_END_NAMESPACE
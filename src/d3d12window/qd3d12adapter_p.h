@@ -0,0 +1,74 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtD3D12Window module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QD3D12ADAPTER_P_H
+#define QD3D12ADAPTER_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "qd3d12adapter.h"
+#include "qd3d12window.h"
+
+QT_BEGIN_NAMESPACE
+
+namespace QD3D12AdapterSelection
+{
+    // Whether a D3D12 device can be created on the adapter. Probes without
+    // creating a device and remembers the result for the process lifetime.
+    bool isSupported(IDXGIAdapter1 *adapter, const DXGI_ADAPTER_DESC1 &desc);
+
+    // Returns null when WARP should be used. QT_D3D12_ADAPTER overrides the
+    // arguments when set.
+    ComPtr<IDXGIAdapter1> select(IDXGIFactory4 *factory, QD3D12Adapter::Preference preference, quint64 luid);
+
+    inline quint64 toQuint64(const LUID &luid)
+    {
+        return (quint64(quint32(luid.HighPart)) << 32) | luid.LowPart;
+    }
+}
+
+QT_END_NAMESPACE
+
+#endif
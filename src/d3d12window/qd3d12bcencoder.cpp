@@ -0,0 +1,759 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtD3D12Window module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include "qd3d12bcencoder.h"
+#include "qd3d12cpumipmapgenerator.h"
+#include <QtCore/QRunnable>
+#include <QtCore/QSemaphore>
+#include <QtCore/QThreadPool>
+#include <QtCore/QVector>
+#include <QtCore/qendian.h>
+#include <QtCore/private/qsimd_p.h>
+#include <QtGui/QImage>
+#include <qmath.h>
+
+QT_BEGIN_NAMESPACE
+
+enum BlockKind {
+    Bc1Block, // color
+    Bc3Block, // alpha + color
+    Bc7Block // mode 6 only
+};
+
+static bool blockKind(DXGI_FORMAT format, BlockKind *kind)
+{
+    switch (format) {
+    case DXGI_FORMAT_BC1_UNORM:
+    case DXGI_FORMAT_BC1_UNORM_SRGB:
+        *kind = Bc1Block;
+        return true;
+    case DXGI_FORMAT_BC3_UNORM:
+    case DXGI_FORMAT_BC3_UNORM_SRGB:
+        *kind = Bc3Block;
+        return true;
+    case DXGI_FORMAT_BC7_UNORM:
+    case DXGI_FORMAT_BC7_UNORM_SRGB:
+        *kind = Bc7Block;
+        return true;
+    default:
+        return false;
+    }
+}
+
+static inline int blockBytes(BlockKind kind)
+{
+    return kind == Bc1Block ? 8 : 16;
+}
+
+// The 16 texels of a block as structure of arrays: r, g, b, a in 0..255.
+struct Q_DECL_ALIGN(16) PixelBlock
+{
+    float c[4][16];
+};
+
+static void loadBlock(const uchar *src, quint32 pitch, int width, int height, int bx, int by, PixelBlock *block)
+{
+    const int x0 = bx * 4;
+    const int y0 = by * 4;
+#ifdef __SSE2__
+    if (x0 + 4 <= width && y0 + 4 <= height) {
+        const __m128i mask = _mm_set1_epi32(0xFF);
+        for (int y = 0; y < 4; ++y) {
+            const __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + (y0 + y) * pitch + x0 * 4));
+            _mm_store_ps(block->c[0] + y * 4, _mm_cvtepi32_ps(_mm_and_si128(p, mask)));
+            _mm_store_ps(block->c[1] + y * 4, _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(p, 8), mask)));
+            _mm_store_ps(block->c[2] + y * 4, _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(p, 16), mask)));
+            _mm_store_ps(block->c[3] + y * 4, _mm_cvtepi32_ps(_mm_srli_epi32(p, 24)));
+        }
+        return;
+    }
+#endif
+    // Edge blocks repeat the last column and row.
+    for (int y = 0; y < 4; ++y) {
+        const uchar *row = src + qMin(y0 + y, height - 1) * pitch;
+        for (int x = 0; x < 4; ++x) {
+            const uchar *p = row + qMin(x0 + x, width - 1) * 4;
+            for (int ch = 0; ch < 4; ++ch)
+                block->c[ch][y * 4 + x] = p[ch];
+        }
+    }
+}
+
+// Channels first..first+count-1 take part, for BC1 colors that is RGB, for
+// BC3 alpha only A and for BC7 all four.
+struct ChannelRange
+{
+    int first;
+    int count;
+};
+
+// Projects every texel onto the segment e0-e1 and snaps it to the nearest
+// of the interpolation weights (ascending, 0 is e0, 1 is e1). indices get
+// the position in weights. Returns the squared error of the block.
+static float fitIndices(const PixelBlock &block, ChannelRange range, const float *e0, const float *e1,
+                        const float *weights, int weightCount, quint8 *indices)
+{
+    float d[4];
+    float dd = 0;
+    for (int ch = range.first; ch < range.first + range.count; ++ch) {
+        d[ch] = e1[ch] - e0[ch];
+        dd += d[ch] * d[ch];
+    }
+    const float scale = dd > 0 ? 1.0f / dd : 0.0f;
+
+    // Midpoints between neighbouring weights.
+    float thresholds[15];
+    for (int i = 0; i < weightCount - 1; ++i)
+        thresholds[i] = (weights[i] + weights[i + 1]) * 0.5f;
+
+#ifdef __SSE2__
+    __m128 error = _mm_setzero_ps();
+    for (int i = 0; i < 16; i += 4) {
+        __m128 t = _mm_setzero_ps();
+        for (int ch = range.first; ch < range.first + range.count; ++ch) {
+            const __m128 p = _mm_sub_ps(_mm_load_ps(block.c[ch] + i), _mm_set1_ps(e0[ch]));
+            t = _mm_add_ps(t, _mm_mul_ps(p, _mm_set1_ps(d[ch] * scale)));
+        }
+        __m128i index = _mm_setzero_si128();
+        __m128 w = _mm_set1_ps(weights[0]);
+        for (int k = 0; k < weightCount - 1; ++k) {
+            const __m128 above = _mm_cmpgt_ps(t, _mm_set1_ps(thresholds[k]));
+            index = _mm_sub_epi32(index, _mm_castps_si128(above));
+            w = _mm_or_ps(_mm_and_ps(above, _mm_set1_ps(weights[k + 1])), _mm_andnot_ps(above, w));
+        }
+        for (int ch = range.first; ch < range.first + range.count; ++ch) {
+            const __m128 v = _mm_add_ps(_mm_set1_ps(e0[ch]), _mm_mul_ps(w, _mm_set1_ps(d[ch])));
+            const __m128 diff = _mm_sub_ps(v, _mm_load_ps(block.c[ch] + i));
+            error = _mm_add_ps(error, _mm_mul_ps(diff, diff));
+        }
+        const __m128i packed = _mm_packs_epi32(index, index);
+        const int lo = _mm_cvtsi128_si32(packed);
+        const int hi = _mm_cvtsi128_si32(_mm_srli_si128(packed, 4));
+        indices[i] = quint8(lo);
+        indices[i + 1] = quint8(lo >> 16);
+        indices[i + 2] = quint8(hi);
+        indices[i + 3] = quint8(hi >> 16);
+    }
+    error = _mm_add_ps(error, _mm_movehl_ps(error, error));
+    error = _mm_add_ss(error, _mm_shuffle_ps(error, error, 1));
+    return _mm_cvtss_f32(error);
+#else
+    float error = 0;
+    for (int i = 0; i < 16; ++i) {
+        float t = 0;
+        for (int ch = range.first; ch < range.first + range.count; ++ch)
+            t += (block.c[ch][i] - e0[ch]) * d[ch] * scale;
+        int index = 0;
+        while (index < weightCount - 1 && t > thresholds[index])
+            ++index;
+        indices[i] = quint8(index);
+        for (int ch = range.first; ch < range.first + range.count; ++ch) {
+            const float diff = e0[ch] + weights[index] * d[ch] - block.c[ch][i];
+            error += diff * diff;
+        }
+    }
+    return error;
+#endif
+}
+
+// Bounding box endpoints, inset a little, with the diagonal picked from the
+// sign of the covariance with the widest channel.
+static void boxEndpoints(const PixelBlock &block, ChannelRange range, float *e0, float *e1)
+{
+    float mean[4];
+    int widest = range.first;
+    for (int ch = range.first; ch < range.first + range.count; ++ch) {
+        float lo = 255, hi = 0, sum = 0;
+        for (int i = 0; i < 16; ++i) {
+            lo = qMin(lo, block.c[ch][i]);
+            hi = qMax(hi, block.c[ch][i]);
+            sum += block.c[ch][i];
+        }
+        const float inset = (hi - lo) / 16;
+        e0[ch] = lo + inset;
+        e1[ch] = hi - inset;
+        mean[ch] = sum / 16;
+        if (e1[ch] - e0[ch] > e1[widest] - e0[widest])
+            widest = ch;
+    }
+    for (int ch = range.first; ch < range.first + range.count; ++ch) {
+        if (ch == widest)
+            continue;
+        float cov = 0;
+        for (int i = 0; i < 16; ++i)
+            cov += (block.c[ch][i] - mean[ch]) * (block.c[widest][i] - mean[widest]);
+        if (cov < 0)
+            qSwap(e0[ch], e1[ch]);
+    }
+}
+
+// The extent of the block along its principal axis, found by power iteration
+// on the covariance matrix.
+static void principalEndpoints(const PixelBlock &block, ChannelRange range, float *e0, float *e1)
+{
+    const int n = range.count;
+    float mean[4] = { 0, 0, 0, 0 };
+    for (int ch = 0; ch < n; ++ch) {
+        for (int i = 0; i < 16; ++i)
+            mean[ch] += block.c[range.first + ch][i];
+        mean[ch] /= 16;
+    }
+
+    float cov[4][4];
+    for (int a = 0; a < n; ++a) {
+        for (int b = a; b < n; ++b) {
+            float sum = 0;
+            for (int i = 0; i < 16; ++i)
+                sum += (block.c[range.first + a][i] - mean[a]) * (block.c[range.first + b][i] - mean[b]);
+            cov[a][b] = cov[b][a] = sum;
+        }
+    }
+
+    float axis[4] = { 1, 1, 1, 1 };
+    for (int iter = 0; iter < 8; ++iter) {
+        float next[4];
+        float len = 0;
+        for (int a = 0; a < n; ++a) {
+            next[a] = 0;
+            for (int b = 0; b < n; ++b)
+                next[a] += cov[a][b] * axis[b];
+            len = qMax(len, qAbs(next[a]));
+        }
+        if (len < 1e-6f)
+            break;
+        for (int a = 0; a < n; ++a)
+            axis[a] = next[a] / len;
+    }
+    float len = 0;
+    for (int a = 0; a < n; ++a)
+        len += axis[a] * axis[a];
+    len = qSqrt(len);
+    for (int a = 0; a < n; ++a)
+        axis[a] /= len;
+
+    float lo = 0, hi = 0;
+    for (int i = 0; i < 16; ++i) {
+        float t = 0;
+        for (int a = 0; a < n; ++a)
+            t += (block.c[range.first + a][i] - mean[a]) * axis[a];
+        lo = qMin(lo, t);
+        hi = qMax(hi, t);
+    }
+    for (int a = 0; a < n; ++a) {
+        e0[range.first + a] = qBound(0.0f, mean[a] + axis[a] * lo, 255.0f);
+        e1[range.first + a] = qBound(0.0f, mean[a] + axis[a] * hi, 255.0f);
+    }
+}
+
+static void initialEndpoints(const PixelBlock &block, ChannelRange range, QD3D12BcEncoder::Quality quality,
+                             float *e0, float *e1)
+{
+    if (quality == QD3D12BcEncoder::FastQuality)
+        boxEndpoints(block, range, e0, e1);
+    else
+        principalEndpoints(block, range, e0, e1);
+}
+
+static inline int refinementCount(QD3D12BcEncoder::Quality quality)
+{
+    switch (quality) {
+    case QD3D12BcEncoder::FastQuality:
+        return 0;
+    case QD3D12BcEncoder::NormalQuality:
+        return 1;
+    default:
+        return 4;
+    }
+}
+
+// Least squares endpoints for the given indices.
+static bool refineEndpoints(const PixelBlock &block, ChannelRange range, const float *weights, const quint8 *indices,
+                            float *e0, float *e1)
+{
+    float aa = 0, ab = 0, bb = 0;
+    float x0[4] = { 0, 0, 0, 0 };
+    float x1[4] = { 0, 0, 0, 0 };
+    for (int i = 0; i < 16; ++i) {
+        const float w = weights[indices[i]];
+        aa += (1 - w) * (1 - w);
+        ab += (1 - w) * w;
+        bb += w * w;
+        for (int ch = range.first; ch < range.first + range.count; ++ch) {
+            x0[ch] += (1 - w) * block.c[ch][i];
+            x1[ch] += w * block.c[ch][i];
+        }
+    }
+    const float det = aa * bb - ab * ab;
+    if (qAbs(det) < 1e-6f)
+        return false;
+    for (int ch = range.first; ch < range.first + range.count; ++ch) {
+        e0[ch] = qBound(0.0f, (bb * x0[ch] - ab * x1[ch]) / det, 255.0f);
+        e1[ch] = qBound(0.0f, (aa * x1[ch] - ab * x0[ch]) / det, 255.0f);
+    }
+    return true;
+}
+
+struct BlockWriter
+{
+    BlockWriter() : pos(0) { bits[0] = bits[1] = 0; }
+
+    void write(quint32 value, int count)
+    {
+        for (int i = 0; i < count; ++i, ++pos) {
+            if (value & (1u << i))
+                bits[pos >> 6] |= Q_UINT64_C(1) << (pos & 63);
+        }
+    }
+
+    void store(quint8 *out) const
+    {
+        qToLittleEndian(bits[0], out);
+        qToLittleEndian(bits[1], out + 8);
+    }
+
+    quint64 bits[2];
+    int pos;
+};
+
+static const float BC1_WEIGHTS[4] = { 0.0f, 1.0f / 3, 2.0f / 3, 1.0f };
+static const quint32 BC1_CODES[4] = { 0, 2, 3, 1 };
+
+static inline quint16 pack565(const float *c)
+{
+    return quint16((qBound(0, qRound(c[0] * 31 / 255), 31) << 11)
+                   | (qBound(0, qRound(c[1] * 63 / 255), 63) << 5)
+                   | qBound(0, qRound(c[2] * 31 / 255), 31));
+}
+
+static inline void unpack565(quint16 v, float *c)
+{
+    const int r = v >> 11;
+    const int g = (v >> 5) & 0x3F;
+    const int b = v & 0x1F;
+    c[0] = float((r << 3) | (r >> 2));
+    c[1] = float((g << 2) | (g >> 4));
+    c[2] = float((b << 3) | (b >> 2));
+}
+
+// Four color mode only, which is also what BC3 color blocks always use.
+static void encodeColorBlock(const PixelBlock &block, QD3D12BcEncoder::Quality quality, quint8 *out)
+{
+    const ChannelRange range = { 0, 3 };
+    float e0[4], e1[4];
+    initialEndpoints(block, range, quality, e0, e1);
+
+    float bestError = -1;
+    quint16 best0 = 0, best1 = 0;
+    quint8 bestIndices[16];
+    const int refinements = refinementCount(quality);
+    for (int iter = 0; ; ++iter) {
+        quint16 c0 = pack565(e0);
+        quint16 c1 = pack565(e1);
+        // The four color mode needs c0 > c1.
+        if (c0 < c1) {
+            qSwap(c0, c1);
+            for (int ch = 0; ch < 3; ++ch)
+                qSwap(e0[ch], e1[ch]);
+        }
+        float q0[4], q1[4];
+        unpack565(c0, q0);
+        unpack565(c1, q1);
+        quint8 indices[16];
+        const float error = fitIndices(block, range, q0, q1, BC1_WEIGHTS, c0 == c1 ? 1 : 4, indices);
+        if (bestError < 0 || error < bestError) {
+            bestError = error;
+            best0 = c0;
+            best1 = c1;
+            memcpy(bestIndices, indices, 16);
+        }
+        if (iter == refinements || error == 0 || !refineEndpoints(block, range, BC1_WEIGHTS, indices, e0, e1))
+            break;
+    }
+
+    quint32 bits = 0;
+    for (int i = 0; i < 16; ++i)
+        bits |= BC1_CODES[bestIndices[i]] << (2 * i);
+    qToLittleEndian(best0, out);
+    qToLittleEndian(best1, out + 2);
+    qToLittleEndian(bits, out + 4);
+}
+
+static const float BC3_ALPHA_WEIGHTS[8] = { 0.0f, 1.0f / 7, 2.0f / 7, 3.0f / 7, 4.0f / 7, 5.0f / 7, 6.0f / 7, 1.0f };
+static const quint32 BC3_ALPHA_CODES[8] = { 0, 2, 3, 4, 5, 6, 7, 1 };
+
+// Eight value mode (a0 > a1) only.
+static void encodeAlphaBlock(const PixelBlock &block, QD3D12BcEncoder::Quality quality, quint8 *out)
+{
+    const ChannelRange range = { 3, 1 };
+    float e0[4], e1[4];
+    e0[3] = 0;
+    e1[3] = 255;
+    for (int i = 0; i < 16; ++i) {
+        e0[3] = qMax(e0[3], block.c[3][i]);
+        e1[3] = qMin(e1[3], block.c[3][i]);
+    }
+
+    float bestError = -1;
+    int best0 = 0, best1 = 0;
+    quint8 bestIndices[16];
+    const int refinements = quality == QD3D12BcEncoder::HighQuality ? 2 : 0;
+    for (int iter = 0; ; ++iter) {
+        int a0 = qBound(0, qRound(e0[3]), 255);
+        int a1 = qBound(0, qRound(e1[3]), 255);
+        if (a0 < a1) {
+            qSwap(a0, a1);
+            qSwap(e0[3], e1[3]);
+        }
+        float q0[4], q1[4];
+        q0[3] = float(a0);
+        q1[3] = float(a1);
+        quint8 indices[16];
+        const float error = fitIndices(block, range, q0, q1, BC3_ALPHA_WEIGHTS, a0 == a1 ? 1 : 8, indices);
+        if (bestError < 0 || error < bestError) {
+            bestError = error;
+            best0 = a0;
+            best1 = a1;
+            memcpy(bestIndices, indices, 16);
+        }
+        if (iter == refinements || error == 0 || !refineEndpoints(block, range, BC3_ALPHA_WEIGHTS, indices, e0, e1))
+            break;
+    }
+
+    BlockWriter writer;
+    writer.write(best0, 8);
+    writer.write(best1, 8);
+    for (int i = 0; i < 16; ++i)
+        writer.write(BC3_ALPHA_CODES[bestIndices[i]], 3);
+    quint8 bytes[16];
+    writer.store(bytes);
+    memcpy(out, bytes, 8);
+}
+
+static const int BC7_WEIGHTS_4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+struct Bc7Endpoints
+{
+    int q[2][4]; // 7 bit
+    int p[2];
+};
+
+static void quantizeBc7(const float *e0, const float *e1, const int *pbits, Bc7Endpoints *ep, float *q0, float *q1)
+{
+    const float *e[2] = { e0, e1 };
+    float *q[2] = { q0, q1 };
+    for (int j = 0; j < 2; ++j) {
+        ep->p[j] = pbits[j];
+        for (int ch = 0; ch < 4; ++ch) {
+            ep->q[j][ch] = qBound(0, qRound((e[j][ch] - pbits[j]) / 2), 127);
+            q[j][ch] = float((ep->q[j][ch] << 1) | pbits[j]);
+        }
+    }
+}
+
+// The p-bit that keeps the endpoint closest to the unquantized one.
+static int bestPBit(const float *e)
+{
+    float error[2] = { 0, 0 };
+    for (int p = 0; p < 2; ++p) {
+        for (int ch = 0; ch < 4; ++ch) {
+            const float v = float((qBound(0, qRound((e[ch] - p) / 2), 127) << 1) | p) - e[ch];
+            error[p] += v * v;
+        }
+    }
+    return error[1] < error[0] ? 1 : 0;
+}
+
+// Mode 6: one subset, RGBA endpoints of 7 bits plus a p-bit each and 4 bit
+// indices. It suits smooth image content and is cheap to search.
+static void encodeBc7Block(const PixelBlock &block, QD3D12BcEncoder::Quality quality, quint8 *out)
+{
+    const ChannelRange range = { 0, 4 };
+    float weights[16];
+    for (int i = 0; i < 16; ++i)
+        weights[i] = BC7_WEIGHTS_4[i] / 64.0f;
+
+    float e0[4], e1[4];
+    initialEndpoints(block, range, quality, e0, e1);
+
+    float bestError = -1;
+    Bc7Endpoints best;
+    quint8 bestIndices[16];
+    const int refinements = refinementCount(quality);
+    for (int iter = 0; ; ++iter) {
+        // The high quality preset tries every p-bit combination.
+        int candidates[4][2] = { { 0, 0 }, { 0, 1 }, { 1, 0 }, { 1, 1 } };
+        int candidateCount = 4;
+        if (quality != QD3D12BcEncoder::HighQuality) {
+            candidates[0][0] = bestPBit(e0);
+            candidates[0][1] = bestPBit(e1);
+            candidateCount = 1;
+        }
+        quint8 iterIndices[16];
+        float iterError = -1;
+        for (int c = 0; c < candidateCount; ++c) {
+            Bc7Endpoints ep;
+            float q0[4], q1[4];
+            quantizeBc7(e0, e1, candidates[c], &ep, q0, q1);
+            quint8 indices[16];
+            const float error = fitIndices(block, range, q0, q1, weights, 16, indices);
+            if (iterError < 0 || error < iterError) {
+                iterError = error;
+                memcpy(iterIndices, indices, 16);
+            }
+            if (bestError < 0 || error < bestError) {
+                bestError = error;
+                best = ep;
+                memcpy(bestIndices, indices, 16);
+            }
+        }
+        if (iter == refinements || iterError == 0 || !refineEndpoints(block, range, weights, iterIndices, e0, e1))
+            break;
+    }
+
+    // The anchor index has an implicit zero top bit, flip the block if needed.
+    if (bestIndices[0] & 8) {
+        for (int ch = 0; ch < 4; ++ch)
+            qSwap(best.q[0][ch], best.q[1][ch]);
+        qSwap(best.p[0], best.p[1]);
+        for (int i = 0; i < 16; ++i)
+            bestIndices[i] = quint8(15 - bestIndices[i]);
+    }
+
+    BlockWriter writer;
+    writer.write(1u << 6, 7); // mode 6
+    for (int ch = 0; ch < 4; ++ch) {
+        writer.write(best.q[0][ch], 7);
+        writer.write(best.q[1][ch], 7);
+    }
+    writer.write(best.p[0], 1);
+    writer.write(best.p[1], 1);
+    writer.write(bestIndices[0], 3);
+    for (int i = 1; i < 16; ++i)
+        writer.write(bestIndices[i], 4);
+    writer.store(out);
+}
+
+struct EncodeContext
+{
+    BlockKind kind;
+    QD3D12BcEncoder::Quality quality;
+    const uchar *src;
+    quint32 srcPitch;
+    int width;
+    int height;
+    quint8 *dst;
+    quint32 dstPitch;
+};
+
+static void encodeBlockRows(const EncodeContext &ctx, int by0, int by1)
+{
+    const int blocksX = (ctx.width + 3) / 4;
+    const int bytes = blockBytes(ctx.kind);
+    PixelBlock block;
+    for (int by = by0; by < by1; ++by) {
+        quint8 *out = ctx.dst + by * ctx.dstPitch;
+        for (int bx = 0; bx < blocksX; ++bx, out += bytes) {
+            loadBlock(ctx.src, ctx.srcPitch, ctx.width, ctx.height, bx, by, &block);
+            switch (ctx.kind) {
+            case Bc1Block:
+                encodeColorBlock(block, ctx.quality, out);
+                break;
+            case Bc3Block:
+                encodeAlphaBlock(block, ctx.quality, out);
+                encodeColorBlock(block, ctx.quality, out + 8);
+                break;
+            case Bc7Block:
+                encodeBc7Block(block, ctx.quality, out);
+                break;
+            }
+        }
+    }
+}
+
+namespace {
+
+class QD3D12BcRowsJob : public QRunnable
+{
+public:
+    QD3D12BcRowsJob(const EncodeContext *ctx, int by0, int by1, QSemaphore *done)
+        : ctx(ctx), by0(by0), by1(by1), done(done)
+    { }
+
+    void run() Q_DECL_OVERRIDE
+    {
+        encodeBlockRows(*ctx, by0, by1);
+        done->release();
+    }
+
+    const EncodeContext *ctx;
+    int by0;
+    int by1;
+    QSemaphore *done;
+};
+
+} // namespace
+
+// Blocks per band. Encoding is far more expensive per texel than filtering,
+// so bands are much smaller than in the mipmap generator.
+static const int MIN_BAND_BLOCKS = 1024;
+
+// BC1, BC3 and BC7, UNORM and SRGB. The data is encoded as is, the SRGB
+// variants only differ in how the texture is sampled.
+bool QD3D12BcEncoder::isFormatSupported(DXGI_FORMAT format)
+{
+    BlockKind kind;
+    return blockKind(format, &kind);
+}
+
+// BC7 when allowed, otherwise BC1 for opaque images and BC3 for the rest.
+DXGI_FORMAT QD3D12BcEncoder::selectFormat(const QImage &image, bool allowBc7)
+{
+    if (allowBc7)
+        return DXGI_FORMAT_BC7_UNORM;
+    if (!image.hasAlphaChannel())
+        return DXGI_FORMAT_BC1_UNORM;
+
+    const QImage img = image.convertToFormat(QImage::Format_RGBA8888);
+    for (int y = 0; y < img.height(); ++y) {
+        const uchar *p = img.constScanLine(y);
+        for (int x = 0; x < img.width(); ++x) {
+            if (p[x * 4 + 3] != 0xFF)
+                return DXGI_FORMAT_BC3_UNORM;
+        }
+    }
+    return DXGI_FORMAT_BC1_UNORM;
+}
+
+// Compresses RGBA8 data of the given size into rows of 4x4 blocks at dst,
+// dstRowPitch bytes apart (the RowPitch of the footprint). Partial blocks at
+// the right and bottom edges repeat the last column and row. Large images
+// are split into bands of block rows processed on the global thread pool.
+bool QD3D12BcEncoder::encode(const uchar *src, quint32 srcRowPitch, const QSize &size, DXGI_FORMAT format,
+                             quint8 *dst, quint32 dstRowPitch, Quality quality)
+{
+    EncodeContext ctx;
+    if (!blockKind(format, &ctx.kind)) {
+        qWarning("QD3D12BcEncoder: Unsupported format %d", int(format));
+        return false;
+    }
+    if (size.isEmpty())
+        return false;
+
+    ctx.quality = quality;
+    ctx.src = src;
+    ctx.srcPitch = srcRowPitch;
+    ctx.width = size.width();
+    ctx.height = size.height();
+    ctx.dst = dst;
+    ctx.dstPitch = dstRowPitch;
+
+    const int blocksX = (ctx.width + 3) / 4;
+    const int blocksY = (ctx.height + 3) / 4;
+    QThreadPool *pool = QThreadPool::globalInstance();
+    const int bands = qBound(1, qMin(blocksX * blocksY / MIN_BAND_BLOCKS, pool->maxThreadCount() + 1), blocksY);
+    if (bands == 1) {
+        encodeBlockRows(ctx, 0, blocksY);
+        return true;
+    }
+
+    // Same scheme as in QD3D12CpuMipmapGenerator: the first band runs here,
+    // bands the pool has no room for too.
+    QSemaphore done;
+    const int rowsPerBand = (blocksY + bands - 1) / bands;
+    int started = 0;
+    for (int by = rowsPerBand; by < blocksY; by += rowsPerBand) {
+        QD3D12BcRowsJob *job = new QD3D12BcRowsJob(&ctx, by, qMin(by + rowsPerBand, blocksY), &done);
+        if (pool->tryStart(job)) {
+            ++started;
+        } else {
+            job->run();
+            delete job;
+        }
+    }
+    encodeBlockRows(ctx, 0, qMin(rowsPerBand, blocksY));
+    done.acquire(started);
+    return true;
+}
+
+// Builds the mip chain of image (filtered as sRGB, like the texture loader
+// does) and compresses every level into the upload buffer dst, laid out as
+// returned by GetCopyableFootprints() for a texture of the given format.
+bool QD3D12BcEncoder::encodeImage(const QImage &image, DXGI_FORMAT format,
+                                  quint8 *dst, const D3D12_PLACED_SUBRESOURCE_FOOTPRINT *footprints, int mipLevels,
+                                  Quality quality)
+{
+    if (!isFormatSupported(format)) {
+        qWarning("QD3D12BcEncoder: Unsupported format %d", int(format));
+        return false;
+    }
+    if (image.isNull() || mipLevels < 1)
+        return false;
+
+    const QImage img = image.convertToFormat(QImage::Format_RGBA8888);
+    int w = img.width();
+    int h = img.height();
+
+    // Tightly packed RGBA8 levels.
+    QVector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> layouts(mipLevels);
+    QVector<QSize> sizes(mipLevels);
+    quint64 size = 0;
+    for (int level = 0; level < mipLevels; ++level) {
+        layouts[level].Offset = size;
+        layouts[level].Footprint.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+        layouts[level].Footprint.Width = w;
+        layouts[level].Footprint.Height = h;
+        layouts[level].Footprint.Depth = 1;
+        layouts[level].Footprint.RowPitch = w * 4;
+        sizes[level] = QSize(w, h);
+        size += w * h * 4;
+        w = qMax(1, w / 2);
+        h = qMax(1, h / 2);
+    }
+    QByteArray chain(int(size), Qt::Uninitialized);
+    quint8 *chainData = reinterpret_cast<quint8 *>(chain.data());
+    if (!QD3D12CpuMipmapGenerator::generate(img.constBits(), img.bytesPerLine(), img.size(),
+                                            DXGI_FORMAT_R8G8B8A8_UNORM_SRGB, chainData, layouts.constData(), mipLevels))
+        return false;
+
+    for (int level = 0; level < mipLevels; ++level) {
+        encode(chainData + layouts[level].Offset, layouts[level].Footprint.RowPitch, sizes[level], format,
+               dst + footprints[level].Offset, footprints[level].Footprint.RowPitch, quality);
+    }
+    return true;
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,69 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtD3D12Window module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#ifndef QD3D12BCENCODER_H
+#define QD3D12BCENCODER_H
+
+#include <QtCore/QSize>
+#include <QtD3D12Window/qd3d12window.h>
+
+QT_BEGIN_NAMESPACE
+
+class QImage;
+
+class QD3D12_EXPORT QD3D12BcEncoder
+{
+public:
+    enum Quality {
+        FastQuality,
+        NormalQuality,
+        HighQuality
+    };
+
+    static bool isFormatSupported(DXGI_FORMAT format);
+    static DXGI_FORMAT selectFormat(const QImage &image, bool allowBc7 = false);
+
+    static bool encode(const uchar *src, quint32 srcRowPitch, const QSize &size, DXGI_FORMAT format,
+                       quint8 *dst, quint32 dstRowPitch, Quality quality = NormalQuality);
+    static bool encodeImage(const QImage &image, DXGI_FORMAT format,
+                            quint8 *dst, const D3D12_PLACED_SUBRESOURCE_FOOTPRINT *footprints, int mipLevels,
+                            Quality quality = NormalQuality);
+};
+
+QT_END_NAMESPACE
+
+#endif
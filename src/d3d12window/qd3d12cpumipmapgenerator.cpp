@@ -0,0 +1,549 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtD3D12Window module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qd3d12cpumipmapgenerator.h"
+#include <QtCore/QRunnable>
+#include <QtCore/QSemaphore>
+#include <QtCore/QThreadPool>
+#include <QtCore/QVector>
+#include <QtCore/private/qsimd_p.h>
+#include <qmath.h>
+
+QT_BEGIN_NAMESPACE
+
+enum PixelKind {
+    Unorm8,
+    Srgb8,
+    Float32
+};
+
+static bool pixelKind(DXGI_FORMAT format, PixelKind *kind)
+{
+    switch (format) {
+    case DXGI_FORMAT_R8G8B8A8_TYPELESS:
+    case DXGI_FORMAT_R8G8B8A8_UNORM:
+    case DXGI_FORMAT_B8G8R8A8_TYPELESS:
+    case DXGI_FORMAT_B8G8R8A8_UNORM:
+    case DXGI_FORMAT_B8G8R8X8_UNORM:
+        *kind = Unorm8;
+        return true;
+    case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+    case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+    case DXGI_FORMAT_B8G8R8X8_UNORM_SRGB:
+        *kind = Srgb8;
+        return true;
+    case DXGI_FORMAT_R32G32B32A32_FLOAT:
+        *kind = Float32;
+        return true;
+    default:
+        return false;
+    }
+}
+
+static inline int bytesPerPixel(PixelKind kind)
+{
+    return kind == Float32 ? 16 : 4;
+}
+
+struct SrgbTables
+{
+    SrgbTables()
+    {
+        for (int i = 0; i < 256; ++i) {
+            const float c = i / 255.0f;
+            toLinear[i] = c <= 0.04045f ? c / 12.92f : qPow((c + 0.055f) / 1.055f, 2.4f);
+        }
+        for (int i = 0; i < 4096; ++i) {
+            const float l = i / 4095.0f;
+            const float c = l <= 0.0031308f ? l * 12.92f : 1.055f * qPow(l, 1.0f / 2.4f) - 0.055f;
+            fromLinear[i] = uchar(qBound(0, int(c * 255.0f + 0.5f), 255));
+        }
+    }
+
+    float toLinear[256];
+    uchar fromLinear[4096];
+};
+
+Q_GLOBAL_STATIC(SrgbTables, srgbTables)
+
+static inline uchar linearToSrgb(const SrgbTables *t, float v)
+{
+    return t->fromLinear[qBound(0, int(v * 4095.0f + 0.5f), 4095)];
+}
+
+static inline void loadPixel(PixelKind kind, const SrgbTables *t, const uchar *p, float *v)
+{
+    switch (kind) {
+    case Unorm8:
+        for (int c = 0; c < 4; ++c)
+            v[c] = p[c] * (1.0f / 255.0f);
+        break;
+    case Srgb8:
+        for (int c = 0; c < 3; ++c)
+            v[c] = t->toLinear[p[c]];
+        v[3] = p[3] * (1.0f / 255.0f);
+        break;
+    case Float32:
+        memcpy(v, p, 16);
+        break;
+    }
+}
+
+static inline void storePixel(PixelKind kind, const SrgbTables *t, const float *v, uchar *p)
+{
+    switch (kind) {
+    case Unorm8:
+        for (int c = 0; c < 4; ++c)
+            p[c] = uchar(qBound(0, int(v[c] * 255.0f + 0.5f), 255));
+        break;
+    case Srgb8:
+        for (int c = 0; c < 3; ++c)
+            p[c] = linearToSrgb(t, v[c]);
+        p[3] = uchar(qBound(0, int(v[3] * 255.0f + 0.5f), 255));
+        break;
+    case Float32:
+        memcpy(p, v, 16);
+        break;
+    }
+}
+
+// 2x2 box kernels for exact halving. Each reads two source rows and writes
+// dstWidth pixels.
+
+static void boxRowUnorm8(const uchar *r0, const uchar *r1, uchar *out, int dstWidth)
+{
+    for (int x = 0; x < dstWidth; ++x) {
+        for (int c = 0; c < 4; ++c)
+            out[x * 4 + c] = uchar((r0[x * 8 + c] + r0[x * 8 + 4 + c] + r1[x * 8 + c] + r1[x * 8 + 4 + c] + 2) >> 2);
+    }
+}
+
+static void boxRowSrgb8(const uchar *r0, const uchar *r1, uchar *out, int dstWidth)
+{
+    const SrgbTables *t = srgbTables();
+    for (int x = 0; x < dstWidth; ++x) {
+        for (int c = 0; c < 3; ++c) {
+            const float l = t->toLinear[r0[x * 8 + c]] + t->toLinear[r0[x * 8 + 4 + c]]
+                    + t->toLinear[r1[x * 8 + c]] + t->toLinear[r1[x * 8 + 4 + c]];
+            out[x * 4 + c] = linearToSrgb(t, l * 0.25f);
+        }
+        out[x * 4 + 3] = uchar((r0[x * 8 + 3] + r0[x * 8 + 7] + r1[x * 8 + 3] + r1[x * 8 + 7] + 2) >> 2);
+    }
+}
+
+static void boxRowFloat32(const uchar *r0, const uchar *r1, uchar *out, int dstWidth)
+{
+    const float *a = reinterpret_cast<const float *>(r0);
+    const float *b = reinterpret_cast<const float *>(r1);
+    float *o = reinterpret_cast<float *>(out);
+    for (int x = 0; x < dstWidth; ++x) {
+        for (int c = 0; c < 4; ++c)
+            o[x * 4 + c] = (a[x * 8 + c] + a[x * 8 + 4 + c] + b[x * 8 + c] + b[x * 8 + 4 + c]) * 0.25f;
+    }
+}
+
+#ifdef __SSE2__
+static void boxRowUnorm8_sse2(const uchar *r0, const uchar *r1, uchar *out, int dstWidth)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i two = _mm_set1_epi16(2);
+    int x = 0;
+    for (; x + 2 <= dstWidth; x += 2) {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(r0 + x * 8));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(r1 + x * 8));
+        // 16 bit lanes: source pixels 0,1 and 2,3 summed vertically
+        const __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+        const __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+        __m128i sum = _mm_add_epi16(_mm_unpacklo_epi64(lo, hi), _mm_unpackhi_epi64(lo, hi));
+        sum = _mm_srli_epi16(_mm_add_epi16(sum, two), 2);
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(out + x * 4), _mm_packus_epi16(sum, sum));
+    }
+    boxRowUnorm8(r0 + x * 8, r1 + x * 8, out + x * 4, dstWidth - x);
+}
+
+static void boxRowFloat32_sse2(const uchar *r0, const uchar *r1, uchar *out, int dstWidth)
+{
+    const float *a = reinterpret_cast<const float *>(r0);
+    const float *b = reinterpret_cast<const float *>(r1);
+    float *o = reinterpret_cast<float *>(out);
+    const __m128 quarter = _mm_set1_ps(0.25f);
+    for (int x = 0; x < dstWidth; ++x) {
+        const __m128 top = _mm_add_ps(_mm_loadu_ps(a + x * 8), _mm_loadu_ps(a + x * 8 + 4));
+        const __m128 bottom = _mm_add_ps(_mm_loadu_ps(b + x * 8), _mm_loadu_ps(b + x * 8 + 4));
+        _mm_storeu_ps(o + x * 4, _mm_mul_ps(_mm_add_ps(top, bottom), quarter));
+    }
+}
+#endif
+
+#if QT_COMPILER_SUPPORTS_HERE(AVX2)
+QT_FUNCTION_TARGET(AVX2)
+static void boxRowUnorm8_avx2(const uchar *r0, const uchar *r1, uchar *out, int dstWidth)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i two = _mm256_set1_epi16(2);
+    int x = 0;
+    for (; x + 4 <= dstWidth; x += 4) {
+        const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(r0 + x * 8));
+        const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(r1 + x * 8));
+        // Per 128 bit lane as in the SSE2 version: [0,1 | 4,5] and [2,3 | 6,7]
+        const __m256i lo = _mm256_add_epi16(_mm256_unpacklo_epi8(a, zero), _mm256_unpacklo_epi8(b, zero));
+        const __m256i hi = _mm256_add_epi16(_mm256_unpackhi_epi8(a, zero), _mm256_unpackhi_epi8(b, zero));
+        __m256i sum = _mm256_add_epi16(_mm256_unpacklo_epi64(lo, hi), _mm256_unpackhi_epi64(lo, hi));
+        sum = _mm256_srli_epi16(_mm256_add_epi16(sum, two), 2);
+        // The low quadword of each lane holds two results, gather them.
+        const __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(sum, sum), 0x08);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + x * 4), _mm256_castsi256_si128(packed));
+    }
+    boxRowUnorm8(r0 + x * 8, r1 + x * 8, out + x * 4, dstWidth - x);
+}
+
+QT_FUNCTION_TARGET(AVX2)
+static void boxRowFloat32_avx2(const uchar *r0, const uchar *r1, uchar *out, int dstWidth)
+{
+    const float *a = reinterpret_cast<const float *>(r0);
+    const float *b = reinterpret_cast<const float *>(r1);
+    float *o = reinterpret_cast<float *>(out);
+    const __m256 quarter = _mm256_set1_ps(0.25f);
+    int x = 0;
+    for (; x + 2 <= dstWidth; x += 2) {
+        const __m256 s0 = _mm256_add_ps(_mm256_loadu_ps(a + x * 8), _mm256_loadu_ps(b + x * 8));
+        const __m256 s1 = _mm256_add_ps(_mm256_loadu_ps(a + x * 8 + 8), _mm256_loadu_ps(b + x * 8 + 8));
+        const __m256 even = _mm256_permute2f128_ps(s0, s1, 0x20);
+        const __m256 odd = _mm256_permute2f128_ps(s0, s1, 0x31);
+        _mm256_storeu_ps(o + x * 4, _mm256_mul_ps(_mm256_add_ps(even, odd), quarter));
+    }
+    boxRowFloat32(r0 + x * 32, r1 + x * 32, out + x * 16, dstWidth - x);
+}
+#endif
+
+typedef void (*BoxRowFunc)(const uchar *r0, const uchar *r1, uchar *out, int dstWidth);
+
+static BoxRowFunc boxRowFunc(PixelKind kind)
+{
+    switch (kind) {
+    case Unorm8:
+#if QT_COMPILER_SUPPORTS_HERE(AVX2)
+        if (qCpuHasFeature(AVX2))
+            return boxRowUnorm8_avx2;
+#endif
+#ifdef __SSE2__
+        return boxRowUnorm8_sse2;
+#else
+        return boxRowUnorm8;
+#endif
+    case Srgb8:
+        // Dominated by the table lookups, vectorizing does not gain much.
+        return boxRowSrgb8;
+    case Float32:
+#if QT_COMPILER_SUPPORTS_HERE(AVX2)
+        if (qCpuHasFeature(AVX2))
+            return boxRowFloat32_avx2;
+#endif
+#ifdef __SSE2__
+        return boxRowFloat32_sse2;
+#else
+        return boxRowFloat32;
+#endif
+    }
+    return Q_NULLPTR;
+}
+
+// Filter taps along one axis. For the box filter the weights are the
+// overlap of each source texel with the destination texel's footprint, which
+// is exact for odd (non-power-of-two) sizes as well. The Kaiser filter is a
+// Kaiser windowed sinc, sharper than the box but more expensive.
+struct FilterTaps
+{
+    int maxTaps;
+    QVector<int> first;
+    QVector<float> weights; // maxTaps per destination texel
+};
+
+static const float KAISER_ALPHA = 4.0f;
+static const float KAISER_RADIUS = 1.5f; // in destination texels
+
+static float besselI0(float x)
+{
+    float sum = 1.0f;
+    float term = 1.0f;
+    for (int k = 1; k < 20; ++k) {
+        term *= (x / (2 * k)) * (x / (2 * k));
+        sum += term;
+        if (term < sum * 1e-7f)
+            break;
+    }
+    return sum;
+}
+
+static float kaiserSinc(float u)
+{
+    const float t = u / KAISER_RADIUS;
+    if (qAbs(t) >= 1.0f)
+        return 0.0f;
+    const float sinc = qFuzzyIsNull(u) ? 1.0f : qSin(float(M_PI) * u) / (float(M_PI) * u);
+    return sinc * besselI0(KAISER_ALPHA * qSqrt(1.0f - t * t)) / besselI0(KAISER_ALPHA);
+}
+
+static void computeTaps(int srcSize, int dstSize, QD3D12CpuMipmapGenerator::Filter filter, FilterTaps *taps)
+{
+    const float scale = float(srcSize) / dstSize;
+    if (filter == QD3D12CpuMipmapGenerator::BoxFilter)
+        taps->maxTaps = qCeil(scale) + 1;
+    else
+        taps->maxTaps = qCeil(2 * KAISER_RADIUS * scale) + 2;
+
+    taps->first.resize(dstSize);
+    taps->weights.fill(0.0f, dstSize * taps->maxTaps);
+
+    for (int x = 0; x < dstSize; ++x) {
+        float *w = taps->weights.data() + x * taps->maxTaps;
+        float total = 0.0f;
+        if (filter == QD3D12CpuMipmapGenerator::BoxFilter) {
+            const float lo = x * scale;
+            const float hi = (x + 1) * scale;
+            const int first = qFloor(lo);
+            taps->first[x] = first;
+            for (int k = 0; k < taps->maxTaps; ++k) {
+                const float overlap = qMin(hi, float(first + k + 1)) - qMax(lo, float(first + k));
+                w[k] = qMax(0.0f, overlap);
+                total += w[k];
+            }
+        } else {
+            const float center = (x + 0.5f) * scale;
+            const int first = qFloor(center - KAISER_RADIUS * scale);
+            taps->first[x] = first;
+            for (int k = 0; k < taps->maxTaps; ++k) {
+                w[k] = kaiserSinc((first + k + 0.5f - center) / scale);
+                total += w[k];
+            }
+        }
+        for (int k = 0; k < taps->maxTaps; ++k)
+            w[k] /= total;
+    }
+}
+
+struct MipLevelContext
+{
+    PixelKind kind;
+    const uchar *src;
+    quint32 srcPitch;
+    int srcWidth;
+    int srcHeight;
+    uchar *scratch; // the destination level, tightly packed, source of the next level
+    int dstWidth;
+    int dstHeight;
+    quint8 *upload;
+    D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint;
+    BoxRowFunc boxRow; // null unless the level is an exact 2x2 box reduction
+    FilterTaps tapsX;
+    FilterTaps tapsY;
+};
+
+static void filterRows(const MipLevelContext &ctx, int y0, int y1)
+{
+    const int bpp = bytesPerPixel(ctx.kind);
+    const quint32 dstPitch = ctx.dstWidth * bpp;
+
+    if (ctx.boxRow) {
+        for (int y = y0; y < y1; ++y) {
+            const uchar *r0 = ctx.src + 2 * y * ctx.srcPitch;
+            uchar *out = ctx.scratch + y * dstPitch;
+            ctx.boxRow(r0, r0 + ctx.srcPitch, out, ctx.dstWidth);
+            memcpy(ctx.upload + ctx.footprint.Offset + y * ctx.footprint.Footprint.RowPitch, out, dstPitch);
+        }
+        return;
+    }
+
+    // Separable: filter vertically into a row of floats, then horizontally.
+    const SrgbTables *t = srgbTables();
+    QVector<float> column(ctx.srcWidth * 4);
+    float pixel[4];
+    for (int y = y0; y < y1; ++y) {
+        column.fill(0.0f);
+        const float *wy = ctx.tapsY.weights.constData() + y * ctx.tapsY.maxTaps;
+        for (int k = 0; k < ctx.tapsY.maxTaps; ++k) {
+            if (wy[k] == 0.0f)
+                continue;
+            const int sy = qBound(0, ctx.tapsY.first[y] + k, ctx.srcHeight - 1);
+            const uchar *row = ctx.src + sy * ctx.srcPitch;
+            for (int x = 0; x < ctx.srcWidth; ++x) {
+                loadPixel(ctx.kind, t, row + x * bpp, pixel);
+                for (int c = 0; c < 4; ++c)
+                    column[x * 4 + c] += wy[k] * pixel[c];
+            }
+        }
+
+        uchar *out = ctx.scratch + y * dstPitch;
+        for (int x = 0; x < ctx.dstWidth; ++x) {
+            const float *wx = ctx.tapsX.weights.constData() + x * ctx.tapsX.maxTaps;
+            float sum[4] = { 0, 0, 0, 0 };
+            for (int k = 0; k < ctx.tapsX.maxTaps; ++k) {
+                const int sx = qBound(0, ctx.tapsX.first[x] + k, ctx.srcWidth - 1);
+                for (int c = 0; c < 4; ++c)
+                    sum[c] += wx[k] * column[sx * 4 + c];
+            }
+            storePixel(ctx.kind, t, sum, out + x * bpp);
+        }
+        memcpy(ctx.upload + ctx.footprint.Offset + y * ctx.footprint.Footprint.RowPitch, out, dstPitch);
+    }
+}
+
+namespace {
+
+class QD3D12MipRowsJob : public QRunnable
+{
+public:
+    QD3D12MipRowsJob(const MipLevelContext *ctx, int y0, int y1, QSemaphore *done)
+        : ctx(ctx), y0(y0), y1(y1), done(done)
+    { }
+
+    void run() Q_DECL_OVERRIDE
+    {
+        filterRows(*ctx, y0, y1);
+        done->release();
+    }
+
+    const MipLevelContext *ctx;
+    int y0;
+    int y1;
+    QSemaphore *done;
+};
+
+} // namespace
+
+// Destination pixels per band. Small levels are not worth going parallel.
+static const int MIN_BAND_PIXELS = 64 * 1024;
+
+static void filterLevel(const MipLevelContext &ctx)
+{
+    QThreadPool *pool = QThreadPool::globalInstance();
+    const int pixels = ctx.dstWidth * ctx.dstHeight;
+    const int bands = qBound(1, qMin(pixels / MIN_BAND_PIXELS, pool->maxThreadCount() + 1), ctx.dstHeight);
+    if (bands == 1) {
+        filterRows(ctx, 0, ctx.dstHeight);
+        return;
+    }
+
+    // The first band runs on the calling thread. When the pool is busy the
+    // other bands do too, so this is safe to call from a pool thread.
+    QSemaphore done;
+    const int rowsPerBand = (ctx.dstHeight + bands - 1) / bands;
+    int started = 0;
+    for (int y = rowsPerBand; y < ctx.dstHeight; y += rowsPerBand) {
+        QD3D12MipRowsJob *job = new QD3D12MipRowsJob(&ctx, y, qMin(y + rowsPerBand, ctx.dstHeight), &done);
+        if (pool->tryStart(job)) {
+            ++started;
+        } else {
+            job->run();
+            delete job;
+        }
+    }
+    filterRows(ctx, 0, qMin(rowsPerBand, ctx.dstHeight));
+    done.acquire(started);
+}
+
+// 8 bit RGBA/BGRA, UNORM and SRGB, and R32G32B32A32_FLOAT.
+bool QD3D12CpuMipmapGenerator::isFormatSupported(DXGI_FORMAT format)
+{
+    PixelKind kind;
+    return pixelKind(format, &kind);
+}
+
+// Builds the mip chain of a 2D image on the CPU, each level from the
+// previous one, and writes every level, including the first, directly into
+// the upload buffer dst using the layouts from GetCopyableFootprints().
+// Levels that are exact halvings with the box filter use SSE2 or AVX2,
+// chosen at runtime; odd sizes and the Kaiser filter take the separable
+// path. sRGB formats are filtered in linear space. Large levels are split
+// into bands of rows processed on the global thread pool.
+bool QD3D12CpuMipmapGenerator::generate(const uchar *src, quint32 srcRowPitch, const QSize &size, DXGI_FORMAT format,
+                                        quint8 *dst, const D3D12_PLACED_SUBRESOURCE_FOOTPRINT *footprints, int mipLevels,
+                                        Filter filter)
+{
+    PixelKind kind;
+    if (!pixelKind(format, &kind)) {
+        qWarning("QD3D12CpuMipmapGenerator: Unsupported format %d", int(format));
+        return false;
+    }
+    if (size.isEmpty() || mipLevels < 1)
+        return false;
+
+    const int bpp = bytesPerPixel(kind);
+    int w = size.width();
+    int h = size.height();
+
+    for (int y = 0; y < h; ++y)
+        memcpy(dst + footprints[0].Offset + y * footprints[0].Footprint.RowPitch, src + y * srcRowPitch, w * bpp);
+
+    // Odd levels go to the first scratch buffer, even ones to the second.
+    QByteArray scratch[2];
+    scratch[0].resize(qMax(1, w / 2) * qMax(1, h / 2) * bpp);
+    scratch[1].resize(qMax(1, w / 4) * qMax(1, h / 4) * bpp);
+
+    MipLevelContext ctx;
+    ctx.kind = kind;
+    ctx.src = src;
+    ctx.srcPitch = srcRowPitch;
+    ctx.upload = dst;
+
+    for (int level = 1; level < mipLevels; ++level) {
+        ctx.srcWidth = w;
+        ctx.srcHeight = h;
+        w = qMax(1, w / 2);
+        h = qMax(1, h / 2);
+        ctx.dstWidth = w;
+        ctx.dstHeight = h;
+        ctx.scratch = reinterpret_cast<uchar *>(scratch[(level - 1) % 2].data());
+        ctx.footprint = footprints[level];
+
+        if (filter == BoxFilter && ctx.srcWidth == 2 * w && ctx.srcHeight == 2 * h) {
+            ctx.boxRow = boxRowFunc(kind);
+        } else {
+            ctx.boxRow = Q_NULLPTR;
+            computeTaps(ctx.srcWidth, w, filter, &ctx.tapsX);
+            computeTaps(ctx.srcHeight, h, filter, &ctx.tapsY);
+        }
+
+        filterLevel(ctx);
+
+        ctx.src = ctx.scratch;
+        ctx.srcPitch = w * bpp;
+    }
+
+    return true;
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,616 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtD3D12Window module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qd3d12ddstexture_p.h"
+#include "qd3d12util_p.h"
+#include "qd3d12formatinfo.h"
+
+QT_BEGIN_NAMESPACE
+
+static const quint32 DDS_MAGIC = 0x20534444; // 'DDS '
+
+#define QD3D12_FOURCC(c0, c1, c2, c3) (quint32(c0) | (quint32(c1) << 8) | (quint32(c2) << 16) | (quint32(c3) << 24))
+
+// DDS_PIXELFORMAT flags
+static const quint32 DDPF_ALPHA = 0x2;
+static const quint32 DDPF_FOURCC = 0x4;
+static const quint32 DDPF_RGB = 0x40;
+static const quint32 DDPF_LUMINANCE = 0x20000;
+static const quint32 DDPF_BUMPDUDV = 0x80000;
+
+// DDS_HEADER flags and caps
+static const quint32 DDSD_MIPMAPCOUNT = 0x20000;
+static const quint32 DDSD_DEPTH = 0x800000;
+static const quint32 DDSCAPS2_CUBEMAP = 0x200;
+static const quint32 DDSCAPS2_CUBEMAP_ALLFACES = 0xFC00;
+static const quint32 DDSCAPS2_VOLUME = 0x200000;
+
+// DDS_HEADER_DXT10
+static const quint32 DDS_DIMENSION_TEXTURE1D = 2;
+static const quint32 DDS_DIMENSION_TEXTURE2D = 3;
+static const quint32 DDS_DIMENSION_TEXTURE3D = 4;
+static const quint32 DDS_RESOURCE_MISC_TEXTURECUBE = 0x4;
+
+struct DdsPixelFormat {
+    quint32 size;
+    quint32 flags;
+    quint32 fourCC;
+    quint32 rgbBitCount;
+    quint32 rBitMask;
+    quint32 gBitMask;
+    quint32 bBitMask;
+    quint32 aBitMask;
+};
+
+struct DdsHeader {
+    quint32 size;
+    quint32 flags;
+    quint32 height;
+    quint32 width;
+    quint32 pitch;
+    quint32 depth;
+    quint32 mipMapCount;
+    quint32 reserved1[11];
+    DdsPixelFormat pixelFormat;
+    quint32 caps;
+    quint32 caps2;
+    quint32 caps3;
+    quint32 caps4;
+    quint32 reserved2;
+};
+
+struct DdsHeaderDxt10 {
+    quint32 dxgiFormat;
+    quint32 resourceDimension;
+    quint32 miscFlag;
+    quint32 arraySize;
+    quint32 miscFlags2;
+};
+
+static bool isBitMask(const DdsPixelFormat &pf, quint32 r, quint32 g, quint32 b, quint32 a)
+{
+    return pf.rBitMask == r && pf.gBitMask == g && pf.bBitMask == b && pf.aBitMask == a;
+}
+
+// Maps the pre-DX10 pixel format description to a DXGI format. Formats
+// without a DXGI equivalent (24 bit RGB for instance) give UNKNOWN.
+static DXGI_FORMAT legacyFormat(const DdsPixelFormat &pf)
+{
+    if (pf.flags & DDPF_FOURCC) {
+        switch (pf.fourCC) {
+        case QD3D12_FOURCC('D', 'X', 'T', '1'):
+            return DXGI_FORMAT_BC1_UNORM;
+        case QD3D12_FOURCC('D', 'X', 'T', '2'):
+        case QD3D12_FOURCC('D', 'X', 'T', '3'):
+            return DXGI_FORMAT_BC2_UNORM;
+        case QD3D12_FOURCC('D', 'X', 'T', '4'):
+        case QD3D12_FOURCC('D', 'X', 'T', '5'):
+            return DXGI_FORMAT_BC3_UNORM;
+        case QD3D12_FOURCC('A', 'T', 'I', '1'):
+        case QD3D12_FOURCC('B', 'C', '4', 'U'):
+            return DXGI_FORMAT_BC4_UNORM;
+        case QD3D12_FOURCC('B', 'C', '4', 'S'):
+            return DXGI_FORMAT_BC4_SNORM;
+        case QD3D12_FOURCC('A', 'T', 'I', '2'):
+        case QD3D12_FOURCC('B', 'C', '5', 'U'):
+            return DXGI_FORMAT_BC5_UNORM;
+        case QD3D12_FOURCC('B', 'C', '5', 'S'):
+            return DXGI_FORMAT_BC5_SNORM;
+        case QD3D12_FOURCC('R', 'G', 'B', 'G'):
+            return DXGI_FORMAT_R8G8_B8G8_UNORM;
+        case QD3D12_FOURCC('G', 'R', 'G', 'B'):
+            return DXGI_FORMAT_G8R8_G8B8_UNORM;
+        case QD3D12_FOURCC('Y', 'U', 'Y', '2'):
+            return DXGI_FORMAT_YUY2;
+        // D3DFORMAT values stored directly in the fourCC field
+        case 36:
+            return DXGI_FORMAT_R16G16B16A16_UNORM;
+        case 110:
+            return DXGI_FORMAT_R16G16B16A16_SNORM;
+        case 111:
+            return DXGI_FORMAT_R16_FLOAT;
+        case 112:
+            return DXGI_FORMAT_R16G16_FLOAT;
+        case 113:
+            return DXGI_FORMAT_R16G16B16A16_FLOAT;
+        case 114:
+            return DXGI_FORMAT_R32_FLOAT;
+        case 115:
+            return DXGI_FORMAT_R32G32_FLOAT;
+        case 116:
+            return DXGI_FORMAT_R32G32B32A32_FLOAT;
+        default:
+            return DXGI_FORMAT_UNKNOWN;
+        }
+    }
+
+    if (pf.flags & DDPF_RGB) {
+        switch (pf.rgbBitCount) {
+        case 32:
+            if (isBitMask(pf, 0x000000ff, 0x0000ff00, 0x00ff0000, 0xff000000))
+                return DXGI_FORMAT_R8G8B8A8_UNORM;
+            if (isBitMask(pf, 0x00ff0000, 0x0000ff00, 0x000000ff, 0xff000000))
+                return DXGI_FORMAT_B8G8R8A8_UNORM;
+            if (isBitMask(pf, 0x00ff0000, 0x0000ff00, 0x000000ff, 0))
+                return DXGI_FORMAT_B8G8R8X8_UNORM;
+            // Many writers get the masks for 10:10:10:2 backwards, this is
+            // what the D3DX loaders assume as well.
+            if (isBitMask(pf, 0x3ff00000, 0x000ffc00, 0x000003ff, 0xc0000000))
+                return DXGI_FORMAT_R10G10B10A2_UNORM;
+            if (isBitMask(pf, 0x0000ffff, 0xffff0000, 0, 0))
+                return DXGI_FORMAT_R16G16_UNORM;
+            if (isBitMask(pf, 0xffffffff, 0, 0, 0))
+                return DXGI_FORMAT_R32_FLOAT;
+            break;
+        case 16:
+            if (isBitMask(pf, 0x7c00, 0x03e0, 0x001f, 0x8000))
+                return DXGI_FORMAT_B5G5R5A1_UNORM;
+            if (isBitMask(pf, 0xf800, 0x07e0, 0x001f, 0))
+                return DXGI_FORMAT_B5G6R5_UNORM;
+            if (isBitMask(pf, 0x0f00, 0x00f0, 0x000f, 0xf000))
+                return DXGI_FORMAT_B4G4R4A4_UNORM;
+            break;
+        default:
+            break;
+        }
+    } else if (pf.flags & DDPF_LUMINANCE) {
+        if (pf.rgbBitCount == 8 && isBitMask(pf, 0xff, 0, 0, 0))
+            return DXGI_FORMAT_R8_UNORM;
+        if (pf.rgbBitCount == 16 && isBitMask(pf, 0xffff, 0, 0, 0))
+            return DXGI_FORMAT_R16_UNORM;
+        if (pf.rgbBitCount == 16 && isBitMask(pf, 0x00ff, 0, 0, 0xff00))
+            return DXGI_FORMAT_R8G8_UNORM;
+    } else if (pf.flags & DDPF_ALPHA) {
+        if (pf.rgbBitCount == 8)
+            return DXGI_FORMAT_A8_UNORM;
+    } else if (pf.flags & DDPF_BUMPDUDV) {
+        if (pf.rgbBitCount == 16 && isBitMask(pf, 0x00ff, 0xff00, 0, 0))
+            return DXGI_FORMAT_R8G8_SNORM;
+        if (pf.rgbBitCount == 32 && isBitMask(pf, 0x000000ff, 0x0000ff00, 0x00ff0000, 0xff000000))
+            return DXGI_FORMAT_R8G8B8A8_SNORM;
+        if (pf.rgbBitCount == 32 && isBitMask(pf, 0x0000ffff, 0xffff0000, 0, 0))
+            return DXGI_FORMAT_R16G16_SNORM;
+    }
+
+    return DXGI_FORMAT_UNKNOWN;
+}
+
+void QD3D12DdsTexturePrivate::reset()
+{
+    format = DXGI_FORMAT_UNKNOWN;
+    dimension = D3D12_RESOURCE_DIMENSION_UNKNOWN;
+    size = QSize();
+    depth = 1;
+    arraySize = 1;
+    mipLevels = 1;
+    cubeMap = false;
+    subresources.clear();
+}
+
+bool QD3D12DdsTexturePrivate::parse()
+{
+    reset();
+
+    qint64 pos = 0;
+    if (dataSize < qint64(sizeof(quint32) + sizeof(DdsHeader))) {
+        qWarning("DDS: File too small");
+        return false;
+    }
+
+    quint32 magic;
+    memcpy(&magic, data, sizeof(magic));
+    pos += sizeof(magic);
+    if (magic != DDS_MAGIC) {
+        qWarning("DDS: Not a DDS file");
+        return false;
+    }
+
+    DdsHeader header;
+    memcpy(&header, data + pos, sizeof(header));
+    pos += sizeof(header);
+    if (header.size != sizeof(DdsHeader) || header.pixelFormat.size != sizeof(DdsPixelFormat)) {
+        qWarning("DDS: Invalid header");
+        return false;
+    }
+
+    // The header values stay unsigned until they are checked against the
+    // D3D12 limits below.
+    const quint32 width = qMax<quint32>(1, header.width);
+    quint32 height = qMax<quint32>(1, header.height);
+    quint32 volumeDepth = 1;
+    quint32 slices = 1;
+    const quint32 levels = (header.flags & DDSD_MIPMAPCOUNT) ? qMax<quint32>(1, header.mipMapCount) : 1;
+
+    if ((header.pixelFormat.flags & DDPF_FOURCC) && header.pixelFormat.fourCC == QD3D12_FOURCC('D', 'X', '1', '0')) {
+        if (dataSize < pos + qint64(sizeof(DdsHeaderDxt10))) {
+            qWarning("DDS: File too small for the DX10 header");
+            return false;
+        }
+        DdsHeaderDxt10 dx10;
+        memcpy(&dx10, data + pos, sizeof(dx10));
+        pos += sizeof(dx10);
+
+        format = DXGI_FORMAT(dx10.dxgiFormat);
+        slices = qMax<quint32>(1, dx10.arraySize);
+        switch (dx10.resourceDimension) {
+        case DDS_DIMENSION_TEXTURE1D:
+            dimension = D3D12_RESOURCE_DIMENSION_TEXTURE1D;
+            height = 1;
+            break;
+        case DDS_DIMENSION_TEXTURE2D:
+            dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+            cubeMap = (dx10.miscFlag & DDS_RESOURCE_MISC_TEXTURECUBE) != 0;
+            break;
+        case DDS_DIMENSION_TEXTURE3D:
+            dimension = D3D12_RESOURCE_DIMENSION_TEXTURE3D;
+            volumeDepth = qMax<quint32>(1, header.depth);
+            if (slices > 1) {
+                qWarning("DDS: Volume texture arrays are not supported");
+                return false;
+            }
+            break;
+        default:
+            qWarning("DDS: Unknown resource dimension %u", dx10.resourceDimension);
+            return false;
+        }
+    } else {
+        format = legacyFormat(header.pixelFormat);
+        dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+        if (header.caps2 & DDSCAPS2_CUBEMAP) {
+            if ((header.caps2 & DDSCAPS2_CUBEMAP_ALLFACES) != DDSCAPS2_CUBEMAP_ALLFACES) {
+                qWarning("DDS: Cubemaps with missing faces are not supported");
+                return false;
+            }
+            cubeMap = true;
+        } else if ((header.caps2 & DDSCAPS2_VOLUME) && (header.flags & DDSD_DEPTH)) {
+            dimension = D3D12_RESOURCE_DIMENSION_TEXTURE3D;
+            volumeDepth = qMax<quint32>(1, header.depth);
+        }
+    }
+
+    // Anything D3D12 cannot create is rejected before the sizes are used in
+    // any arithmetic, so that bogus headers cannot overflow it.
+    quint32 maxSize = D3D12_REQ_TEXTURE2D_U_OR_V_DIMENSION;
+    quint32 maxSlices = D3D12_REQ_TEXTURE2D_ARRAY_AXIS_DIMENSION;
+    if (dimension == D3D12_RESOURCE_DIMENSION_TEXTURE1D) {
+        maxSize = D3D12_REQ_TEXTURE1D_U_DIMENSION;
+        maxSlices = D3D12_REQ_TEXTURE1D_ARRAY_AXIS_DIMENSION;
+    } else if (dimension == D3D12_RESOURCE_DIMENSION_TEXTURE3D) {
+        maxSize = D3D12_REQ_TEXTURE3D_U_V_OR_W_DIMENSION;
+        maxSlices = 1;
+    } else if (cubeMap) {
+        maxSize = D3D12_REQ_TEXTURECUBE_DIMENSION;
+        maxSlices = D3D12_REQ_TEXTURE2D_ARRAY_AXIS_DIMENSION / 6;
+    }
+    if (width > maxSize || height > maxSize || volumeDepth > maxSize) {
+        qWarning("DDS: Size %ux%ux%u exceeds the limit of %u", width, height, volumeDepth, maxSize);
+        return false;
+    }
+    if (slices > maxSlices) {
+        qWarning("DDS: Array size %u exceeds the limit of %u", slices, maxSlices);
+        return false;
+    }
+    if (levels > D3D12_REQ_MIP_LEVELS) {
+        qWarning("DDS: Invalid mip level count %u", levels);
+        return false;
+    }
+
+    size = QSize(int(width), int(height));
+    depth = int(volumeDepth);
+    arraySize = int(slices) * (cubeMap ? 6 : 1);
+    mipLevels = int(levels);
+
+    const QD3D12FormatInfo formatInfo = QD3D12FormatInfo::forFormat(format);
+    if (!formatInfo.isValid() || formatInfo.testFlag(QD3D12FormatInfo::Planar)) {
+        qWarning("DDS: Unsupported pixel format (DXGI format %d)", int(format));
+        return false;
+    }
+
+    int maxMipLevels = 1;
+    for (int s = qMax(qMax(size.width(), size.height()), depth); s > 1; s >>= 1)
+        ++maxMipLevels;
+    if (mipLevels > maxMipLevels) {
+        qWarning("DDS: Invalid mip level count %d", mipLevels);
+        return false;
+    }
+
+    // The file has the same order as D3D12 subresources: all mip levels of
+    // the first array slice (or cube face), then the next one.
+    subresources.reserve(arraySize * mipLevels);
+    for (int slice = 0; slice < arraySize; ++slice) {
+        int w = size.width();
+        int h = size.height();
+        int d = depth;
+        for (int level = 0; level < mipLevels; ++level) {
+            QD3D12DdsTexture::Subresource sub;
+            sub.rowPitch = formatInfo.rowBytes(w);
+            sub.rowCount = formatInfo.rowCount(h);
+            sub.depth = d;
+            const qint64 bytes = qint64(sub.rowPitch) * sub.rowCount * sub.depth;
+            if (pos + bytes > dataSize) {
+                qWarning("DDS: File is truncated");
+                subresources.clear();
+                return false;
+            }
+            sub.data = data + pos;
+            pos += bytes;
+            subresources.append(sub);
+
+            w = qMax(1, w / 2);
+            h = qMax(1, h / 2);
+            d = qMax(1, d / 2);
+        }
+    }
+
+    return true;
+}
+
+// Reads DirectDraw Surface files: the legacy header with DXT1-5, BC4/BC5
+// and the common uncompressed layouts, as well as the DX10 extended header
+// with any DXGI format that can be stored in a texture, including BC6H and
+// BC7. 1D, 2D and volume textures, texture arrays and cubemaps (also cube
+// arrays) are supported. The file is memory mapped and subresource() points
+// straight into the mapping, nothing is copied until
+// writeSubresources() writes into the upload buffer.
+QD3D12DdsTexture::QD3D12DdsTexture()
+    : d_ptr(new QD3D12DdsTexturePrivate)
+{
+}
+
+QD3D12DdsTexture::~QD3D12DdsTexture()
+{
+}
+
+bool QD3D12DdsTexture::load(const QString &fileName)
+{
+    Q_D(QD3D12DdsTexture);
+    clear();
+
+    d->file.setFileName(fileName);
+    if (!d->file.open(QIODevice::ReadOnly)) {
+        qWarning("Failed to open %s", qPrintable(fileName));
+        return false;
+    }
+
+    d->dataSize = d->file.size();
+    d->data = d->file.map(0, d->dataSize);
+    if (!d->data) {
+        d->buffer = d->file.readAll();
+        d->file.close();
+        d->data = reinterpret_cast<const uchar *>(d->buffer.constData());
+        d->dataSize = d->buffer.size();
+    }
+
+    if (!d->parse()) {
+        qWarning("Failed to load %s", qPrintable(fileName));
+        clear();
+        return false;
+    }
+    return true;
+}
+
+// The data is referenced, not copied.
+bool QD3D12DdsTexture::load(const QByteArray &data)
+{
+    Q_D(QD3D12DdsTexture);
+    clear();
+
+    d->buffer = data;
+    d->data = reinterpret_cast<const uchar *>(d->buffer.constData());
+    d->dataSize = d->buffer.size();
+
+    if (!d->parse()) {
+        clear();
+        return false;
+    }
+    return true;
+}
+
+void QD3D12DdsTexture::clear()
+{
+    Q_D(QD3D12DdsTexture);
+    d->reset();
+    if (d->file.isOpen()) {
+        if (d->data && d->buffer.isEmpty())
+            d->file.unmap(const_cast<uchar *>(d->data));
+        d->file.close();
+    }
+    d->buffer.clear();
+    d->data = Q_NULLPTR;
+    d->dataSize = 0;
+}
+
+bool QD3D12DdsTexture::isValid() const
+{
+    Q_D(const QD3D12DdsTexture);
+    return !d->subresources.isEmpty();
+}
+
+DXGI_FORMAT QD3D12DdsTexture::format() const
+{
+    Q_D(const QD3D12DdsTexture);
+    return d->format;
+}
+
+D3D12_RESOURCE_DIMENSION QD3D12DdsTexture::dimension() const
+{
+    Q_D(const QD3D12DdsTexture);
+    return d->dimension;
+}
+
+QSize QD3D12DdsTexture::size() const
+{
+    Q_D(const QD3D12DdsTexture);
+    return d->size;
+}
+
+int QD3D12DdsTexture::depth() const
+{
+    Q_D(const QD3D12DdsTexture);
+    return d->depth;
+}
+
+// Cube faces count as array slices, a cubemap has an array size of 6.
+int QD3D12DdsTexture::arraySize() const
+{
+    Q_D(const QD3D12DdsTexture);
+    return d->arraySize;
+}
+
+int QD3D12DdsTexture::mipLevels() const
+{
+    Q_D(const QD3D12DdsTexture);
+    return d->mipLevels;
+}
+
+bool QD3D12DdsTexture::isCubeMap() const
+{
+    Q_D(const QD3D12DdsTexture);
+    return d->cubeMap;
+}
+
+int QD3D12DdsTexture::subresourceCount() const
+{
+    Q_D(const QD3D12DdsTexture);
+    return d->subresources.count();
+}
+
+// Indexed like D3D12 subresources: mipLevel + arraySlice * mipLevels().
+QD3D12DdsTexture::Subresource QD3D12DdsTexture::subresource(int index) const
+{
+    Q_D(const QD3D12DdsTexture);
+    return d->subresources.value(index);
+}
+
+D3D12_RESOURCE_DESC QD3D12DdsTexture::resourceDesc() const
+{
+    Q_D(const QD3D12DdsTexture);
+    D3D12_RESOURCE_DESC desc = {};
+    desc.Dimension = d->dimension;
+    desc.Width = d->size.width();
+    desc.Height = d->size.height();
+    desc.DepthOrArraySize = d->dimension == D3D12_RESOURCE_DIMENSION_TEXTURE3D ? d->depth : d->arraySize;
+    desc.MipLevels = d->mipLevels;
+    desc.Format = d->format;
+    desc.SampleDesc.Count = 1;
+    desc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
+    return desc;
+}
+
+D3D12_SHADER_RESOURCE_VIEW_DESC QD3D12DdsTexture::shaderResourceViewDesc() const
+{
+    Q_D(const QD3D12DdsTexture);
+    D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+    srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+    srvDesc.Format = d->format;
+
+    switch (d->dimension) {
+    case D3D12_RESOURCE_DIMENSION_TEXTURE1D:
+        if (d->arraySize > 1) {
+            srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE1DARRAY;
+            srvDesc.Texture1DArray.MipLevels = d->mipLevels;
+            srvDesc.Texture1DArray.ArraySize = d->arraySize;
+        } else {
+            srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE1D;
+            srvDesc.Texture1D.MipLevels = d->mipLevels;
+        }
+        break;
+    case D3D12_RESOURCE_DIMENSION_TEXTURE3D:
+        srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE3D;
+        srvDesc.Texture3D.MipLevels = d->mipLevels;
+        break;
+    default:
+        if (d->cubeMap && d->arraySize > 6) {
+            srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURECUBEARRAY;
+            srvDesc.TextureCubeArray.MipLevels = d->mipLevels;
+            srvDesc.TextureCubeArray.NumCubes = d->arraySize / 6;
+        } else if (d->cubeMap) {
+            srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURECUBE;
+            srvDesc.TextureCube.MipLevels = d->mipLevels;
+        } else if (d->arraySize > 1) {
+            srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2DARRAY;
+            srvDesc.Texture2DArray.MipLevels = d->mipLevels;
+            srvDesc.Texture2DArray.ArraySize = d->arraySize;
+        } else {
+            srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+            srvDesc.Texture2D.MipLevels = d->mipLevels;
+        }
+        break;
+    }
+
+    return srvDesc;
+}
+
+// The layout of all subresources in an upload buffer, as reported by
+// GetCopyableFootprints(), which handles block compressed formats too.
+QVector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> QD3D12DdsTexture::footprints(ID3D12Device *device, quint64 *totalSize) const
+{
+    Q_D(const QD3D12DdsTexture);
+    QVector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> layouts(d->subresources.count());
+    const D3D12_RESOURCE_DESC desc = resourceDesc();
+    UINT64 size = 0;
+    device->GetCopyableFootprints(&desc, 0, layouts.count(), 0, layouts.data(), Q_NULLPTR, Q_NULLPTR, &size);
+    if (totalSize)
+        *totalSize = size;
+    return layouts;
+}
+
+// Copies every subresource from the file into dst, which is typically a
+// mapped upload buffer, honoring the (256 byte aligned) row pitches of the
+// footprints.
+void QD3D12DdsTexture::writeSubresources(quint8 *dst, const QVector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> &footprints) const
+{
+    Q_D(const QD3D12DdsTexture);
+    const int count = qMin(footprints.count(), d->subresources.count());
+    for (int i = 0; i < count; ++i) {
+        const Subresource &sub(d->subresources[i]);
+        const D3D12_PLACED_SUBRESOURCE_FOOTPRINT &layout(footprints[i]);
+        const uchar *src = sub.data;
+        quint8 *p = dst + layout.Offset;
+        if (layout.Footprint.RowPitch == sub.rowPitch) {
+            memcpy(p, src, size_t(sub.rowPitch) * sub.rowCount * sub.depth);
+            continue;
+        }
+        const quint32 rows = sub.rowCount * sub.depth;
+        for (quint32 y = 0; y < rows; ++y) {
+            memcpy(p, src, sub.rowPitch);
+            src += sub.rowPitch;
+            p += layout.Footprint.RowPitch;
+        }
+    }
+}
+
+QT_END_NAMESPACE
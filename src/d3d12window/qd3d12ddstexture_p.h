@@ -0,0 +1,88 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtD3D12Window module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QD3D12DDSTEXTURE_P_H
+#define QD3D12DDSTEXTURE_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "qd3d12ddstexture.h"
+#include <QtCore/QFile>
+
+QT_BEGIN_NAMESPACE
+
+class QD3D12DdsTexturePrivate
+{
+public:
+    QD3D12DdsTexturePrivate()
+        : data(Q_NULLPTR),
+          dataSize(0)
+    {
+        reset();
+    }
+
+    void reset();
+    bool parse();
+
+    // Either the mapped file or, when mapping is not possible (for example
+    // compressed resources), its contents.
+    QFile file;
+    QByteArray buffer;
+    const uchar *data;
+    qint64 dataSize;
+
+    DXGI_FORMAT format;
+    D3D12_RESOURCE_DIMENSION dimension;
+    QSize size;
+    int depth;
+    int arraySize;
+    int mipLevels;
+    bool cubeMap;
+    QVector<QD3D12DdsTexture::Subresource> subresources;
+};
+
+QT_END_NAMESPACE
+
+#endif
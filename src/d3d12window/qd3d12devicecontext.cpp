@@ -0,0 +1,615 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtD3D12Window module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qd3d12devicecontext_p.h"
+#include "qd3d12window_p.h"
+#include "qd3d12util_p.h"
+#include <QtCore/QTimer>
+
+QT_BEGIN_NAMESPACE
+
+QD3D12DeviceContextPrivate::~QD3D12DeviceContextPrivate()
+{
+}
+
+void QD3D12DeviceContextPrivate::release(bool waitForIdle)
+{
+    if (waitForIdle && fence) {
+        commandQueue->Signal(fence.Get(), ++fenceValue);
+        waitForFence(fenceValue);
+    }
+
+    foreach (ID3D12CommandList *list, pendingLists)
+        list->Release();
+    pendingLists.clear();
+    pendingListOwners.clear();
+    foreach (QD3D12WindowPrivate *w, pendingPresents)
+        w->presentPending = false;
+    pendingPresents.clear();
+
+    pipelineStates.clear();
+
+    descriptorHeap = Q_NULLPTR;
+    descriptorStride = 0;
+    freeDescriptors.clear();
+    pendingReleases.clear();
+
+    if (uploadBuffer)
+        uploadBuffer->Unmap(0, Q_NULLPTR);
+    uploadBuffer = Q_NULLPTR;
+    uploadData = Q_NULLPTR;
+    uploadHead = uploadTail = 0;
+    uploadMarks.clear();
+
+    fence = Q_NULLPTR;
+    if (fenceEvent) {
+        CloseHandle(fenceEvent);
+        fenceEvent = Q_NULLPTR;
+    }
+    fenceValue = 0;
+
+    commandQueue = Q_NULLPTR;
+    device = Q_NULLPTR;
+    factory = Q_NULLPTR;
+
+    if (created) {
+        created = false;
+        ++generation;
+    }
+}
+
+void QD3D12DeviceContextPrivate::deviceLost()
+{
+    Q_Q(QD3D12DeviceContext);
+    qWarning("D3D device lost");
+
+    // Every attached window goes down with the device. They come back on
+    // their next update, the first one re-creates the context.
+    const QVector<QD3D12WindowPrivate *> attached = windows;
+    foreach (QD3D12WindowPrivate *w, attached) {
+        dropPending(w);
+        w->contextLost();
+    }
+
+    release(false);
+
+    emit q->deviceLost();
+}
+
+void QD3D12DeviceContextPrivate::attach(QD3D12WindowPrivate *w)
+{
+    if (!windows.contains(w))
+        windows.append(w);
+}
+
+void QD3D12DeviceContextPrivate::detach(QD3D12WindowPrivate *w)
+{
+    dropPending(w);
+    windows.removeOne(w);
+}
+
+void QD3D12DeviceContextPrivate::dropPending(QD3D12WindowPrivate *w)
+{
+    for (int i = pendingListOwners.count() - 1; i >= 0; --i) {
+        if (pendingListOwners[i] == w) {
+            pendingLists[i]->Release();
+            pendingLists.remove(i);
+            pendingListOwners.remove(i);
+        }
+    }
+    if (pendingPresents.removeOne(w))
+        w->presentPending = false;
+}
+
+void QD3D12DeviceContextPrivate::submit(QD3D12WindowPrivate *w, int count, ID3D12CommandList *const *commandLists)
+{
+    // Keep the lists alive until the batch is executed, the window may go
+    // away in the meantime.
+    for (int i = 0; i < count; ++i) {
+        commandLists[i]->AddRef();
+        pendingLists.append(commandLists[i]);
+        pendingListOwners.append(w);
+    }
+}
+
+void QD3D12DeviceContextPrivate::queuePresent(QD3D12WindowPrivate *w)
+{
+    Q_Q(QD3D12DeviceContext);
+
+    if (!w->presentPending) {
+        w->presentPending = true;
+        pendingPresents.append(w);
+    }
+
+    // All windows painted in the same event loop iteration, which is the
+    // normal case with update requests driven by the same vsync, end up in
+    // one batch.
+    if (!flushScheduled) {
+        flushScheduled = true;
+        QTimer::singleShot(0, q, [this]() { flushBatch(); });
+    }
+}
+
+void QD3D12DeviceContextPrivate::flushBatch()
+{
+    flushScheduled = false;
+    if (flushing || !created)
+        return;
+    if (pendingLists.isEmpty() && pendingPresents.isEmpty())
+        return;
+
+    flushing = true;
+    const int gen = generation;
+
+    if (!pendingLists.isEmpty()) {
+        QD3D12_TRACE_SCOPE("ExecuteCommandLists");
+        commandQueue->ExecuteCommandLists(pendingLists.count(), pendingLists.constData());
+        foreach (ID3D12CommandList *list, pendingLists)
+            list->Release();
+        pendingLists.clear();
+        pendingListOwners.clear();
+    }
+
+    const QVector<QD3D12WindowPrivate *> presents = pendingPresents;
+    pendingPresents.clear();
+    foreach (QD3D12WindowPrivate *w, presents) {
+        w->presentPending = false;
+        w->present();
+        // A lost device has taken down all windows, including the rest of this batch.
+        if (gen != generation)
+            break;
+    }
+
+    if (gen == generation)
+        signalFrame();
+
+    flushing = false;
+}
+
+void QD3D12DeviceContextPrivate::signalFrame()
+{
+    commandQueue->Signal(fence.Get(), ++fenceValue);
+    UploadMark mark;
+    mark.fenceValue = fenceValue;
+    mark.head = uploadHead;
+    uploadMarks.enqueue(mark);
+    retire();
+}
+
+void QD3D12DeviceContextPrivate::retire()
+{
+    const quint64 completed = fence->GetCompletedValue();
+
+    while (!uploadMarks.isEmpty() && uploadMarks.head().fenceValue <= completed)
+        uploadTail = uploadMarks.dequeue().head;
+
+    while (!pendingReleases.isEmpty() && pendingReleases.head().fenceValue <= completed)
+        freeDescriptorRange(pendingReleases.dequeue().range);
+}
+
+void QD3D12DeviceContextPrivate::waitForFence(quint64 value)
+{
+    if (fence->GetCompletedValue() < value) {
+        if (FAILED(fence->SetEventOnCompletion(value, fenceEvent))) {
+            qWarning("SetEventOnCompletion failed");
+            return;
+        }
+        WaitForSingleObject(fenceEvent, INFINITE);
+    }
+}
+
+void QD3D12DeviceContextPrivate::freeDescriptorRange(const FreeRange &range)
+{
+    int i = 0;
+    while (i < freeDescriptors.count() && freeDescriptors[i].offset < range.offset)
+        ++i;
+    freeDescriptors.insert(i, range);
+
+    if (i + 1 < freeDescriptors.count()
+            && freeDescriptors[i].offset + freeDescriptors[i].count == freeDescriptors[i + 1].offset) {
+        freeDescriptors[i].count += freeDescriptors[i + 1].count;
+        freeDescriptors.remove(i + 1);
+    }
+    if (i > 0 && freeDescriptors[i - 1].offset + freeDescriptors[i - 1].count == freeDescriptors[i].offset) {
+        freeDescriptors[i - 1].count += freeDescriptors[i].count;
+        freeDescriptors.remove(i);
+    }
+}
+
+// Shares one device, one direct queue and a set of caches between windows.
+// Windows attach with QD3D12Window::setDeviceContext() before they are first
+// exposed. Command lists submitted via QD3D12Window::executeCommandLists()
+// from paintD3D() are collected and executed together, followed by the
+// Presents of all windows that painted in the same event loop iteration.
+QD3D12DeviceContext::QD3D12DeviceContext(QObject *parent)
+    : QObject(*(new QD3D12DeviceContextPrivate), parent)
+{
+}
+
+QD3D12DeviceContext::~QD3D12DeviceContext()
+{
+    Q_D(QD3D12DeviceContext);
+
+    // Windows keep their references to the device and continue on their own.
+    d->flushBatch();
+    foreach (QD3D12WindowPrivate *w, d->windows)
+        w->deviceContext = Q_NULLPTR;
+    d->windows.clear();
+
+    d->release(true);
+}
+
+void QD3D12DeviceContext::setAdapterPreference(QD3D12Adapter::Preference preference)
+{
+    Q_D(QD3D12DeviceContext);
+    if (d->created) {
+        qWarning("setAdapterPreference: Already created, request ignored.");
+        return;
+    }
+    d->adapterPreference = preference;
+}
+
+QD3D12Adapter::Preference QD3D12DeviceContext::adapterPreference() const
+{
+    Q_D(const QD3D12DeviceContext);
+    return d->adapterPreference;
+}
+
+void QD3D12DeviceContext::setAdapterLuid(quint64 luid)
+{
+    Q_D(QD3D12DeviceContext);
+    if (d->created) {
+        qWarning("setAdapterLuid: Already created, request ignored.");
+        return;
+    }
+    d->adapterLuid = luid;
+}
+
+quint64 QD3D12DeviceContext::adapterLuid() const
+{
+    Q_D(const QD3D12DeviceContext);
+    return d->adapterLuid;
+}
+
+// Number of descriptors in the shared shader visible CBV/SRV/UAV heap.
+void QD3D12DeviceContext::setDescriptorHeapSize(int count)
+{
+    Q_D(QD3D12DeviceContext);
+    if (d->created) {
+        qWarning("setDescriptorHeapSize: Already created, request ignored.");
+        return;
+    }
+    d->descriptorHeapSize = qMax(1, count);
+}
+
+int QD3D12DeviceContext::descriptorHeapSize() const
+{
+    Q_D(const QD3D12DeviceContext);
+    return d->descriptorHeapSize;
+}
+
+// Size of the upload ring in bytes, rounded up to 64 KB.
+void QD3D12DeviceContext::setUploadPoolSize(quint32 size)
+{
+    Q_D(QD3D12DeviceContext);
+    if (d->created) {
+        qWarning("setUploadPoolSize: Already created, request ignored.");
+        return;
+    }
+    const quint32 align = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+    d->uploadPoolSize = qMax(align, (size + align - 1) & ~(align - 1));
+}
+
+quint32 QD3D12DeviceContext::uploadPoolSize() const
+{
+    Q_D(const QD3D12DeviceContext);
+    return d->uploadPoolSize;
+}
+
+// Called implicitly by the first attached window that gets initialized.
+bool QD3D12DeviceContext::create()
+{
+    Q_D(QD3D12DeviceContext);
+    if (d->created)
+        return true;
+
+    QD3D12_TRACE_SCOPE("createDeviceContext");
+
+    if (!QD3D12Util::createDevice(d->adapterPreference, d->adapterLuid, &d->factory, &d->device))
+        return false;
+
+    D3D12_COMMAND_QUEUE_DESC queueDesc = {};
+    queueDesc.Type = D3D12_COMMAND_LIST_TYPE_DIRECT;
+    if (FAILED(d->device->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&d->commandQueue)))) {
+        qWarning("Failed to create command queue");
+        d->release(false);
+        return false;
+    }
+
+    if (FAILED(d->device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&d->fence)))) {
+        qWarning("Failed to create fence");
+        d->release(false);
+        return false;
+    }
+    d->fenceEvent = CreateEvent(Q_NULLPTR, FALSE, FALSE, Q_NULLPTR);
+
+    D3D12_DESCRIPTOR_HEAP_DESC heapDesc = {};
+    heapDesc.NumDescriptors = d->descriptorHeapSize;
+    heapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+    heapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
+    if (FAILED(d->device->CreateDescriptorHeap(&heapDesc, IID_PPV_ARGS(&d->descriptorHeap)))) {
+        qWarning("Failed to create shared descriptor heap");
+        d->release(false);
+        return false;
+    }
+    d->descriptorStride = d->device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+    d->freeDescriptors.append(QD3D12DeviceContextPrivate::FreeRange(0, d->descriptorHeapSize));
+
+    D3D12_HEAP_PROPERTIES uploadHeapProp = {};
+    uploadHeapProp.Type = D3D12_HEAP_TYPE_UPLOAD;
+
+    D3D12_RESOURCE_DESC bufDesc = {};
+    bufDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+    bufDesc.Width = d->uploadPoolSize;
+    bufDesc.Height = 1;
+    bufDesc.DepthOrArraySize = 1;
+    bufDesc.MipLevels = 1;
+    bufDesc.Format = DXGI_FORMAT_UNKNOWN;
+    bufDesc.SampleDesc.Count = 1;
+    bufDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+
+    if (FAILED(d->device->CreateCommittedResource(&uploadHeapProp, D3D12_HEAP_FLAG_NONE, &bufDesc,
+                                                  D3D12_RESOURCE_STATE_GENERIC_READ, Q_NULLPTR,
+                                                  IID_PPV_ARGS(&d->uploadBuffer)))) {
+        qWarning("Failed to create upload pool");
+        d->release(false);
+        return false;
+    }
+    // Upload heaps can stay mapped for their entire lifetime.
+    D3D12_RANGE readRange = { 0, 0 };
+    if (FAILED(d->uploadBuffer->Map(0, &readRange, reinterpret_cast<void **>(&d->uploadData)))) {
+        qWarning("Failed to map upload pool");
+        d->uploadBuffer = Q_NULLPTR;
+        d->release(false);
+        return false;
+    }
+
+    d->created = true;
+    return true;
+}
+
+// Releases the device and everything created from it. Attached windows
+// release their resources too and initialize again on their next update.
+void QD3D12DeviceContext::destroy()
+{
+    Q_D(QD3D12DeviceContext);
+    if (!d->created)
+        return;
+
+    d->flushBatch();
+    const QVector<QD3D12WindowPrivate *> attached = d->windows;
+    foreach (QD3D12WindowPrivate *w, attached)
+        w->contextLost();
+
+    d->release(true);
+}
+
+bool QD3D12DeviceContext::isCreated() const
+{
+    Q_D(const QD3D12DeviceContext);
+    return d->created;
+}
+
+ID3D12Device *QD3D12DeviceContext::device() const
+{
+    Q_D(const QD3D12DeviceContext);
+    return d->device.Get();
+}
+
+ID3D12CommandQueue *QD3D12DeviceContext::commandQueue() const
+{
+    Q_D(const QD3D12DeviceContext);
+    return d->commandQueue.Get();
+}
+
+// Returns a cached pipeline state for the description, creating it on first
+// use. The context owns the object, it stays valid until the device is lost
+// or the context is destroyed.
+ID3D12PipelineState *QD3D12DeviceContext::pipelineState(const D3D12_GRAPHICS_PIPELINE_STATE_DESC &desc)
+{
+    Q_D(QD3D12DeviceContext);
+    if (!d->created) {
+        qWarning("pipelineState: Device context not created");
+        return Q_NULLPTR;
+    }
+
+    const QByteArray key = QD3D12Util::pipelineKey(desc);
+    auto it = d->pipelineStates.constFind(key);
+    if (it != d->pipelineStates.cend())
+        return it->Get();
+
+    ComPtr<ID3D12PipelineState> pso;
+    HRESULT hr = d->device->CreateGraphicsPipelineState(&desc, IID_PPV_ARGS(&pso));
+    if (FAILED(hr)) {
+        qWarning("Failed to create graphics pipeline state: 0x%x", hr);
+        return Q_NULLPTR;
+    }
+    d->pipelineStates.insert(key, pso);
+    return pso.Get();
+}
+
+ID3D12PipelineState *QD3D12DeviceContext::pipelineState(const D3D12_COMPUTE_PIPELINE_STATE_DESC &desc)
+{
+    Q_D(QD3D12DeviceContext);
+    if (!d->created) {
+        qWarning("pipelineState: Device context not created");
+        return Q_NULLPTR;
+    }
+
+    const QByteArray key = QD3D12Util::pipelineKey(desc);
+    auto it = d->pipelineStates.constFind(key);
+    if (it != d->pipelineStates.cend())
+        return it->Get();
+
+    ComPtr<ID3D12PipelineState> pso;
+    HRESULT hr = d->device->CreateComputePipelineState(&desc, IID_PPV_ARGS(&pso));
+    if (FAILED(hr)) {
+        qWarning("Failed to create compute pipeline state: 0x%x", hr);
+        return Q_NULLPTR;
+    }
+    d->pipelineStates.insert(key, pso);
+    return pso.Get();
+}
+
+ID3D12DescriptorHeap *QD3D12DeviceContext::descriptorHeap() const
+{
+    Q_D(const QD3D12DeviceContext);
+    return d->descriptorHeap.Get();
+}
+
+// Allocates a contiguous range from the shared shader visible heap. Since
+// there can only be one such heap bound at a time, windows sharing textures
+// should allocate all their shader visible descriptors here.
+QD3D12DeviceContext::Descriptors QD3D12DeviceContext::allocateDescriptors(int count)
+{
+    Q_D(QD3D12DeviceContext);
+    Descriptors result;
+    if (!d->created || count <= 0)
+        return result;
+
+    d->retire();
+
+    for (int i = 0; i < d->freeDescriptors.count(); ++i) {
+        QD3D12DeviceContextPrivate::FreeRange &r(d->freeDescriptors[i]);
+        if (r.count >= count) {
+            result.offset = r.offset;
+            result.count = count;
+            result.stride = d->descriptorStride;
+            result.cpuStart = d->descriptorHeap->GetCPUDescriptorHandleForHeapStart();
+            result.cpuStart.ptr += r.offset * d->descriptorStride;
+            result.gpuStart = d->descriptorHeap->GetGPUDescriptorHandleForHeapStart();
+            result.gpuStart.ptr += r.offset * d->descriptorStride;
+            r.offset += count;
+            r.count -= count;
+            if (!r.count)
+                d->freeDescriptors.remove(i);
+            return result;
+        }
+    }
+
+    qWarning("allocateDescriptors: Out of descriptors (%d requested)", count);
+    return result;
+}
+
+// The range becomes reusable once the GPU is done with the current batch.
+void QD3D12DeviceContext::releaseDescriptors(const Descriptors &descriptors)
+{
+    Q_D(QD3D12DeviceContext);
+    if (!d->created || !descriptors.isValid())
+        return;
+
+    QD3D12DeviceContextPrivate::PendingRelease pr;
+    pr.fenceValue = d->fenceValue + 1;
+    pr.range = QD3D12DeviceContextPrivate::FreeRange(descriptors.offset, descriptors.count);
+    d->pendingReleases.enqueue(pr);
+}
+
+// Suballocates from the persistently mapped upload ring. Blocks when the
+// ring is full until the GPU has finished an earlier batch.
+QD3D12DeviceContext::UploadAllocation QD3D12DeviceContext::allocateUpload(quint32 size, quint32 alignment)
+{
+    Q_D(QD3D12DeviceContext);
+    UploadAllocation result;
+    if (!d->created)
+        return result;
+
+    if (size > d->uploadPoolSize) {
+        qWarning("allocateUpload: %u bytes do not fit in the upload pool", size);
+        return result;
+    }
+
+    const quint64 poolSize = d->uploadPoolSize;
+    const quint64 align = qMax(1u, alignment);
+    for (;;) {
+        d->retire();
+
+        quint64 pos = d->uploadHead;
+        const quint64 offset = pos % poolSize;
+        quint64 alignedOffset = (offset + align - 1) & ~(align - 1);
+        if (alignedOffset + size > poolSize) {
+            pos += poolSize - offset;
+            alignedOffset = 0;
+        } else {
+            pos += alignedOffset - offset;
+        }
+
+        if (pos + size - d->uploadTail <= poolSize) {
+            d->uploadHead = pos + size;
+            result.buffer = d->uploadBuffer.Get();
+            result.offset = alignedOffset;
+            result.data = d->uploadData + alignedOffset;
+            result.gpuAddress = d->uploadBuffer->GetGPUVirtualAddress() + alignedOffset;
+            return result;
+        }
+
+        if (d->uploadMarks.isEmpty()) {
+            qWarning("allocateUpload: Upload pool exhausted within a single batch");
+            return result;
+        }
+        d->waitForFence(d->uploadMarks.head().fenceValue);
+    }
+}
+
+// Executes the pending command lists and presents the pending windows
+// right away instead of waiting for the event loop.
+void QD3D12DeviceContext::flush()
+{
+    Q_D(QD3D12DeviceContext);
+    d->flushBatch();
+}
+
+void QD3D12DeviceContext::waitForGPU()
+{
+    Q_D(QD3D12DeviceContext);
+    if (!d->created)
+        return;
+
+    d->signalFrame();
+    d->waitForFence(d->fenceValue);
+    d->retire();
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,117 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtD3D12Window module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QD3D12DEVICECONTEXT_H
+#define QD3D12DEVICECONTEXT_H
+
+#include <QtCore/QObject>
+#include <QtD3D12Window/qd3d12window.h>
+
+QT_BEGIN_NAMESPACE
+
+class QD3D12DeviceContextPrivate;
+
+class QD3D12_EXPORT QD3D12DeviceContext : public QObject
+{
+    Q_OBJECT
+    Q_DECLARE_PRIVATE(QD3D12DeviceContext)
+
+public:
+    // A range of descriptors in the shared shader visible CBV/SRV/UAV heap.
+    struct Descriptors {
+        Descriptors() : offset(-1), count(0), stride(0) { cpuStart.ptr = 0; gpuStart.ptr = 0; }
+        bool isValid() const { return count > 0; }
+        D3D12_CPU_DESCRIPTOR_HANDLE cpuHandle(int i) const { D3D12_CPU_DESCRIPTOR_HANDLE h = cpuStart; h.ptr += i * stride; return h; }
+        D3D12_GPU_DESCRIPTOR_HANDLE gpuHandle(int i) const { D3D12_GPU_DESCRIPTOR_HANDLE h = gpuStart; h.ptr += i * stride; return h; }
+        int offset;
+        int count;
+        UINT stride;
+        D3D12_CPU_DESCRIPTOR_HANDLE cpuStart;
+        D3D12_GPU_DESCRIPTOR_HANDLE gpuStart;
+    };
+
+    // A chunk of the shared upload ring. Valid until the GPU has finished
+    // the frame batch it was allocated for.
+    struct UploadAllocation {
+        UploadAllocation() : buffer(Q_NULLPTR), offset(0), data(Q_NULLPTR), gpuAddress(0) { }
+        bool isValid() const { return data != Q_NULLPTR; }
+        ID3D12Resource *buffer;
+        quint64 offset;
+        quint8 *data;
+        D3D12_GPU_VIRTUAL_ADDRESS gpuAddress;
+    };
+
+    explicit QD3D12DeviceContext(QObject *parent = Q_NULLPTR);
+    ~QD3D12DeviceContext();
+
+    void setAdapterPreference(QD3D12Adapter::Preference preference);
+    QD3D12Adapter::Preference adapterPreference() const;
+    void setAdapterLuid(quint64 luid);
+    quint64 adapterLuid() const;
+    void setDescriptorHeapSize(int count);
+    int descriptorHeapSize() const;
+    void setUploadPoolSize(quint32 size);
+    quint32 uploadPoolSize() const;
+
+    bool create();
+    void destroy();
+    bool isCreated() const;
+
+    ID3D12Device *device() const;
+    ID3D12CommandQueue *commandQueue() const;
+
+    ID3D12PipelineState *pipelineState(const D3D12_GRAPHICS_PIPELINE_STATE_DESC &desc);
+    ID3D12PipelineState *pipelineState(const D3D12_COMPUTE_PIPELINE_STATE_DESC &desc);
+
+    ID3D12DescriptorHeap *descriptorHeap() const;
+    Descriptors allocateDescriptors(int count);
+    void releaseDescriptors(const Descriptors &descriptors);
+
+    UploadAllocation allocateUpload(quint32 size, quint32 alignment = D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+
+    void flush();
+    void waitForGPU();
+
+signals:
+    void deviceLost();
+
+private:
+    Q_DISABLE_COPY(QD3D12DeviceContext)
+};
+
+QT_END_NAMESPACE
+
+#endif
@@ -0,0 +1,158 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtD3D12Window module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QD3D12DEVICECONTEXT_P_H
+#define QD3D12DEVICECONTEXT_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "qd3d12devicecontext.h"
+#include <QtCore/QHash>
+#include <QtCore/QVector>
+#include <QtCore/QQueue>
+#include <QtCore/private/qobject_p.h>
+
+QT_BEGIN_NAMESPACE
+
+class QD3D12WindowPrivate;
+
+class QD3D12DeviceContextPrivate : public QObjectPrivate
+{
+    Q_DECLARE_PUBLIC(QD3D12DeviceContext)
+
+public:
+    QD3D12DeviceContextPrivate()
+        : adapterPreference(QD3D12Adapter::DefaultPreference),
+          adapterLuid(0),
+          descriptorHeapSize(4096),
+          uploadPoolSize(16 * 1024 * 1024),
+          created(false),
+          descriptorStride(0),
+          fenceEvent(Q_NULLPTR),
+          fenceValue(0),
+          uploadData(Q_NULLPTR),
+          uploadHead(0),
+          uploadTail(0),
+          generation(0),
+          flushScheduled(false),
+          flushing(false)
+    { }
+    ~QD3D12DeviceContextPrivate();
+
+    static QD3D12DeviceContextPrivate *get(QD3D12DeviceContext *c) { return c->d_func(); }
+
+    struct FreeRange {
+        FreeRange() : offset(0), count(0) { }
+        FreeRange(int o, int c) : offset(o), count(c) { }
+        int offset;
+        int count;
+    };
+
+    struct PendingRelease {
+        quint64 fenceValue;
+        FreeRange range;
+    };
+
+    struct UploadMark {
+        quint64 fenceValue;
+        quint64 head;
+    };
+
+    void release(bool waitForIdle);
+    void deviceLost();
+
+    void attach(QD3D12WindowPrivate *w);
+    void detach(QD3D12WindowPrivate *w);
+    void dropPending(QD3D12WindowPrivate *w);
+    void submit(QD3D12WindowPrivate *w, int count, ID3D12CommandList *const *commandLists);
+    void queuePresent(QD3D12WindowPrivate *w);
+    void flushBatch();
+    void signalFrame();
+    void retire();
+    void waitForFence(quint64 value);
+    void freeDescriptorRange(const FreeRange &range);
+
+    QD3D12Adapter::Preference adapterPreference;
+    quint64 adapterLuid;
+    int descriptorHeapSize;
+    quint32 uploadPoolSize;
+
+    bool created;
+    ComPtr<IDXGIFactory4> factory;
+    ComPtr<ID3D12Device> device;
+    ComPtr<ID3D12CommandQueue> commandQueue;
+
+    QHash<QByteArray, ComPtr<ID3D12PipelineState> > pipelineStates;
+
+    ComPtr<ID3D12DescriptorHeap> descriptorHeap;
+    UINT descriptorStride;
+    QVector<FreeRange> freeDescriptors; // sorted by offset
+    QQueue<PendingRelease> pendingReleases;
+
+    ComPtr<ID3D12Fence> fence;
+    HANDLE fenceEvent;
+    quint64 fenceValue;
+
+    // The upload ring uses monotonic positions, the buffer offset is pos % size.
+    ComPtr<ID3D12Resource> uploadBuffer;
+    quint8 *uploadData;
+    quint64 uploadHead;
+    quint64 uploadTail;
+    QQueue<UploadMark> uploadMarks;
+
+    // Bumped whenever the device goes away.
+    int generation;
+
+    QVector<QD3D12WindowPrivate *> windows;
+    QVector<QD3D12WindowPrivate *> pendingPresents;
+    QVector<ID3D12CommandList *> pendingLists; // referenced until executed
+    QVector<QD3D12WindowPrivate *> pendingListOwners;
+    bool flushScheduled;
+    bool flushing;
+};
+
+QT_END_NAMESPACE
+
+#endif
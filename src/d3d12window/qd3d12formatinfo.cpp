@@ -0,0 +1,192 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtD3D12Window module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include "qd3d12formatinfo.h"
+
+QT_BEGIN_NAMESPACE
+
+static Q_DECL_CONSTEXPR int FORMAT_TABLE_SIZE = sizeof(qd3d12FormatInfoTable) / sizeof(qd3d12FormatInfoTable[0]);
+
+#ifdef Q_COMPILER_CONSTEXPR
+static Q_DECL_CONSTEXPR bool isTableOrdered(int i)
+{
+    return i == FORMAT_TABLE_SIZE || (int(qd3d12FormatInfoTable[i].format) == i && isTableOrdered(i + 1));
+}
+Q_STATIC_ASSERT(isTableOrdered(0));
+Q_STATIC_ASSERT(FORMAT_TABLE_SIZE == DXGI_FORMAT_B4G4R4A4_UNORM + 1);
+#endif
+
+struct QD3D12PlaneInfo
+{
+    DXGI_FORMAT format;
+    quint32 blockBytes;
+    quint32 widthShift;
+    quint32 heightShift;
+};
+
+// Copies of planar formats go through one subresource per plane, each with
+// its own format. Depth goes through R32 and stencil through R8, chroma is
+// subsampled.
+static QD3D12PlaneInfo planeInfo(const QD3D12FormatInfo &info, UINT plane)
+{
+    QD3D12PlaneInfo p = { info.format, info.blockBytes, 0, 0 };
+    if (!info.testFlag(QD3D12FormatInfo::Planar))
+        return p;
+
+    switch (info.format) {
+    case DXGI_FORMAT_R32G8X24_TYPELESS:
+    case DXGI_FORMAT_D32_FLOAT_S8X24_UINT:
+    case DXGI_FORMAT_R24G8_TYPELESS:
+    case DXGI_FORMAT_D24_UNORM_S8_UINT:
+        p.format = plane ? DXGI_FORMAT_R8_TYPELESS : DXGI_FORMAT_R32_TYPELESS;
+        p.blockBytes = plane ? 1 : 4;
+        break;
+    case DXGI_FORMAT_NV12:
+    case DXGI_FORMAT_420_OPAQUE:
+        p.format = plane ? DXGI_FORMAT_R8G8_TYPELESS : DXGI_FORMAT_R8_TYPELESS;
+        p.blockBytes = plane ? 2 : 1;
+        p.widthShift = p.heightShift = plane;
+        break;
+    case DXGI_FORMAT_P010:
+    case DXGI_FORMAT_P016:
+        p.format = plane ? DXGI_FORMAT_R16G16_TYPELESS : DXGI_FORMAT_R16_TYPELESS;
+        p.blockBytes = plane ? 4 : 2;
+        p.widthShift = p.heightShift = plane;
+        break;
+    case DXGI_FORMAT_NV11:
+        p.format = plane ? DXGI_FORMAT_R8G8_TYPELESS : DXGI_FORMAT_R8_TYPELESS;
+        p.blockBytes = plane ? 2 : 1;
+        p.widthShift = plane ? 2 : 0;
+        break;
+    default:
+        break;
+    }
+    return p;
+}
+
+// Zero mip levels asks for the full chain down to 1x1, as in resource creation.
+UINT QD3D12FormatInfo::mipLevelCount(const D3D12_RESOURCE_DESC &desc)
+{
+    if (desc.MipLevels || desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+        return qMax<UINT>(1, desc.MipLevels);
+
+    UINT64 extent = qMax<UINT64>(desc.Width, desc.Height);
+    if (desc.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE3D)
+        extent = qMax<UINT64>(extent, desc.DepthOrArraySize);
+    UINT levels = 1;
+    while (extent >> levels)
+        ++levels;
+    return levels;
+}
+
+// Subresources are ordered by plane, then array slice, then mip level. Each
+// one starts at a 512 byte boundary and has 256 byte aligned rows. The total
+// covers the last row of the last subresource without its pitch padding.
+bool QD3D12FormatInfo::copyableFootprints(const D3D12_RESOURCE_DESC &desc, UINT firstSubresource, UINT numSubresources,
+                                          UINT64 baseOffset, D3D12_PLACED_SUBRESOURCE_FOOTPRINT *layouts,
+                                          UINT *numRows, UINT64 *rowSizes, UINT64 *totalBytes)
+{
+    if (desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER) {
+        if (firstSubresource != 0 || numSubresources > 1)
+            return false;
+        if (numSubresources) {
+            if (layouts) {
+                layouts[0].Offset = baseOffset;
+                layouts[0].Footprint.Format = DXGI_FORMAT_UNKNOWN;
+                layouts[0].Footprint.Width = UINT(desc.Width);
+                layouts[0].Footprint.Height = 1;
+                layouts[0].Footprint.Depth = 1;
+                layouts[0].Footprint.RowPitch = UINT((desc.Width + D3D12_TEXTURE_DATA_PITCH_ALIGNMENT - 1)
+                                                     & ~UINT64(D3D12_TEXTURE_DATA_PITCH_ALIGNMENT - 1));
+            }
+            if (numRows)
+                numRows[0] = 1;
+            if (rowSizes)
+                rowSizes[0] = desc.Width;
+        }
+        if (totalBytes)
+            *totalBytes = numSubresources ? desc.Width : 0;
+        return true;
+    }
+
+    const QD3D12FormatInfo info = forFormat(desc.Format);
+    const UINT mipLevels = mipLevelCount(desc);
+    const UINT arraySize = desc.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE3D ? 1 : desc.DepthOrArraySize;
+    if (!info.isValid() || firstSubresource + numSubresources > mipLevels * arraySize * info.planeCount)
+        return false;
+
+    UINT64 offset = 0;
+    UINT64 total = 0;
+    for (UINT i = 0; i < numSubresources; ++i) {
+        const UINT subresource = firstSubresource + i;
+        const UINT level = subresource % mipLevels;
+        const UINT plane = subresource / (mipLevels * arraySize);
+        const QD3D12PlaneInfo p = planeInfo(info, plane);
+
+        const quint32 width = qMax<quint32>(1, quint32(desc.Width >> level) >> p.widthShift);
+        const quint32 height = qMax<quint32>(1, (desc.Height >> level) >> p.heightShift);
+        const quint32 depth = desc.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE3D
+                ? qMax<quint32>(1, desc.DepthOrArraySize >> level) : 1;
+        const quint32 blocksX = (width + info.blockWidth - 1) / info.blockWidth;
+        const quint32 blocksY = (height + info.blockHeight - 1) / info.blockHeight;
+        const quint32 rowSize = blocksX * p.blockBytes;
+        const quint32 pitch = (rowSize + D3D12_TEXTURE_DATA_PITCH_ALIGNMENT - 1)
+                & ~(D3D12_TEXTURE_DATA_PITCH_ALIGNMENT - 1);
+
+        if (layouts) {
+            layouts[i].Offset = baseOffset + offset;
+            layouts[i].Footprint.Format = p.format;
+            layouts[i].Footprint.Width = blocksX * info.blockWidth;
+            layouts[i].Footprint.Height = blocksY * info.blockHeight;
+            layouts[i].Footprint.Depth = depth;
+            layouts[i].Footprint.RowPitch = pitch;
+        }
+        if (numRows)
+            numRows[i] = blocksY;
+        if (rowSizes)
+            rowSizes[i] = rowSize;
+
+        total = offset + UINT64(pitch) * (blocksY * depth - 1) + rowSize;
+        offset = (offset + UINT64(pitch) * blocksY * depth + D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT - 1)
+                & ~UINT64(D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT - 1);
+    }
+    if (totalBytes)
+        *totalBytes = total;
+    return true;
+}
+
+QT_END_NAMESPACE
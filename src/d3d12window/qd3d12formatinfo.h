@@ -0,0 +1,285 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtD3D12Window module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#ifndef QD3D12FORMATINFO_H
+#define QD3D12FORMATINFO_H
+
+#include <QtD3D12Window/qd3d12windowglobal.h>
+
+#include <d3d12.h>
+
+QT_BEGIN_NAMESPACE
+
+// Static description of a DXGI format. Everything is known at compile time,
+// so lookups with a constant format fold away and the rest is a single
+// table access, cheap enough for per-texture upload and readback paths.
+struct QD3D12_EXPORT QD3D12FormatInfo
+{
+    enum Flag {
+        Typeless = 0x01,
+        SRgb = 0x02,
+        Depth = 0x04,
+        Stencil = 0x08,
+        BlockCompressed = 0x10,
+        Packed = 0x20,  // 4:2:2 with two pixels per block
+        Planar = 0x40,  // one subresource per plane, see planeCount
+        Video = 0x80
+    };
+
+    DXGI_FORMAT format;
+    quint8 blockWidth;
+    quint8 blockHeight;
+    quint8 blockBytes;
+    quint8 planeCount;
+    quint8 flags;
+    DXGI_FORMAT typelessFormat;
+    DXGI_FORMAT linearFormat; // the UNORM relative of an sRGB format
+    DXGI_FORMAT srgbFormat;   // the sRGB relative, UNKNOWN if there is none
+
+    Q_DECL_CONSTEXPR bool isValid() const { return blockBytes != 0; }
+    Q_DECL_CONSTEXPR bool testFlag(Flag flag) const { return (flags & flag) != 0; }
+
+    Q_DECL_CONSTEXPR quint32 blocksPerRow(quint32 width) const { return (width + blockWidth - 1) / blockWidth; }
+    Q_DECL_CONSTEXPR quint32 rowCount(quint32 height) const { return (height + blockHeight - 1) / blockHeight; }
+    Q_DECL_CONSTEXPR quint32 rowBytes(quint32 width) const { return blocksPerRow(width) * blockBytes; }
+    Q_DECL_CONSTEXPR quint32 rowPitch(quint32 width) const
+    {
+        return (rowBytes(width) + D3D12_TEXTURE_DATA_PITCH_ALIGNMENT - 1) & ~(D3D12_TEXTURE_DATA_PITCH_ALIGNMENT - 1);
+    }
+
+    static Q_DECL_CONSTEXPR QD3D12FormatInfo forFormat(DXGI_FORMAT format);
+
+    // The number of levels desc describes, resolving a MipLevels of 0.
+    static UINT mipLevelCount(const D3D12_RESOURCE_DESC &desc);
+
+    // Same results as ID3D12Device::GetCopyableFootprints(), without a device.
+    static bool copyableFootprints(const D3D12_RESOURCE_DESC &desc, UINT firstSubresource, UINT numSubresources,
+                                   UINT64 baseOffset, D3D12_PLACED_SUBRESOURCE_FOOTPRINT *layouts,
+                                   UINT *numRows = Q_NULLPTR, UINT64 *rowSizes = Q_NULLPTR,
+                                   UINT64 *totalBytes = Q_NULLPTR);
+};
+
+#define QD3D12_FORMAT(f, bw, bh, bytes, planes, flags, typeless, linear, srgb) \
+    { DXGI_FORMAT_ ## f, bw, bh, bytes, planes, flags, DXGI_FORMAT_ ## typeless, \
+      DXGI_FORMAT_ ## linear, DXGI_FORMAT_ ## srgb }
+#define QD3D12_PLAIN(f, bytes, typeless) QD3D12_FORMAT(f, 1, 1, bytes, 1, 0, typeless, f, UNKNOWN)
+#define QD3D12_TYPELESS(f, bytes) \
+    QD3D12_FORMAT(f, 1, 1, bytes, 1, QD3D12FormatInfo::Typeless, f, UNKNOWN, UNKNOWN)
+
+// Indexed by DXGI_FORMAT, from UNKNOWN up to B4G4R4A4_UNORM.
+static Q_DECL_CONSTEXPR const QD3D12FormatInfo qd3d12FormatInfoTable[] = {
+    QD3D12_FORMAT(UNKNOWN, 0, 0, 0, 0, 0, UNKNOWN, UNKNOWN, UNKNOWN),
+
+    QD3D12_TYPELESS(R32G32B32A32_TYPELESS, 16),
+    QD3D12_PLAIN(R32G32B32A32_FLOAT, 16, R32G32B32A32_TYPELESS),
+    QD3D12_PLAIN(R32G32B32A32_UINT, 16, R32G32B32A32_TYPELESS),
+    QD3D12_PLAIN(R32G32B32A32_SINT, 16, R32G32B32A32_TYPELESS),
+
+    QD3D12_TYPELESS(R32G32B32_TYPELESS, 12),
+    QD3D12_PLAIN(R32G32B32_FLOAT, 12, R32G32B32_TYPELESS),
+    QD3D12_PLAIN(R32G32B32_UINT, 12, R32G32B32_TYPELESS),
+    QD3D12_PLAIN(R32G32B32_SINT, 12, R32G32B32_TYPELESS),
+
+    QD3D12_TYPELESS(R16G16B16A16_TYPELESS, 8),
+    QD3D12_PLAIN(R16G16B16A16_FLOAT, 8, R16G16B16A16_TYPELESS),
+    QD3D12_PLAIN(R16G16B16A16_UNORM, 8, R16G16B16A16_TYPELESS),
+    QD3D12_PLAIN(R16G16B16A16_UINT, 8, R16G16B16A16_TYPELESS),
+    QD3D12_PLAIN(R16G16B16A16_SNORM, 8, R16G16B16A16_TYPELESS),
+    QD3D12_PLAIN(R16G16B16A16_SINT, 8, R16G16B16A16_TYPELESS),
+
+    QD3D12_TYPELESS(R32G32_TYPELESS, 8),
+    QD3D12_PLAIN(R32G32_FLOAT, 8, R32G32_TYPELESS),
+    QD3D12_PLAIN(R32G32_UINT, 8, R32G32_TYPELESS),
+    QD3D12_PLAIN(R32G32_SINT, 8, R32G32_TYPELESS),
+
+    QD3D12_FORMAT(R32G8X24_TYPELESS, 1, 1, 8, 2,
+                  QD3D12FormatInfo::Typeless | QD3D12FormatInfo::Planar,
+                  R32G8X24_TYPELESS, UNKNOWN, UNKNOWN),
+    QD3D12_FORMAT(D32_FLOAT_S8X24_UINT, 1, 1, 8, 2,
+                  QD3D12FormatInfo::Depth | QD3D12FormatInfo::Stencil | QD3D12FormatInfo::Planar,
+                  R32G8X24_TYPELESS, D32_FLOAT_S8X24_UINT, UNKNOWN),
+    QD3D12_PLAIN(R32_FLOAT_X8X24_TYPELESS, 8, R32G8X24_TYPELESS),
+    QD3D12_PLAIN(X32_TYPELESS_G8X24_UINT, 8, R32G8X24_TYPELESS),
+
+    QD3D12_TYPELESS(R10G10B10A2_TYPELESS, 4),
+    QD3D12_PLAIN(R10G10B10A2_UNORM, 4, R10G10B10A2_TYPELESS),
+    QD3D12_PLAIN(R10G10B10A2_UINT, 4, R10G10B10A2_TYPELESS),
+    QD3D12_PLAIN(R11G11B10_FLOAT, 4, UNKNOWN),
+
+    QD3D12_FORMAT(R8G8B8A8_TYPELESS, 1, 1, 4, 1, QD3D12FormatInfo::Typeless,
+                  R8G8B8A8_TYPELESS, R8G8B8A8_UNORM, R8G8B8A8_UNORM_SRGB),
+    QD3D12_FORMAT(R8G8B8A8_UNORM, 1, 1, 4, 1, 0, R8G8B8A8_TYPELESS, R8G8B8A8_UNORM, R8G8B8A8_UNORM_SRGB),
+    QD3D12_FORMAT(R8G8B8A8_UNORM_SRGB, 1, 1, 4, 1, QD3D12FormatInfo::SRgb,
+                  R8G8B8A8_TYPELESS, R8G8B8A8_UNORM, R8G8B8A8_UNORM_SRGB),
+    QD3D12_PLAIN(R8G8B8A8_UINT, 4, R8G8B8A8_TYPELESS),
+    QD3D12_PLAIN(R8G8B8A8_SNORM, 4, R8G8B8A8_TYPELESS),
+    QD3D12_PLAIN(R8G8B8A8_SINT, 4, R8G8B8A8_TYPELESS),
+
+    QD3D12_TYPELESS(R16G16_TYPELESS, 4),
+    QD3D12_PLAIN(R16G16_FLOAT, 4, R16G16_TYPELESS),
+    QD3D12_PLAIN(R16G16_UNORM, 4, R16G16_TYPELESS),
+    QD3D12_PLAIN(R16G16_UINT, 4, R16G16_TYPELESS),
+    QD3D12_PLAIN(R16G16_SNORM, 4, R16G16_TYPELESS),
+    QD3D12_PLAIN(R16G16_SINT, 4, R16G16_TYPELESS),
+
+    QD3D12_TYPELESS(R32_TYPELESS, 4),
+    QD3D12_FORMAT(D32_FLOAT, 1, 1, 4, 1, QD3D12FormatInfo::Depth, R32_TYPELESS, D32_FLOAT, UNKNOWN),
+    QD3D12_PLAIN(R32_FLOAT, 4, R32_TYPELESS),
+    QD3D12_PLAIN(R32_UINT, 4, R32_TYPELESS),
+    QD3D12_PLAIN(R32_SINT, 4, R32_TYPELESS),
+
+    QD3D12_FORMAT(R24G8_TYPELESS, 1, 1, 4, 2,
+                  QD3D12FormatInfo::Typeless | QD3D12FormatInfo::Planar,
+                  R24G8_TYPELESS, UNKNOWN, UNKNOWN),
+    QD3D12_FORMAT(D24_UNORM_S8_UINT, 1, 1, 4, 2,
+                  QD3D12FormatInfo::Depth | QD3D12FormatInfo::Stencil | QD3D12FormatInfo::Planar,
+                  R24G8_TYPELESS, D24_UNORM_S8_UINT, UNKNOWN),
+    QD3D12_PLAIN(R24_UNORM_X8_TYPELESS, 4, R24G8_TYPELESS),
+    QD3D12_PLAIN(X24_TYPELESS_G8_UINT, 4, R24G8_TYPELESS),
+
+    QD3D12_TYPELESS(R8G8_TYPELESS, 2),
+    QD3D12_PLAIN(R8G8_UNORM, 2, R8G8_TYPELESS),
+    QD3D12_PLAIN(R8G8_UINT, 2, R8G8_TYPELESS),
+    QD3D12_PLAIN(R8G8_SNORM, 2, R8G8_TYPELESS),
+    QD3D12_PLAIN(R8G8_SINT, 2, R8G8_TYPELESS),
+
+    QD3D12_TYPELESS(R16_TYPELESS, 2),
+    QD3D12_PLAIN(R16_FLOAT, 2, R16_TYPELESS),
+    QD3D12_FORMAT(D16_UNORM, 1, 1, 2, 1, QD3D12FormatInfo::Depth, R16_TYPELESS, D16_UNORM, UNKNOWN),
+    QD3D12_PLAIN(R16_UNORM, 2, R16_TYPELESS),
+    QD3D12_PLAIN(R16_UINT, 2, R16_TYPELESS),
+    QD3D12_PLAIN(R16_SNORM, 2, R16_TYPELESS),
+    QD3D12_PLAIN(R16_SINT, 2, R16_TYPELESS),
+
+    QD3D12_TYPELESS(R8_TYPELESS, 1),
+    QD3D12_PLAIN(R8_UNORM, 1, R8_TYPELESS),
+    QD3D12_PLAIN(R8_UINT, 1, R8_TYPELESS),
+    QD3D12_PLAIN(R8_SNORM, 1, R8_TYPELESS),
+    QD3D12_PLAIN(R8_SINT, 1, R8_TYPELESS),
+    QD3D12_PLAIN(A8_UNORM, 1, UNKNOWN),
+
+    QD3D12_FORMAT(R1_UNORM, 8, 1, 1, 1, 0, UNKNOWN, R1_UNORM, UNKNOWN),
+    QD3D12_PLAIN(R9G9B9E5_SHAREDEXP, 4, UNKNOWN),
+    QD3D12_FORMAT(R8G8_B8G8_UNORM, 2, 1, 4, 1, QD3D12FormatInfo::Packed, UNKNOWN, R8G8_B8G8_UNORM, UNKNOWN),
+    QD3D12_FORMAT(G8R8_G8B8_UNORM, 2, 1, 4, 1, QD3D12FormatInfo::Packed, UNKNOWN, G8R8_G8B8_UNORM, UNKNOWN),
+
+    QD3D12_FORMAT(BC1_TYPELESS, 4, 4, 8, 1, QD3D12FormatInfo::BlockCompressed | QD3D12FormatInfo::Typeless,
+                  BC1_TYPELESS, BC1_UNORM, BC1_UNORM_SRGB),
+    QD3D12_FORMAT(BC1_UNORM, 4, 4, 8, 1, QD3D12FormatInfo::BlockCompressed,
+                  BC1_TYPELESS, BC1_UNORM, BC1_UNORM_SRGB),
+    QD3D12_FORMAT(BC1_UNORM_SRGB, 4, 4, 8, 1, QD3D12FormatInfo::BlockCompressed | QD3D12FormatInfo::SRgb,
+                  BC1_TYPELESS, BC1_UNORM, BC1_UNORM_SRGB),
+    QD3D12_FORMAT(BC2_TYPELESS, 4, 4, 16, 1, QD3D12FormatInfo::BlockCompressed | QD3D12FormatInfo::Typeless,
+                  BC2_TYPELESS, BC2_UNORM, BC2_UNORM_SRGB),
+    QD3D12_FORMAT(BC2_UNORM, 4, 4, 16, 1, QD3D12FormatInfo::BlockCompressed,
+                  BC2_TYPELESS, BC2_UNORM, BC2_UNORM_SRGB),
+    QD3D12_FORMAT(BC2_UNORM_SRGB, 4, 4, 16, 1, QD3D12FormatInfo::BlockCompressed | QD3D12FormatInfo::SRgb,
+                  BC2_TYPELESS, BC2_UNORM, BC2_UNORM_SRGB),
+    QD3D12_FORMAT(BC3_TYPELESS, 4, 4, 16, 1, QD3D12FormatInfo::BlockCompressed | QD3D12FormatInfo::Typeless,
+                  BC3_TYPELESS, BC3_UNORM, BC3_UNORM_SRGB),
+    QD3D12_FORMAT(BC3_UNORM, 4, 4, 16, 1, QD3D12FormatInfo::BlockCompressed,
+                  BC3_TYPELESS, BC3_UNORM, BC3_UNORM_SRGB),
+    QD3D12_FORMAT(BC3_UNORM_SRGB, 4, 4, 16, 1, QD3D12FormatInfo::BlockCompressed | QD3D12FormatInfo::SRgb,
+                  BC3_TYPELESS, BC3_UNORM, BC3_UNORM_SRGB),
+    QD3D12_FORMAT(BC4_TYPELESS, 4, 4, 8, 1, QD3D12FormatInfo::BlockCompressed | QD3D12FormatInfo::Typeless,
+                  BC4_TYPELESS, UNKNOWN, UNKNOWN),
+    QD3D12_FORMAT(BC4_UNORM, 4, 4, 8, 1, QD3D12FormatInfo::BlockCompressed, BC4_TYPELESS, BC4_UNORM, UNKNOWN),
+    QD3D12_FORMAT(BC4_SNORM, 4, 4, 8, 1, QD3D12FormatInfo::BlockCompressed, BC4_TYPELESS, BC4_SNORM, UNKNOWN),
+    QD3D12_FORMAT(BC5_TYPELESS, 4, 4, 16, 1, QD3D12FormatInfo::BlockCompressed | QD3D12FormatInfo::Typeless,
+                  BC5_TYPELESS, UNKNOWN, UNKNOWN),
+    QD3D12_FORMAT(BC5_UNORM, 4, 4, 16, 1, QD3D12FormatInfo::BlockCompressed, BC5_TYPELESS, BC5_UNORM, UNKNOWN),
+    QD3D12_FORMAT(BC5_SNORM, 4, 4, 16, 1, QD3D12FormatInfo::BlockCompressed, BC5_TYPELESS, BC5_SNORM, UNKNOWN),
+
+    QD3D12_PLAIN(B5G6R5_UNORM, 2, UNKNOWN),
+    QD3D12_PLAIN(B5G5R5A1_UNORM, 2, UNKNOWN),
+    QD3D12_FORMAT(B8G8R8A8_UNORM, 1, 1, 4, 1, 0, B8G8R8A8_TYPELESS, B8G8R8A8_UNORM, B8G8R8A8_UNORM_SRGB),
+    QD3D12_FORMAT(B8G8R8X8_UNORM, 1, 1, 4, 1, 0, B8G8R8X8_TYPELESS, B8G8R8X8_UNORM, B8G8R8X8_UNORM_SRGB),
+    QD3D12_PLAIN(R10G10B10_XR_BIAS_A2_UNORM, 4, R10G10B10A2_TYPELESS),
+    QD3D12_FORMAT(B8G8R8A8_TYPELESS, 1, 1, 4, 1, QD3D12FormatInfo::Typeless,
+                  B8G8R8A8_TYPELESS, B8G8R8A8_UNORM, B8G8R8A8_UNORM_SRGB),
+    QD3D12_FORMAT(B8G8R8A8_UNORM_SRGB, 1, 1, 4, 1, QD3D12FormatInfo::SRgb,
+                  B8G8R8A8_TYPELESS, B8G8R8A8_UNORM, B8G8R8A8_UNORM_SRGB),
+    QD3D12_FORMAT(B8G8R8X8_TYPELESS, 1, 1, 4, 1, QD3D12FormatInfo::Typeless,
+                  B8G8R8X8_TYPELESS, B8G8R8X8_UNORM, B8G8R8X8_UNORM_SRGB),
+    QD3D12_FORMAT(B8G8R8X8_UNORM_SRGB, 1, 1, 4, 1, QD3D12FormatInfo::SRgb,
+                  B8G8R8X8_TYPELESS, B8G8R8X8_UNORM, B8G8R8X8_UNORM_SRGB),
+
+    QD3D12_FORMAT(BC6H_TYPELESS, 4, 4, 16, 1, QD3D12FormatInfo::BlockCompressed | QD3D12FormatInfo::Typeless,
+                  BC6H_TYPELESS, UNKNOWN, UNKNOWN),
+    QD3D12_FORMAT(BC6H_UF16, 4, 4, 16, 1, QD3D12FormatInfo::BlockCompressed, BC6H_TYPELESS, BC6H_UF16, UNKNOWN),
+    QD3D12_FORMAT(BC6H_SF16, 4, 4, 16, 1, QD3D12FormatInfo::BlockCompressed, BC6H_TYPELESS, BC6H_SF16, UNKNOWN),
+    QD3D12_FORMAT(BC7_TYPELESS, 4, 4, 16, 1, QD3D12FormatInfo::BlockCompressed | QD3D12FormatInfo::Typeless,
+                  BC7_TYPELESS, BC7_UNORM, BC7_UNORM_SRGB),
+    QD3D12_FORMAT(BC7_UNORM, 4, 4, 16, 1, QD3D12FormatInfo::BlockCompressed,
+                  BC7_TYPELESS, BC7_UNORM, BC7_UNORM_SRGB),
+    QD3D12_FORMAT(BC7_UNORM_SRGB, 4, 4, 16, 1, QD3D12FormatInfo::BlockCompressed | QD3D12FormatInfo::SRgb,
+                  BC7_TYPELESS, BC7_UNORM, BC7_UNORM_SRGB),
+
+    // For the planar video formats the block describes the luma plane.
+    QD3D12_FORMAT(AYUV, 1, 1, 4, 1, QD3D12FormatInfo::Video, UNKNOWN, AYUV, UNKNOWN),
+    QD3D12_FORMAT(Y410, 1, 1, 4, 1, QD3D12FormatInfo::Video, UNKNOWN, Y410, UNKNOWN),
+    QD3D12_FORMAT(Y416, 1, 1, 8, 1, QD3D12FormatInfo::Video, UNKNOWN, Y416, UNKNOWN),
+    QD3D12_FORMAT(NV12, 1, 1, 1, 2, QD3D12FormatInfo::Video | QD3D12FormatInfo::Planar, UNKNOWN, NV12, UNKNOWN),
+    QD3D12_FORMAT(P010, 1, 1, 2, 2, QD3D12FormatInfo::Video | QD3D12FormatInfo::Planar, UNKNOWN, P010, UNKNOWN),
+    QD3D12_FORMAT(P016, 1, 1, 2, 2, QD3D12FormatInfo::Video | QD3D12FormatInfo::Planar, UNKNOWN, P016, UNKNOWN),
+    QD3D12_FORMAT(420_OPAQUE, 1, 1, 1, 2, QD3D12FormatInfo::Video | QD3D12FormatInfo::Planar,
+                  UNKNOWN, 420_OPAQUE, UNKNOWN),
+    QD3D12_FORMAT(YUY2, 2, 1, 4, 1, QD3D12FormatInfo::Video | QD3D12FormatInfo::Packed, UNKNOWN, YUY2, UNKNOWN),
+    QD3D12_FORMAT(Y210, 2, 1, 8, 1, QD3D12FormatInfo::Video | QD3D12FormatInfo::Packed, UNKNOWN, Y210, UNKNOWN),
+    QD3D12_FORMAT(Y216, 2, 1, 8, 1, QD3D12FormatInfo::Video | QD3D12FormatInfo::Packed, UNKNOWN, Y216, UNKNOWN),
+    QD3D12_FORMAT(NV11, 1, 1, 1, 2, QD3D12FormatInfo::Video | QD3D12FormatInfo::Planar, UNKNOWN, NV11, UNKNOWN),
+    QD3D12_FORMAT(AI44, 1, 1, 1, 1, QD3D12FormatInfo::Video, UNKNOWN, AI44, UNKNOWN),
+    QD3D12_FORMAT(IA44, 1, 1, 1, 1, QD3D12FormatInfo::Video, UNKNOWN, IA44, UNKNOWN),
+    QD3D12_FORMAT(P8, 1, 1, 1, 1, QD3D12FormatInfo::Video, UNKNOWN, P8, UNKNOWN),
+    QD3D12_FORMAT(A8P8, 1, 1, 2, 1, QD3D12FormatInfo::Video, UNKNOWN, A8P8, UNKNOWN),
+    QD3D12_PLAIN(B4G4R4A4_UNORM, 2, UNKNOWN)
+};
+
+#undef QD3D12_TYPELESS
+#undef QD3D12_PLAIN
+#undef QD3D12_FORMAT
+
+// Formats past the table, such as the newer video ones, come back invalid.
+Q_DECL_CONSTEXPR inline QD3D12FormatInfo QD3D12FormatInfo::forFormat(DXGI_FORMAT format)
+{
+    return uint(format) < sizeof(qd3d12FormatInfoTable) / sizeof(qd3d12FormatInfoTable[0])
+            ? qd3d12FormatInfoTable[format] : qd3d12FormatInfoTable[0];
+}
+
+QT_END_NAMESPACE
+
+#endif
@@ -0,0 +1,204 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtD3D12Window module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qd3d12frametrace_p.h"
+
+#ifdef QD3D12_FRAME_TRACE
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QMutex>
+
+QT_BEGIN_NAMESPACE
+
+Q_GLOBAL_STATIC(QMutex, ringListMutex)
+typedef QVector<QD3D12TraceRing *> RingList;
+Q_GLOBAL_STATIC(RingList, ringList)
+
+static QElapsedTimer *traceClock()
+{
+    static QElapsedTimer *t = Q_NULLPTR;
+    if (!t) {
+        t = new QElapsedTimer;
+        t->start();
+    }
+    return t;
+}
+
+// Make sure the clock is started before any second thread can race for it.
+static struct QD3D12TraceClockInit { QD3D12TraceClockInit() { traceClock(); } } traceClockInit;
+
+qint64 QD3D12FrameTrace::now()
+{
+    return traceClock()->nsecsElapsed();
+}
+
+QD3D12TraceRing::QD3D12TraceRing()
+    : threadId(GetCurrentThreadId()),
+      head(0)
+{
+}
+
+QD3D12TraceRing *QD3D12TraceRing::current()
+{
+    // Rings are never freed: events from threads that have finished are still
+    // wanted in the export, and the number of threads rendering is small.
+    static thread_local QD3D12TraceRing *ring = Q_NULLPTR;
+    if (!ring) {
+        ring = new QD3D12TraceRing;
+        QMutexLocker lock(ringListMutex());
+        ringList()->append(ring);
+    }
+    return ring;
+}
+
+// A slot is only taken when its sequence number is the same before and after
+// copying the fields, so events the writer laps or is in the middle of
+// rewriting are dropped instead of coming out torn.
+QVector<QD3D12TraceEvent> QD3D12TraceRing::snapshot() const
+{
+    const quint64 h = head.loadAcquire();
+    const quint64 first = h > quint64(CAPACITY) ? h - CAPACITY : 0;
+
+    QVector<QD3D12TraceEvent> result;
+    result.reserve(int(h - first));
+    for (quint64 i = first; i < h; ++i) {
+        const QD3D12TraceSlot &slot(slots[i & (CAPACITY - 1)]);
+        if (slot.seq.loadAcquire() != i + 1)
+            continue;
+        QD3D12TraceEvent e;
+        e.name = slot.name.loadAcquire();
+        e.begin = slot.begin.loadAcquire();
+        e.end = slot.end.loadAcquire();
+        if (slot.seq.load() != i + 1)
+            continue;
+        result.append(e);
+    }
+    return result;
+}
+
+QD3D12FrameTimeHistogram::QD3D12FrameTimeHistogram()
+    : count(0),
+      next(0)
+{
+    memset(buckets, 0, sizeof(buckets));
+}
+
+void QD3D12FrameTimeHistogram::add(float ms)
+{
+    if (count == WINDOW)
+        --buckets[bucket(samples[next])];
+    else
+        ++count;
+
+    samples[next] = ms;
+    ++buckets[bucket(ms)];
+    next = (next + 1) % WINDOW;
+}
+
+QD3D12Window::FrameTimeStatistics QD3D12FrameTimeHistogram::statistics() const
+{
+    QD3D12Window::FrameTimeStatistics stats;
+    stats.sampleCount = count;
+    if (!count)
+        return stats;
+
+    for (int i = 0; i < count; ++i)
+        stats.max = qMax(stats.max, samples[i]);
+
+    const int ranks[3] = { (count * 50 + 99) / 100, (count * 95 + 99) / 100, (count * 99 + 99) / 100 };
+    float *results[3] = { &stats.p50, &stats.p95, &stats.p99 };
+    int r = 0;
+    int seen = 0;
+    for (int i = 0; i < BUCKETS && r < 3; ++i) {
+        seen += buckets[i];
+        while (r < 3 && seen >= ranks[r]) {
+            // The last bucket is open ended, report the maximum for it.
+            *results[r] = i == BUCKETS - 1 ? stats.max : qMin(stats.max, (i + 1) / 10.0f);
+            ++r;
+        }
+    }
+    return stats;
+}
+
+// Writes the events of all threads in the Trace Event Format understood by
+// chrome://tracing and Perfetto.
+bool QD3D12FrameTrace::exportChromeTrace(const QString &fileName)
+{
+    RingList rings;
+    {
+        QMutexLocker lock(ringListMutex());
+        rings = *ringList();
+    }
+
+    QFile f(fileName);
+    if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning("Failed to open %s for writing", qPrintable(fileName));
+        return false;
+    }
+
+    const qint64 pid = QCoreApplication::applicationPid();
+    QByteArray out = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    foreach (QD3D12TraceRing *ring, rings) {
+        const QVector<QD3D12TraceEvent> events = ring->snapshot();
+        if (!first)
+            out += ',';
+        first = false;
+        out += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" + QByteArray::number(pid)
+                + ",\"tid\":" + QByteArray::number(ring->threadId)
+                + ",\"args\":{\"name\":\"thread " + QByteArray::number(ring->threadId) + "\"}}";
+        foreach (const QD3D12TraceEvent &e, events) {
+            out += ",{\"name\":\"" + QByteArray(e.name) + "\",\"cat\":\"d3d12\",\"ph\":\"X\",\"ts\":"
+                    + QByteArray::number(e.begin / 1000.0, 'f', 3)
+                    + ",\"dur\":" + QByteArray::number((e.end - e.begin) / 1000.0, 'f', 3)
+                    + ",\"pid\":" + QByteArray::number(pid)
+                    + ",\"tid\":" + QByteArray::number(ring->threadId) + '}';
+        }
+        if (out.size() > 1024 * 1024) {
+            f.write(out);
+            out.clear();
+        }
+    }
+    out += "]}\n";
+    f.write(out);
+    return f.error() == QFile::NoError;
+}
+
+QT_END_NAMESPACE
+
+#endif // QD3D12_FRAME_TRACE
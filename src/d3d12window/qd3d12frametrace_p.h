@@ -0,0 +1,182 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtD3D12Window module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QD3D12FRAMETRACE_P_H
+#define QD3D12FRAMETRACE_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "qd3d12window.h"
+#include <QtCore/QAtomicInteger>
+#include <QtCore/QAtomicPointer>
+#include <QtCore/QVector>
+
+QT_BEGIN_NAMESPACE
+
+// CPU side frame instrumentation. Everything here is compiled out unless the
+// module is configured with CONFIG+=d3d12_frame_trace, which defines
+// QD3D12_FRAME_TRACE.
+
+#ifdef QD3D12_FRAME_TRACE
+
+struct QD3D12TraceEvent
+{
+    const char *name; // must be a string literal
+    qint64 begin;
+    qint64 end;
+};
+
+// One ring entry. seq is the index of the event in the slot plus one, and 0
+// while the owning thread is rewriting it. The fields are atomics so that a
+// reader copying the slot concurrently is well defined; the release stores
+// and acquire loads are plain moves on x86.
+struct QD3D12TraceSlot
+{
+    QAtomicInteger<quint64> seq;
+    QAtomicPointer<const char> name;
+    QAtomicInteger<qint64> begin;
+    QAtomicInteger<qint64> end;
+};
+
+// Single producer ring, one per thread. Writing never blocks or allocates;
+// readers take a snapshot and drop the slots that were rewritten while
+// copying them.
+class QD3D12TraceRing
+{
+public:
+    static const int CAPACITY = 1 << 14;
+
+    QD3D12TraceRing();
+
+    void record(const char *name, qint64 begin, qint64 end)
+    {
+        const quint64 h = head.load();
+        QD3D12TraceSlot &slot(slots[h & (CAPACITY - 1)]);
+        slot.seq.store(0);
+        slot.name.storeRelease(name);
+        slot.begin.storeRelease(begin);
+        slot.end.storeRelease(end);
+        slot.seq.storeRelease(h + 1);
+        head.storeRelease(h + 1);
+    }
+
+    QVector<QD3D12TraceEvent> snapshot() const;
+
+    static QD3D12TraceRing *current();
+
+    quint32 threadId;
+    QAtomicInteger<quint64> head;
+    QD3D12TraceSlot slots[CAPACITY];
+};
+
+// Rolling window of the last WINDOW samples, bucketed at 0.1 ms so that
+// adding a sample is O(1) and percentiles need no sorting.
+class QD3D12FrameTimeHistogram
+{
+public:
+    static const int WINDOW = 1024;
+    static const int BUCKETS = 1000;
+
+    QD3D12FrameTimeHistogram();
+
+    void add(float ms);
+    QD3D12Window::FrameTimeStatistics statistics() const;
+
+private:
+    static int bucket(float ms) { return qBound(0, int(ms * 10.0f), BUCKETS - 1); }
+
+    float samples[WINDOW];
+    int count;
+    int next;
+    quint16 buckets[BUCKETS];
+};
+
+class QD3D12FrameTrace
+{
+public:
+    static qint64 now();
+    static bool exportChromeTrace(const QString &fileName);
+
+    QD3D12FrameTimeHistogram histograms[QD3D12Window::ResizePhase + 1];
+};
+
+class QD3D12TraceScope
+{
+public:
+    QD3D12TraceScope(const char *name, QD3D12FrameTimeHistogram *histogram = Q_NULLPTR)
+        : m_name(name), m_histogram(histogram), m_begin(QD3D12FrameTrace::now())
+    { }
+    ~QD3D12TraceScope()
+    {
+        const qint64 end = QD3D12FrameTrace::now();
+        QD3D12TraceRing::current()->record(m_name, m_begin, end);
+        if (m_histogram)
+            m_histogram->add((end - m_begin) / 1000000.0f);
+    }
+
+private:
+    Q_DISABLE_COPY(QD3D12TraceScope)
+    const char *m_name;
+    QD3D12FrameTimeHistogram *m_histogram;
+    qint64 m_begin;
+};
+
+#define QD3D12_TRACE_CONCAT_(a, b) a ## b
+#define QD3D12_TRACE_CONCAT(a, b) QD3D12_TRACE_CONCAT_(a, b)
+#define QD3D12_TRACE_SCOPE(name) \
+    QD3D12TraceScope QD3D12_TRACE_CONCAT(qd3d12TraceScope, __LINE__)(name)
+#define QD3D12_TRACE_PHASE(d, phase, name) \
+    QD3D12TraceScope QD3D12_TRACE_CONCAT(qd3d12TraceScope, __LINE__)(name, &(d)->frameTrace.histograms[phase])
+
+#else
+
+#define QD3D12_TRACE_SCOPE(name) (void) 0
+#define QD3D12_TRACE_PHASE(d, phase, name) (void) 0
+
+#endif // QD3D12_FRAME_TRACE
+
+QT_END_NAMESPACE
+
+#endif
@@ -0,0 +1,361 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtD3D12Window module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qd3d12glyphatlas_p.h"
+#include "qd3d12util_p.h"
+#include <QtCore/qmath.h>
+#include <QtGui/QGlyphRun>
+#include <QtGui/QPainter>
+#include <QtGui/QTextLayout>
+
+QT_BEGIN_NAMESPACE
+
+// Shelf heights are rounded up so that glyphs of similar size share rows.
+static const int SHELF_GRANULARITY = 4;
+static const int MAX_RUNS = 4096;
+
+// Picks the lowest shelf the glyph fits in, or opens a new one below the
+// last. size includes the gap to the next glyph.
+bool QD3D12GlyphAtlasPrivate::allocate(const QSize &size, QPoint *pos, int *shelf)
+{
+    int best = -1;
+    for (int i = 0; i < shelves.count(); ++i) {
+        const QD3D12GlyphShelf &s(shelves.at(i));
+        if (size.height() <= s.height && s.x + size.width() <= image.width()
+                && (best < 0 || s.height < shelves.at(best).height))
+            best = i;
+    }
+
+    if (best < 0) {
+        const int y = shelves.isEmpty() ? 0 : shelves.last().y + shelves.last().height;
+        const int height = (size.height() + SHELF_GRANULARITY - 1) / SHELF_GRANULARITY * SHELF_GRANULARITY;
+        if (y + height > image.height() || size.width() > image.width()) {
+            full = true;
+            return false;
+        }
+        QD3D12GlyphShelf s;
+        s.y = y;
+        s.height = height;
+        s.x = 0;
+        shelves.append(s);
+        best = shelves.count() - 1;
+    }
+
+    QD3D12GlyphShelf &s(shelves[best]);
+    *pos = QPoint(s.x, s.y);
+    *shelf = best;
+    s.x += size.width();
+    return true;
+}
+
+QString QD3D12GlyphAtlasPrivate::fontKey(const QRawFont &font) const
+{
+    return font.familyName() + QLatin1Char('/') + font.styleName() + QLatin1Char('/')
+            + QString::number(font.pixelSize()) + QLatin1Char('/') + QString::number(font.weight())
+            + QLatin1Char('/') + QString::number(int(font.style()));
+}
+
+// Caches glyphs in a single channel texture. Glyphs are rasterized once, at
+// the pixel size of the QRawFont they are requested with, by filling their
+// outline with the raster paint engine, and packed into shelves. Only the
+// changed parts of the texture are uploaded.
+//
+// textRun() lays out a string with QTextLayout, including font merging and
+// shaping, and caches the resulting glyph rectangles, so drawing text that
+// was drawn before costs one hash lookup.
+QD3D12GlyphAtlas::QD3D12GlyphAtlas()
+    : d_ptr(new QD3D12GlyphAtlasPrivate)
+{
+}
+
+QD3D12GlyphAtlas::~QD3D12GlyphAtlas()
+{
+}
+
+bool QD3D12GlyphAtlas::create(ID3D12Device *device, const QSize &size)
+{
+    Q_D(QD3D12GlyphAtlas);
+    destroy();
+
+    D3D12_RESOURCE_DESC desc = {};
+    desc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+    desc.Width = size.width();
+    desc.Height = size.height();
+    desc.DepthOrArraySize = 1;
+    desc.MipLevels = 1;
+    desc.Format = DXGI_FORMAT_R8_UNORM;
+    desc.SampleDesc.Count = 1;
+    desc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
+    D3D12_HEAP_PROPERTIES heapProp = {};
+    heapProp.Type = D3D12_HEAP_TYPE_DEFAULT;
+    if (FAILED(device->CreateCommittedResource(&heapProp, D3D12_HEAP_FLAG_NONE, &desc, D3D12_RESOURCE_STATE_COPY_DEST,
+                                               Q_NULLPTR, IID_PPV_ARGS(&d->texture)))) {
+        qWarning("QD3D12GlyphAtlas: Failed to create %dx%d atlas texture", size.width(), size.height());
+        return false;
+    }
+
+    d->device = device;
+    d->state = D3D12_RESOURCE_STATE_COPY_DEST;
+    d->image = QImage(size, QImage::Format_Alpha8);
+    clear();
+    return true;
+}
+
+void QD3D12GlyphAtlas::destroy()
+{
+    Q_D(QD3D12GlyphAtlas);
+    d->texture.Reset();
+    d->device.Reset();
+    d->image = QImage();
+    d->shelves.clear();
+    d->glyphs.clear();
+    d->runs.clear();
+    d->fontIds.clear();
+    d->full = false;
+}
+
+bool QD3D12GlyphAtlas::isCreated() const
+{
+    Q_D(const QD3D12GlyphAtlas);
+    return d->texture.Get() != Q_NULLPTR;
+}
+
+QSize QD3D12GlyphAtlas::size() const
+{
+    Q_D(const QD3D12GlyphAtlas);
+    return d->image.size();
+}
+
+ID3D12Resource *QD3D12GlyphAtlas::texture() const
+{
+    Q_D(const QD3D12GlyphAtlas);
+    return d->texture.Get();
+}
+
+void QD3D12GlyphAtlas::createShaderResourceView(D3D12_CPU_DESCRIPTOR_HANDLE handle) const
+{
+    Q_D(const QD3D12GlyphAtlas);
+    D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+    srvDesc.Shader4ComponentMapping = D3D12_ENCODE_SHADER_4_COMPONENT_MAPPING(0, 0, 0, 0);
+    srvDesc.Format = DXGI_FORMAT_R8_UNORM;
+    srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+    srvDesc.Texture2D.MipLevels = 1;
+    d->device->CreateShaderResourceView(d->texture.Get(), &srvDesc, handle);
+}
+
+// Returns a null glyph for glyphs without pixels, like spaces, and when the
+// atlas is full.
+QD3D12GlyphAtlas::Glyph QD3D12GlyphAtlas::glyph(const QRawFont &font, quint32 glyphIndex)
+{
+    Q_D(QD3D12GlyphAtlas);
+    if (d->image.isNull() || d->full)
+        return Glyph();
+
+    const QString fontKey = d->fontKey(font);
+    QHash<QString, quint32>::const_iterator fontIt = d->fontIds.constFind(fontKey);
+    if (fontIt == d->fontIds.cend())
+        fontIt = d->fontIds.insert(fontKey, d->fontIds.count());
+    const quint64 key = (quint64(*fontIt) << 32) | glyphIndex;
+
+    QHash<quint64, Glyph>::const_iterator it = d->glyphs.constFind(key);
+    if (it != d->glyphs.cend())
+        return *it;
+
+    Glyph g;
+    const QPainterPath path = font.pathForGlyph(glyphIndex);
+    const QRectF bounds = path.boundingRect();
+    if (bounds.isEmpty()) {
+        d->glyphs.insert(key, g);
+        return g;
+    }
+
+    // One pixel of empty border for the antialiased edges, plus a gap to
+    // the next glyph.
+    const int left = qFloor(bounds.left()) - 1;
+    const int top = qFloor(bounds.top()) - 1;
+    const QRect rect(left, top, qCeil(bounds.right()) + 1 - left, qCeil(bounds.bottom()) + 1 - top);
+    QPoint pos;
+    int shelf;
+    if (!d->allocate(rect.size() + QSize(1, 1), &pos, &shelf))
+        return g;
+
+    QPainter p(&d->image);
+    p.setRenderHint(QPainter::Antialiasing);
+    p.translate(pos - rect.topLeft());
+    p.fillPath(path, Qt::black);
+    p.end();
+
+    d->shelves[shelf].dirty |= QRect(pos, rect.size() + QSize(1, 1));
+    g.rect = rect;
+    g.textureRect = QRectF(qreal(pos.x()) / d->image.width(), qreal(pos.y()) / d->image.height(),
+                           qreal(rect.width()) / d->image.width(), qreal(rect.height()) / d->image.height());
+    d->glyphs.insert(key, g);
+    return g;
+}
+
+// The glyphs of text laid out on one line, positioned relative to the
+// start of the baseline and snapped to whole pixels. scale multiplies the
+// font size, for drawing with a scaling transform or a device pixel ratio.
+// Returns an empty run when the atlas became full.
+QVector<QD3D12GlyphAtlas::Glyph> QD3D12GlyphAtlas::textRun(const QFont &font, const QString &text, qreal scale)
+{
+    Q_D(QD3D12GlyphAtlas);
+    const QString key = font.key() + QLatin1Char('\n') + QString::number(scale) + QLatin1Char('\n') + text;
+    QHash<QString, QVector<Glyph> >::const_iterator it = d->runs.constFind(key);
+    if (it != d->runs.cend())
+        return *it;
+
+    QTextLayout layout(text, font);
+    QTextOption option;
+    option.setWrapMode(QTextOption::NoWrap);
+    layout.setTextOption(option);
+    layout.beginLayout();
+    QTextLine line = layout.createLine();
+    line.setLineWidth(1e6);
+    layout.endLayout();
+    const qreal ascent = line.ascent();
+
+    QVector<Glyph> run;
+    foreach (const QGlyphRun &glyphRun, layout.glyphRuns()) {
+        QRawFont rawFont = glyphRun.rawFont();
+        if (scale != 1)
+            rawFont.setPixelSize(rawFont.pixelSize() * scale);
+        const QVector<quint32> indexes = glyphRun.glyphIndexes();
+        const QVector<QPointF> positions = glyphRun.positions();
+        for (int i = 0; i < indexes.count(); ++i) {
+            Glyph g = glyph(rawFont, indexes.at(i));
+            if (d->full)
+                return QVector<Glyph>();
+            if (g.isNull())
+                continue;
+            g.rect.translate(qRound(positions.at(i).x() * scale), qRound((positions.at(i).y() - ascent) * scale));
+            run.append(g);
+        }
+    }
+
+    if (d->runs.count() >= MAX_RUNS)
+        d->runs.clear();
+    d->runs.insert(key, run);
+    return run;
+}
+
+int QD3D12GlyphAtlas::glyphCount() const
+{
+    Q_D(const QD3D12GlyphAtlas);
+    return d->glyphs.count();
+}
+
+bool QD3D12GlyphAtlas::isFull() const
+{
+    Q_D(const QD3D12GlyphAtlas);
+    return d->full;
+}
+
+// Nothing is uploaded here: every glyph added afterwards uploads its whole
+// cell, so stale texels are never sampled.
+void QD3D12GlyphAtlas::clear()
+{
+    Q_D(QD3D12GlyphAtlas);
+    d->image.fill(0);
+    d->shelves.clear();
+    d->glyphs.clear();
+    d->runs.clear();
+    d->full = false;
+}
+
+quint32 QD3D12GlyphAtlas::pendingUploadSize() const
+{
+    Q_D(const QD3D12GlyphAtlas);
+    quint32 size = 0;
+    foreach (const QD3D12GlyphShelf &shelf, d->shelves) {
+        if (!shelf.dirty.isEmpty()) {
+            size = QD3D12Util::alignedTextureOffset(size);
+            size += QD3D12Util::alignedTexturePitch(shelf.dirty.width()) * shelf.dirty.height();
+        }
+    }
+    return size;
+}
+
+void QD3D12GlyphAtlas::upload(ID3D12GraphicsCommandList *commandList, ID3D12Resource *uploadBuffer,
+                              quint32 uploadOffset, quint8 *uploadData)
+{
+    Q_D(QD3D12GlyphAtlas);
+    if (!d->texture)
+        return;
+
+    quint32 offset = 0;
+    for (int i = 0; i < d->shelves.count(); ++i) {
+        QRect &dirty(d->shelves[i].dirty);
+        if (dirty.isEmpty())
+            continue;
+
+        if (d->state != D3D12_RESOURCE_STATE_COPY_DEST) {
+            // Waits for earlier draws sampling the atlas.
+            QD3D12Util::transitionResource(d->texture.Get(), commandList, d->state, D3D12_RESOURCE_STATE_COPY_DEST);
+            d->state = D3D12_RESOURCE_STATE_COPY_DEST;
+        }
+
+        offset = QD3D12Util::alignedTextureOffset(offset);
+        const quint32 rowPitch = QD3D12Util::alignedTexturePitch(dirty.width());
+        for (int y = 0; y < dirty.height(); ++y)
+            memcpy(uploadData + offset + y * rowPitch, d->image.constScanLine(dirty.top() + y) + dirty.left(), dirty.width());
+
+        D3D12_TEXTURE_COPY_LOCATION dst;
+        dst.pResource = d->texture.Get();
+        dst.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+        dst.SubresourceIndex = 0;
+        D3D12_TEXTURE_COPY_LOCATION src;
+        src.pResource = uploadBuffer;
+        src.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
+        src.PlacedFootprint.Offset = uploadOffset + offset;
+        src.PlacedFootprint.Footprint.Format = DXGI_FORMAT_R8_UNORM;
+        src.PlacedFootprint.Footprint.Width = dirty.width();
+        src.PlacedFootprint.Footprint.Height = dirty.height();
+        src.PlacedFootprint.Footprint.Depth = 1;
+        src.PlacedFootprint.Footprint.RowPitch = rowPitch;
+        commandList->CopyTextureRegion(&dst, dirty.left(), dirty.top(), 0, &src, Q_NULLPTR);
+
+        offset += rowPitch * dirty.height();
+        dirty = QRect();
+    }
+
+    if (d->state != D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE) {
+        QD3D12Util::transitionResource(d->texture.Get(), commandList, d->state, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+        d->state = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
+    }
+}
+
+QT_END_NAMESPACE
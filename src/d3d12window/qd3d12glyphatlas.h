@@ -0,0 +1,99 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtD3D12Window module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QD3D12GLYPHATLAS_H
+#define QD3D12GLYPHATLAS_H
+
+#include <QtCore/QScopedPointer>
+#include <QtCore/QRect>
+#include <QtCore/QVector>
+#include <QtGui/QFont>
+#include <QtGui/QRawFont>
+#include <QtD3D12Window/qd3d12window.h>
+
+QT_BEGIN_NAMESPACE
+
+class QD3D12GlyphAtlasPrivate;
+
+class QD3D12_EXPORT QD3D12GlyphAtlas
+{
+    Q_DECLARE_PRIVATE(QD3D12GlyphAtlas)
+
+public:
+    struct Glyph {
+        bool isNull() const { return rect.isEmpty(); }
+        QRect rect; // in pixels, relative to the pen position on the baseline
+        QRectF textureRect; // normalized
+    };
+
+    QD3D12GlyphAtlas();
+    ~QD3D12GlyphAtlas();
+
+    bool create(ID3D12Device *device, const QSize &size = QSize(1024, 1024));
+    void destroy();
+    bool isCreated() const;
+
+    QSize size() const;
+    ID3D12Resource *texture() const;
+    // An R8_UNORM view with the coverage in all four channels, so that it
+    // can be multiplied with a premultiplied color.
+    void createShaderResourceView(D3D12_CPU_DESCRIPTOR_HANDLE handle) const;
+
+    Glyph glyph(const QRawFont &font, quint32 glyphIndex);
+    QVector<Glyph> textRun(const QFont &font, const QString &text, qreal scale = 1);
+    int glyphCount() const;
+
+    // When a glyph does not fit, glyph() and textRun() return nothing and
+    // the atlas reports full until clear() is called. Clearing is safe once
+    // the draws using the old contents are recorded.
+    bool isFull() const;
+    void clear();
+
+    // Records the copies of the glyphs added since the last upload. The
+    // caller provides pendingUploadSize() bytes of mapped upload memory at
+    // an offset aligned to D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT.
+    quint32 pendingUploadSize() const;
+    void upload(ID3D12GraphicsCommandList *commandList, ID3D12Resource *uploadBuffer,
+                quint32 uploadOffset, quint8 *uploadData);
+
+private:
+    Q_DISABLE_COPY(QD3D12GlyphAtlas)
+    QScopedPointer<QD3D12GlyphAtlasPrivate> d_ptr;
+};
+
+QT_END_NAMESPACE
+
+#endif
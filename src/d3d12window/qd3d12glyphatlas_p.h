@@ -0,0 +1,95 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtD3D12Window module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QD3D12GLYPHATLAS_P_H
+#define QD3D12GLYPHATLAS_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "qd3d12glyphatlas.h"
+#include <QtCore/QHash>
+#include <QtGui/QImage>
+
+QT_BEGIN_NAMESPACE
+
+// A row of glyphs of up to height pixels, filled from the left. dirty is
+// what has been rasterized but not uploaded yet.
+struct QD3D12GlyphShelf
+{
+    int y;
+    int height;
+    int x;
+    QRect dirty;
+};
+
+class QD3D12GlyphAtlasPrivate
+{
+public:
+    QD3D12GlyphAtlasPrivate()
+        : state(D3D12_RESOURCE_STATE_COPY_DEST),
+          full(false)
+    { }
+
+    bool allocate(const QSize &size, QPoint *pos, int *shelf);
+    QString fontKey(const QRawFont &font) const;
+
+    ComPtr<ID3D12Device> device;
+    ComPtr<ID3D12Resource> texture;
+    D3D12_RESOURCE_STATES state;
+
+    // CPU copy of the atlas, Format_Alpha8.
+    QImage image;
+    QVector<QD3D12GlyphShelf> shelves;
+    bool full;
+
+    // Glyphs by font id in the upper and glyph index in the lower 32 bits.
+    QHash<QString, quint32> fontIds;
+    QHash<quint64, QD3D12GlyphAtlas::Glyph> glyphs;
+    QHash<QString, QVector<QD3D12GlyphAtlas::Glyph> > runs;
+};
+
+QT_END_NAMESPACE
+
+#endif
@@ -0,0 +1,387 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtD3D12Window module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include "qd3d12gpubcencoder_p.h"
+#include "qd3d12gpubcencoder_bc1_cs.h"
+#include "qd3d12gpubcencoder_bc7_cs.h"
+#include "qd3d12formatinfo.h"
+
+QT_BEGIN_NAMESPACE
+
+static const int DEFAULT_HEAP_SIZE = 256;
+static const int DESCRIPTORS_PER_ENCODE = 2; // SRV + UAV
+
+static void appendTransition(QVector<D3D12_RESOURCE_BARRIER> *barriers, ID3D12Resource *resource, UINT subresource,
+                             D3D12_RESOURCE_STATES before, D3D12_RESOURCE_STATES after)
+{
+    if (before == after)
+        return;
+
+    D3D12_RESOURCE_BARRIER barrier = {};
+    barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+    barrier.Transition.pResource = resource;
+    barrier.Transition.StateBefore = before;
+    barrier.Transition.StateAfter = after;
+    barrier.Transition.Subresource = subresource;
+    barriers->append(barrier);
+}
+
+bool QD3D12GpuBcEncoderPrivate::reserveDescriptors(int count)
+{
+    if (heap && heapUsed + count <= heapCapacity)
+        return true;
+
+    if (heap) {
+        retiredHeaps.append(heap);
+        heap.Reset();
+    }
+
+    D3D12_DESCRIPTOR_HEAP_DESC heapDesc = {};
+    heapDesc.NumDescriptors = qMax(DEFAULT_HEAP_SIZE, count);
+    heapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+    heapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
+    if (FAILED(device->CreateDescriptorHeap(&heapDesc, IID_PPV_ARGS(&heap)))) {
+        qWarning("QD3D12GpuBcEncoder: Failed to create descriptor heap");
+        return false;
+    }
+    heapCapacity = heapDesc.NumDescriptors;
+    heapUsed = 0;
+    return true;
+}
+
+bool QD3D12GpuBcEncoderPrivate::reserveScratch(quint64 size)
+{
+    if (scratch && scratchSize >= size)
+        return true;
+
+    if (scratch) {
+        retiredScratch.append(scratch);
+        scratch.Reset();
+    }
+
+    D3D12_HEAP_PROPERTIES defaultHeapProp = {};
+    defaultHeapProp.Type = D3D12_HEAP_TYPE_DEFAULT;
+    D3D12_RESOURCE_DESC bufDesc = {};
+    bufDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+    bufDesc.Width = size;
+    bufDesc.Height = 1;
+    bufDesc.DepthOrArraySize = 1;
+    bufDesc.MipLevels = 1;
+    bufDesc.Format = DXGI_FORMAT_UNKNOWN;
+    bufDesc.SampleDesc.Count = 1;
+    bufDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+    bufDesc.Flags = D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
+    if (FAILED(device->CreateCommittedResource(&defaultHeapProp, D3D12_HEAP_FLAG_NONE, &bufDesc,
+                                               D3D12_RESOURCE_STATE_UNORDERED_ACCESS, Q_NULLPTR,
+                                               IID_PPV_ARGS(&scratch)))) {
+        qWarning("QD3D12GpuBcEncoder: Failed to create scratch buffer");
+        return false;
+    }
+    scratchSize = size;
+    scratchState = D3D12_RESOURCE_STATE_UNORDERED_ACCESS;
+    return true;
+}
+
+QD3D12GpuBcEncoder::QD3D12GpuBcEncoder()
+    : d_ptr(new QD3D12GpuBcEncoderPrivate)
+{
+}
+
+QD3D12GpuBcEncoder::~QD3D12GpuBcEncoder()
+{
+}
+
+bool QD3D12GpuBcEncoder::create(ID3D12Device *device)
+{
+    Q_D(QD3D12GpuBcEncoder);
+    destroy();
+
+    D3D12_DESCRIPTOR_RANGE descRange[2];
+    descRange[0].RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_SRV;
+    descRange[0].NumDescriptors = 1;
+    descRange[0].BaseShaderRegister = 0; // t0
+    descRange[0].RegisterSpace = 0;
+    descRange[0].OffsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND;
+    descRange[1].RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_UAV;
+    descRange[1].NumDescriptors = 1;
+    descRange[1].BaseShaderRegister = 0; // u0
+    descRange[1].RegisterSpace = 0;
+    descRange[1].OffsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND;
+
+    D3D12_ROOT_PARAMETER rootParameters[2];
+    rootParameters[0].ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
+    rootParameters[0].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+    rootParameters[0].DescriptorTable.NumDescriptorRanges = 2;
+    rootParameters[0].DescriptorTable.pDescriptorRanges = descRange;
+    rootParameters[1].ParameterType = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;
+    rootParameters[1].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+    rootParameters[1].Constants.Num32BitValues = 6;
+    rootParameters[1].Constants.ShaderRegister = 0; // b0
+    rootParameters[1].Constants.RegisterSpace = 0;
+
+    D3D12_ROOT_SIGNATURE_DESC desc = {};
+    desc.NumParameters = 2;
+    desc.pParameters = rootParameters;
+
+    ComPtr<ID3DBlob> signature;
+    ComPtr<ID3DBlob> error;
+    if (FAILED(D3D12SerializeRootSignature(&desc, D3D_ROOT_SIGNATURE_VERSION_1, &signature, &error))) {
+        QByteArray msg;
+        if (error)
+            msg = QByteArray(static_cast<const char *>(error->GetBufferPointer()), int(error->GetBufferSize()));
+        qWarning("QD3D12GpuBcEncoder: Failed to serialize root signature: %s", msg.constData());
+        return false;
+    }
+    if (FAILED(device->CreateRootSignature(0, signature->GetBufferPointer(), signature->GetBufferSize(),
+                                           IID_PPV_ARGS(&d->rootSignature)))) {
+        qWarning("QD3D12GpuBcEncoder: Failed to create root signature");
+        return false;
+    }
+
+    D3D12_COMPUTE_PIPELINE_STATE_DESC psoDesc = {};
+    psoDesc.pRootSignature = d->rootSignature.Get();
+    psoDesc.CS.pShaderBytecode = g_CS_EncodeBC1;
+    psoDesc.CS.BytecodeLength = sizeof(g_CS_EncodeBC1);
+    if (FAILED(device->CreateComputePipelineState(&psoDesc, IID_PPV_ARGS(&d->bc1PipelineState)))) {
+        qWarning("QD3D12GpuBcEncoder: Failed to create BC1 compute pipeline state");
+        destroy();
+        return false;
+    }
+    psoDesc.CS.pShaderBytecode = g_CS_EncodeBC7;
+    psoDesc.CS.BytecodeLength = sizeof(g_CS_EncodeBC7);
+    if (FAILED(device->CreateComputePipelineState(&psoDesc, IID_PPV_ARGS(&d->bc7PipelineState)))) {
+        qWarning("QD3D12GpuBcEncoder: Failed to create BC7 compute pipeline state");
+        destroy();
+        return false;
+    }
+
+    d->device = device;
+    d->descriptorSize = device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+    return true;
+}
+
+void QD3D12GpuBcEncoder::destroy()
+{
+    Q_D(QD3D12GpuBcEncoder);
+    d->retiredHeaps.clear();
+    d->retiredScratch.clear();
+    d->heap.Reset();
+    d->heapCapacity = 0;
+    d->heapUsed = 0;
+    d->scratch.Reset();
+    d->scratchSize = 0;
+    d->bc1PipelineState.Reset();
+    d->bc7PipelineState.Reset();
+    d->rootSignature.Reset();
+    d->device.Reset();
+}
+
+bool QD3D12GpuBcEncoder::isCreated() const
+{
+    Q_D(const QD3D12GpuBcEncoder);
+    return d->bc1PipelineState.Get() != Q_NULLPTR;
+}
+
+// BC1 and BC7, UNORM and SRGB.
+bool QD3D12GpuBcEncoder::isFormatSupported(DXGI_FORMAT format)
+{
+    switch (format) {
+    case DXGI_FORMAT_BC1_UNORM:
+    case DXGI_FORMAT_BC1_UNORM_SRGB:
+    case DXGI_FORMAT_BC7_UNORM:
+    case DXGI_FORMAT_BC7_UNORM_SRGB:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// A destination texture for encode(). The size must be a multiple of 4.
+// The caller owns the returned texture.
+ID3D12Resource *QD3D12GpuBcEncoder::createTexture(const QSize &size, int mipLevels, DXGI_FORMAT format,
+                                                  D3D12_RESOURCE_STATES state)
+{
+    Q_D(QD3D12GpuBcEncoder);
+    if (!d->device || !isFormatSupported(format) || size.isEmpty() || size.width() % 4 || size.height() % 4) {
+        qWarning("QD3D12GpuBcEncoder: Cannot create a %dx%d texture with format %d",
+                 size.width(), size.height(), int(format));
+        return Q_NULLPTR;
+    }
+
+    D3D12_RESOURCE_DESC textureDesc = {};
+    textureDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+    textureDesc.Width = size.width();
+    textureDesc.Height = size.height();
+    textureDesc.DepthOrArraySize = 1;
+    textureDesc.MipLevels = mipLevels;
+    textureDesc.Format = format;
+    textureDesc.SampleDesc.Count = 1;
+    textureDesc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
+
+    D3D12_HEAP_PROPERTIES defaultHeapProp = {};
+    defaultHeapProp.Type = D3D12_HEAP_TYPE_DEFAULT;
+    ID3D12Resource *texture = Q_NULLPTR;
+    if (FAILED(d->device->CreateCommittedResource(&defaultHeapProp, D3D12_HEAP_FLAG_NONE, &textureDesc,
+                                                  state, Q_NULLPTR, IID_PPV_ARGS(&texture)))) {
+        qWarning("QD3D12GpuBcEncoder: Failed to create texture");
+        return Q_NULLPTR;
+    }
+    return texture;
+}
+
+// BC formats cannot be UAVs, so the blocks are written to a buffer and
+// copied into the texture from there, all on the GPU. Only the given level
+// of the first array slice is touched. The source needs a format that can
+// be read as float, when it is an sRGB one the data is encoded as stored.
+bool QD3D12GpuBcEncoder::encode(ID3D12GraphicsCommandList *commandList,
+                                ID3D12Resource *source, D3D12_RESOURCE_STATES sourceState,
+                                ID3D12Resource *destination, D3D12_RESOURCE_STATES destinationState,
+                                int level)
+{
+    Q_D(QD3D12GpuBcEncoder);
+    if (!d->bc1PipelineState) {
+        qWarning("QD3D12GpuBcEncoder: encode() called before create()");
+        return false;
+    }
+
+    const D3D12_RESOURCE_DESC srcDesc = source->GetDesc();
+    const D3D12_RESOURCE_DESC dstDesc = destination->GetDesc();
+    if (!isFormatSupported(dstDesc.Format)) {
+        qWarning("QD3D12GpuBcEncoder: Unsupported destination format %d", int(dstDesc.Format));
+        return false;
+    }
+    if (srcDesc.Dimension != D3D12_RESOURCE_DIMENSION_TEXTURE2D || srcDesc.SampleDesc.Count > 1
+            || srcDesc.Width != dstDesc.Width || srcDesc.Height != dstDesc.Height
+            || level >= srcDesc.MipLevels || level >= dstDesc.MipLevels) {
+        qWarning("QD3D12GpuBcEncoder: Source and destination do not match");
+        return false;
+    }
+
+    const bool bc7 = dstDesc.Format == DXGI_FORMAT_BC7_UNORM || dstDesc.Format == DXGI_FORMAT_BC7_UNORM_SRGB;
+    const quint32 width = qMax(1u, quint32(srcDesc.Width) >> level);
+    const quint32 height = qMax(1u, srcDesc.Height >> level);
+    const quint32 blocksX = (width + 3) / 4;
+    const quint32 blocksY = (height + 3) / 4;
+
+    D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint = {};
+    footprint.Footprint.Format = dstDesc.Format;
+    footprint.Footprint.Width = blocksX * 4;
+    footprint.Footprint.Height = blocksY * 4;
+    footprint.Footprint.Depth = 1;
+    footprint.Footprint.RowPitch = QD3D12FormatInfo::forFormat(dstDesc.Format).rowPitch(width);
+
+    if (!d->reserveDescriptors(DESCRIPTORS_PER_ENCODE)
+            || !d->reserveScratch(quint64(footprint.Footprint.RowPitch) * blocksY))
+        return false;
+
+    D3D12_CPU_DESCRIPTOR_HANDLE cpuHandle = d->heap->GetCPUDescriptorHandleForHeapStart();
+    cpuHandle.ptr += d->heapUsed * d->descriptorSize;
+    D3D12_GPU_DESCRIPTOR_HANDLE gpuHandle = d->heap->GetGPUDescriptorHandleForHeapStart();
+    gpuHandle.ptr += d->heapUsed * d->descriptorSize;
+    d->heapUsed += DESCRIPTORS_PER_ENCODE;
+
+    D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+    srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+    srvDesc.Format = srcDesc.Format;
+    srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+    srvDesc.Texture2D.MostDetailedMip = level;
+    srvDesc.Texture2D.MipLevels = 1;
+    d->device->CreateShaderResourceView(source, &srvDesc, cpuHandle);
+    cpuHandle.ptr += d->descriptorSize;
+
+    D3D12_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
+    uavDesc.Format = DXGI_FORMAT_R32_TYPELESS;
+    uavDesc.ViewDimension = D3D12_UAV_DIMENSION_BUFFER;
+    uavDesc.Buffer.NumElements = UINT(d->scratchSize / 4);
+    uavDesc.Buffer.Flags = D3D12_BUFFER_UAV_FLAG_RAW;
+    d->device->CreateUnorderedAccessView(d->scratch.Get(), Q_NULLPTR, &uavDesc, cpuHandle);
+
+    const UINT srcSubresource = level;
+    const UINT dstSubresource = level;
+
+    QVector<D3D12_RESOURCE_BARRIER> barriers;
+    appendTransition(&barriers, source, srcSubresource, sourceState, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+    appendTransition(&barriers, d->scratch.Get(), 0, d->scratchState, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+    if (!barriers.isEmpty())
+        commandList->ResourceBarrier(barriers.count(), barriers.constData());
+
+    commandList->SetPipelineState(bc7 ? d->bc7PipelineState.Get() : d->bc1PipelineState.Get());
+    commandList->SetComputeRootSignature(d->rootSignature.Get());
+    ID3D12DescriptorHeap *heaps[] = { d->heap.Get() };
+    commandList->SetDescriptorHeaps(_countof(heaps), heaps);
+    commandList->SetComputeRootDescriptorTable(0, gpuHandle);
+    const bool srgb = QD3D12FormatInfo::forFormat(srcDesc.Format).testFlag(QD3D12FormatInfo::SRgb);
+    const quint32 constants[6] = { width, height, blocksX, blocksY, footprint.Footprint.RowPitch, srgb ? 1u : 0u };
+    commandList->SetComputeRoot32BitConstants(1, 6, constants, 0);
+    // One thread per block, in 8x8 groups.
+    commandList->Dispatch((blocksX + 7) / 8, (blocksY + 7) / 8, 1);
+
+    barriers.clear();
+    appendTransition(&barriers, source, srcSubresource, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, sourceState);
+    appendTransition(&barriers, d->scratch.Get(), 0, D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
+                     D3D12_RESOURCE_STATE_COPY_SOURCE);
+    appendTransition(&barriers, destination, dstSubresource, destinationState, D3D12_RESOURCE_STATE_COPY_DEST);
+    commandList->ResourceBarrier(barriers.count(), barriers.constData());
+    d->scratchState = D3D12_RESOURCE_STATE_COPY_SOURCE;
+
+    D3D12_TEXTURE_COPY_LOCATION dstLoc;
+    dstLoc.pResource = destination;
+    dstLoc.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+    dstLoc.SubresourceIndex = dstSubresource;
+    D3D12_TEXTURE_COPY_LOCATION srcLoc;
+    srcLoc.pResource = d->scratch.Get();
+    srcLoc.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
+    srcLoc.PlacedFootprint = footprint;
+    commandList->CopyTextureRegion(&dstLoc, 0, 0, 0, &srcLoc, Q_NULLPTR);
+
+    barriers.clear();
+    appendTransition(&barriers, destination, dstSubresource, D3D12_RESOURCE_STATE_COPY_DEST, destinationState);
+    if (!barriers.isEmpty())
+        commandList->ResourceBarrier(barriers.count(), barriers.constData());
+
+    return true;
+}
+
+void QD3D12GpuBcEncoder::reset()
+{
+    Q_D(QD3D12GpuBcEncoder);
+    d->retiredHeaps.clear();
+    d->retiredScratch.clear();
+    d->heapUsed = 0;
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,85 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtD3D12Window module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#ifndef QD3D12GPUBCENCODER_H
+#define QD3D12GPUBCENCODER_H
+
+#include <QtCore/QScopedPointer>
+#include <QtCore/QSize>
+#include <QtD3D12Window/qd3d12window.h>
+
+QT_BEGIN_NAMESPACE
+
+class QD3D12GpuBcEncoderPrivate;
+
+class QD3D12_EXPORT QD3D12GpuBcEncoder
+{
+    Q_DECLARE_PRIVATE(QD3D12GpuBcEncoder)
+
+public:
+    QD3D12GpuBcEncoder();
+    ~QD3D12GpuBcEncoder();
+
+    bool create(ID3D12Device *device);
+    void destroy();
+    bool isCreated() const;
+
+    static bool isFormatSupported(DXGI_FORMAT format);
+    ID3D12Resource *createTexture(const QSize &size, int mipLevels, DXGI_FORMAT format,
+                                  D3D12_RESOURCE_STATES state = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+
+    // Records the compression of level of source into the same level of
+    // destination, a BC1 or BC7 texture of the same size. Both are left in
+    // the given states.
+    bool encode(ID3D12GraphicsCommandList *commandList,
+                ID3D12Resource *source, D3D12_RESOURCE_STATES sourceState,
+                ID3D12Resource *destination, D3D12_RESOURCE_STATES destinationState,
+                int level = 0);
+
+    // Descriptors and scratch buffers are only reused after this, call it
+    // once the GPU has finished executing the command lists from the
+    // previous encode() calls.
+    void reset();
+
+private:
+    Q_DISABLE_COPY(QD3D12GpuBcEncoder)
+    QScopedPointer<QD3D12GpuBcEncoderPrivate> d_ptr;
+};
+
+QT_END_NAMESPACE
+
+#endif
@@ -0,0 +1,271 @@
+// Block compression for QD3D12GpuBcEncoder. One thread encodes one 4x4 block
+// and stores it in a raw buffer that is then copied into the BC texture, as
+// BC formats cannot be written through UAVs. The search mirrors the normal
+// quality preset of QD3D12BcEncoder: principal axis endpoints, one least
+// squares refinement.
+
+static const uint GROUP_DIM = 8;
+
+Texture2D<float4> source : register(t0); // a view of the source level only
+RWByteAddressBuffer blocks : register(u0);
+
+cbuffer EncodeConstants : register(b0)
+{
+    uint2 textureSize;
+    uint2 blockCount;
+    uint rowPitch; // bytes between rows of blocks
+    uint srgb; // the source view returns linear values of sRGB data
+}
+
+static const float BC1_WEIGHTS[4] = { 0.0, 1.0 / 3.0, 2.0 / 3.0, 1.0 };
+static const uint BC1_CODES[4] = { 0, 2, 3, 1 };
+static const uint BC7_WEIGHTS[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+float3 linearToSRgb(float3 c)
+{
+    return c < 0.0031308 ? 12.92 * c : 1.055 * pow(abs(c), 1.0 / 2.4) - 0.055;
+}
+
+void loadBlock(uint2 blockId, out float4 texels[16])
+{
+    // Partial blocks at the edges repeat the last column and row.
+    for (uint i = 0; i < 16; ++i) {
+        const uint2 pos = min(blockId * 4 + uint2(i & 3, i >> 2), textureSize - 1);
+        float4 c = source.Load(int3(pos, 0));
+        if (srgb)
+            c.rgb = linearToSRgb(c.rgb);
+        texels[i] = round(saturate(c) * 255.0);
+    }
+}
+
+// mask selects the channels taking part: RGB for BC1, RGBA for BC7.
+void principalEndpoints(float4 texels[16], float4 mask, out float4 e0, out float4 e1)
+{
+    float4 mean = 0;
+    for (uint i = 0; i < 16; ++i)
+        mean += texels[i];
+    mean = mean / 16.0 * mask;
+
+    float4x4 cov = 0;
+    for (uint j = 0; j < 16; ++j) {
+        const float4 d = (texels[j] - mean) * mask;
+        cov[0] += d.x * d;
+        cov[1] += d.y * d;
+        cov[2] += d.z * d;
+        cov[3] += d.w * d;
+    }
+
+    float4 axis = mask;
+    for (uint iter = 0; iter < 8; ++iter) {
+        const float4 next = mul(cov, axis);
+        const float len = max(max(abs(next.x), abs(next.y)), max(abs(next.z), abs(next.w)));
+        if (len < 1e-6)
+            break;
+        axis = next / len;
+    }
+    axis = normalize(axis);
+
+    float lo = 0;
+    float hi = 0;
+    for (uint k = 0; k < 16; ++k) {
+        const float t = dot((texels[k] - mean) * mask, axis);
+        lo = min(lo, t);
+        hi = max(hi, t);
+    }
+    e0 = clamp(mean + axis * lo, 0.0, 255.0);
+    e1 = clamp(mean + axis * hi, 0.0, 255.0);
+}
+
+// Snaps the projection of every texel onto e0-e1 to the nearest of the
+// ascending weights. Returns the squared error.
+float fitIndices(float4 texels[16], float4 mask, float4 e0, float4 e1, float weights[16], uint weightCount,
+                 out uint indices[16])
+{
+    const float4 d = (e1 - e0) * mask;
+    const float dd = dot(d, d);
+    const float scale = dd > 0 ? 1.0 / dd : 0.0;
+    float error = 0;
+    for (uint i = 0; i < 16; ++i) {
+        const float t = dot(texels[i] - e0, d) * scale;
+        uint index = 0;
+        for (uint k = 0; k + 1 < weightCount; ++k) {
+            if (t > (weights[k] + weights[k + 1]) * 0.5)
+                index = k + 1;
+        }
+        indices[i] = index;
+        const float4 diff = (e0 + weights[index] * d - texels[i]) * mask;
+        error += dot(diff, diff);
+    }
+    return error;
+}
+
+// Least squares endpoints for the given indices.
+void refineEndpoints(float4 texels[16], float weights[16], uint indices[16], inout float4 e0, inout float4 e1)
+{
+    float aa = 0, ab = 0, bb = 0;
+    float4 x0 = 0, x1 = 0;
+    for (uint i = 0; i < 16; ++i) {
+        const float w = weights[indices[i]];
+        aa += (1 - w) * (1 - w);
+        ab += (1 - w) * w;
+        bb += w * w;
+        x0 += (1 - w) * texels[i];
+        x1 += w * texels[i];
+    }
+    const float det = aa * bb - ab * ab;
+    if (abs(det) < 1e-6)
+        return;
+    e0 = clamp((bb * x0 - ab * x1) / det, 0.0, 255.0);
+    e1 = clamp((aa * x1 - ab * x0) / det, 0.0, 255.0);
+}
+
+uint pack565(float4 c)
+{
+    const uint3 q = uint3(round(c.rgb * float3(31.0, 63.0, 31.0) / 255.0));
+    return (q.r << 11) | (q.g << 5) | q.b;
+}
+
+float4 unpack565(uint v)
+{
+    const uint3 q = uint3(v >> 11, (v >> 5) & 0x3F, v & 0x1F);
+    return float4((q.r << 3) | (q.r >> 2), (q.g << 2) | (q.g >> 4), (q.b << 3) | (q.b >> 2), 0);
+}
+
+uint2 encodeBC1(float4 texels[16])
+{
+    const float4 mask = float4(1, 1, 1, 0);
+    float weights[16];
+    for (uint w = 0; w < 16; ++w)
+        weights[w] = w < 4 ? BC1_WEIGHTS[w] : 1.0;
+
+    float4 e0, e1;
+    principalEndpoints(texels, mask, e0, e1);
+
+    uint2 best = 0;
+    float bestError = -1;
+    for (uint iter = 0; iter < 2; ++iter) {
+        uint c0 = pack565(e0);
+        uint c1 = pack565(e1);
+        // The four color mode needs c0 > c1.
+        if (c0 < c1) {
+            const uint c = c0;
+            c0 = c1;
+            c1 = c;
+            const float4 e = e0;
+            e0 = e1;
+            e1 = e;
+        }
+        uint indices[16];
+        const float error = fitIndices(texels, mask, unpack565(c0), unpack565(c1), weights, c0 == c1 ? 1 : 4, indices);
+        if (bestError < 0 || error < bestError) {
+            bestError = error;
+            best.x = c0 | (c1 << 16);
+            best.y = 0;
+            for (uint i = 0; i < 16; ++i)
+                best.y |= BC1_CODES[indices[i]] << (2 * i);
+        }
+        refineEndpoints(texels, weights, indices, e0, e1);
+    }
+    return best;
+}
+
+void writeBits(inout uint4 block, inout uint pos, uint value, uint count)
+{
+    const uint word = pos >> 5;
+    const uint shift = pos & 31;
+    block[word] |= value << shift;
+    if (shift + count > 32)
+        block[word + 1] |= value >> (32 - shift);
+    pos += count;
+}
+
+// The p-bit that keeps the endpoint closest to the unquantized one.
+uint bestPBit(float4 e)
+{
+    const float4 d0 = float4((uint4(clamp(round(e / 2), 0, 127)) << 1)) - e;
+    const float4 d1 = float4((uint4(clamp(round((e - 1) / 2), 0, 127)) << 1) | 1) - e;
+    return dot(d1, d1) < dot(d0, d0) ? 1 : 0;
+}
+
+// Mode 6: one subset, RGBA endpoints of 7 bits plus a p-bit each, 4 bit indices.
+uint4 encodeBC7(float4 texels[16])
+{
+    const float4 mask = 1;
+    float weights[16];
+    for (uint w = 0; w < 16; ++w)
+        weights[w] = BC7_WEIGHTS[w] / 64.0;
+
+    float4 e0, e1;
+    principalEndpoints(texels, mask, e0, e1);
+
+    uint4 q0 = 0, q1 = 0;
+    uint p0 = 0, p1 = 0;
+    uint bestIndices[16];
+    float bestError = -1;
+    for (uint iter = 0; iter < 2; ++iter) {
+        const uint pb0 = bestPBit(e0);
+        const uint pb1 = bestPBit(e1);
+        const uint4 v0 = uint4(clamp(round((e0 - pb0) / 2), 0, 127));
+        const uint4 v1 = uint4(clamp(round((e1 - pb1) / 2), 0, 127));
+        uint indices[16];
+        const float error = fitIndices(texels, mask, float4((v0 << 1) | pb0), float4((v1 << 1) | pb1),
+                                       weights, 16, indices);
+        if (bestError < 0 || error < bestError) {
+            bestError = error;
+            q0 = v0;
+            q1 = v1;
+            p0 = pb0;
+            p1 = pb1;
+            bestIndices = indices;
+        }
+        refineEndpoints(texels, weights, indices, e0, e1);
+    }
+
+    // The anchor index has an implicit zero top bit, flip the block if needed.
+    if (bestIndices[0] & 8) {
+        const uint4 q = q0;
+        q0 = q1;
+        q1 = q;
+        const uint p = p0;
+        p0 = p1;
+        p1 = p;
+        for (uint i = 0; i < 16; ++i)
+            bestIndices[i] = 15 - bestIndices[i];
+    }
+
+    uint4 block = 0;
+    uint pos = 0;
+    writeBits(block, pos, 1 << 6, 7); // mode 6
+    for (uint ch = 0; ch < 4; ++ch) {
+        writeBits(block, pos, q0[ch], 7);
+        writeBits(block, pos, q1[ch], 7);
+    }
+    writeBits(block, pos, p0, 1);
+    writeBits(block, pos, p1, 1);
+    writeBits(block, pos, bestIndices[0], 3);
+    for (uint j = 1; j < 16; ++j)
+        writeBits(block, pos, bestIndices[j], 4);
+    return block;
+}
+
+[numthreads(GROUP_DIM, GROUP_DIM, 1)]
+void CS_EncodeBC1(uint3 globalId : SV_DispatchThreadID)
+{
+    if (any(globalId.xy >= blockCount))
+        return;
+
+    float4 texels[16];
+    loadBlock(globalId.xy, texels);
+    blocks.Store2(globalId.y * rowPitch + globalId.x * 8, encodeBC1(texels));
+}
+
+[numthreads(GROUP_DIM, GROUP_DIM, 1)]
+void CS_EncodeBC7(uint3 globalId : SV_DispatchThreadID)
+{
+    if (any(globalId.xy >= blockCount))
+        return;
+
+    float4 texels[16];
+    loadBlock(globalId.xy, texels);
+    blocks.Store4(globalId.y * rowPitch + globalId.x * 16, encodeBC7(texels));
+}
@@ -0,0 +1,486 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtD3D12Window module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include "qd3d12gpuculler_p.h"
+#include "qd3d12gpuculler_reduce_cs.h"
+#include "qd3d12gpuculler_cull_cs.h"
+#include "qd3d12indirectdrawer.h"
+#include "qd3d12util_p.h"
+
+QT_BEGIN_NAMESPACE
+
+static const int DEFAULT_HEAP_SIZE = 64;
+static const int DESCRIPTORS_PER_BINDING = 2; // instance SRV + argument UAV
+static const int CULL_CONSTANT_COUNT = 50;
+
+// Matches the flags in qd3d12gpuculler.hlsl.
+enum CullFlag {
+    CullIndexed = 0x01,
+    CullDrawId = 0x02,
+    CullOcclusion = 0x04
+};
+
+bool QD3D12GpuCullerPrivate::reserveDescriptors(int count)
+{
+    if (heap && heapUsed + count <= heapCapacity)
+        return true;
+
+    // Views in the old heap may still be in use by the GPU, so they are
+    // created again in the new one instead of being moved.
+    if (heap) {
+        retiredHeaps.append(heap);
+        heap.Reset();
+    }
+    bindings.clear();
+    pyramidSlot = -1;
+
+    D3D12_DESCRIPTOR_HEAP_DESC heapDesc = {};
+    heapDesc.NumDescriptors = qMax(DEFAULT_HEAP_SIZE, count + 1);
+    heapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+    heapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
+    if (FAILED(device->CreateDescriptorHeap(&heapDesc, IID_PPV_ARGS(&heap)))) {
+        qWarning("QD3D12GpuCuller: Failed to create descriptor heap");
+        return false;
+    }
+    heapCapacity = heapDesc.NumDescriptors;
+    heapUsed = 1;
+
+    D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+    srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+    srvDesc.Format = DXGI_FORMAT_R32_FLOAT;
+    srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+    srvDesc.Texture2D.MipLevels = 1;
+    device->CreateShaderResourceView(Q_NULLPTR, &srvDesc, cpuHandle(0));
+    return true;
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE QD3D12GpuCullerPrivate::cpuHandle(int slot) const
+{
+    D3D12_CPU_DESCRIPTOR_HANDLE h = heap->GetCPUDescriptorHandleForHeapStart();
+    h.ptr += slot * descriptorSize;
+    return h;
+}
+
+D3D12_GPU_DESCRIPTOR_HANDLE QD3D12GpuCullerPrivate::gpuHandle(int slot) const
+{
+    D3D12_GPU_DESCRIPTOR_HANDLE h = heap->GetGPUDescriptorHandleForHeapStart();
+    h.ptr += slot * descriptorSize;
+    return h;
+}
+
+bool QD3D12GpuCullerPrivate::ensurePyramid(ID3D12Resource *depthBuffer)
+{
+    const D3D12_RESOURCE_DESC desc = depthBuffer->GetDesc();
+    if (desc.Dimension != D3D12_RESOURCE_DIMENSION_TEXTURE2D || desc.SampleDesc.Count > 1) {
+        qWarning("QD3D12GpuCuller: Only non-multisample 2D depth buffers are supported");
+        return false;
+    }
+    if (desc.Format != DXGI_FORMAT_R32_TYPELESS && desc.Format != DXGI_FORMAT_R32_FLOAT) {
+        qWarning("QD3D12GpuCuller: Unsupported depth buffer format %d (needs R32_TYPELESS)", desc.Format);
+        return false;
+    }
+
+    const QSize size(int(desc.Width), int(desc.Height));
+    if (pyramid && depthBuffer == depth.Get() && size == depthSize)
+        return true;
+
+    if (pyramid) {
+        retiredPyramids.append(pyramid);
+        pyramid.Reset();
+    }
+    depth = depthBuffer;
+    depthSize = size;
+    pyramidSize = QSize(qMax(1, size.width() / 2), qMax(1, size.height() / 2));
+    pyramidSlot = -1;
+    pyramidValid = false;
+
+    pyramidLevels = 1;
+    for (int s = qMax(pyramidSize.width(), pyramidSize.height()); s > 1; s >>= 1)
+        ++pyramidLevels;
+
+    D3D12_HEAP_PROPERTIES heapProp = {};
+    heapProp.Type = D3D12_HEAP_TYPE_DEFAULT;
+    D3D12_RESOURCE_DESC texDesc = {};
+    texDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+    texDesc.Width = pyramidSize.width();
+    texDesc.Height = pyramidSize.height();
+    texDesc.DepthOrArraySize = 1;
+    texDesc.MipLevels = pyramidLevels;
+    texDesc.Format = DXGI_FORMAT_R32_FLOAT;
+    texDesc.SampleDesc.Count = 1;
+    texDesc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
+    texDesc.Flags = D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
+    if (FAILED(device->CreateCommittedResource(&heapProp, D3D12_HEAP_FLAG_NONE, &texDesc,
+                                               D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, Q_NULLPTR,
+                                               IID_PPV_ARGS(&pyramid)))) {
+        qWarning("QD3D12GpuCuller: Failed to create depth pyramid of size %dx%d",
+                 pyramidSize.width(), pyramidSize.height());
+        depth.Reset();
+        return false;
+    }
+    return true;
+}
+
+void QD3D12GpuCullerPrivate::createPyramidViews()
+{
+    pyramidSlot = heapUsed;
+    heapUsed += 1 + 2 * pyramidLevels;
+
+    D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+    srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+    srvDesc.Format = DXGI_FORMAT_R32_FLOAT;
+    srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+    srvDesc.Texture2D.MipLevels = pyramidLevels;
+    device->CreateShaderResourceView(pyramid.Get(), &srvDesc, cpuHandle(pyramidSlot));
+
+    // Each pass reads the level above alone, so that the levels still being
+    // written may stay in UNORDERED_ACCESS.
+    srvDesc.Texture2D.MipLevels = 1;
+    for (quint32 level = 0; level < pyramidLevels; ++level) {
+        const int slot = pyramidSlot + 1 + 2 * level;
+        srvDesc.Texture2D.MostDetailedMip = level ? level - 1 : 0;
+        device->CreateShaderResourceView(level ? pyramid.Get() : depth.Get(), &srvDesc, cpuHandle(slot));
+
+        D3D12_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
+        uavDesc.Format = DXGI_FORMAT_R32_FLOAT;
+        uavDesc.ViewDimension = D3D12_UAV_DIMENSION_TEXTURE2D;
+        uavDesc.Texture2D.MipSlice = level;
+        device->CreateUnorderedAccessView(pyramid.Get(), Q_NULLPTR, &uavDesc, cpuHandle(slot + 1));
+    }
+}
+
+int QD3D12GpuCullerPrivate::bindingSlot(ID3D12Resource *instances, ID3D12Resource *arguments, quint64 argumentSize)
+{
+    foreach (const QD3D12CullBinding &binding, bindings) {
+        if (binding.instances.Get() == instances && binding.arguments.Get() == arguments)
+            return binding.slot;
+    }
+
+    QD3D12CullBinding binding;
+    binding.instances = instances;
+    binding.arguments = arguments;
+    binding.slot = heapUsed;
+    heapUsed += DESCRIPTORS_PER_BINDING;
+
+    D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+    srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+    srvDesc.Format = DXGI_FORMAT_UNKNOWN;
+    srvDesc.ViewDimension = D3D12_SRV_DIMENSION_BUFFER;
+    srvDesc.Buffer.NumElements = UINT(instances->GetDesc().Width / sizeof(QD3D12CullInstance));
+    srvDesc.Buffer.StructureByteStride = sizeof(QD3D12CullInstance);
+    device->CreateShaderResourceView(instances, &srvDesc, cpuHandle(binding.slot));
+
+    // A raw view, the stride of the commands depends on the drawer.
+    D3D12_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
+    uavDesc.Format = DXGI_FORMAT_R32_TYPELESS;
+    uavDesc.ViewDimension = D3D12_UAV_DIMENSION_BUFFER;
+    uavDesc.Buffer.NumElements = UINT(argumentSize / 4);
+    uavDesc.Buffer.Flags = D3D12_BUFFER_UAV_FLAG_RAW;
+    device->CreateUnorderedAccessView(arguments, Q_NULLPTR, &uavDesc, cpuHandle(binding.slot + 1));
+
+    bindings.append(binding);
+    return binding.slot;
+}
+
+// Replaces the per-object visibility loop on the CPU. Every instance is
+// tested against the frustum and against a hierarchical depth pyramid
+// built from the previous frame's depth buffer, and the survivors are
+// compacted into the argument buffer of a QD3D12IndirectDrawer. A frame
+// then typically does:
+//
+//   culler.cull(commandList, instances, count, projection * view, &drawer);
+//   ... set the pipeline state and bindings, drawer.execute(commandList);
+//   culler.buildDepthPyramid(commandList, depthStencil(), D3D12_RESOURCE_STATE_DEPTH_WRITE);
+//
+// The depth test assumes that smaller values are nearer.
+QD3D12GpuCuller::QD3D12GpuCuller()
+    : d_ptr(new QD3D12GpuCullerPrivate)
+{
+}
+
+QD3D12GpuCuller::~QD3D12GpuCuller()
+{
+}
+
+bool QD3D12GpuCuller::create(ID3D12Device *device)
+{
+    Q_D(QD3D12GpuCuller);
+    destroy();
+
+    D3D12_DESCRIPTOR_RANGE descRange[3];
+    descRange[0].RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_SRV;
+    descRange[0].NumDescriptors = 1;
+    descRange[0].BaseShaderRegister = 0; // t0
+    descRange[0].RegisterSpace = 0;
+    descRange[0].OffsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND;
+    descRange[1].RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_UAV;
+    descRange[1].NumDescriptors = 1;
+    descRange[1].BaseShaderRegister = 0; // u0
+    descRange[1].RegisterSpace = 0;
+    descRange[1].OffsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND;
+    descRange[2].RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_SRV;
+    descRange[2].NumDescriptors = 1;
+    descRange[2].BaseShaderRegister = 1; // t1
+    descRange[2].RegisterSpace = 0;
+    descRange[2].OffsetInDescriptorsFromTableStart = 0;
+
+    D3D12_ROOT_PARAMETER rootParameters[3];
+    rootParameters[0].ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
+    rootParameters[0].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+    rootParameters[0].DescriptorTable.NumDescriptorRanges = 2;
+    rootParameters[0].DescriptorTable.pDescriptorRanges = descRange;
+    rootParameters[1].ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
+    rootParameters[1].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+    rootParameters[1].DescriptorTable.NumDescriptorRanges = 1;
+    rootParameters[1].DescriptorTable.pDescriptorRanges = descRange + 2;
+    rootParameters[2].ParameterType = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;
+    rootParameters[2].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+    rootParameters[2].Constants.Num32BitValues = CULL_CONSTANT_COUNT;
+    rootParameters[2].Constants.ShaderRegister = 0; // b0
+    rootParameters[2].Constants.RegisterSpace = 0;
+
+    D3D12_ROOT_SIGNATURE_DESC desc = {};
+    desc.NumParameters = 3;
+    desc.pParameters = rootParameters;
+
+    ComPtr<ID3DBlob> signature;
+    ComPtr<ID3DBlob> error;
+    if (FAILED(D3D12SerializeRootSignature(&desc, D3D_ROOT_SIGNATURE_VERSION_1, &signature, &error))) {
+        QByteArray msg;
+        if (error)
+            msg = QByteArray(static_cast<const char *>(error->GetBufferPointer()), int(error->GetBufferSize()));
+        qWarning("QD3D12GpuCuller: Failed to serialize root signature: %s", msg.constData());
+        return false;
+    }
+    if (FAILED(device->CreateRootSignature(0, signature->GetBufferPointer(), signature->GetBufferSize(),
+                                           IID_PPV_ARGS(&d->rootSignature)))) {
+        qWarning("QD3D12GpuCuller: Failed to create root signature");
+        return false;
+    }
+
+    D3D12_COMPUTE_PIPELINE_STATE_DESC psoDesc = {};
+    psoDesc.pRootSignature = d->rootSignature.Get();
+    psoDesc.CS.pShaderBytecode = g_CS_ReduceDepth;
+    psoDesc.CS.BytecodeLength = sizeof(g_CS_ReduceDepth);
+    if (FAILED(device->CreateComputePipelineState(&psoDesc, IID_PPV_ARGS(&d->reducePipelineState)))) {
+        qWarning("QD3D12GpuCuller: Failed to create depth reduction pipeline state");
+        destroy();
+        return false;
+    }
+    psoDesc.CS.pShaderBytecode = g_CS_Cull;
+    psoDesc.CS.BytecodeLength = sizeof(g_CS_Cull);
+    if (FAILED(device->CreateComputePipelineState(&psoDesc, IID_PPV_ARGS(&d->cullPipelineState)))) {
+        qWarning("QD3D12GpuCuller: Failed to create culling pipeline state");
+        destroy();
+        return false;
+    }
+
+    d->device = device;
+    d->descriptorSize = device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+    return true;
+}
+
+void QD3D12GpuCuller::destroy()
+{
+    Q_D(QD3D12GpuCuller);
+    d->bindings.clear();
+    d->retiredHeaps.clear();
+    d->retiredPyramids.clear();
+    d->heap.Reset();
+    d->heapCapacity = 0;
+    d->heapUsed = 0;
+    d->pyramid.Reset();
+    d->depth.Reset();
+    d->depthSize = QSize();
+    d->pyramidSize = QSize();
+    d->pyramidLevels = 0;
+    d->pyramidSlot = -1;
+    d->pyramidValid = false;
+    d->cullPipelineState.Reset();
+    d->reducePipelineState.Reset();
+    d->rootSignature.Reset();
+    d->device.Reset();
+}
+
+bool QD3D12GpuCuller::isCreated() const
+{
+    Q_D(const QD3D12GpuCuller);
+    return d->cullPipelineState.Get() != Q_NULLPTR;
+}
+
+bool QD3D12GpuCuller::buildDepthPyramid(ID3D12GraphicsCommandList *commandList,
+                                        ID3D12Resource *depth, D3D12_RESOURCE_STATES depthState)
+{
+    Q_D(QD3D12GpuCuller);
+    if (!d->cullPipelineState) {
+        qWarning("QD3D12GpuCuller: buildDepthPyramid() called before create()");
+        return false;
+    }
+    if (!d->ensurePyramid(depth))
+        return false;
+    if (!d->reserveDescriptors(1 + 2 * d->pyramidLevels))
+        return false;
+    if (d->pyramidSlot < 0)
+        d->createPyramidViews();
+
+    QD3D12Util::transitionResource(d->pyramid.Get(), commandList, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE,
+                                   D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+    if (depthState != D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE)
+        QD3D12Util::transitionResource(depth, commandList, depthState, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+
+    commandList->SetPipelineState(d->reducePipelineState.Get());
+    commandList->SetComputeRootSignature(d->rootSignature.Get());
+    ID3D12DescriptorHeap *heaps[] = { d->heap.Get() };
+    commandList->SetDescriptorHeaps(_countof(heaps), heaps);
+    commandList->SetComputeRootDescriptorTable(1, d->gpuHandle(0));
+
+    // Same as mipmap generation, except that each level is a max instead of
+    // an average and the first one comes from the depth buffer.
+    for (quint32 level = 0; level < d->pyramidLevels; ++level) {
+        commandList->SetComputeRootDescriptorTable(0, d->gpuHandle(d->pyramidSlot + 1 + 2 * level));
+        const quint32 w = qMax(1, d->pyramidSize.width() >> level);
+        const quint32 h = qMax(1, d->pyramidSize.height() >> level);
+        commandList->Dispatch((w + 7) / 8, (h + 7) / 8, 1);
+
+        D3D12_RESOURCE_BARRIER barrier = {};
+        barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+        barrier.Transition.pResource = d->pyramid.Get();
+        barrier.Transition.StateBefore = D3D12_RESOURCE_STATE_UNORDERED_ACCESS;
+        barrier.Transition.StateAfter = D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE;
+        barrier.Transition.Subresource = level;
+        commandList->ResourceBarrier(1, &barrier);
+    }
+
+    if (depthState != D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE)
+        QD3D12Util::transitionResource(depth, commandList, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, depthState);
+
+    d->pyramidValid = true;
+    return true;
+}
+
+void QD3D12GpuCuller::invalidateDepthPyramid()
+{
+    Q_D(QD3D12GpuCuller);
+    d->pyramidValid = false;
+}
+
+bool QD3D12GpuCuller::hasDepthPyramid() const
+{
+    Q_D(const QD3D12GpuCuller);
+    return d->pyramidValid;
+}
+
+bool QD3D12GpuCuller::cull(ID3D12GraphicsCommandList *commandList, ID3D12Resource *instances, quint32 instanceCount,
+                           const QMatrix4x4 &viewProjection, QD3D12IndirectDrawer *drawer)
+{
+    Q_D(QD3D12GpuCuller);
+    if (!d->cullPipelineState) {
+        qWarning("QD3D12GpuCuller: cull() called before create()");
+        return false;
+    }
+    if (!drawer->isCreated()) {
+        qWarning("QD3D12GpuCuller: The indirect drawer is not created");
+        return false;
+    }
+
+    drawer->reset(commandList);
+    const quint64 capacity = instances->GetDesc().Width / sizeof(QD3D12CullInstance);
+    if (instanceCount > capacity) {
+        qWarning("QD3D12GpuCuller: %u instances do not fit into a buffer of %llu", instanceCount, capacity);
+        instanceCount = quint32(capacity);
+    }
+    if (!instanceCount)
+        return true;
+
+    const bool occlusion = d->pyramidValid;
+    if (!d->reserveDescriptors(DESCRIPTORS_PER_BINDING + (occlusion ? 1 + 2 * d->pyramidLevels : 0)))
+        return false;
+    if (occlusion && d->pyramidSlot < 0)
+        d->createPyramidViews();
+    const int slot = d->bindingSlot(instances, drawer->argumentBuffer(), drawer->countOffset() + sizeof(UINT));
+
+    quint32 constants[CULL_CONSTANT_COUNT];
+    float *f = reinterpret_cast<float *>(constants);
+    memcpy(f, viewProjection.constData(), 16 * sizeof(float));
+
+    // The planes of the D3D clip volume, -w <= x, y <= w and 0 <= z <= w.
+    const QVector4D r0 = viewProjection.row(0);
+    const QVector4D r1 = viewProjection.row(1);
+    const QVector4D r2 = viewProjection.row(2);
+    const QVector4D r3 = viewProjection.row(3);
+    const QVector4D planes[6] = { r3 + r0, r3 - r0, r3 + r1, r3 - r1, r2, r3 - r2 };
+    for (int i = 0; i < 6; ++i) {
+        const float len = planes[i].toVector3D().length();
+        const QVector4D p = len > 0.0f ? planes[i] / len : planes[i];
+        f[16 + i * 4] = p.x();
+        f[16 + i * 4 + 1] = p.y();
+        f[16 + i * 4 + 2] = p.z();
+        f[16 + i * 4 + 3] = p.w();
+    }
+
+    constants[40] = instanceCount;
+    constants[41] = drawer->maxDraws();
+    constants[42] = drawer->argumentStride();
+    constants[43] = quint32(drawer->countOffset());
+    constants[44] = (drawer->drawType() == QD3D12IndirectDrawer::DrawIndexed ? CullIndexed : 0)
+            | (drawer->hasDrawId() ? CullDrawId : 0)
+            | (occlusion ? CullOcclusion : 0);
+    constants[45] = d->pyramidLevels;
+    constants[46] = d->pyramidSize.width();
+    constants[47] = d->pyramidSize.height();
+    f[48] = d->depthSize.width();
+    f[49] = d->depthSize.height();
+
+    commandList->SetPipelineState(d->cullPipelineState.Get());
+    commandList->SetComputeRootSignature(d->rootSignature.Get());
+    ID3D12DescriptorHeap *heaps[] = { d->heap.Get() };
+    commandList->SetDescriptorHeaps(_countof(heaps), heaps);
+    commandList->SetComputeRootDescriptorTable(0, d->gpuHandle(slot));
+    commandList->SetComputeRootDescriptorTable(1, d->gpuHandle(occlusion ? d->pyramidSlot : 0));
+    commandList->SetComputeRoot32BitConstants(2, CULL_CONSTANT_COUNT, constants, 0);
+    commandList->Dispatch((instanceCount + 63) / 64, 1, 1);
+    return true;
+}
+
+void QD3D12GpuCuller::reset()
+{
+    Q_D(QD3D12GpuCuller);
+    d->retiredHeaps.clear();
+    d->retiredPyramids.clear();
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,106 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtD3D12Window module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#ifndef QD3D12GPUCULLER_H
+#define QD3D12GPUCULLER_H
+
+#include <QtCore/QScopedPointer>
+#include <QtGui/QMatrix4x4>
+#include <QtD3D12Window/qd3d12window.h>
+
+QT_BEGIN_NAMESPACE
+
+class QD3D12IndirectDrawer;
+class QD3D12GpuCullerPrivate;
+
+// One element of the instance buffer given to QD3D12GpuCuller::cull().
+struct QD3D12CullInstance
+{
+    float center[3]; // bounding sphere in world space
+    float radius;
+    quint32 drawId;
+    quint32 countPerInstance; // vertex or index count
+    quint32 instanceCount;
+    quint32 startLocation; // first vertex or index
+    qint32 baseVertex; // DrawIndexed only
+    quint32 startInstance;
+    quint32 reserved[2];
+};
+
+class QD3D12_EXPORT QD3D12GpuCuller
+{
+    Q_DECLARE_PRIVATE(QD3D12GpuCuller)
+
+public:
+    QD3D12GpuCuller();
+    ~QD3D12GpuCuller();
+
+    bool create(ID3D12Device *device);
+    void destroy();
+    bool isCreated() const;
+
+    // Reduces depth, a non-multisample R32_TYPELESS texture in depthState,
+    // into the depth pyramid used by the next cull() calls. depth is left
+    // in depthState.
+    bool buildDepthPyramid(ID3D12GraphicsCommandList *commandList,
+                           ID3D12Resource *depth, D3D12_RESOURCE_STATES depthState);
+    // Culls against the frustum only until the next buildDepthPyramid(),
+    // for example after a camera cut.
+    void invalidateDepthPyramid();
+    bool hasDepthPyramid() const;
+
+    // Resets drawer and fills it with the arguments of the instances that
+    // are inside the frustum and not behind the depth pyramid. instances is
+    // a buffer of QD3D12CullInstance in the NON_PIXEL_SHADER_RESOURCE state.
+    // This sets its own pipeline state, root signature and descriptor heap
+    // on the command list.
+    bool cull(ID3D12GraphicsCommandList *commandList, ID3D12Resource *instances, quint32 instanceCount,
+              const QMatrix4x4 &viewProjection, QD3D12IndirectDrawer *drawer);
+
+    // Descriptor heaps and depth pyramids that got replaced are only
+    // released after this, call it once the GPU has finished executing the
+    // command lists from previous calls.
+    void reset();
+
+private:
+    Q_DISABLE_COPY(QD3D12GpuCuller)
+    QScopedPointer<QD3D12GpuCullerPrivate> d_ptr;
+};
+
+QT_END_NAMESPACE
+
+#endif
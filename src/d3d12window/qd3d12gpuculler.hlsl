@@ -0,0 +1,146 @@
+// Culling for QD3D12GpuCuller. CS_ReduceDepth builds one level of the
+// hierarchical depth pyramid, keeping the farthest depth of the texels below
+// each texel. CS_Cull tests one bounding sphere per thread against the
+// frustum and the pyramid and appends the draw arguments of the survivors.
+
+static const uint GROUP_DIM = 8;
+static const uint CULL_GROUP_SIZE = 64;
+
+static const uint CULL_INDEXED = 0x01;
+static const uint CULL_DRAW_ID = 0x02;
+static const uint CULL_OCCLUSION = 0x04;
+
+// QD3D12CullInstance
+struct Instance
+{
+    float4 sphere; // center and radius in world space
+    uint drawId;
+    uint countPerInstance;
+    uint instanceCount;
+    uint startLocation;
+    int baseVertex;
+    uint startInstance;
+    uint2 reserved;
+};
+
+Texture2D<float> reduceSource : register(t0); // the depth buffer or the previous level only
+RWTexture2D<float> reduceTarget : register(u0);
+
+StructuredBuffer<Instance> instances : register(t0);
+Texture2D<float> depthPyramid : register(t1);
+RWByteAddressBuffer commands : register(u0); // the arguments and the count of a QD3D12IndirectDrawer
+
+cbuffer CullConstants : register(b0)
+{
+    float4x4 viewProjection;
+    float4 frustumPlanes[6];
+    uint instanceCount;
+    uint maxDraws;
+    uint commandStride;
+    uint countOffset;
+    uint flags;
+    uint pyramidLevels;
+    uint2 pyramidSize;
+    float2 depthSize;
+}
+
+[numthreads(GROUP_DIM, GROUP_DIM, 1)]
+void CS_ReduceDepth(uint3 globalId : SV_DispatchThreadID)
+{
+    uint2 srcSize;
+    uint2 dstSize;
+    reduceSource.GetDimensions(srcSize.x, srcSize.y);
+    reduceTarget.GetDimensions(dstSize.x, dstSize.y);
+    if (any(globalId.xy >= dstSize))
+        return;
+
+    // The last column and row of an odd sized source cover three texels,
+    // so that nothing is left out.
+    const uint2 extent = uint2(globalId.x == dstSize.x - 1 && srcSize.x > 1 && (srcSize.x & 1) ? 3 : 2,
+                               globalId.y == dstSize.y - 1 && srcSize.y > 1 && (srcSize.y & 1) ? 3 : 2);
+    const uint2 base = globalId.xy * 2;
+    float farthest = 0.0;
+    for (uint y = 0; y < extent.y; ++y) {
+        for (uint x = 0; x < extent.x; ++x)
+            farthest = max(farthest, reduceSource.Load(int3(min(base + uint2(x, y), srcSize - 1), 0)));
+    }
+    reduceTarget[globalId.xy] = farthest;
+}
+
+bool isInFrustum(float4 sphere)
+{
+    for (uint i = 0; i < 6; ++i) {
+        if (dot(frustumPlanes[i].xyz, sphere.xyz) + frustumPlanes[i].w < -sphere.w)
+            return false;
+    }
+    return true;
+}
+
+bool isOccluded(float4 sphere)
+{
+    float2 ndcMin = float2(1.0, 1.0);
+    float2 ndcMax = float2(-1.0, -1.0);
+    float nearest = 1.0;
+    for (uint i = 0; i < 8; ++i) {
+        const float3 corner = sphere.xyz + sphere.w * float3((i & 1) ? 1.0 : -1.0,
+                                                             (i & 2) ? 1.0 : -1.0,
+                                                             (i & 4) ? 1.0 : -1.0);
+        const float4 p = mul(viewProjection, float4(corner, 1.0));
+        // Boxes reaching behind the camera are never occluded.
+        if (p.w <= 0.0)
+            return false;
+        const float3 ndc = p.xyz / p.w;
+        ndcMin = min(ndcMin, ndc.xy);
+        ndcMax = max(ndcMax, ndc.xy);
+        nearest = min(nearest, ndc.z);
+    }
+
+    // In texels of the first level, which has half the size of the depth
+    // buffer. Pick the level where the rectangle spans at most 2x2 texels.
+    const float2 rectMin = saturate(float2(ndcMin.x, -ndcMax.y) * 0.5 + 0.5) * depthSize * 0.5;
+    const float2 rectMax = saturate(float2(ndcMax.x, -ndcMin.y) * 0.5 + 0.5) * depthSize * 0.5;
+    const float2 extent = rectMax - rectMin;
+    const uint level = min(uint(ceil(log2(max(max(extent.x, extent.y), 1.0)))), pyramidLevels - 1);
+    const uint2 levelSize = max(pyramidSize >> level, uint2(1, 1));
+    const uint2 t0 = min(uint2(rectMin) >> level, levelSize - 1);
+    const uint2 t1 = min(uint2(rectMax) >> level, levelSize - 1);
+
+    float farthest = depthPyramid.Load(int3(t0, level));
+    farthest = max(farthest, depthPyramid.Load(int3(t1.x, t0.y, level)));
+    farthest = max(farthest, depthPyramid.Load(int3(t0.x, t1.y, level)));
+    farthest = max(farthest, depthPyramid.Load(int3(t1, level)));
+    return nearest > farthest;
+}
+
+[numthreads(CULL_GROUP_SIZE, 1, 1)]
+void CS_Cull(uint3 globalId : SV_DispatchThreadID)
+{
+    if (globalId.x >= instanceCount)
+        return;
+
+    const Instance instance = instances[globalId.x];
+    if (!isInFrustum(instance.sphere))
+        return;
+    if ((flags & CULL_OCCLUSION) && isOccluded(instance.sphere))
+        return;
+
+    // The count may go past maxDraws, ExecuteIndirect clamps it.
+    uint slot;
+    commands.InterlockedAdd(countOffset, 1, slot);
+    if (slot >= maxDraws)
+        return;
+
+    uint address = slot * commandStride;
+    if (flags & CULL_DRAW_ID) {
+        commands.Store(address, instance.drawId);
+        address += 4;
+    }
+    if (flags & CULL_INDEXED) {
+        commands.Store4(address, uint4(instance.countPerInstance, instance.instanceCount,
+                                       instance.startLocation, asuint(instance.baseVertex)));
+        commands.Store(address + 16, instance.startInstance);
+    } else {
+        commands.Store4(address, uint4(instance.countPerInstance, instance.instanceCount,
+                                       instance.startLocation, instance.startInstance));
+    }
+}
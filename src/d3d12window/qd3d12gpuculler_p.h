@@ -0,0 +1,115 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtD3D12Window module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#ifndef QD3D12GPUCULLER_P_H
+#define QD3D12GPUCULLER_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "qd3d12gpuculler.h"
+#include <QtCore/QVector>
+
+QT_BEGIN_NAMESPACE
+
+// The views of one instance buffer and argument buffer pair.
+struct QD3D12CullBinding
+{
+    ComPtr<ID3D12Resource> instances;
+    ComPtr<ID3D12Resource> arguments;
+    int slot;
+};
+
+class QD3D12GpuCullerPrivate
+{
+public:
+    QD3D12GpuCullerPrivate()
+        : heapCapacity(0),
+          heapUsed(0),
+          descriptorSize(0),
+          pyramidLevels(0),
+          pyramidSlot(-1),
+          pyramidValid(false)
+    { }
+
+    bool reserveDescriptors(int count);
+    D3D12_CPU_DESCRIPTOR_HANDLE cpuHandle(int slot) const;
+    D3D12_GPU_DESCRIPTOR_HANDLE gpuHandle(int slot) const;
+    bool ensurePyramid(ID3D12Resource *depth);
+    void createPyramidViews();
+    int bindingSlot(ID3D12Resource *instances, ID3D12Resource *arguments, quint64 argumentSize);
+
+    ComPtr<ID3D12Device> device;
+    ComPtr<ID3D12RootSignature> rootSignature;
+    ComPtr<ID3D12PipelineState> reducePipelineState;
+    ComPtr<ID3D12PipelineState> cullPipelineState;
+
+    // Views are created once and then reused for as long as their resources
+    // stay the same, so slots are only handed out, never recycled. Slot 0
+    // is a null SRV for culling without a pyramid.
+    ComPtr<ID3D12DescriptorHeap> heap;
+    int heapCapacity;
+    int heapUsed;
+    UINT descriptorSize;
+    QVector<QD3D12CullBinding> bindings;
+
+    // Level 0 is half the size of the depth buffer. pyramidSlot is the SRV
+    // of all levels, followed by a source SRV and target UAV per level.
+    ComPtr<ID3D12Resource> pyramid;
+    ComPtr<ID3D12Resource> depth;
+    QSize depthSize;
+    QSize pyramidSize;
+    quint32 pyramidLevels;
+    int pyramidSlot;
+    bool pyramidValid;
+
+    // Kept alive until reset().
+    QVector<ComPtr<ID3D12DescriptorHeap> > retiredHeaps;
+    QVector<ComPtr<ID3D12Resource> > retiredPyramids;
+};
+
+QT_END_NAMESPACE
+
+#endif
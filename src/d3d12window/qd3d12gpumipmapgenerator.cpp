@@ -0,0 +1,428 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtD3D12Window module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include "qd3d12gpumipmapgenerator_p.h"
+#include "qd3d12gpumipmapgenerator_cs.h"
+#include <QtCore/QDebug>
+
+QT_BEGIN_NAMESPACE
+
+// Passes of several textures share one heap, only when a single record()
+// needs more than this is a bigger heap created.
+static const int DEFAULT_HEAP_SIZE = 1024;
+static const int DESCRIPTORS_PER_PASS = 5; // SRV + 4 UAVs
+
+static void appendTransition(QVector<D3D12_RESOURCE_BARRIER> *barriers, ID3D12Resource *resource, UINT subresource,
+                             D3D12_RESOURCE_STATES before, D3D12_RESOURCE_STATES after)
+{
+    if (before == after)
+        return;
+
+    D3D12_RESOURCE_BARRIER barrier = {};
+    barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+    barrier.Transition.pResource = resource;
+    barrier.Transition.StateBefore = before;
+    barrier.Transition.StateAfter = after;
+    barrier.Transition.Subresource = subresource;
+    barriers->append(barrier);
+}
+
+bool QD3D12GpuMipmapGeneratorPrivate::viewFormats(DXGI_FORMAT format, bool srgb,
+                                                  DXGI_FORMAT *srvFormat, DXGI_FORMAT *uavFormat)
+{
+    // UAVs cannot have sRGB formats, so sRGB textures are written through a
+    // UNORM view and the shader does the encoding.
+    switch (format) {
+    case DXGI_FORMAT_R8G8B8A8_TYPELESS:
+        *srvFormat = srgb ? DXGI_FORMAT_R8G8B8A8_UNORM_SRGB : DXGI_FORMAT_R8G8B8A8_UNORM;
+        *uavFormat = DXGI_FORMAT_R8G8B8A8_UNORM;
+        return true;
+    case DXGI_FORMAT_B8G8R8A8_TYPELESS:
+        *srvFormat = srgb ? DXGI_FORMAT_B8G8R8A8_UNORM_SRGB : DXGI_FORMAT_B8G8R8A8_UNORM;
+        *uavFormat = DXGI_FORMAT_B8G8R8A8_UNORM;
+        return true;
+    case DXGI_FORMAT_R16G16B16A16_TYPELESS:
+        *srvFormat = *uavFormat = DXGI_FORMAT_R16G16B16A16_FLOAT;
+        return !srgb;
+    case DXGI_FORMAT_R32G32B32A32_TYPELESS:
+        *srvFormat = *uavFormat = DXGI_FORMAT_R32G32B32A32_FLOAT;
+        return !srgb;
+    case DXGI_FORMAT_R8G8B8A8_UNORM:
+    case DXGI_FORMAT_B8G8R8A8_UNORM:
+    case DXGI_FORMAT_R10G10B10A2_UNORM:
+    case DXGI_FORMAT_R11G11B10_FLOAT:
+    case DXGI_FORMAT_R16G16B16A16_UNORM:
+    case DXGI_FORMAT_R16G16B16A16_FLOAT:
+    case DXGI_FORMAT_R32G32B32A32_FLOAT:
+    case DXGI_FORMAT_R8G8_UNORM:
+    case DXGI_FORMAT_R16G16_FLOAT:
+    case DXGI_FORMAT_R8_UNORM:
+    case DXGI_FORMAT_R16_FLOAT:
+    case DXGI_FORMAT_R32_FLOAT:
+        *srvFormat = *uavFormat = format;
+        return !srgb;
+    default:
+        return false;
+    }
+}
+
+QVector<QD3D12MipmapPass> QD3D12GpuMipmapGeneratorPrivate::makePasses(quint32 width, quint32 height, quint32 mipLevels)
+{
+    QVector<QD3D12MipmapPass> passes;
+    quint32 level = 0;
+    while (level + 1 < mipLevels) {
+        QD3D12MipmapPass pass;
+        pass.srcLevel = level;
+        pass.oddSource = ((width > 1 && (width & 1)) ? 1 : 0) | ((height > 1 && (height & 1)) ? 2 : 0);
+        pass.width = qMax(1u, width >> 1);
+        pass.height = qMax(1u, height >> 1);
+        pass.mipCount = 1;
+        width = pass.width;
+        height = pass.height;
+        // The shader derives further levels from 2x2 averages within the
+        // group, that is only exact as long as both dimensions halve evenly.
+        while (pass.mipCount < 4 && level + pass.mipCount + 1 < mipLevels
+               && (width == 1 || !(width & 1)) && (height == 1 || !(height & 1))
+               && (width > 1 || height > 1)) {
+            width = qMax(1u, width >> 1);
+            height = qMax(1u, height >> 1);
+            ++pass.mipCount;
+        }
+        passes.append(pass);
+        level += pass.mipCount;
+    }
+    return passes;
+}
+
+bool QD3D12GpuMipmapGeneratorPrivate::reserveDescriptors(int count)
+{
+    if (heap && heapUsed + count <= heapCapacity)
+        return true;
+
+    if (heap) {
+        retiredHeaps.append(heap);
+        heap.Reset();
+    }
+
+    D3D12_DESCRIPTOR_HEAP_DESC heapDesc = {};
+    heapDesc.NumDescriptors = qMax(DEFAULT_HEAP_SIZE, count);
+    heapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+    heapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
+    if (FAILED(device->CreateDescriptorHeap(&heapDesc, IID_PPV_ARGS(&heap)))) {
+        qWarning("QD3D12GpuMipmapGenerator: Failed to create descriptor heap");
+        return false;
+    }
+    heapCapacity = heapDesc.NumDescriptors;
+    heapUsed = 0;
+    return true;
+}
+
+void QD3D12GpuMipmapGeneratorPrivate::createViews(QD3D12MipmapJob *job)
+{
+    D3D12_CPU_DESCRIPTOR_HANDLE h = heap->GetCPUDescriptorHandleForHeapStart();
+    h.ptr += heapUsed * descriptorSize;
+    job->descriptors = heap->GetGPUDescriptorHandleForHeapStart();
+    job->descriptors.ptr += heapUsed * descriptorSize;
+    heapUsed += DESCRIPTORS_PER_PASS * job->passes.count();
+
+    foreach (const QD3D12MipmapPass &pass, job->passes) {
+        // The source level alone, so that the levels still being written
+        // may stay in UNORDERED_ACCESS.
+        D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+        srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+        srvDesc.Format = job->srvFormat;
+        srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2DARRAY;
+        srvDesc.Texture2DArray.MostDetailedMip = pass.srcLevel;
+        srvDesc.Texture2DArray.MipLevels = 1;
+        srvDesc.Texture2DArray.ArraySize = job->arraySize;
+        device->CreateShaderResourceView(job->texture.Get(), &srvDesc, h);
+        h.ptr += descriptorSize;
+
+        // Unused slots get null descriptors.
+        for (quint32 i = 0; i < 4; ++i, h.ptr += descriptorSize) {
+            D3D12_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
+            uavDesc.Format = job->uavFormat;
+            uavDesc.ViewDimension = D3D12_UAV_DIMENSION_TEXTURE2DARRAY;
+            uavDesc.Texture2DArray.MipSlice = pass.srcLevel + 1 + i;
+            uavDesc.Texture2DArray.ArraySize = job->arraySize;
+            device->CreateUnorderedAccessView(i < pass.mipCount ? job->texture.Get() : Q_NULLPTR,
+                                              Q_NULLPTR, &uavDesc, h);
+        }
+    }
+}
+
+QD3D12GpuMipmapGenerator::QD3D12GpuMipmapGenerator()
+    : d_ptr(new QD3D12GpuMipmapGeneratorPrivate)
+{
+}
+
+QD3D12GpuMipmapGenerator::~QD3D12GpuMipmapGenerator()
+{
+}
+
+bool QD3D12GpuMipmapGenerator::create(ID3D12Device *device)
+{
+    Q_D(QD3D12GpuMipmapGenerator);
+    destroy();
+
+    D3D12_STATIC_SAMPLER_DESC sampler = {};
+    sampler.Filter = D3D12_FILTER_MIN_MAG_MIP_LINEAR;
+    sampler.AddressU = D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
+    sampler.AddressV = D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
+    sampler.AddressW = D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
+    sampler.MaxLOD = D3D12_FLOAT32_MAX;
+
+    D3D12_DESCRIPTOR_RANGE descRange[2];
+    descRange[0].RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_SRV;
+    descRange[0].NumDescriptors = 1;
+    descRange[0].BaseShaderRegister = 0; // t0
+    descRange[0].RegisterSpace = 0;
+    descRange[0].OffsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND;
+    descRange[1].RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_UAV;
+    descRange[1].NumDescriptors = 4;
+    descRange[1].BaseShaderRegister = 0; // u0..u3
+    descRange[1].RegisterSpace = 0;
+    descRange[1].OffsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND;
+
+    D3D12_ROOT_PARAMETER rootParameters[2];
+    rootParameters[0].ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
+    rootParameters[0].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+    rootParameters[0].DescriptorTable.NumDescriptorRanges = 2;
+    rootParameters[0].DescriptorTable.pDescriptorRanges = descRange;
+    rootParameters[1].ParameterType = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;
+    rootParameters[1].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+    rootParameters[1].Constants.Num32BitValues = 7;
+    rootParameters[1].Constants.ShaderRegister = 0; // b0
+    rootParameters[1].Constants.RegisterSpace = 0;
+
+    D3D12_ROOT_SIGNATURE_DESC desc = {};
+    desc.NumParameters = 2;
+    desc.pParameters = rootParameters;
+    desc.NumStaticSamplers = 1;
+    desc.pStaticSamplers = &sampler;
+
+    ComPtr<ID3DBlob> signature;
+    ComPtr<ID3DBlob> error;
+    if (FAILED(D3D12SerializeRootSignature(&desc, D3D_ROOT_SIGNATURE_VERSION_1, &signature, &error))) {
+        QByteArray msg;
+        if (error)
+            msg = QByteArray(static_cast<const char *>(error->GetBufferPointer()), int(error->GetBufferSize()));
+        qWarning("QD3D12GpuMipmapGenerator: Failed to serialize root signature: %s", msg.constData());
+        return false;
+    }
+    if (FAILED(device->CreateRootSignature(0, signature->GetBufferPointer(), signature->GetBufferSize(),
+                                           IID_PPV_ARGS(&d->rootSignature)))) {
+        qWarning("QD3D12GpuMipmapGenerator: Failed to create root signature");
+        return false;
+    }
+
+    D3D12_COMPUTE_PIPELINE_STATE_DESC psoDesc = {};
+    psoDesc.pRootSignature = d->rootSignature.Get();
+    psoDesc.CS.pShaderBytecode = g_CS_GenerateMipMaps;
+    psoDesc.CS.BytecodeLength = sizeof(g_CS_GenerateMipMaps);
+    if (FAILED(device->CreateComputePipelineState(&psoDesc, IID_PPV_ARGS(&d->pipelineState)))) {
+        qWarning("QD3D12GpuMipmapGenerator: Failed to create compute pipeline state");
+        d->rootSignature.Reset();
+        return false;
+    }
+
+    d->device = device;
+    d->descriptorSize = device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+    return true;
+}
+
+void QD3D12GpuMipmapGenerator::destroy()
+{
+    Q_D(QD3D12GpuMipmapGenerator);
+    d->jobs.clear();
+    d->retiredHeaps.clear();
+    d->heap.Reset();
+    d->heapCapacity = 0;
+    d->heapUsed = 0;
+    d->pipelineState.Reset();
+    d->rootSignature.Reset();
+    d->device.Reset();
+}
+
+bool QD3D12GpuMipmapGenerator::isCreated() const
+{
+    Q_D(const QD3D12GpuMipmapGenerator);
+    return d->pipelineState.Get() != Q_NULLPTR;
+}
+
+bool QD3D12GpuMipmapGenerator::add(ID3D12Resource *texture, Flags flags, D3D12_RESOURCE_STATES state)
+{
+    Q_D(QD3D12GpuMipmapGenerator);
+    if (!d->pipelineState) {
+        qWarning("QD3D12GpuMipmapGenerator: add() called before create()");
+        return false;
+    }
+
+    const D3D12_RESOURCE_DESC desc = texture->GetDesc();
+    if (desc.Dimension != D3D12_RESOURCE_DIMENSION_TEXTURE2D || desc.SampleDesc.Count > 1) {
+        qWarning("QD3D12GpuMipmapGenerator: Only non-multisample 2D textures, arrays and cubemaps are supported");
+        return false;
+    }
+    if (!(desc.Flags & D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS)) {
+        qWarning("QD3D12GpuMipmapGenerator: The texture does not allow unordered access");
+        return false;
+    }
+
+    QD3D12MipmapJob job;
+    job.srgb = flags.testFlag(SRgb);
+    if (!QD3D12GpuMipmapGeneratorPrivate::viewFormats(desc.Format, job.srgb, &job.srvFormat, &job.uavFormat)) {
+        qWarning("QD3D12GpuMipmapGenerator: Unsupported format %d (sRGB textures need a TYPELESS format)",
+                 desc.Format);
+        return false;
+    }
+    if (desc.MipLevels < 2)
+        return true;
+
+    job.texture = texture;
+    job.state = state;
+    job.arraySize = desc.DepthOrArraySize;
+    job.mipLevels = desc.MipLevels;
+    job.passes = QD3D12GpuMipmapGeneratorPrivate::makePasses(quint32(desc.Width), desc.Height, desc.MipLevels);
+    d->jobs.append(job);
+    return true;
+}
+
+int QD3D12GpuMipmapGenerator::pendingCount() const
+{
+    Q_D(const QD3D12GpuMipmapGenerator);
+    return d->jobs.count();
+}
+
+void QD3D12GpuMipmapGenerator::record(ID3D12GraphicsCommandList *commandList)
+{
+    Q_D(QD3D12GpuMipmapGenerator);
+    if (d->jobs.isEmpty())
+        return;
+
+    int descriptorCount = 0;
+    int stepCount = 0;
+    foreach (const QD3D12MipmapJob &job, d->jobs) {
+        descriptorCount += DESCRIPTORS_PER_PASS * job.passes.count();
+        stepCount = qMax(stepCount, job.passes.count());
+    }
+    if (!d->reserveDescriptors(descriptorCount)) {
+        d->jobs.clear();
+        return;
+    }
+    for (int i = 0; i < d->jobs.count(); ++i)
+        d->createViews(&d->jobs[i]);
+
+    // Level 0 is only read, everything else is written first. Each level
+    // becomes a shader resource once its pass is done.
+    QVector<D3D12_RESOURCE_BARRIER> barriers;
+    foreach (const QD3D12MipmapJob &job, d->jobs) {
+        for (quint32 slice = 0; slice < job.arraySize; ++slice) {
+            for (quint32 level = 0; level < job.mipLevels; ++level) {
+                appendTransition(&barriers, job.texture.Get(), slice * job.mipLevels + level, job.state,
+                                 level ? D3D12_RESOURCE_STATE_UNORDERED_ACCESS
+                                       : D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+            }
+        }
+    }
+    if (!barriers.isEmpty())
+        commandList->ResourceBarrier(barriers.count(), barriers.constData());
+
+    commandList->SetPipelineState(d->pipelineState.Get());
+    commandList->SetComputeRootSignature(d->rootSignature.Get());
+    ID3D12DescriptorHeap *heaps[] = { d->heap.Get() };
+    commandList->SetDescriptorHeaps(_countof(heaps), heaps);
+
+    // The passes of different textures are independent, so step through all
+    // textures together and have one batch of barriers per step instead of
+    // one per dispatch.
+    for (int step = 0; step < stepCount; ++step) {
+        barriers.clear();
+        foreach (const QD3D12MipmapJob &job, d->jobs) {
+            if (step >= job.passes.count())
+                continue;
+            const QD3D12MipmapPass &pass(job.passes[step]);
+
+            D3D12_GPU_DESCRIPTOR_HANDLE h = job.descriptors;
+            h.ptr += step * DESCRIPTORS_PER_PASS * d->descriptorSize;
+            commandList->SetComputeRootDescriptorTable(0, h);
+
+            const float texelSize[2] = { 1.0f / pass.width, 1.0f / pass.height };
+            quint32 constants[7] = { pass.width, pass.height, 0, 0,
+                                     pass.mipCount, pass.oddSource, job.srgb ? 1u : 0u };
+            memcpy(constants + 2, texelSize, sizeof(texelSize));
+            commandList->SetComputeRoot32BitConstants(1, 7, constants, 0);
+
+            // One thread per texel of the first level written, in 8x8 groups.
+            commandList->Dispatch((pass.width + 7) / 8, (pass.height + 7) / 8, job.arraySize);
+
+            for (quint32 slice = 0; slice < job.arraySize; ++slice) {
+                for (quint32 i = 1; i <= pass.mipCount; ++i) {
+                    appendTransition(&barriers, job.texture.Get(), slice * job.mipLevels + pass.srcLevel + i,
+                                     D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
+                                     D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+                }
+            }
+        }
+        commandList->ResourceBarrier(barriers.count(), barriers.constData());
+    }
+
+    barriers.clear();
+    foreach (const QD3D12MipmapJob &job, d->jobs) {
+        appendTransition(&barriers, job.texture.Get(), D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES,
+                         D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, job.state);
+    }
+    if (!barriers.isEmpty())
+        commandList->ResourceBarrier(barriers.count(), barriers.constData());
+
+    d->jobs.clear();
+}
+
+void QD3D12GpuMipmapGenerator::generate(ID3D12GraphicsCommandList *commandList, ID3D12Resource *texture,
+                                        Flags flags, D3D12_RESOURCE_STATES state)
+{
+    if (add(texture, flags, state))
+        record(commandList);
+}
+
+void QD3D12GpuMipmapGenerator::reset()
+{
+    Q_D(QD3D12GpuMipmapGenerator);
+    d->retiredHeaps.clear();
+    d->heapUsed = 0;
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,91 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtD3D12Window module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#ifndef QD3D12GPUMIPMAPGENERATOR_H
+#define QD3D12GPUMIPMAPGENERATOR_H
+
+#include <QtCore/QScopedPointer>
+#include <QtD3D12Window/qd3d12window.h>
+
+QT_BEGIN_NAMESPACE
+
+class QD3D12GpuMipmapGeneratorPrivate;
+
+class QD3D12_EXPORT QD3D12GpuMipmapGenerator
+{
+    Q_DECLARE_PRIVATE(QD3D12GpuMipmapGenerator)
+
+public:
+    enum Flag {
+        SRgb = 0x01 // the texture has a TYPELESS format and is sampled as sRGB
+    };
+    Q_DECLARE_FLAGS(Flags, Flag)
+
+    QD3D12GpuMipmapGenerator();
+    ~QD3D12GpuMipmapGenerator();
+
+    bool create(ID3D12Device *device);
+    void destroy();
+    bool isCreated() const;
+
+    // Textures need D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS. Level 0 of
+    // every array slice is the source, state is the state the texture is in
+    // before and after the generation.
+    bool add(ID3D12Resource *texture, Flags flags = 0,
+             D3D12_RESOURCE_STATES state = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+    int pendingCount() const;
+
+    // Records all added textures in one compute pass. This sets its own
+    // pipeline state, root signature and descriptor heap on the command list.
+    void record(ID3D12GraphicsCommandList *commandList);
+    void generate(ID3D12GraphicsCommandList *commandList, ID3D12Resource *texture, Flags flags = 0,
+                  D3D12_RESOURCE_STATES state = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+
+    // Descriptors are only reused after this, call it once the GPU has
+    // finished executing the command lists from the previous record() calls.
+    void reset();
+
+private:
+    Q_DISABLE_COPY(QD3D12GpuMipmapGenerator)
+    QScopedPointer<QD3D12GpuMipmapGeneratorPrivate> d_ptr;
+};
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(QD3D12GpuMipmapGenerator::Flags)
+
+QT_END_NAMESPACE
+
+#endif
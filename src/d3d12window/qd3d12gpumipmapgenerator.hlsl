@@ -0,0 +1,116 @@
+// Mipmap generation for QD3D12GpuMipmapGenerator. Based on the shader of the
+// hellogpumipmap example, which in turn is a simplified version of
+// https://github.com/Microsoft/DirectX-Graphics-Samples/blob/master/MiniEngine/Core/Shaders/GenerateMipsCS.hlsli
+//
+// Each dispatch writes up to four levels below the source level. The host side only
+// asks for more than one level when every further halving is exact, so the
+// 2x2 averages of the group shared values below are correct for NPOT sizes too.
+
+static const uint GROUP_DIM = 8; // 2 ^ (out_mip_count - 1)
+
+Texture2DArray<float4> srcMip : register(t0); // a view of the source level only
+SamplerState linearClamp : register(s0);
+
+cbuffer MipmapConstants : register(b0)
+{
+    uint2 mip1Size;
+    float2 texelSize; // 1 / mip1Size
+    uint mipCount; // 1..4
+    uint oddSource; // bit 0: source width is odd, bit 1: source height is odd
+    uint srgb; // the UAVs are UNORM views of an sRGB texture
+}
+
+RWTexture2DArray<float4> outMip1 : register(u0);
+RWTexture2DArray<float4> outMip2 : register(u1);
+RWTexture2DArray<float4> outMip3 : register(u2);
+RWTexture2DArray<float4> outMip4 : register(u3);
+
+groupshared float4 groupColor[GROUP_DIM * GROUP_DIM];
+
+float3 linearToSRgb(float3 c)
+{
+    return c < 0.0031308 ? 12.92 * c : 1.055 * pow(abs(c), 1.0 / 2.4) - 0.055;
+}
+
+float4 packColor(float4 c)
+{
+    // Averaging happens in linear space, sampling an sRGB view already
+    // returns linear values.
+    return srgb ? float4(linearToSRgb(c.rgb), c.a) : c;
+}
+
+float4 sampleSource(float2 uv, float slice)
+{
+    return srcMip.SampleLevel(linearClamp, float3(uv, slice), 0);
+}
+
+float4 loadSource(uint3 globalId)
+{
+    // Threads outside the level duplicate the edge texel so that a dimension
+    // of 1 can still be halved exactly in the group shared pass.
+    const float2 id = min(globalId.xy, mip1Size - 1);
+    const float slice = globalId.z;
+
+    if (oddSource == 0) {
+        // One bilinear tap covers the 2x2 source texels.
+        return sampleSource(texelSize * (id + 0.5), slice);
+    } else if (oddSource == 1) {
+        // Odd width: the destination texel covers three source columns.
+        const float2 uv = texelSize * (id + float2(0.25, 0.5));
+        const float2 offset = texelSize * float2(0.5, 0.0);
+        return 0.5 * (sampleSource(uv, slice) + sampleSource(uv + offset, slice));
+    } else if (oddSource == 2) {
+        const float2 uv = texelSize * (id + float2(0.5, 0.25));
+        const float2 offset = texelSize * float2(0.0, 0.5);
+        return 0.5 * (sampleSource(uv, slice) + sampleSource(uv + offset, slice));
+    }
+
+    const float2 uv = texelSize * (id + 0.25);
+    const float2 offset = texelSize * 0.5;
+    return 0.25 * (sampleSource(uv, slice)
+                   + sampleSource(uv + float2(offset.x, 0.0), slice)
+                   + sampleSource(uv + float2(0.0, offset.y), slice)
+                   + sampleSource(uv + offset, slice));
+}
+
+[numthreads(GROUP_DIM, GROUP_DIM, 1)]
+void CS_GenerateMipMaps(uint groupIndex : SV_GroupIndex, uint3 globalId : SV_DispatchThreadID)
+{
+    float4 c = loadSource(globalId);
+    outMip1[globalId] = packColor(c);
+
+    if (mipCount == 1)
+        return;
+
+    groupColor[groupIndex] = c;
+    GroupMemoryBarrierWithGroupSync();
+
+    // x and y even
+    if ((groupIndex & 0x9) == 0) {
+        c = 0.25 * (c + groupColor[groupIndex + 0x01] + groupColor[groupIndex + 0x08] + groupColor[groupIndex + 0x09]);
+        outMip2[uint3(globalId.xy / 2, globalId.z)] = packColor(c);
+        groupColor[groupIndex] = c;
+    }
+
+    if (mipCount == 2)
+        return;
+
+    GroupMemoryBarrierWithGroupSync();
+
+    // x and y multiples of 4
+    if ((groupIndex & 0x1B) == 0) {
+        c = 0.25 * (c + groupColor[groupIndex + 0x02] + groupColor[groupIndex + 0x10] + groupColor[groupIndex + 0x12]);
+        outMip3[uint3(globalId.xy / 4, globalId.z)] = packColor(c);
+        groupColor[groupIndex] = c;
+    }
+
+    if (mipCount == 3)
+        return;
+
+    GroupMemoryBarrierWithGroupSync();
+
+    if (groupIndex == 0) {
+        c = 0.25 * (c + groupColor[0x04] + groupColor[0x20] + groupColor[0x24]);
+        outMip4[uint3(globalId.xy / 8, globalId.z)] = packColor(c);
+    }
+}
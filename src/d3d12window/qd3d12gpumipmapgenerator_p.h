@@ -0,0 +1,109 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtD3D12Window module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#ifndef QD3D12GPUMIPMAPGENERATOR_P_H
+#define QD3D12GPUMIPMAPGENERATOR_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "qd3d12gpumipmapgenerator.h"
+#include <QtCore/QVector>
+
+QT_BEGIN_NAMESPACE
+
+// One dispatch, writing mipCount levels below srcLevel.
+struct QD3D12MipmapPass
+{
+    quint32 srcLevel;
+    quint32 mipCount;
+    quint32 oddSource;
+    quint32 width; // of the first level written
+    quint32 height;
+};
+
+struct QD3D12MipmapJob
+{
+    ComPtr<ID3D12Resource> texture;
+    D3D12_RESOURCE_STATES state;
+    DXGI_FORMAT srvFormat;
+    DXGI_FORMAT uavFormat;
+    bool srgb;
+    quint32 arraySize;
+    quint32 mipLevels;
+    QVector<QD3D12MipmapPass> passes;
+    D3D12_GPU_DESCRIPTOR_HANDLE descriptors; // SRV and 4 UAVs per pass
+};
+
+class QD3D12GpuMipmapGeneratorPrivate
+{
+public:
+    QD3D12GpuMipmapGeneratorPrivate()
+        : heapCapacity(0),
+          heapUsed(0),
+          descriptorSize(0)
+    { }
+
+    static bool viewFormats(DXGI_FORMAT format, bool srgb, DXGI_FORMAT *srvFormat, DXGI_FORMAT *uavFormat);
+    static QVector<QD3D12MipmapPass> makePasses(quint32 width, quint32 height, quint32 mipLevels);
+
+    bool reserveDescriptors(int count);
+    void createViews(QD3D12MipmapJob *job);
+
+    ComPtr<ID3D12Device> device;
+    ComPtr<ID3D12RootSignature> rootSignature;
+    ComPtr<ID3D12PipelineState> pipelineState;
+    ComPtr<ID3D12DescriptorHeap> heap;
+    // Heaps that ran full, kept alive until reset().
+    QVector<ComPtr<ID3D12DescriptorHeap> > retiredHeaps;
+    int heapCapacity;
+    int heapUsed;
+    UINT descriptorSize;
+    QVector<QD3D12MipmapJob> jobs;
+};
+
+QT_END_NAMESPACE
+
+#endif
@@ -0,0 +1,349 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtD3D12Window module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qd3d12gpuprofiler_p.h"
+
+QT_BEGIN_NAMESPACE
+
+// Each slot owns a range of MAX_SCOPES_PER_FRAME * 2 timestamp queries in the
+// heap, a readback buffer the range gets resolved into, and an allocator for
+// the small command list that does the resolve right before Present. Slots
+// are recycled in order once the GPU is done with them, so results arrive
+// with a latency of a couple of frames but reading them never stalls.
+
+static const UINT QUERIES_PER_SLOT = QD3D12GpuProfilerPrivate::MAX_SCOPES_PER_FRAME * 2;
+
+QD3D12GpuProfilerPrivate::~QD3D12GpuProfilerPrivate()
+{
+    if (fenceEvent)
+        CloseHandle(fenceEvent);
+}
+
+bool QD3D12GpuProfilerPrivate::initialize(ID3D12Device *device, ID3D12CommandQueue *queue)
+{
+    commandQueue = queue;
+
+    if (FAILED(commandQueue->GetTimestampFrequency(&frequency)) || !frequency) {
+        qWarning("Failed to query timestamp frequency");
+        return false;
+    }
+
+    D3D12_QUERY_HEAP_DESC heapDesc = {};
+    heapDesc.Type = D3D12_QUERY_HEAP_TYPE_TIMESTAMP;
+    heapDesc.Count = QUERIES_PER_SLOT * FRAME_COUNT;
+    if (FAILED(device->CreateQueryHeap(&heapDesc, IID_PPV_ARGS(&queryHeap)))) {
+        qWarning("Failed to create timestamp query heap");
+        return false;
+    }
+
+    D3D12_HEAP_PROPERTIES heapProp = {};
+    heapProp.Type = D3D12_HEAP_TYPE_READBACK;
+
+    D3D12_RESOURCE_DESC bufDesc = {};
+    bufDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+    bufDesc.Width = QUERIES_PER_SLOT * sizeof(UINT64);
+    bufDesc.Height = 1;
+    bufDesc.DepthOrArraySize = 1;
+    bufDesc.MipLevels = 1;
+    bufDesc.Format = DXGI_FORMAT_UNKNOWN;
+    bufDesc.SampleDesc.Count = 1;
+    bufDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+
+    for (int i = 0; i < FRAME_COUNT; ++i) {
+        Slot &slot(slots[i]);
+        slot = Slot();
+        if (FAILED(device->CreateCommittedResource(&heapProp, D3D12_HEAP_FLAG_NONE, &bufDesc,
+                                                   D3D12_RESOURCE_STATE_COPY_DEST, Q_NULLPTR, IID_PPV_ARGS(&slot.readbackBuffer)))) {
+            qWarning("Failed to create committed resource (timestamp readback buffer)");
+            return false;
+        }
+        if (FAILED(device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&slot.commandAllocator)))) {
+            qWarning("Failed to create command allocator (timestamp resolve)");
+            return false;
+        }
+    }
+
+    if (FAILED(device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, slots[0].commandAllocator.Get(), Q_NULLPTR,
+                                         IID_PPV_ARGS(&commandList)))) {
+        qWarning("Failed to create command list (timestamp resolve)");
+        return false;
+    }
+    commandList->Close();
+
+    fenceValue = 0;
+    if (FAILED(device->CreateFence(fenceValue, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&fence)))) {
+        qWarning("Failed to create fence (timestamp resolve)");
+        return false;
+    }
+    if (!fenceEvent)
+        fenceEvent = CreateEvent(Q_NULLPTR, FALSE, FALSE, Q_NULLPTR);
+
+    currentSlot = 0;
+    openScopes.clear();
+    return true;
+}
+
+void QD3D12GpuProfilerPrivate::releaseResources()
+{
+    for (int i = 0; i < FRAME_COUNT; ++i)
+        slots[i] = Slot();
+    openScopes.clear();
+    commandList = Q_NULLPTR;
+    fence = Q_NULLPTR;
+    queryHeap = Q_NULLPTR;
+    commandQueue = Q_NULLPTR;
+}
+
+void QD3D12GpuProfilerPrivate::collect(int slotIndex)
+{
+    Q_Q(QD3D12GpuProfiler);
+    Slot &slot(slots[slotIndex]);
+
+    quint8 *p = Q_NULLPTR;
+    D3D12_RANGE readRange = { 0, slot.queryCount * sizeof(UINT64) };
+    if (FAILED(slot.readbackBuffer->Map(0, &readRange, reinterpret_cast<void **>(&p)))) {
+        qWarning("Map failed (timestamp readback buffer)");
+        slot.pending = false;
+        return;
+    }
+
+    timings.clear();
+    timings.reserve(slot.scopes.count());
+    const UINT64 *ts = reinterpret_cast<const UINT64 *>(p);
+    const double msPerTick = 1000.0 / double(frequency);
+    foreach (const Scope &scope, slot.scopes) {
+        QD3D12GpuTiming t;
+        t.name = scope.name;
+        t.depth = scope.depth;
+        // Timestamps from different engines or after a clock change can go
+        // backwards. Treat those as zero instead of reporting garbage.
+        const UINT64 begin = ts[scope.beginQuery];
+        const UINT64 end = ts[scope.endQuery];
+        t.milliseconds = end > begin ? (end - begin) * msPerTick : 0.0;
+        timings.append(t);
+    }
+
+    D3D12_RANGE writeRange = { 0, 0 };
+    slot.readbackBuffer->Unmap(0, &writeRange);
+
+    resultFrame = slot.frame;
+    slot.pending = false;
+
+    emit q->timingsReady();
+}
+
+void QD3D12GpuProfilerPrivate::flush()
+{
+    if (!fence)
+        return;
+
+    for (int i = 0; i < FRAME_COUNT; ++i) {
+        const int slotIndex = (currentSlot + i) % FRAME_COUNT;
+        Slot &slot(slots[slotIndex]);
+        if (!slot.pending)
+            continue;
+        if (fence->GetCompletedValue() < slot.fenceValue
+                && SUCCEEDED(fence->SetEventOnCompletion(slot.fenceValue, fenceEvent)))
+            WaitForSingleObject(fenceEvent, INFINITE);
+        collect(slotIndex);
+    }
+}
+
+void QD3D12GpuProfilerPrivate::beginFrame()
+{
+    if (!fence)
+        return;
+
+    // Deliver everything that has finished, oldest first. The slot about to
+    // be recorded into holds the oldest frame.
+    const UINT64 completed = fence->GetCompletedValue();
+    for (int i = 0; i < FRAME_COUNT; ++i) {
+        const int slotIndex = (currentSlot + i) % FRAME_COUNT;
+        Slot &slot(slots[slotIndex]);
+        if (slot.pending && slot.fenceValue <= completed)
+            collect(slotIndex);
+    }
+
+    // The slot about to be recorded into must be idle. This only blocks when
+    // the application runs more than FRAME_COUNT frames ahead of the GPU.
+    Slot &slot(slots[currentSlot]);
+    if (slot.pending) {
+        if (SUCCEEDED(fence->SetEventOnCompletion(slot.fenceValue, fenceEvent)))
+            WaitForSingleObject(fenceEvent, INFINITE);
+        collect(currentSlot);
+    }
+
+    slot.queryCount = 0;
+    slot.scopes.clear();
+    slot.frame = frameCount;
+}
+
+void QD3D12GpuProfilerPrivate::endFrame()
+{
+    if (!fence)
+        return;
+
+    if (!openScopes.isEmpty())
+        qWarning("QD3D12GpuProfiler: %d scope(s) still open at the end of the frame", openScopes.count());
+
+    ++frameCount;
+
+    Slot &slot(slots[currentSlot]);
+    if (slot.scopes.isEmpty()) {
+        openScopes.clear();
+        return;
+    }
+
+    slot.commandAllocator->Reset();
+    commandList->Reset(slot.commandAllocator.Get(), Q_NULLPTR);
+
+    // Scopes left open end here, so that every resolved query has been
+    // written. Negative entries are scopes dropped because of overflow.
+    foreach (int idx, openScopes) {
+        if (idx >= 0)
+            commandList->EndQuery(queryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP,
+                                  currentSlot * QUERIES_PER_SLOT + slot.scopes.at(idx).endQuery);
+    }
+    openScopes.clear();
+
+    commandList->ResolveQueryData(queryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP,
+                                  currentSlot * QUERIES_PER_SLOT, slot.queryCount,
+                                  slot.readbackBuffer.Get(), 0);
+    commandList->Close();
+
+    ID3D12CommandList *commandLists[] = { commandList.Get() };
+    commandQueue->ExecuteCommandLists(_countof(commandLists), commandLists);
+
+    slot.fenceValue = ++fenceValue;
+    commandQueue->Signal(fence.Get(), slot.fenceValue);
+    slot.pending = true;
+
+    currentSlot = (currentSlot + 1) % FRAME_COUNT;
+}
+
+QD3D12GpuProfiler::QD3D12GpuProfiler(QObject *parent)
+    : QObject(*(new QD3D12GpuProfilerPrivate), parent)
+{
+}
+
+QD3D12GpuProfiler::~QD3D12GpuProfiler()
+{
+}
+
+// Writes a timestamp into the command list. Scopes can nest, but must be
+// closed in the same frame, and cannot be used in bundles.
+void QD3D12GpuProfiler::beginScope(ID3D12GraphicsCommandList *commandList, const char *name)
+{
+    Q_D(QD3D12GpuProfiler);
+    if (!d->queryHeap)
+        return;
+
+    QD3D12GpuProfilerPrivate::Slot &slot(d->slots[d->currentSlot]);
+    if (slot.queryCount + 2 > QUERIES_PER_SLOT) {
+        if (!d->overflowWarned) {
+            qWarning("QD3D12GpuProfiler: More than %d scopes in a frame, ignoring the rest",
+                     QD3D12GpuProfilerPrivate::MAX_SCOPES_PER_FRAME);
+            d->overflowWarned = true;
+        }
+        d->openScopes.append(-1);
+        return;
+    }
+
+    QD3D12GpuProfilerPrivate::Scope scope;
+    scope.name = name;
+    scope.depth = d->openScopes.count();
+    scope.beginQuery = slot.queryCount++;
+    scope.endQuery = slot.queryCount++;
+    commandList->EndQuery(d->queryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP,
+                          d->currentSlot * QUERIES_PER_SLOT + scope.beginQuery);
+
+    d->openScopes.append(slot.scopes.count());
+    slot.scopes.append(scope);
+}
+
+void QD3D12GpuProfiler::endScope(ID3D12GraphicsCommandList *commandList)
+{
+    Q_D(QD3D12GpuProfiler);
+    if (d->openScopes.isEmpty())
+        return;
+
+    const int idx = d->openScopes.takeLast();
+    if (idx < 0)
+        return;
+
+    const QD3D12GpuProfilerPrivate::Scope &scope(d->slots[d->currentSlot].scopes.at(idx));
+    commandList->EndQuery(d->queryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP,
+                          d->currentSlot * QUERIES_PER_SLOT + scope.endQuery);
+}
+
+// The per-scope durations of the most recently completed frame, in the order
+// the scopes were opened.
+QVector<QD3D12GpuTiming> QD3D12GpuProfiler::timings() const
+{
+    Q_D(const QD3D12GpuProfiler);
+    return d->timings;
+}
+
+// Sum of all scopes called name in the most recently completed frame.
+double QD3D12GpuProfiler::milliseconds(const QByteArray &name) const
+{
+    Q_D(const QD3D12GpuProfiler);
+    double ms = 0;
+    foreach (const QD3D12GpuTiming &t, d->timings) {
+        if (t.name == name)
+            ms += t.milliseconds;
+    }
+    return ms;
+}
+
+// The number of the frame timings() belongs to, counted from the first frame
+// after the profiler was enabled.
+quint64 QD3D12GpuProfiler::timingsFrame() const
+{
+    Q_D(const QD3D12GpuProfiler);
+    return d->resultFrame;
+}
+
+// Blocks until the GPU has finished every frame still in flight and emits
+// timingsReady() for each, oldest first. Useful before reporting results
+// or stopping rendering, when no further frames would deliver them.
+void QD3D12GpuProfiler::flush()
+{
+    Q_D(QD3D12GpuProfiler);
+    d->flush();
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,107 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtD3D12Window module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QD3D12GPUPROFILER_H
+#define QD3D12GPUPROFILER_H
+
+#include <QtCore/QObject>
+#include <QtCore/QVector>
+#include <QtD3D12Window/qd3d12window.h>
+
+QT_BEGIN_NAMESPACE
+
+struct QD3D12GpuTiming
+{
+    QD3D12GpuTiming() : depth(0), milliseconds(0) { }
+    QByteArray name;
+    int depth;
+    double milliseconds;
+};
+
+Q_DECLARE_TYPEINFO(QD3D12GpuTiming, Q_MOVABLE_TYPE);
+
+class QD3D12GpuProfilerPrivate;
+
+class QD3D12_EXPORT QD3D12GpuProfiler : public QObject
+{
+    Q_OBJECT
+    Q_DECLARE_PRIVATE(QD3D12GpuProfiler)
+
+public:
+    ~QD3D12GpuProfiler();
+
+    void beginScope(ID3D12GraphicsCommandList *commandList, const char *name);
+    void endScope(ID3D12GraphicsCommandList *commandList);
+
+    QVector<QD3D12GpuTiming> timings() const;
+    double milliseconds(const QByteArray &name) const;
+    quint64 timingsFrame() const;
+    void flush();
+
+signals:
+    void timingsReady();
+
+private:
+    explicit QD3D12GpuProfiler(QObject *parent);
+    Q_DISABLE_COPY(QD3D12GpuProfiler)
+    friend class QD3D12Window;
+    friend class QD3D12OffscreenRenderer;
+};
+
+class QD3D12GpuScope
+{
+public:
+    QD3D12GpuScope(QD3D12GpuProfiler *profiler, ID3D12GraphicsCommandList *commandList, const char *name)
+        : m_profiler(profiler), m_commandList(commandList)
+    {
+        if (m_profiler)
+            m_profiler->beginScope(m_commandList, name);
+    }
+    ~QD3D12GpuScope()
+    {
+        if (m_profiler)
+            m_profiler->endScope(m_commandList);
+    }
+
+private:
+    Q_DISABLE_COPY(QD3D12GpuScope)
+    QD3D12GpuProfiler *m_profiler;
+    ID3D12GraphicsCommandList *m_commandList;
+};
+
+QT_END_NAMESPACE
+
+#endif
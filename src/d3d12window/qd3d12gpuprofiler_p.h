@@ -0,0 +1,125 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtD3D12Window module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QD3D12GPUPROFILER_P_H
+#define QD3D12GPUPROFILER_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "qd3d12gpuprofiler.h"
+#include "qd3d12window_p.h"
+#include <QtCore/private/qobject_p.h>
+
+QT_BEGIN_NAMESPACE
+
+class QD3D12GpuProfilerPrivate : public QObjectPrivate, public QD3D12FrameObserver
+{
+    Q_DECLARE_PUBLIC(QD3D12GpuProfiler)
+
+public:
+    // Results for a frame are read back this many frames later at the earliest.
+    static const int FRAME_COUNT = 3;
+    static const int MAX_SCOPES_PER_FRAME = 256;
+
+    QD3D12GpuProfilerPrivate()
+        : fenceEvent(Q_NULLPTR),
+          fenceValue(0),
+          frequency(0),
+          currentSlot(0),
+          frameCount(0),
+          resultFrame(0),
+          overflowWarned(false)
+    { }
+    ~QD3D12GpuProfilerPrivate();
+
+    static QD3D12GpuProfilerPrivate *get(QD3D12GpuProfiler *p) { return p->d_func(); }
+
+    bool initialize(ID3D12Device *device, ID3D12CommandQueue *commandQueue);
+
+    void beginFrame() Q_DECL_OVERRIDE;
+    void endFrame() Q_DECL_OVERRIDE;
+    void releaseResources() Q_DECL_OVERRIDE;
+
+    void collect(int slot);
+    void flush();
+
+    struct Scope {
+        QByteArray name;
+        int depth;
+        UINT beginQuery;
+        UINT endQuery;
+    };
+
+    struct Slot {
+        Slot() : fenceValue(0), queryCount(0), pending(false), frame(0) { }
+        ComPtr<ID3D12CommandAllocator> commandAllocator;
+        ComPtr<ID3D12Resource> readbackBuffer;
+        UINT64 fenceValue;
+        UINT queryCount;
+        bool pending;
+        quint64 frame;
+        QVector<Scope> scopes;
+    };
+
+    ComPtr<ID3D12CommandQueue> commandQueue;
+    ComPtr<ID3D12QueryHeap> queryHeap;
+    ComPtr<ID3D12GraphicsCommandList> commandList;
+    ComPtr<ID3D12Fence> fence;
+    HANDLE fenceEvent;
+    UINT64 fenceValue;
+    UINT64 frequency;
+    Slot slots[FRAME_COUNT];
+    int currentSlot;
+    QVector<int> openScopes;
+    quint64 frameCount;
+
+    QVector<QD3D12GpuTiming> timings;
+    quint64 resultFrame;
+    bool overflowWarned;
+};
+
+QT_END_NAMESPACE
+
+#endif
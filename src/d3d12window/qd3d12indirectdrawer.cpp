@@ -0,0 +1,275 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtD3D12Window module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include "qd3d12indirectdrawer_p.h"
+#include "qd3d12util_p.h"
+
+QT_BEGIN_NAMESPACE
+
+// Submits any number of draws with one ExecuteIndirect call. The arguments
+// are written on the GPU, typically by a compute pass that appends one
+// command per visible object:
+//
+//   struct Command {
+//       uint drawId; // only when created with a drawIdParameter
+//       uint vertexCountPerInstance; // or indexCountPerInstance
+//       uint instanceCount;
+//       uint startVertexLocation; // or startIndexLocation
+//       int baseVertexLocation; // only for DrawIndexed
+//       uint startInstanceLocation;
+//   };
+//   AppendStructuredBuffer<Command> commands : register(u0);
+//
+// Use one drawer per pipeline state, everything else the draws need has to
+// come from the root signature bindings set before execute().
+QD3D12IndirectDrawer::QD3D12IndirectDrawer()
+    : d_ptr(new QD3D12IndirectDrawerPrivate)
+{
+}
+
+QD3D12IndirectDrawer::~QD3D12IndirectDrawer()
+{
+}
+
+bool QD3D12IndirectDrawer::create(ID3D12Device *device, DrawType type, quint32 maxDraws,
+                                  ID3D12RootSignature *rootSignature, int drawIdParameter)
+{
+    Q_D(QD3D12IndirectDrawer);
+    destroy();
+
+    if (!maxDraws) {
+        qWarning("QD3D12IndirectDrawer: maxDraws must not be 0");
+        return false;
+    }
+    if (drawIdParameter >= 0 && !rootSignature) {
+        qWarning("QD3D12IndirectDrawer: A draw id needs a root signature");
+        return false;
+    }
+
+    D3D12_INDIRECT_ARGUMENT_DESC args[2] = {};
+    UINT argCount = 0;
+    quint32 stride = 0;
+    if (drawIdParameter >= 0) {
+        args[argCount].Type = D3D12_INDIRECT_ARGUMENT_TYPE_CONSTANT;
+        args[argCount].Constant.RootParameterIndex = drawIdParameter;
+        args[argCount].Constant.DestOffsetIn32BitValues = 0;
+        args[argCount].Constant.Num32BitValuesToSet = 1;
+        ++argCount;
+        stride += sizeof(UINT);
+    }
+    if (type == DrawIndexed) {
+        args[argCount].Type = D3D12_INDIRECT_ARGUMENT_TYPE_DRAW_INDEXED;
+        stride += sizeof(D3D12_DRAW_INDEXED_ARGUMENTS);
+    } else {
+        args[argCount].Type = D3D12_INDIRECT_ARGUMENT_TYPE_DRAW;
+        stride += sizeof(D3D12_DRAW_ARGUMENTS);
+    }
+    ++argCount;
+
+    D3D12_COMMAND_SIGNATURE_DESC sigDesc = {};
+    sigDesc.ByteStride = stride;
+    sigDesc.NumArgumentDescs = argCount;
+    sigDesc.pArgumentDescs = args;
+    // The root signature is only allowed when the commands change bindings.
+    if (FAILED(device->CreateCommandSignature(&sigDesc, drawIdParameter >= 0 ? rootSignature : Q_NULLPTR,
+                                              IID_PPV_ARGS(&d->commandSignature)))) {
+        qWarning("QD3D12IndirectDrawer: Failed to create command signature");
+        return false;
+    }
+
+    const quint64 counterAlign = D3D12_UAV_COUNTER_PLACEMENT_ALIGNMENT;
+    d->countOffset = (quint64(maxDraws) * stride + counterAlign - 1) & ~(counterAlign - 1);
+
+    D3D12_HEAP_PROPERTIES heapProp = {};
+    heapProp.Type = D3D12_HEAP_TYPE_DEFAULT;
+    D3D12_RESOURCE_DESC bufDesc = {};
+    bufDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+    bufDesc.Width = d->countOffset + sizeof(UINT);
+    bufDesc.Height = 1;
+    bufDesc.DepthOrArraySize = 1;
+    bufDesc.MipLevels = 1;
+    bufDesc.Format = DXGI_FORMAT_UNKNOWN;
+    bufDesc.SampleDesc.Count = 1;
+    bufDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+    bufDesc.Flags = D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
+    if (FAILED(device->CreateCommittedResource(&heapProp, D3D12_HEAP_FLAG_NONE, &bufDesc,
+                                               D3D12_RESOURCE_STATE_COMMON, Q_NULLPTR,
+                                               IID_PPV_ARGS(&d->arguments)))) {
+        qWarning("QD3D12IndirectDrawer: Failed to create argument buffer");
+        destroy();
+        return false;
+    }
+    d->state = D3D12_RESOURCE_STATE_COMMON;
+
+    heapProp.Type = D3D12_HEAP_TYPE_UPLOAD;
+    bufDesc.Width = sizeof(UINT);
+    bufDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
+    if (FAILED(device->CreateCommittedResource(&heapProp, D3D12_HEAP_FLAG_NONE, &bufDesc,
+                                               D3D12_RESOURCE_STATE_GENERIC_READ, Q_NULLPTR,
+                                               IID_PPV_ARGS(&d->zero)))) {
+        qWarning("QD3D12IndirectDrawer: Failed to create buffer");
+        destroy();
+        return false;
+    }
+    UINT *p = Q_NULLPTR;
+    D3D12_RANGE readRange = { 0, 0 };
+    if (FAILED(d->zero->Map(0, &readRange, reinterpret_cast<void **>(&p)))) {
+        qWarning("QD3D12IndirectDrawer: Map failed");
+        destroy();
+        return false;
+    }
+    *p = 0;
+    d->zero->Unmap(0, Q_NULLPTR);
+
+    d->device = device;
+    d->type = type;
+    d->maxDraws = maxDraws;
+    d->drawId = drawIdParameter >= 0;
+    d->stride = stride;
+    return true;
+}
+
+void QD3D12IndirectDrawer::destroy()
+{
+    Q_D(QD3D12IndirectDrawer);
+    d->device.Reset();
+    d->commandSignature.Reset();
+    d->arguments.Reset();
+    d->zero.Reset();
+    d->maxDraws = 0;
+    d->drawId = false;
+    d->stride = 0;
+    d->countOffset = 0;
+}
+
+bool QD3D12IndirectDrawer::isCreated() const
+{
+    Q_D(const QD3D12IndirectDrawer);
+    return d->arguments.Get() != Q_NULLPTR;
+}
+
+QD3D12IndirectDrawer::DrawType QD3D12IndirectDrawer::drawType() const
+{
+    Q_D(const QD3D12IndirectDrawer);
+    return d->type;
+}
+
+quint32 QD3D12IndirectDrawer::maxDraws() const
+{
+    Q_D(const QD3D12IndirectDrawer);
+    return d->maxDraws;
+}
+
+bool QD3D12IndirectDrawer::hasDrawId() const
+{
+    Q_D(const QD3D12IndirectDrawer);
+    return d->drawId;
+}
+
+quint32 QD3D12IndirectDrawer::argumentStride() const
+{
+    Q_D(const QD3D12IndirectDrawer);
+    return d->stride;
+}
+
+ID3D12CommandSignature *QD3D12IndirectDrawer::commandSignature() const
+{
+    Q_D(const QD3D12IndirectDrawer);
+    return d->commandSignature.Get();
+}
+
+ID3D12Resource *QD3D12IndirectDrawer::argumentBuffer() const
+{
+    Q_D(const QD3D12IndirectDrawer);
+    return d->arguments.Get();
+}
+
+// The offset of the UINT draw count in argumentBuffer().
+quint64 QD3D12IndirectDrawer::countOffset() const
+{
+    Q_D(const QD3D12IndirectDrawer);
+    return d->countOffset;
+}
+
+void QD3D12IndirectDrawer::createArgumentUav(D3D12_CPU_DESCRIPTOR_HANDLE handle)
+{
+    Q_D(QD3D12IndirectDrawer);
+    if (!d->arguments)
+        return;
+
+    D3D12_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
+    uavDesc.Format = DXGI_FORMAT_UNKNOWN;
+    uavDesc.ViewDimension = D3D12_UAV_DIMENSION_BUFFER;
+    uavDesc.Buffer.NumElements = d->maxDraws;
+    uavDesc.Buffer.StructureByteStride = d->stride;
+    uavDesc.Buffer.CounterOffsetInBytes = d->countOffset;
+    d->device->CreateUnorderedAccessView(d->arguments.Get(), d->arguments.Get(), &uavDesc, handle);
+}
+
+void QD3D12IndirectDrawer::reset(ID3D12GraphicsCommandList *commandList)
+{
+    Q_D(QD3D12IndirectDrawer);
+    if (!d->arguments)
+        return;
+
+    if (d->state != D3D12_RESOURCE_STATE_COPY_DEST)
+        QD3D12Util::transitionResource(d->arguments.Get(), commandList, d->state, D3D12_RESOURCE_STATE_COPY_DEST);
+    commandList->CopyBufferRegion(d->arguments.Get(), d->countOffset, d->zero.Get(), 0, sizeof(UINT));
+    QD3D12Util::transitionResource(d->arguments.Get(), commandList,
+                                   D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+    d->state = D3D12_RESOURCE_STATE_UNORDERED_ACCESS;
+}
+
+// Records the draws appended since the last reset(). The pipeline state,
+// root signature, bindings and render targets must be set already.
+void QD3D12IndirectDrawer::execute(ID3D12GraphicsCommandList *commandList)
+{
+    Q_D(QD3D12IndirectDrawer);
+    if (!d->arguments)
+        return;
+
+    if (d->state != D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT) {
+        QD3D12Util::transitionResource(d->arguments.Get(), commandList,
+                                       d->state, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT);
+        d->state = D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT;
+    }
+    commandList->ExecuteIndirect(d->commandSignature.Get(), d->maxDraws,
+                                 d->arguments.Get(), 0,
+                                 d->arguments.Get(), d->countOffset);
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,93 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtD3D12Window module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#ifndef QD3D12INDIRECTDRAWER_H
+#define QD3D12INDIRECTDRAWER_H
+
+#include <QtCore/QScopedPointer>
+#include <QtD3D12Window/qd3d12window.h>
+
+QT_BEGIN_NAMESPACE
+
+class QD3D12IndirectDrawerPrivate;
+
+class QD3D12_EXPORT QD3D12IndirectDrawer
+{
+    Q_DECLARE_PRIVATE(QD3D12IndirectDrawer)
+
+public:
+    enum DrawType {
+        Draw,
+        DrawIndexed
+    };
+
+    QD3D12IndirectDrawer();
+    ~QD3D12IndirectDrawer();
+
+    // With drawIdParameter set, every command starts with a 32-bit value
+    // that is written to that root constant parameter of rootSignature
+    // before the draw, typically the index of the object.
+    bool create(ID3D12Device *device, DrawType type, quint32 maxDraws,
+                ID3D12RootSignature *rootSignature = Q_NULLPTR, int drawIdParameter = -1);
+    void destroy();
+    bool isCreated() const;
+
+    DrawType drawType() const;
+    quint32 maxDraws() const;
+    bool hasDrawId() const;
+    quint32 argumentStride() const;
+    ID3D12CommandSignature *commandSignature() const;
+    ID3D12Resource *argumentBuffer() const;
+    quint64 countOffset() const;
+
+    // An AppendStructuredBuffer view of the arguments, its counter is the
+    // draw count.
+    void createArgumentUav(D3D12_CPU_DESCRIPTOR_HANDLE handle);
+
+    // Sets the draw count to zero and leaves the buffer ready for the
+    // compute pass appending the arguments.
+    void reset(ID3D12GraphicsCommandList *commandList);
+    void execute(ID3D12GraphicsCommandList *commandList);
+
+private:
+    Q_DISABLE_COPY(QD3D12IndirectDrawer)
+    QScopedPointer<QD3D12IndirectDrawerPrivate> d_ptr;
+};
+
+QT_END_NAMESPACE
+
+#endif
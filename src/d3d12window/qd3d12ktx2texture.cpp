@@ -0,0 +1,807 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtD3D12Window module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qd3d12ktx2texture_p.h"
+#include "qd3d12util_p.h"
+#include "qd3d12formatinfo.h"
+#include <QtCore/QAtomicInt>
+#include <QtCore/QRunnable>
+#include <QtCore/QSemaphore>
+#include <QtCore/QThreadPool>
+#include <QtCore/qendian.h>
+
+QT_BEGIN_NAMESPACE
+
+static const uchar KTX2_IDENTIFIER[12] = { 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+static const int KTX2_HEADER_SIZE = 80;
+static const int KTX2_LEVEL_INDEX_ENTRY_SIZE = 24;
+// Upper bound for a supercompressed level, inflated or not. Anything larger
+// would not fit into a QByteArray anyway.
+static const quint64 KTX2_MAX_LEVEL_SIZE = 1024 * 1024 * 1024;
+
+// Khronos Data Format descriptor values
+static const uchar KHR_DF_MODEL_RGBSDA = 1;
+static const uchar KHR_DF_MODEL_ETC1S = 163;
+static const uchar KHR_DF_MODEL_UASTC = 166;
+static const uchar KHR_DF_TRANSFER_SRGB = 2;
+static const uchar KHR_DF_CHANNEL_RGBSDA_ALPHA = 15;
+static const uchar KHR_DF_CHANNEL_UASTC_RGBA = 3;
+static const uchar KHR_DF_CHANNEL_UASTC_RRRG = 5;
+
+static inline quint32 readU32(const uchar *p)
+{
+    return qFromLittleEndian<quint32>(p);
+}
+
+static inline quint64 readU64(const uchar *p)
+{
+    return qFromLittleEndian<quint64>(p);
+}
+
+// The VkFormat values a KTX2 file can use without transcoding.
+static DXGI_FORMAT vkFormatToDxgi(quint32 vkFormat)
+{
+    switch (vkFormat) {
+    case 9: // VK_FORMAT_R8_UNORM
+        return DXGI_FORMAT_R8_UNORM;
+    case 16: // VK_FORMAT_R8G8_UNORM
+        return DXGI_FORMAT_R8G8_UNORM;
+    case 37: // VK_FORMAT_R8G8B8A8_UNORM
+        return DXGI_FORMAT_R8G8B8A8_UNORM;
+    case 43: // VK_FORMAT_R8G8B8A8_SRGB
+        return DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;
+    case 44: // VK_FORMAT_B8G8R8A8_UNORM
+        return DXGI_FORMAT_B8G8R8A8_UNORM;
+    case 50: // VK_FORMAT_B8G8R8A8_SRGB
+        return DXGI_FORMAT_B8G8R8A8_UNORM_SRGB;
+    case 64: // VK_FORMAT_A2B10G10R10_UNORM_PACK32
+        return DXGI_FORMAT_R10G10B10A2_UNORM;
+    case 76: // VK_FORMAT_R16_SFLOAT
+        return DXGI_FORMAT_R16_FLOAT;
+    case 83: // VK_FORMAT_R16G16_SFLOAT
+        return DXGI_FORMAT_R16G16_FLOAT;
+    case 97: // VK_FORMAT_R16G16B16A16_SFLOAT
+        return DXGI_FORMAT_R16G16B16A16_FLOAT;
+    case 100: // VK_FORMAT_R32_SFLOAT
+        return DXGI_FORMAT_R32_FLOAT;
+    case 103: // VK_FORMAT_R32G32_SFLOAT
+        return DXGI_FORMAT_R32G32_FLOAT;
+    case 109: // VK_FORMAT_R32G32B32A32_SFLOAT
+        return DXGI_FORMAT_R32G32B32A32_FLOAT;
+    case 122: // VK_FORMAT_B10G11R11_UFLOAT_PACK32
+        return DXGI_FORMAT_R11G11B10_FLOAT;
+    case 123: // VK_FORMAT_E5B9G9R9_UFLOAT_PACK32
+        return DXGI_FORMAT_R9G9B9E5_SHAREDEXP;
+    case 131: // VK_FORMAT_BC1_RGB_UNORM_BLOCK
+    case 133: // VK_FORMAT_BC1_RGBA_UNORM_BLOCK
+        return DXGI_FORMAT_BC1_UNORM;
+    case 132: // VK_FORMAT_BC1_RGB_SRGB_BLOCK
+    case 134: // VK_FORMAT_BC1_RGBA_SRGB_BLOCK
+        return DXGI_FORMAT_BC1_UNORM_SRGB;
+    case 135: // VK_FORMAT_BC2_UNORM_BLOCK
+        return DXGI_FORMAT_BC2_UNORM;
+    case 136: // VK_FORMAT_BC2_SRGB_BLOCK
+        return DXGI_FORMAT_BC2_UNORM_SRGB;
+    case 137: // VK_FORMAT_BC3_UNORM_BLOCK
+        return DXGI_FORMAT_BC3_UNORM;
+    case 138: // VK_FORMAT_BC3_SRGB_BLOCK
+        return DXGI_FORMAT_BC3_UNORM_SRGB;
+    case 139: // VK_FORMAT_BC4_UNORM_BLOCK
+        return DXGI_FORMAT_BC4_UNORM;
+    case 140: // VK_FORMAT_BC4_SNORM_BLOCK
+        return DXGI_FORMAT_BC4_SNORM;
+    case 141: // VK_FORMAT_BC5_UNORM_BLOCK
+        return DXGI_FORMAT_BC5_UNORM;
+    case 142: // VK_FORMAT_BC5_SNORM_BLOCK
+        return DXGI_FORMAT_BC5_SNORM;
+    case 143: // VK_FORMAT_BC6H_UFLOAT_BLOCK
+        return DXGI_FORMAT_BC6H_UF16;
+    case 144: // VK_FORMAT_BC6H_SFLOAT_BLOCK
+        return DXGI_FORMAT_BC6H_SF16;
+    case 145: // VK_FORMAT_BC7_UNORM_BLOCK
+        return DXGI_FORMAT_BC7_UNORM;
+    case 146: // VK_FORMAT_BC7_SRGB_BLOCK
+        return DXGI_FORMAT_BC7_UNORM_SRGB;
+    default:
+        return DXGI_FORMAT_UNKNOWN;
+    }
+}
+
+// Zstandard is not available in Qt, transcoders that handle UASTC usually
+// come with it though.
+bool QD3D12TextureTranscoder::decompressZstd(const uchar *src, quint64 srcSize, uchar *dst, quint64 dstSize)
+{
+    Q_UNUSED(src);
+    Q_UNUSED(srcSize);
+    Q_UNUSED(dst);
+    Q_UNUSED(dstSize);
+    return false;
+}
+
+void QD3D12Ktx2TexturePrivate::reset()
+{
+    sourceFormat = DXGI_FORMAT_UNKNOWN;
+    transcodeFormat = QD3D12TextureTranscoder::Etc1s;
+    supercompression = QD3D12Ktx2Texture::NoSupercompression;
+    transcode = false;
+    alpha = false;
+    sRgb = false;
+    globalData = Q_NULLPTR;
+    globalDataSize = 0;
+    format = DXGI_FORMAT_UNKNOWN;
+    dimension = D3D12_RESOURCE_DIMENSION_UNKNOWN;
+    size = QSize();
+    depth = 1;
+    layerCount = 1;
+    faceCount = 1;
+    mipLevels = 1;
+    levels.clear();
+}
+
+void QD3D12Ktx2TexturePrivate::parseDataFormat(const uchar *dfd, quint32 dfdSize)
+{
+    // dfdTotalSize, then the basic descriptor block: 24 bytes followed by 16 byte samples.
+    if (dfdSize < 4 + 24)
+        return;
+    const uchar *block = dfd + 4;
+    const quint32 blockSize = qMin<quint32>(qFromLittleEndian<quint16>(block + 6), dfdSize - 4);
+    const uchar colorModel = block[8];
+    const int sampleCount = blockSize >= 24 ? (blockSize - 24) / 16 : 0;
+
+    sRgb = block[10] == KHR_DF_TRANSFER_SRGB;
+
+    if (colorModel == KHR_DF_MODEL_ETC1S) {
+        transcodeFormat = QD3D12TextureTranscoder::Etc1s;
+        alpha = sampleCount > 1;
+    } else if (colorModel == KHR_DF_MODEL_UASTC) {
+        transcodeFormat = QD3D12TextureTranscoder::Uastc;
+        const uchar channel = sampleCount > 0 ? (block[24 + 3] & 0xF) : 0;
+        alpha = channel == KHR_DF_CHANNEL_UASTC_RGBA || channel == KHR_DF_CHANNEL_UASTC_RRRG;
+    } else if (colorModel == KHR_DF_MODEL_RGBSDA) {
+        for (int i = 0; i < sampleCount; ++i) {
+            if ((block[24 + i * 16 + 3] & 0xF) == KHR_DF_CHANNEL_RGBSDA_ALPHA)
+                alpha = true;
+        }
+    }
+}
+
+bool QD3D12Ktx2TexturePrivate::parse()
+{
+    reset();
+
+    if (dataSize < KTX2_HEADER_SIZE || memcmp(data, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER))) {
+        qWarning("KTX2: Not a KTX2 file");
+        return false;
+    }
+
+    const quint32 vkFormat = readU32(data + 12);
+    const quint32 width = readU32(data + 20);
+    const quint32 height = readU32(data + 24);
+    const quint32 pixelDepth = readU32(data + 28);
+    const quint32 layers = readU32(data + 32);
+    const quint32 faces = readU32(data + 36);
+    const quint32 levelCount = readU32(data + 40);
+    const quint32 scheme = readU32(data + 44);
+    const quint32 dfdOffset = readU32(data + 48);
+    const quint32 dfdSize = readU32(data + 52);
+    const quint64 sgdOffset = readU64(data + 64);
+    const quint64 sgdSize = readU64(data + 72);
+
+    if (!width || (faces != 1 && faces != 6) || (faces == 6 && (pixelDepth || width != height))) {
+        qWarning("KTX2: Invalid dimensions");
+        return false;
+    }
+    if (scheme > QD3D12Ktx2Texture::Zlib) {
+        qWarning("KTX2: Unknown supercompression scheme %u", scheme);
+        return false;
+    }
+    supercompression = QD3D12Ktx2Texture::Supercompression(scheme);
+
+    // Anything D3D12 cannot create is rejected before the sizes are used in
+    // any arithmetic, so that bogus headers cannot overflow it.
+    quint32 maxSize = D3D12_REQ_TEXTURE2D_U_OR_V_DIMENSION;
+    quint32 maxLayers = D3D12_REQ_TEXTURE2D_ARRAY_AXIS_DIMENSION;
+    if (pixelDepth) {
+        maxSize = D3D12_REQ_TEXTURE3D_U_V_OR_W_DIMENSION;
+        maxLayers = 1;
+    } else if (!height) {
+        maxSize = D3D12_REQ_TEXTURE1D_U_DIMENSION;
+        maxLayers = D3D12_REQ_TEXTURE1D_ARRAY_AXIS_DIMENSION;
+    } else if (faces == 6) {
+        maxSize = D3D12_REQ_TEXTURECUBE_DIMENSION;
+        maxLayers = D3D12_REQ_TEXTURE2D_ARRAY_AXIS_DIMENSION / 6;
+    }
+    if (width > maxSize || height > maxSize || pixelDepth > maxSize) {
+        qWarning("KTX2: Size %ux%ux%u exceeds the limit of %u", width, height, pixelDepth, maxSize);
+        return false;
+    }
+    if (layers > maxLayers) {
+        qWarning("KTX2: Layer count %u exceeds the limit of %u", layers, maxLayers);
+        return false;
+    }
+    if (levelCount > D3D12_REQ_MIP_LEVELS) {
+        qWarning("KTX2: Invalid level count %u", levelCount);
+        return false;
+    }
+
+    size = QSize(int(width), int(qMax<quint32>(1, height)));
+    depth = int(qMax<quint32>(1, pixelDepth));
+    layerCount = int(qMax<quint32>(1, layers));
+    faceCount = int(faces);
+    // A level count of 0 asks for mipmaps to be generated, which is left to the application.
+    mipLevels = int(qMax<quint32>(1, levelCount));
+    if (pixelDepth)
+        dimension = D3D12_RESOURCE_DIMENSION_TEXTURE3D;
+    else if (height)
+        dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+    else
+        dimension = D3D12_RESOURCE_DIMENSION_TEXTURE1D;
+
+    int maxMipLevels = 1;
+    for (int s = qMax(qMax(size.width(), size.height()), depth); s > 1; s >>= 1)
+        ++maxMipLevels;
+    if (mipLevels > maxMipLevels
+            || dataSize < KTX2_HEADER_SIZE + qint64(mipLevels) * KTX2_LEVEL_INDEX_ENTRY_SIZE) {
+        qWarning("KTX2: Invalid level count %d", mipLevels);
+        return false;
+    }
+
+    if (dfdSize && qint64(dfdOffset) + dfdSize <= dataSize)
+        parseDataFormat(data + dfdOffset, dfdSize);
+
+    if (sgdSize) {
+        if (sgdOffset > quint64(dataSize) || sgdSize > quint64(dataSize) - sgdOffset) {
+            qWarning("KTX2: Supercompression global data out of bounds");
+            return false;
+        }
+        globalData = data + sgdOffset;
+        globalDataSize = sgdSize;
+    }
+
+    // VK_FORMAT_UNDEFINED means Basis Universal, either ETC1S (always with
+    // BasisLZ) or UASTC (with or without Zstandard).
+    if (vkFormat == 0) {
+        transcode = true;
+        if (supercompression == QD3D12Ktx2Texture::BasisLZ)
+            transcodeFormat = QD3D12TextureTranscoder::Etc1s;
+        else if (transcodeFormat != QD3D12TextureTranscoder::Uastc) {
+            qWarning("KTX2: Unsupported data format");
+            return false;
+        }
+        if (dimension != D3D12_RESOURCE_DIMENSION_TEXTURE2D) {
+            qWarning("KTX2: Only 2D Basis Universal textures are supported");
+            return false;
+        }
+    } else {
+        sourceFormat = vkFormatToDxgi(vkFormat);
+        if (sourceFormat == DXGI_FORMAT_UNKNOWN) {
+            qWarning("KTX2: Unsupported VkFormat %u", vkFormat);
+            return false;
+        }
+        if (supercompression == QD3D12Ktx2Texture::BasisLZ) {
+            qWarning("KTX2: BasisLZ is only valid for Basis Universal textures");
+            return false;
+        }
+        format = sourceFormat;
+    }
+
+    levels.resize(mipLevels);
+    const uchar *index = data + KTX2_HEADER_SIZE;
+    for (int level = 0; level < mipLevels; ++level) {
+        const uchar *entry = index + level * KTX2_LEVEL_INDEX_ENTRY_SIZE;
+        const quint64 offset = readU64(entry);
+        QD3D12Ktx2Level &l(levels[level]);
+        l.size = readU64(entry + 8);
+        l.uncompressedSize = readU64(entry + 16);
+        if (offset > quint64(dataSize) || l.size > quint64(dataSize) - offset) {
+            qWarning("KTX2: Level %d is out of bounds", level);
+            levels.clear();
+            return false;
+        }
+        l.data = data + offset;
+        // BasisLZ levels are handed to the transcoder as they are.
+        if (supercompression == QD3D12Ktx2Texture::NoSupercompression || supercompression == QD3D12Ktx2Texture::BasisLZ)
+            l.uncompressedSize = l.size;
+    }
+
+    return true;
+}
+
+// The level contents, after inflating Zstandard and zlib. For BasisLZ this
+// is the still supercompressed level, which the transcoder decodes together
+// with the global data.
+const uchar *QD3D12Ktx2TexturePrivate::levelData(int level) const
+{
+    const QD3D12Ktx2Level &l(levels[level]);
+    if (supercompression == QD3D12Ktx2Texture::Zstandard || supercompression == QD3D12Ktx2Texture::Zlib)
+        return l.inflated.isEmpty() ? Q_NULLPTR : reinterpret_cast<const uchar *>(l.inflated.constData());
+    return l.data;
+}
+
+namespace {
+
+class QD3D12Ktx2Job : public QRunnable
+{
+public:
+    QD3D12Ktx2Job(QD3D12Ktx2TexturePrivate *d, QSemaphore *done, QAtomicInt *failed, int level)
+        : d(d), done(done), failed(failed), level(level), layer(0), face(0), dst(Q_NULLPTR)
+    { }
+
+    void run() Q_DECL_OVERRIDE;
+    bool inflate();
+    bool write();
+
+    QD3D12Ktx2TexturePrivate *d;
+    QSemaphore *done;
+    QAtomicInt *failed;
+    int level;
+    int layer;
+    int face;
+    quint8 *dst; // null for the inflate step
+    D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint;
+};
+
+} // namespace
+
+void QD3D12Ktx2Job::run()
+{
+    if (!(dst ? write() : inflate()))
+        failed->storeRelease(1);
+    done->release();
+}
+
+bool QD3D12Ktx2Job::inflate()
+{
+    QD3D12Ktx2Level &l(d->levels[level]);
+    // Both sizes come from the file, check them before allocating anything.
+    if (l.size > KTX2_MAX_LEVEL_SIZE || l.uncompressedSize > KTX2_MAX_LEVEL_SIZE) {
+        qWarning("KTX2: Level %d is too large (%llu bytes, %llu inflated)", level, l.size, l.uncompressedSize);
+        return false;
+    }
+    if (d->supercompression == QD3D12Ktx2Texture::Zlib) {
+        // qUncompress wants the expected size in front of the zlib stream.
+        QByteArray compressed(4 + int(l.size), Qt::Uninitialized);
+        qToBigEndian<quint32>(quint32(l.uncompressedSize), reinterpret_cast<uchar *>(compressed.data()));
+        memcpy(compressed.data() + 4, l.data, l.size);
+        l.inflated = qUncompress(compressed);
+    } else {
+        l.inflated.resize(int(l.uncompressedSize));
+        if (!d->transcoder || !d->transcoder->decompressZstd(l.data, l.size,
+                                                             reinterpret_cast<uchar *>(l.inflated.data()),
+                                                             quint64(l.inflated.size()))) {
+            qWarning("KTX2: Zstandard decompression requires a transcoder that supports it");
+            l.inflated.clear();
+        }
+    }
+    if (quint64(l.inflated.size()) != l.uncompressedSize) {
+        qWarning("KTX2: Failed to inflate level %d", level);
+        l.inflated.clear();
+        return false;
+    }
+    return true;
+}
+
+bool QD3D12Ktx2Job::write()
+{
+    const QD3D12Ktx2Level &l(d->levels[level]);
+    const uchar *src = d->levelData(level);
+    const int w = qMax(1, d->size.width() >> level);
+    const int h = qMax(1, d->size.height() >> level);
+    const int imageInLevel = layer * d->faceCount + face;
+
+    if (d->transcode) {
+        QD3D12TextureTranscoder::Image image;
+        image.format = d->transcodeFormat;
+        image.globalData = d->globalData;
+        image.globalDataSize = d->globalDataSize;
+        image.level = level;
+        image.layer = layer;
+        image.face = face;
+        image.imageIndex = level * d->layerCount * d->faceCount + imageInLevel;
+        image.size = QSize(w, h);
+        image.hasAlpha = d->alpha;
+        if (d->transcodeFormat == QD3D12TextureTranscoder::Uastc) {
+            const quint64 imageSize = quint64((w + 3) / 4) * ((h + 3) / 4) * 16;
+            if ((imageInLevel + 1) * imageSize > l.uncompressedSize) {
+                qWarning("KTX2: Level %d is truncated", level);
+                return false;
+            }
+            image.data = src + imageInLevel * imageSize;
+            image.dataSize = imageSize;
+        } else {
+            image.data = src;
+            image.dataSize = l.uncompressedSize;
+        }
+        return d->transcoder->transcode(image, d->format, dst + footprint.Offset, footprint.Footprint.RowPitch);
+    }
+
+    const QD3D12FormatInfo formatInfo = QD3D12FormatInfo::forFormat(d->sourceFormat);
+    const quint32 rowPitch = formatInfo.rowBytes(w);
+    const quint32 rows = formatInfo.rowCount(h) * qMax(1, d->depth >> level);
+    const quint64 imageSize = quint64(rowPitch) * rows;
+    if ((imageInLevel + 1) * imageSize > l.uncompressedSize) {
+        qWarning("KTX2: Level %d is truncated", level);
+        return false;
+    }
+    src += imageInLevel * imageSize;
+    quint8 *p = dst + footprint.Offset;
+    if (footprint.Footprint.RowPitch == rowPitch) {
+        memcpy(p, src, imageSize);
+    } else {
+        for (quint32 y = 0; y < rows; ++y) {
+            memcpy(p, src, rowPitch);
+            src += rowPitch;
+            p += footprint.Footprint.RowPitch;
+        }
+    }
+    return true;
+}
+
+// Reads KTX2 files. Textures in a DXGI compatible VkFormat (BC1-BC7 and the
+// common uncompressed formats), optionally with Zstandard or zlib
+// supercompression, are uploaded as-is. Basis Universal textures (ETC1S
+// and UASTC) are transcoded, to BC7 when the transcoder and the device
+// support it, otherwise to BC3 or BC1 depending on alpha. The transcoding
+// itself is left to a QD3D12TextureTranscoder, typically a thin wrapper
+// around the Basis Universal transcoder, as that is not part of the module.
+//
+// writeSubresources() runs on the global thread pool, one job per image,
+// and writes straight into the upload buffer.
+QD3D12Ktx2Texture::QD3D12Ktx2Texture()
+    : d_ptr(new QD3D12Ktx2TexturePrivate)
+{
+}
+
+QD3D12Ktx2Texture::~QD3D12Ktx2Texture()
+{
+    clear();
+}
+
+// The transcoder must be thread safe, it is called from several threads
+// at once. Not owned.
+void QD3D12Ktx2Texture::setTranscoder(QD3D12TextureTranscoder *transcoder)
+{
+    Q_D(QD3D12Ktx2Texture);
+    d->transcoder = transcoder;
+}
+
+QD3D12TextureTranscoder *QD3D12Ktx2Texture::transcoder() const
+{
+    Q_D(const QD3D12Ktx2Texture);
+    return d->transcoder;
+}
+
+bool QD3D12Ktx2Texture::load(const QString &fileName)
+{
+    Q_D(QD3D12Ktx2Texture);
+    clear();
+
+    d->file.setFileName(fileName);
+    if (!d->file.open(QIODevice::ReadOnly)) {
+        qWarning("Failed to open %s", qPrintable(fileName));
+        return false;
+    }
+
+    d->dataSize = d->file.size();
+    d->data = d->file.map(0, d->dataSize);
+    if (!d->data) {
+        d->buffer = d->file.readAll();
+        d->file.close();
+        d->data = reinterpret_cast<const uchar *>(d->buffer.constData());
+        d->dataSize = d->buffer.size();
+    }
+
+    if (!d->parse()) {
+        qWarning("Failed to load %s", qPrintable(fileName));
+        clear();
+        return false;
+    }
+    return true;
+}
+
+// The data is referenced, not copied.
+bool QD3D12Ktx2Texture::load(const QByteArray &data)
+{
+    Q_D(QD3D12Ktx2Texture);
+    clear();
+
+    d->buffer = data;
+    d->data = reinterpret_cast<const uchar *>(d->buffer.constData());
+    d->dataSize = d->buffer.size();
+
+    if (!d->parse()) {
+        clear();
+        return false;
+    }
+    return true;
+}
+
+void QD3D12Ktx2Texture::clear()
+{
+    Q_D(QD3D12Ktx2Texture);
+    d->reset();
+    if (d->file.isOpen()) {
+        if (d->data && d->buffer.isEmpty())
+            d->file.unmap(const_cast<uchar *>(d->data));
+        d->file.close();
+    }
+    d->buffer.clear();
+    d->data = Q_NULLPTR;
+    d->dataSize = 0;
+}
+
+bool QD3D12Ktx2Texture::isValid() const
+{
+    Q_D(const QD3D12Ktx2Texture);
+    return !d->levels.isEmpty();
+}
+
+QD3D12Ktx2Texture::Supercompression QD3D12Ktx2Texture::supercompression() const
+{
+    Q_D(const QD3D12Ktx2Texture);
+    return d->supercompression;
+}
+
+bool QD3D12Ktx2Texture::needsTranscoding() const
+{
+    Q_D(const QD3D12Ktx2Texture);
+    return d->transcode;
+}
+
+bool QD3D12Ktx2Texture::hasAlpha() const
+{
+    Q_D(const QD3D12Ktx2Texture);
+    return d->alpha;
+}
+
+bool QD3D12Ktx2Texture::isSRgb() const
+{
+    Q_D(const QD3D12Ktx2Texture);
+    return d->sRgb;
+}
+
+static bool isFormatSupported(ID3D12Device *device, DXGI_FORMAT format)
+{
+    D3D12_FEATURE_DATA_FORMAT_SUPPORT support = {};
+    support.Format = format;
+    if (FAILED(device->CheckFeatureSupport(D3D12_FEATURE_FORMAT_SUPPORT, &support, sizeof(support))))
+        return false;
+    const UINT needed = D3D12_FORMAT_SUPPORT1_TEXTURE2D | D3D12_FORMAT_SUPPORT1_SHADER_SAMPLE;
+    return (UINT(support.Support1) & needed) == needed;
+}
+
+// Picks the format the texture is uploaded in. For Basis Universal this is
+// BC7 if possible, BC3 or BC1 otherwise. Must be called before
+// resourceDesc(), footprints() and writeSubresources().
+DXGI_FORMAT QD3D12Ktx2Texture::selectFormat(ID3D12Device *device)
+{
+    Q_D(QD3D12Ktx2Texture);
+    if (!d->transcode) {
+        d->format = d->sourceFormat;
+        return d->format;
+    }
+
+    d->format = DXGI_FORMAT_UNKNOWN;
+    if (!d->transcoder) {
+        qWarning("KTX2: Basis Universal textures need a transcoder");
+        return d->format;
+    }
+
+    DXGI_FORMAT candidates[2];
+    candidates[0] = d->sRgb ? DXGI_FORMAT_BC7_UNORM_SRGB : DXGI_FORMAT_BC7_UNORM;
+    if (d->alpha)
+        candidates[1] = d->sRgb ? DXGI_FORMAT_BC3_UNORM_SRGB : DXGI_FORMAT_BC3_UNORM;
+    else
+        candidates[1] = d->sRgb ? DXGI_FORMAT_BC1_UNORM_SRGB : DXGI_FORMAT_BC1_UNORM;
+
+    for (int i = 0; i < 2; ++i) {
+        if (d->transcoder->supportsTarget(d->transcodeFormat, candidates[i]) && isFormatSupported(device, candidates[i])) {
+            d->format = candidates[i];
+            break;
+        }
+    }
+
+    if (d->format == DXGI_FORMAT_UNKNOWN)
+        qWarning("KTX2: No suitable transcode target");
+    return d->format;
+}
+
+DXGI_FORMAT QD3D12Ktx2Texture::format() const
+{
+    Q_D(const QD3D12Ktx2Texture);
+    return d->format;
+}
+
+D3D12_RESOURCE_DIMENSION QD3D12Ktx2Texture::dimension() const
+{
+    Q_D(const QD3D12Ktx2Texture);
+    return d->dimension;
+}
+
+QSize QD3D12Ktx2Texture::size() const
+{
+    Q_D(const QD3D12Ktx2Texture);
+    return d->size;
+}
+
+int QD3D12Ktx2Texture::depth() const
+{
+    Q_D(const QD3D12Ktx2Texture);
+    return d->depth;
+}
+
+// Layers times faces, a cubemap has an array size of 6.
+int QD3D12Ktx2Texture::arraySize() const
+{
+    Q_D(const QD3D12Ktx2Texture);
+    return d->layerCount * d->faceCount;
+}
+
+int QD3D12Ktx2Texture::mipLevels() const
+{
+    Q_D(const QD3D12Ktx2Texture);
+    return d->mipLevels;
+}
+
+bool QD3D12Ktx2Texture::isCubeMap() const
+{
+    Q_D(const QD3D12Ktx2Texture);
+    return d->faceCount == 6;
+}
+
+D3D12_RESOURCE_DESC QD3D12Ktx2Texture::resourceDesc() const
+{
+    Q_D(const QD3D12Ktx2Texture);
+    D3D12_RESOURCE_DESC desc = {};
+    desc.Dimension = d->dimension;
+    desc.Width = d->size.width();
+    desc.Height = d->size.height();
+    desc.DepthOrArraySize = d->dimension == D3D12_RESOURCE_DIMENSION_TEXTURE3D ? d->depth : arraySize();
+    desc.MipLevels = d->mipLevels;
+    desc.Format = d->format;
+    desc.SampleDesc.Count = 1;
+    desc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
+    return desc;
+}
+
+D3D12_SHADER_RESOURCE_VIEW_DESC QD3D12Ktx2Texture::shaderResourceViewDesc() const
+{
+    Q_D(const QD3D12Ktx2Texture);
+    D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+    srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+    srvDesc.Format = d->format;
+
+    const bool cubeMap = d->faceCount == 6;
+    switch (d->dimension) {
+    case D3D12_RESOURCE_DIMENSION_TEXTURE1D:
+        if (d->layerCount > 1) {
+            srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE1DARRAY;
+            srvDesc.Texture1DArray.MipLevels = d->mipLevels;
+            srvDesc.Texture1DArray.ArraySize = d->layerCount;
+        } else {
+            srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE1D;
+            srvDesc.Texture1D.MipLevels = d->mipLevels;
+        }
+        break;
+    case D3D12_RESOURCE_DIMENSION_TEXTURE3D:
+        srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE3D;
+        srvDesc.Texture3D.MipLevels = d->mipLevels;
+        break;
+    default:
+        if (cubeMap && d->layerCount > 1) {
+            srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURECUBEARRAY;
+            srvDesc.TextureCubeArray.MipLevels = d->mipLevels;
+            srvDesc.TextureCubeArray.NumCubes = d->layerCount;
+        } else if (cubeMap) {
+            srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURECUBE;
+            srvDesc.TextureCube.MipLevels = d->mipLevels;
+        } else if (d->layerCount > 1) {
+            srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2DARRAY;
+            srvDesc.Texture2DArray.MipLevels = d->mipLevels;
+            srvDesc.Texture2DArray.ArraySize = d->layerCount;
+        } else {
+            srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+            srvDesc.Texture2D.MipLevels = d->mipLevels;
+        }
+        break;
+    }
+
+    return srvDesc;
+}
+
+QVector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> QD3D12Ktx2Texture::footprints(ID3D12Device *device, quint64 *totalSize) const
+{
+    Q_D(const QD3D12Ktx2Texture);
+    QVector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> layouts;
+    UINT64 size = 0;
+    if (d->format == DXGI_FORMAT_UNKNOWN) {
+        qWarning("KTX2: footprints() called without a format, call selectFormat() first");
+    } else {
+        const D3D12_RESOURCE_DESC desc = resourceDesc();
+        layouts.resize(d->mipLevels * arraySize());
+        device->GetCopyableFootprints(&desc, 0, layouts.count(), 0, layouts.data(), Q_NULLPTR, Q_NULLPTR, &size);
+    }
+    if (totalSize)
+        *totalSize = size;
+    return layouts;
+}
+
+// Inflates supercompressed levels, then transcodes or copies every image
+// directly into dst, typically a mapped upload buffer. Blocks until all
+// jobs are done. Returns false if any of them failed.
+bool QD3D12Ktx2Texture::writeSubresources(quint8 *dst, const QVector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> &footprints)
+{
+    Q_D(QD3D12Ktx2Texture);
+    const int images = arraySize();
+    if (d->levels.isEmpty() || footprints.count() < d->mipLevels * images)
+        return false;
+    if (d->transcode && (!d->transcoder || d->format == DXGI_FORMAT_UNKNOWN))
+        return false;
+
+    QThreadPool *pool = QThreadPool::globalInstance();
+    QSemaphore done;
+    QAtomicInt failed;
+
+    if (d->supercompression == Zstandard || d->supercompression == Zlib) {
+        for (int level = 0; level < d->mipLevels; ++level)
+            pool->start(new QD3D12Ktx2Job(d, &done, &failed, level));
+        done.acquire(d->mipLevels);
+        if (failed.loadAcquire())
+            return false;
+    }
+
+    for (int level = 0; level < d->mipLevels; ++level) {
+        for (int layer = 0; layer < d->layerCount; ++layer) {
+            for (int face = 0; face < d->faceCount; ++face) {
+                QD3D12Ktx2Job *job = new QD3D12Ktx2Job(d, &done, &failed, level);
+                job->layer = layer;
+                job->face = face;
+                job->dst = dst;
+                job->footprint = footprints[level + (layer * d->faceCount + face) * d->mipLevels];
+                pool->start(job);
+            }
+        }
+    }
+    done.acquire(d->mipLevels * images);
+
+    // The inflated levels are not needed anymore.
+    for (int level = 0; level < d->mipLevels; ++level)
+        d->levels[level].inflated.clear();
+
+    return !failed.loadAcquire();
+}
+
+QT_END_NAMESPACE
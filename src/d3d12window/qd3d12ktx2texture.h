@@ -0,0 +1,128 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtD3D12Window module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QD3D12KTX2TEXTURE_H
+#define QD3D12KTX2TEXTURE_H
+
+#include <QtCore/QScopedPointer>
+#include <QtCore/QSize>
+#include <QtCore/QVector>
+#include <QtD3D12Window/qd3d12window.h>
+
+QT_BEGIN_NAMESPACE
+
+class QD3D12Ktx2TexturePrivate;
+
+class QD3D12_EXPORT QD3D12TextureTranscoder
+{
+public:
+    enum SourceFormat {
+        Etc1s,
+        Uastc
+    };
+
+    struct Image {
+        SourceFormat format;
+        const uchar *data; // the whole level for ETC1S, one image for UASTC
+        quint64 dataSize;
+        const uchar *globalData; // BasisLZ supercompression global data
+        quint64 globalDataSize;
+        int level;
+        int layer;
+        int face;
+        int imageIndex;
+        QSize size;
+        bool hasAlpha;
+    };
+
+    virtual ~QD3D12TextureTranscoder() { }
+
+    virtual bool supportsTarget(SourceFormat format, DXGI_FORMAT target) const = 0;
+    virtual bool transcode(const Image &image, DXGI_FORMAT target, quint8 *dst, quint32 rowPitch) = 0;
+    virtual bool decompressZstd(const uchar *src, quint64 srcSize, uchar *dst, quint64 dstSize);
+};
+
+class QD3D12_EXPORT QD3D12Ktx2Texture
+{
+    Q_DECLARE_PRIVATE(QD3D12Ktx2Texture)
+
+public:
+    enum Supercompression {
+        NoSupercompression,
+        BasisLZ,
+        Zstandard,
+        Zlib
+    };
+
+    QD3D12Ktx2Texture();
+    ~QD3D12Ktx2Texture();
+
+    void setTranscoder(QD3D12TextureTranscoder *transcoder);
+    QD3D12TextureTranscoder *transcoder() const;
+
+    bool load(const QString &fileName);
+    bool load(const QByteArray &data);
+    void clear();
+    bool isValid() const;
+
+    Supercompression supercompression() const;
+    bool needsTranscoding() const;
+    bool hasAlpha() const;
+    bool isSRgb() const;
+
+    DXGI_FORMAT selectFormat(ID3D12Device *device);
+    DXGI_FORMAT format() const;
+    D3D12_RESOURCE_DIMENSION dimension() const;
+    QSize size() const;
+    int depth() const;
+    int arraySize() const;
+    int mipLevels() const;
+    bool isCubeMap() const;
+
+    D3D12_RESOURCE_DESC resourceDesc() const;
+    D3D12_SHADER_RESOURCE_VIEW_DESC shaderResourceViewDesc() const;
+
+    QVector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> footprints(ID3D12Device *device, quint64 *totalSize) const;
+    bool writeSubresources(quint8 *dst, const QVector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> &footprints);
+
+private:
+    Q_DISABLE_COPY(QD3D12Ktx2Texture)
+    QScopedPointer<QD3D12Ktx2TexturePrivate> d_ptr;
+};
+
+QT_END_NAMESPACE
+
+#endif
@@ -0,0 +1,395 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtD3D12Window module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include "qd3d12meshuploader_p.h"
+
+QT_BEGIN_NAMESPACE
+
+static const quint32 MESH_DATA_ALIGNMENT = 16;
+
+static inline quint32 alignedMeshOffset(quint32 offset)
+{
+    return (offset + MESH_DATA_ALIGNMENT - 1) & ~(MESH_DATA_ALIGNMENT - 1);
+}
+
+// Packs the meshes into blocks of up to blockSize bytes, vertices followed
+// by indices. Meshes that do not fit into a block get one of their own.
+void QD3D12MeshUploaderPrivate::layout(QVector<quint32> *blockSizes)
+{
+    blockSizes->clear();
+    int current = -1;
+    for (int i = 0; i < meshes.count(); ++i) {
+        QD3D12MeshEntry &mesh(meshes[i]);
+        const quint32 vertexSize = alignedMeshOffset(mesh.vertices.size());
+        const quint32 size = vertexSize + mesh.indices.size();
+        if (size > blockSize) {
+            mesh.block = blockSizes->count();
+            mesh.vertexOffset = 0;
+            mesh.indexOffset = vertexSize;
+            blockSizes->append(size);
+            continue;
+        }
+        if (current < 0 || alignedMeshOffset(blockSizes->at(current)) + size > blockSize) {
+            current = blockSizes->count();
+            blockSizes->append(0);
+        }
+        mesh.block = current;
+        mesh.vertexOffset = alignedMeshOffset(blockSizes->at(current));
+        mesh.indexOffset = mesh.vertexOffset + vertexSize;
+        (*blockSizes)[current] = mesh.indexOffset + mesh.indices.size();
+    }
+}
+
+void QD3D12MeshUploaderPrivate::waitForCopy()
+{
+    if (fence && fence->GetCompletedValue() < fenceValue) {
+        if (SUCCEEDED(fence->SetEventOnCompletion(fenceValue, fenceEvent)))
+            WaitForSingleObject(fenceEvent, INFINITE);
+    }
+    releaseStaging();
+}
+
+void QD3D12MeshUploaderPrivate::releaseStaging()
+{
+    staging.Reset();
+    commandList.Reset();
+    allocator.Reset();
+}
+
+// Draws already submitted to the rendering queue may still read the buffers,
+// so they are only released once a fence signaled there after those draws
+// has passed.
+void QD3D12MeshUploaderPrivate::retireBlocks()
+{
+    if (blocks.isEmpty())
+        return;
+    if (renderFence && SUCCEEDED(renderQueue->Signal(renderFence.Get(), ++renderFenceValue))) {
+        QD3D12RetiredMeshBlocks r;
+        r.fence = renderFence;
+        r.fenceValue = renderFenceValue;
+        r.blocks.swap(blocks);
+        retired.append(r);
+    }
+    blocks.clear();
+    releaseRetired(false);
+}
+
+void QD3D12MeshUploaderPrivate::releaseRetired(bool wait)
+{
+    while (!retired.isEmpty()) {
+        const QD3D12RetiredMeshBlocks &r(retired.first());
+        if (r.fence->GetCompletedValue() < r.fenceValue) {
+            if (!wait)
+                break;
+            if (SUCCEEDED(r.fence->SetEventOnCompletion(r.fenceValue, fenceEvent)))
+                WaitForSingleObject(fenceEvent, INFINITE);
+        }
+        retired.removeFirst();
+    }
+}
+
+// Keeps static vertex and index data in DEFAULT heap buffers, so draws read
+// it from video memory instead of across the bus from upload heaps. Many
+// small meshes share one buffer, each gets its own offset into it.
+//
+// The data is staged once and copied on a dedicated copy queue, in
+// parallel with rendering. After device loss call upload() again with the
+// new device, the data is kept for that.
+QD3D12MeshUploader::QD3D12MeshUploader()
+    : d_ptr(new QD3D12MeshUploaderPrivate)
+{
+    Q_D(QD3D12MeshUploader);
+    d->fenceEvent = CreateEvent(Q_NULLPTR, FALSE, FALSE, Q_NULLPTR);
+}
+
+QD3D12MeshUploader::~QD3D12MeshUploader()
+{
+    Q_D(QD3D12MeshUploader);
+    d->waitForCopy();
+    d->retireBlocks();
+    d->releaseRetired(true);
+    CloseHandle(d->fenceEvent);
+}
+
+// The size of the shared buffers, 4 MB by default. Takes effect on the next
+// upload().
+void QD3D12MeshUploader::setBlockSize(quint32 size)
+{
+    Q_D(QD3D12MeshUploader);
+    d->blockSize = qMax(MESH_DATA_ALIGNMENT, size);
+}
+
+quint32 QD3D12MeshUploader::blockSize() const
+{
+    Q_D(const QD3D12MeshUploader);
+    return d->blockSize;
+}
+
+// indexFormat is DXGI_FORMAT_R16_UINT or DXGI_FORMAT_R32_UINT. Returns the
+// id of the mesh for vertexBufferView() and indexBufferView(). Meshes added
+// after upload() only get buffers with the next upload().
+int QD3D12MeshUploader::addMesh(const void *vertices, quint32 vertexDataSize, quint32 vertexStride,
+                                const void *indices, quint32 indexDataSize, DXGI_FORMAT indexFormat)
+{
+    Q_D(QD3D12MeshUploader);
+    if (!vertices || !vertexDataSize || !vertexStride) {
+        qWarning("QD3D12MeshUploader: No vertex data");
+        return -1;
+    }
+    if (indexFormat != DXGI_FORMAT_R16_UINT && indexFormat != DXGI_FORMAT_R32_UINT) {
+        qWarning("QD3D12MeshUploader: Unsupported index format %d", int(indexFormat));
+        return -1;
+    }
+
+    QD3D12MeshEntry mesh;
+    mesh.vertices = QByteArray(static_cast<const char *>(vertices), int(vertexDataSize));
+    if (indices && indexDataSize)
+        mesh.indices = QByteArray(static_cast<const char *>(indices), int(indexDataSize));
+    mesh.vertexStride = vertexStride;
+    mesh.indexFormat = indexFormat;
+    mesh.block = -1;
+    mesh.vertexOffset = 0;
+    mesh.indexOffset = 0;
+    d->meshes.append(mesh);
+    return d->meshes.count() - 1;
+}
+
+int QD3D12MeshUploader::meshCount() const
+{
+    Q_D(const QD3D12MeshUploader);
+    return d->meshes.count();
+}
+
+// Drops the meshes, waiting for a pending copy first. The buffers are
+// released once the rendering queue is done with the draws submitted so far.
+void QD3D12MeshUploader::clear()
+{
+    Q_D(QD3D12MeshUploader);
+    d->waitForCopy();
+    d->retireBlocks();
+    d->meshes.clear();
+}
+
+bool QD3D12MeshUploader::upload(ID3D12Device *device, ID3D12CommandQueue *queue)
+{
+    Q_D(QD3D12MeshUploader);
+    d->waitForCopy();
+    d->retireBlocks();
+    if (d->meshes.isEmpty())
+        return true;
+
+    if (d->renderQueue.Get() != queue) {
+        d->renderQueue = queue;
+        d->renderFence.Reset();
+        d->renderFenceValue = 0;
+        if (FAILED(device->CreateFence(d->renderFenceValue, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&d->renderFence)))) {
+            qWarning("QD3D12MeshUploader: Failed to create fence");
+            d->renderQueue.Reset();
+            return false;
+        }
+    }
+
+    ComPtr<ID3D12Device> queueDevice;
+    if (d->copyQueue && (FAILED(d->copyQueue->GetDevice(IID_PPV_ARGS(&queueDevice))) || queueDevice.Get() != device)) {
+        d->copyQueue.Reset();
+        d->fence.Reset();
+    }
+    if (!d->copyQueue) {
+        D3D12_COMMAND_QUEUE_DESC queueDesc = {};
+        queueDesc.Type = D3D12_COMMAND_LIST_TYPE_COPY;
+        if (FAILED(device->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&d->copyQueue)))) {
+            qWarning("QD3D12MeshUploader: Failed to create copy queue");
+            return false;
+        }
+        d->fenceValue = 0;
+        if (FAILED(device->CreateFence(d->fenceValue, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&d->fence)))) {
+            qWarning("QD3D12MeshUploader: Failed to create fence");
+            d->copyQueue.Reset();
+            return false;
+        }
+    }
+
+    QVector<quint32> blockSizes;
+    d->layout(&blockSizes);
+    QVector<quint64> stagingOffsets(blockSizes.count());
+    quint64 stagingSize = 0;
+    for (int i = 0; i < blockSizes.count(); ++i) {
+        stagingOffsets[i] = stagingSize;
+        stagingSize += alignedMeshOffset(blockSizes[i]);
+    }
+
+    D3D12_HEAP_PROPERTIES uploadHeapProp = {};
+    uploadHeapProp.Type = D3D12_HEAP_TYPE_UPLOAD;
+    D3D12_RESOURCE_DESC bufDesc = {};
+    bufDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+    bufDesc.Width = stagingSize;
+    bufDesc.Height = 1;
+    bufDesc.DepthOrArraySize = 1;
+    bufDesc.MipLevels = 1;
+    bufDesc.Format = DXGI_FORMAT_UNKNOWN;
+    bufDesc.SampleDesc.Count = 1;
+    bufDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+    if (FAILED(device->CreateCommittedResource(&uploadHeapProp, D3D12_HEAP_FLAG_NONE, &bufDesc,
+                                               D3D12_RESOURCE_STATE_GENERIC_READ, Q_NULLPTR,
+                                               IID_PPV_ARGS(&d->staging)))) {
+        qWarning("QD3D12MeshUploader: Failed to create staging buffer");
+        return false;
+    }
+
+    quint8 *p = Q_NULLPTR;
+    D3D12_RANGE readRange = { 0, 0 };
+    if (FAILED(d->staging->Map(0, &readRange, reinterpret_cast<void **>(&p)))) {
+        qWarning("QD3D12MeshUploader: Map failed");
+        d->releaseStaging();
+        return false;
+    }
+    foreach (const QD3D12MeshEntry &mesh, d->meshes) {
+        quint8 *dst = p + stagingOffsets[mesh.block];
+        memcpy(dst + mesh.vertexOffset, mesh.vertices.constData(), mesh.vertices.size());
+        if (!mesh.indices.isEmpty())
+            memcpy(dst + mesh.indexOffset, mesh.indices.constData(), mesh.indices.size());
+    }
+    d->staging->Unmap(0, Q_NULLPTR);
+
+    if (FAILED(device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_COPY, IID_PPV_ARGS(&d->allocator)))
+            || FAILED(device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_COPY, d->allocator.Get(), Q_NULLPTR,
+                                                IID_PPV_ARGS(&d->commandList)))) {
+        qWarning("QD3D12MeshUploader: Failed to create copy command list");
+        d->releaseStaging();
+        return false;
+    }
+
+    // Buffers are always created in the COMMON state. They are promoted to
+    // COPY_DEST by the copy, decay back when it is done, and are then
+    // promoted to the vertex and index buffer states on the direct queue,
+    // so no barriers are needed anywhere.
+    D3D12_HEAP_PROPERTIES defaultHeapProp = {};
+    defaultHeapProp.Type = D3D12_HEAP_TYPE_DEFAULT;
+    d->blocks.resize(blockSizes.count());
+    for (int i = 0; i < blockSizes.count(); ++i) {
+        bufDesc.Width = blockSizes[i];
+        if (FAILED(device->CreateCommittedResource(&defaultHeapProp, D3D12_HEAP_FLAG_NONE, &bufDesc,
+                                                   D3D12_RESOURCE_STATE_COMMON, Q_NULLPTR,
+                                                   IID_PPV_ARGS(&d->blocks[i])))) {
+            qWarning("QD3D12MeshUploader: Failed to create mesh buffer of %u bytes", blockSizes[i]);
+            d->blocks.clear();
+            d->releaseStaging();
+            return false;
+        }
+        d->commandList->CopyBufferRegion(d->blocks[i].Get(), 0, d->staging.Get(), stagingOffsets[i], blockSizes[i]);
+    }
+    d->commandList->Close();
+
+    ID3D12CommandList *commandLists[] = { d->commandList.Get() };
+    d->copyQueue->ExecuteCommandLists(_countof(commandLists), commandLists);
+    d->copyQueue->Signal(d->fence.Get(), ++d->fenceValue);
+    queue->Wait(d->fence.Get(), d->fenceValue);
+    return true;
+}
+
+bool QD3D12MeshUploader::isUploaded() const
+{
+    Q_D(const QD3D12MeshUploader);
+    return !d->blocks.isEmpty();
+}
+
+// Returns true once the GPU has finished the copy, the staging memory is
+// released then. Rendering does not need to check this.
+bool QD3D12MeshUploader::isCopyFinished()
+{
+    Q_D(QD3D12MeshUploader);
+    d->releaseRetired(false);
+    if (d->fence && d->fence->GetCompletedValue() < d->fenceValue)
+        return false;
+    d->releaseStaging();
+    return true;
+}
+
+// Meshes added after the last upload() have no buffer yet and get an empty
+// view until upload() is called again.
+D3D12_VERTEX_BUFFER_VIEW QD3D12MeshUploader::vertexBufferView(int mesh) const
+{
+    Q_D(const QD3D12MeshUploader);
+    D3D12_VERTEX_BUFFER_VIEW view = {};
+    if (mesh < 0 || mesh >= d->meshes.count())
+        return view;
+    const QD3D12MeshEntry &entry(d->meshes[mesh]);
+    if (entry.block < 0 || entry.block >= d->blocks.count())
+        return view;
+    view.BufferLocation = d->blocks[entry.block]->GetGPUVirtualAddress() + entry.vertexOffset;
+    view.SizeInBytes = entry.vertices.size();
+    view.StrideInBytes = entry.vertexStride;
+    return view;
+}
+
+// An empty view for meshes without indices, and for meshes not uploaded yet.
+D3D12_INDEX_BUFFER_VIEW QD3D12MeshUploader::indexBufferView(int mesh) const
+{
+    Q_D(const QD3D12MeshUploader);
+    D3D12_INDEX_BUFFER_VIEW view = {};
+    if (mesh < 0 || mesh >= d->meshes.count())
+        return view;
+    const QD3D12MeshEntry &entry(d->meshes[mesh]);
+    if (entry.block < 0 || entry.block >= d->blocks.count() || entry.indices.isEmpty())
+        return view;
+    view.BufferLocation = d->blocks[entry.block]->GetGPUVirtualAddress() + entry.indexOffset;
+    view.SizeInBytes = entry.indices.size();
+    view.Format = entry.indexFormat;
+    return view;
+}
+
+quint32 QD3D12MeshUploader::indexCount(int mesh) const
+{
+    Q_D(const QD3D12MeshUploader);
+    if (mesh < 0 || mesh >= d->meshes.count())
+        return 0;
+    const QD3D12MeshEntry &entry(d->meshes[mesh]);
+    return entry.indices.size() / (entry.indexFormat == DXGI_FORMAT_R32_UINT ? 4 : 2);
+}
+
+// The shared buffers, for example for QD3D12ResidencyManager::track().
+QVector<ID3D12Resource *> QD3D12MeshUploader::buffers() const
+{
+    Q_D(const QD3D12MeshUploader);
+    QVector<ID3D12Resource *> result;
+    result.reserve(d->blocks.count());
+    foreach (const ComPtr<ID3D12Resource> &block, d->blocks)
+        result.append(block.Get());
+    return result;
+}
+
+QT_END_NAMESPACE
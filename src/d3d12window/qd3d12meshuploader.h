@@ -0,0 +1,86 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtD3D12Window module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#ifndef QD3D12MESHUPLOADER_H
+#define QD3D12MESHUPLOADER_H
+
+#include <QtCore/QScopedPointer>
+#include <QtCore/QVector>
+#include <QtD3D12Window/qd3d12window.h>
+
+QT_BEGIN_NAMESPACE
+
+class QD3D12MeshUploaderPrivate;
+
+class QD3D12_EXPORT QD3D12MeshUploader
+{
+    Q_DECLARE_PRIVATE(QD3D12MeshUploader)
+
+public:
+    QD3D12MeshUploader();
+    ~QD3D12MeshUploader();
+
+    void setBlockSize(quint32 size);
+    quint32 blockSize() const;
+
+    int addMesh(const void *vertices, quint32 vertexDataSize, quint32 vertexStride,
+                const void *indices = Q_NULLPTR, quint32 indexDataSize = 0,
+                DXGI_FORMAT indexFormat = DXGI_FORMAT_R16_UINT);
+    int meshCount() const;
+    void clear();
+
+    // Copies everything added so far into DEFAULT heap buffers on a copy
+    // queue. Draws submitted to queue after this wait for the copy on the
+    // GPU, the CPU never blocks. The buffers of an earlier upload are
+    // released once queue has finished the work submitted before this call.
+    bool upload(ID3D12Device *device, ID3D12CommandQueue *queue);
+    bool isUploaded() const;
+    bool isCopyFinished();
+
+    D3D12_VERTEX_BUFFER_VIEW vertexBufferView(int mesh) const;
+    D3D12_INDEX_BUFFER_VIEW indexBufferView(int mesh) const;
+    quint32 indexCount(int mesh) const;
+    QVector<ID3D12Resource *> buffers() const;
+
+private:
+    Q_DISABLE_COPY(QD3D12MeshUploader)
+    QScopedPointer<QD3D12MeshUploaderPrivate> d_ptr;
+};
+
+QT_END_NAMESPACE
+
+#endif
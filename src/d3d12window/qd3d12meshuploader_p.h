@@ -0,0 +1,118 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtD3D12Window module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#ifndef QD3D12MESHUPLOADER_P_H
+#define QD3D12MESHUPLOADER_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "qd3d12meshuploader.h"
+#include <QtCore/QByteArray>
+
+QT_BEGIN_NAMESPACE
+
+struct QD3D12MeshEntry
+{
+    // Kept so the meshes can be uploaded again after device loss.
+    QByteArray vertices;
+    QByteArray indices;
+    quint32 vertexStride;
+    DXGI_FORMAT indexFormat;
+
+    // Placement, valid after upload().
+    int block;
+    quint32 vertexOffset;
+    quint32 indexOffset;
+};
+
+struct QD3D12RetiredMeshBlocks
+{
+    ComPtr<ID3D12Fence> fence;
+    UINT64 fenceValue;
+    QVector<ComPtr<ID3D12Resource> > blocks;
+};
+
+class QD3D12MeshUploaderPrivate
+{
+public:
+    QD3D12MeshUploaderPrivate()
+        : blockSize(4 * 1024 * 1024),
+          fenceEvent(Q_NULLPTR),
+          fenceValue(0),
+          renderFenceValue(0)
+    { }
+
+    void layout(QVector<quint32> *blockSizes);
+    void waitForCopy();
+    void releaseStaging();
+    void retireBlocks();
+    void releaseRetired(bool wait);
+
+    quint32 blockSize;
+    QVector<QD3D12MeshEntry> meshes;
+    QVector<ComPtr<ID3D12Resource> > blocks;
+
+    ComPtr<ID3D12CommandQueue> copyQueue;
+    ComPtr<ID3D12Fence> fence;
+    HANDLE fenceEvent;
+    UINT64 fenceValue;
+
+    // Only alive until the copy has finished.
+    ComPtr<ID3D12Resource> staging;
+    ComPtr<ID3D12CommandAllocator> allocator;
+    ComPtr<ID3D12GraphicsCommandList> commandList;
+
+    // The queue drawing with the buffers, buffers that were replaced stay
+    // alive until it has passed the fence signaled after them.
+    ComPtr<ID3D12CommandQueue> renderQueue;
+    ComPtr<ID3D12Fence> renderFence;
+    UINT64 renderFenceValue;
+    QVector<QD3D12RetiredMeshBlocks> retired;
+};
+
+QT_END_NAMESPACE
+
+#endif
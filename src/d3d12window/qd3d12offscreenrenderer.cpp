@@ -0,0 +1,543 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtD3D12Window module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qd3d12offscreenrenderer.h"
+#include "qd3d12window_p.h"
+#include "qd3d12gpuprofiler_p.h"
+#include "qd3d12util_p.h"
+#include <QtCore/QScopedPointer>
+#include <QtCore/private/qobject_p.h>
+
+QT_BEGIN_NAMESPACE
+
+class QD3D12OffscreenRendererPrivate : public QObjectPrivate
+{
+    Q_DECLARE_PUBLIC(QD3D12OffscreenRenderer)
+
+public:
+    QD3D12OffscreenRendererPrivate()
+        : size(256, 256),
+          extraRenderTargetCount(0),
+          adapterPreference(QD3D12Adapter::DefaultPreference),
+          adapterLuid(0),
+          created(false),
+          rtvStride(0),
+          dsvStride(0),
+          gpuProfiler(Q_NULLPTR)
+    { }
+
+    bool setupRenderTargets();
+    void waitForIdle();
+    void release();
+    void deviceLost();
+
+    QSize size;
+    int extraRenderTargetCount;
+    QD3D12Adapter::Preference adapterPreference;
+    quint64 adapterLuid;
+    bool created;
+    ComPtr<ID3D12Device> device;
+    ComPtr<ID3D12CommandQueue> commandQueue;
+    ComPtr<ID3D12DescriptorHeap> rtvHeap;
+    ComPtr<ID3D12DescriptorHeap> dsvHeap;
+    ComPtr<ID3D12Resource> renderTarget;
+    ComPtr<ID3D12Resource> depthStencil;
+    UINT rtvStride;
+    UINT dsvStride;
+    ComPtr<ID3D12CommandAllocator> commandAllocator;
+    ComPtr<ID3D12CommandAllocator> bundleAllocator;
+    ComPtr<ID3D12CommandAllocator> grabAllocator;
+    ComPtr<ID3D12GraphicsCommandList> grabCommandList;
+    QScopedPointer<QD3D12Window::Fence> idleFence;
+    QD3D12GpuProfiler *gpuProfiler;
+    QVector<QD3D12FrameObserver *> frameObservers;
+};
+
+bool QD3D12OffscreenRendererPrivate::setupRenderTargets()
+{
+    // The "back buffer" rests in the COMMON state between frames, which is
+    // the same as PRESENT, so rendering code written for QD3D12Window works
+    // unchanged.
+    renderTarget.Attach(QD3D12Util::createRenderTarget(device.Get(), rtvHeap->GetCPUDescriptorHandleForHeapStart(),
+                                                       size, Q_NULLPTR, 0, D3D12_RESOURCE_STATE_COMMON));
+    depthStencil.Attach(QD3D12Util::createDepthStencil(device.Get(), dsvHeap->GetCPUDescriptorHandleForHeapStart(),
+                                                       size, 0));
+    return renderTarget && depthStencil;
+}
+
+void QD3D12OffscreenRendererPrivate::waitForIdle()
+{
+    if (commandQueue && idleFence)
+        QD3D12Util::waitForGPU(commandQueue.Get(), idleFence.data());
+}
+
+void QD3D12OffscreenRendererPrivate::release()
+{
+    foreach (QD3D12FrameObserver *observer, frameObservers)
+        observer->releaseResources();
+
+    idleFence.reset();
+    grabCommandList = Q_NULLPTR;
+    grabAllocator = Q_NULLPTR;
+    bundleAllocator = Q_NULLPTR;
+    commandAllocator = Q_NULLPTR;
+    rtvStride = dsvStride = 0;
+    depthStencil = Q_NULLPTR;
+    renderTarget = Q_NULLPTR;
+    dsvHeap = Q_NULLPTR;
+    rtvHeap = Q_NULLPTR;
+    commandQueue = Q_NULLPTR;
+    device = Q_NULLPTR;
+
+    created = false;
+}
+
+void QD3D12OffscreenRendererPrivate::deviceLost()
+{
+    Q_Q(QD3D12OffscreenRenderer);
+    qWarning("D3D device lost");
+
+    q->releaseD3D();
+    release();
+    q->create();
+}
+
+QD3D12OffscreenRenderer::QD3D12OffscreenRenderer(QObject *parent)
+    : QObject(*(new QD3D12OffscreenRendererPrivate), parent)
+{
+}
+
+QD3D12OffscreenRenderer::~QD3D12OffscreenRenderer()
+{
+    Q_D(QD3D12OffscreenRenderer);
+    // Subclasses are gone by now, releaseD3D() cannot be called here.
+    d->waitForIdle();
+    d->release();
+}
+
+void QD3D12OffscreenRenderer::setSize(const QSize &size)
+{
+    Q_D(QD3D12OffscreenRenderer);
+    if (size == d->size || size.isEmpty())
+        return;
+
+    d->size = size;
+    if (!d->created)
+        return;
+
+    d->waitForIdle();
+    d->depthStencil = Q_NULLPTR;
+    d->renderTarget = Q_NULLPTR;
+    d->setupRenderTargets();
+    resizeD3D(size);
+}
+
+QSize QD3D12OffscreenRenderer::size() const
+{
+    Q_D(const QD3D12OffscreenRenderer);
+    return d->size;
+}
+
+void QD3D12OffscreenRenderer::setExtraRenderTargetCount(int count)
+{
+    Q_D(QD3D12OffscreenRenderer);
+    if (d->created) {
+        qWarning("setExtraRenderTargetCount: Already initialized, request ignored.");
+        return;
+    }
+    d->extraRenderTargetCount = qMax(0, count);
+}
+
+void QD3D12OffscreenRenderer::setGpuProfilingEnabled(bool enable)
+{
+    Q_D(QD3D12OffscreenRenderer);
+    if (d->created) {
+        qWarning("setGpuProfilingEnabled: Already initialized, request ignored.");
+        return;
+    }
+    if (enable == (d->gpuProfiler != Q_NULLPTR))
+        return;
+
+    if (enable) {
+        d->gpuProfiler = new QD3D12GpuProfiler(this);
+        d->frameObservers.append(QD3D12GpuProfilerPrivate::get(d->gpuProfiler));
+    } else {
+        d->frameObservers.removeOne(QD3D12GpuProfilerPrivate::get(d->gpuProfiler));
+        delete d->gpuProfiler;
+        d->gpuProfiler = Q_NULLPTR;
+    }
+}
+
+// Forces the WARP software rasterizer instead of a hardware adapter. Useful
+// on headless servers without a GPU and for reproducible reference images.
+// Same as setAdapterPreference(QD3D12Adapter::Software).
+void QD3D12OffscreenRenderer::setSoftwareRendering(bool enable)
+{
+    setAdapterPreference(enable ? QD3D12Adapter::Software : QD3D12Adapter::DefaultPreference);
+}
+
+bool QD3D12OffscreenRenderer::isSoftwareRendering() const
+{
+    Q_D(const QD3D12OffscreenRenderer);
+    return d->adapterPreference == QD3D12Adapter::Software;
+}
+
+void QD3D12OffscreenRenderer::setAdapterPreference(QD3D12Adapter::Preference preference)
+{
+    Q_D(QD3D12OffscreenRenderer);
+    if (d->created) {
+        qWarning("setAdapterPreference: Already initialized, request ignored.");
+        return;
+    }
+    d->adapterPreference = preference;
+}
+
+QD3D12Adapter::Preference QD3D12OffscreenRenderer::adapterPreference() const
+{
+    Q_D(const QD3D12OffscreenRenderer);
+    return d->adapterPreference;
+}
+
+void QD3D12OffscreenRenderer::setAdapterLuid(quint64 luid)
+{
+    Q_D(QD3D12OffscreenRenderer);
+    if (d->created) {
+        qWarning("setAdapterLuid: Already initialized, request ignored.");
+        return;
+    }
+    d->adapterLuid = luid;
+}
+
+quint64 QD3D12OffscreenRenderer::adapterLuid() const
+{
+    Q_D(const QD3D12OffscreenRenderer);
+    return d->adapterLuid;
+}
+
+// Creates the device, the queue and a single color and depth-stencil buffer
+// of size(), then calls initializeD3D(). There is no window and no swap
+// chain involved.
+bool QD3D12OffscreenRenderer::create()
+{
+    Q_D(QD3D12OffscreenRenderer);
+    if (d->created)
+        return true;
+
+    ComPtr<IDXGIFactory4> factory;
+    if (!QD3D12Util::createDevice(d->adapterPreference, d->adapterLuid, &factory, &d->device))
+        return false;
+
+    D3D12_COMMAND_QUEUE_DESC queueDesc = {};
+    queueDesc.Type = D3D12_COMMAND_LIST_TYPE_DIRECT;
+    if (FAILED(d->device->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&d->commandQueue)))) {
+        qWarning("Failed to create command queue");
+        d->release();
+        return false;
+    }
+
+    if (FAILED(d->device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&d->commandAllocator)))) {
+        qWarning("Failed to create command allocator");
+        d->release();
+        return false;
+    }
+
+    if (FAILED(d->device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_BUNDLE, IID_PPV_ARGS(&d->bundleAllocator)))) {
+        qWarning("Failed to create command bundle allocator");
+        d->release();
+        return false;
+    }
+
+    D3D12_DESCRIPTOR_HEAP_DESC rtvHeapDesc = {};
+    rtvHeapDesc.NumDescriptors = 1 + d->extraRenderTargetCount;
+    rtvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_RTV;
+    if (FAILED(d->device->CreateDescriptorHeap(&rtvHeapDesc, IID_PPV_ARGS(&d->rtvHeap)))) {
+        qWarning("Failed to create render target view descriptor heap");
+        d->release();
+        return false;
+    }
+    d->rtvStride = d->device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
+
+    D3D12_DESCRIPTOR_HEAP_DESC dsvHeapDesc = {};
+    dsvHeapDesc.NumDescriptors = 1 + d->extraRenderTargetCount;
+    dsvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_DSV;
+    if (FAILED(d->device->CreateDescriptorHeap(&dsvHeapDesc, IID_PPV_ARGS(&d->dsvHeap)))) {
+        qWarning("Failed to create depth stencil heap");
+        d->release();
+        return false;
+    }
+    d->dsvStride = d->device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_DSV);
+
+    if (!d->setupRenderTargets()) {
+        d->release();
+        return false;
+    }
+
+    d->idleFence.reset(QD3D12Util::createFence(d->device.Get()));
+
+    if (d->gpuProfiler && !QD3D12GpuProfilerPrivate::get(d->gpuProfiler)->initialize(d->device.Get(), d->commandQueue.Get()))
+        qWarning("GPU profiling is not available");
+
+    d->created = true;
+
+    foreach (QD3D12FrameObserver *observer, d->frameObservers)
+        observer->initializeResources();
+
+    initializeD3D();
+    return true;
+}
+
+void QD3D12OffscreenRenderer::destroy()
+{
+    Q_D(QD3D12OffscreenRenderer);
+    if (!d->created)
+        return;
+
+    d->waitForIdle();
+    releaseD3D();
+    d->release();
+}
+
+bool QD3D12OffscreenRenderer::isCreated() const
+{
+    Q_D(const QD3D12OffscreenRenderer);
+    return d->created;
+}
+
+// Runs one frame: paintD3D() followed by afterPresent(), with the frame
+// boundaries the helpers like the GPU profiler rely on around them. Returns
+// false when the device could not be created or got lost during the frame;
+// in the latter case everything has been reinitialized by the time this
+// returns.
+bool QD3D12OffscreenRenderer::renderFrame()
+{
+    Q_D(QD3D12OffscreenRenderer);
+    if (!create())
+        return false;
+
+    foreach (QD3D12FrameObserver *observer, d->frameObservers)
+        observer->beginFrame();
+
+    paintD3D();
+
+    foreach (QD3D12FrameObserver *observer, d->frameObservers)
+        observer->endFrame();
+
+    afterPresent();
+
+    const HRESULT reason = d->device->GetDeviceRemovedReason();
+    if (reason == DXGI_ERROR_DEVICE_REMOVED || reason == DXGI_ERROR_DEVICE_RESET || reason == DXGI_ERROR_DEVICE_HUNG) {
+        d->deviceLost();
+        return false;
+    }
+
+    return true;
+}
+
+// Reads back the contents of the color buffer. Must not be called while a
+// frame is being recorded.
+QImage QD3D12OffscreenRenderer::grab()
+{
+    Q_D(QD3D12OffscreenRenderer);
+    if (!d->created)
+        return QImage();
+
+    if (!d->grabAllocator) {
+        if (FAILED(d->device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&d->grabAllocator)))) {
+            qWarning("Failed to create command allocator");
+            return QImage();
+        }
+        if (FAILED(d->device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, d->grabAllocator.Get(), Q_NULLPTR,
+                                                IID_PPV_ARGS(&d->grabCommandList)))) {
+            qWarning("Failed to create command list");
+            return QImage();
+        }
+    } else {
+        d->grabAllocator->Reset();
+        d->grabCommandList->Reset(d->grabAllocator.Get(), Q_NULLPTR);
+    }
+
+    return readbackRGBA8888(d->renderTarget.Get(), D3D12_RESOURCE_STATE_COMMON, d->grabCommandList.Get());
+}
+
+ID3D12Device *QD3D12OffscreenRenderer::device() const
+{
+    Q_D(const QD3D12OffscreenRenderer);
+    return d->device.Get();
+}
+
+ID3D12CommandQueue *QD3D12OffscreenRenderer::commandQueue() const
+{
+    Q_D(const QD3D12OffscreenRenderer);
+    return d->commandQueue.Get();
+}
+
+ID3D12CommandAllocator *QD3D12OffscreenRenderer::commandAllocator() const
+{
+    Q_D(const QD3D12OffscreenRenderer);
+    return d->commandAllocator.Get();
+}
+
+ID3D12CommandAllocator *QD3D12OffscreenRenderer::bundleAllocator() const
+{
+    Q_D(const QD3D12OffscreenRenderer);
+    return d->bundleAllocator.Get();
+}
+
+QD3D12GpuProfiler *QD3D12OffscreenRenderer::gpuProfiler() const
+{
+    Q_D(const QD3D12OffscreenRenderer);
+    return d->gpuProfiler;
+}
+
+QD3D12OffscreenRenderer::Fence *QD3D12OffscreenRenderer::createFence() const
+{
+    Q_D(const QD3D12OffscreenRenderer);
+    return QD3D12Util::createFence(d->device.Get());
+}
+
+void QD3D12OffscreenRenderer::waitForGPU(Fence *f) const
+{
+    Q_D(const QD3D12OffscreenRenderer);
+    QD3D12Util::waitForGPU(d->commandQueue.Get(), f);
+}
+
+void QD3D12OffscreenRenderer::transitionResource(ID3D12Resource *resource, ID3D12GraphicsCommandList *commandList,
+                                                 D3D12_RESOURCE_STATES before, D3D12_RESOURCE_STATES after) const
+{
+    QD3D12Util::transitionResource(resource, commandList, before, after);
+}
+
+void QD3D12OffscreenRenderer::uavBarrier(ID3D12Resource *resource, ID3D12GraphicsCommandList *commandList) const
+{
+    QD3D12Util::uavBarrier(resource, commandList);
+}
+
+ID3D12Resource *QD3D12OffscreenRenderer::backBufferRenderTarget() const
+{
+    Q_D(const QD3D12OffscreenRenderer);
+    return d->renderTarget.Get();
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE QD3D12OffscreenRenderer::backBufferRenderTargetCPUHandle() const
+{
+    Q_D(const QD3D12OffscreenRenderer);
+    return d->rtvHeap->GetCPUDescriptorHandleForHeapStart();
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE QD3D12OffscreenRenderer::depthStencilCPUHandle() const
+{
+    Q_D(const QD3D12OffscreenRenderer);
+    return d->dsvHeap->GetCPUDescriptorHandleForHeapStart();
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE QD3D12OffscreenRenderer::extraRenderTargetCPUHandle(int idx) const
+{
+    Q_D(const QD3D12OffscreenRenderer);
+    Q_ASSERT(idx >= 0 && idx < d->extraRenderTargetCount);
+    D3D12_CPU_DESCRIPTOR_HANDLE rtvHandle(d->rtvHeap->GetCPUDescriptorHandleForHeapStart());
+    rtvHandle.ptr += (1 + idx) * d->rtvStride;
+    return rtvHandle;
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE QD3D12OffscreenRenderer::extraDepthStencilCPUHandle(int idx) const
+{
+    Q_D(const QD3D12OffscreenRenderer);
+    Q_ASSERT(idx >= 0 && idx < d->extraRenderTargetCount);
+    D3D12_CPU_DESCRIPTOR_HANDLE dsvHandle(d->dsvHeap->GetCPUDescriptorHandleForHeapStart());
+    dsvHandle.ptr += (1 + idx) * d->dsvStride;
+    return dsvHandle;
+}
+
+ID3D12Resource *QD3D12OffscreenRenderer::createExtraRenderTargetAndView(D3D12_CPU_DESCRIPTOR_HANDLE viewHandle,
+                                                                        const QSize &size,
+                                                                        const float *clearColor,
+                                                                        int samples)
+{
+    Q_D(QD3D12OffscreenRenderer);
+    return QD3D12Util::createRenderTarget(d->device.Get(), viewHandle, size, clearColor, samples);
+}
+
+ID3D12Resource *QD3D12OffscreenRenderer::createExtraDepthStencilAndView(D3D12_CPU_DESCRIPTOR_HANDLE viewHandle,
+                                                                        const QSize &size,
+                                                                        int samples)
+{
+    Q_D(QD3D12OffscreenRenderer);
+    return QD3D12Util::createDepthStencil(d->device.Get(), viewHandle, size, samples);
+}
+
+quint32 QD3D12OffscreenRenderer::alignedCBSize(quint32 size) const
+{
+    return QD3D12Util::alignedCBSize(size);
+}
+
+quint32 QD3D12OffscreenRenderer::alignedTexturePitch(quint32 rowPitch) const
+{
+    return QD3D12Util::alignedTexturePitch(rowPitch);
+}
+
+quint32 QD3D12OffscreenRenderer::alignedTextureOffset(quint32 offset) const
+{
+    return QD3D12Util::alignedTextureOffset(offset);
+}
+
+QImage QD3D12OffscreenRenderer::readbackRGBA8888(ID3D12Resource *rt, D3D12_RESOURCE_STATES rtState,
+                                                 ID3D12GraphicsCommandList *commandList)
+{
+    Q_D(QD3D12OffscreenRenderer);
+    return QD3D12Util::readbackRGBA8888(d->device.Get(), d->commandQueue.Get(), rt, rtState, commandList);
+}
+
+void QD3D12OffscreenRenderer::initializeD3D()
+{
+}
+
+void QD3D12OffscreenRenderer::releaseD3D()
+{
+}
+
+void QD3D12OffscreenRenderer::resizeD3D(const QSize &)
+{
+}
+
+void QD3D12OffscreenRenderer::paintD3D()
+{
+}
+
+void QD3D12OffscreenRenderer::afterPresent()
+{
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,1299 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtD3D12Window module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qd3d12paintengine_p.h"
+#include "qd3d12paintengine_vs.h"
+#include "qd3d12paintengine_ps.h"
+#include "qd3d12util_p.h"
+#include <QtCore/qmath.h>
+#include <QtGui/QFontInfo>
+#include <QtGui/QPainter>
+#include <QtGui/QPainterPathStroker>
+#include <QtGui/private/qtriangulator_p.h>
+#include <algorithm>
+
+QT_BEGIN_NAMESPACE
+
+extern Q_GUI_EXPORT int qt_defaultDpiX();
+extern Q_GUI_EXPORT int qt_defaultDpiY();
+
+Q_STATIC_ASSERT(sizeof(QD3D12PaintVertex) == 20);
+
+static const int RAMP_WIDTH = 256;
+// Larger text looks better, and packs better, as outlines.
+static const int MAX_ATLAS_PIXEL_SIZE = 96;
+static const quint32 UPLOAD_BUFFER_SIZE = 1024 * 1024;
+
+static inline quint32 packColor(QRgb premultiplied)
+{
+    return qRed(premultiplied) | (qGreen(premultiplied) << 8) | (qBlue(premultiplied) << 16)
+            | (quint32(qAlpha(premultiplied)) << 24);
+}
+
+static uint pathHash(const QPainterPath &path)
+{
+    uint h = uint(path.fillRule());
+    for (int i = 0; i < path.elementCount(); ++i) {
+        const QPainterPath::Element &e(path.elementAt(i));
+        h = 31 * h + uint(e.type);
+        h = 31 * h + qHash(e.x);
+        h = 31 * h + qHash(e.y);
+    }
+    return h;
+}
+
+static uint strokeHash(const QPen &pen)
+{
+    uint h = qHash(pen.widthF()) ^ (uint(pen.style()) << 4) ^ (uint(pen.capStyle()) << 8)
+            ^ (uint(pen.joinStyle()) << 12) ^ qHash(pen.miterLimit());
+    if (pen.style() != Qt::SolidLine) {
+        foreach (qreal dash, pen.dashPattern())
+            h = 31 * h + qHash(dash);
+        h = 31 * h + qHash(pen.dashOffset());
+    }
+    return h;
+}
+
+// Only what affects the geometry of the stroke.
+static bool sameStroke(const QPen &a, const QPen &b)
+{
+    return a.widthF() == b.widthF() && a.style() == b.style() && a.capStyle() == b.capStyle()
+            && a.joinStyle() == b.joinStyle() && a.miterLimit() == b.miterLimit()
+            && (a.style() == Qt::SolidLine
+                || (a.dashPattern() == b.dashPattern() && a.dashOffset() == b.dashOffset()));
+}
+
+// Curves are flattened for the scale they are drawn at, rounded up to a
+// power of two so that animated scales do not triangulate every frame.
+static int levelOfDetail(const QTransform &m)
+{
+    const qreal scale = qMax(qSqrt(m.m11() * m.m11() + m.m12() * m.m12()),
+                             qSqrt(m.m21() * m.m21() + m.m22() * m.m22()));
+    int lod = 1;
+    while (lod < scale && lod < 64)
+        lod *= 2;
+    return lod;
+}
+
+QD3D12PaintEnginePrivate::~QD3D12PaintEnginePrivate()
+{
+    if (fenceEvent)
+        CloseHandle(fenceEvent);
+}
+
+void QD3D12PaintEnginePrivate::beginFrame()
+{
+    if (!fence)
+        return;
+
+    nextFrame();
+    frameActive = true;
+}
+
+void QD3D12PaintEnginePrivate::endFrame()
+{
+    if (!fence || !frameActive)
+        return;
+
+    signalFrame();
+    frameActive = false;
+}
+
+void QD3D12PaintEnginePrivate::releaseResources()
+{
+    Q_Q(QD3D12PaintEngine);
+    q->destroy();
+}
+
+void QD3D12PaintEnginePrivate::setTarget(ID3D12Resource *resource, D3D12_CPU_DESCRIPTOR_HANDLE rtv,
+                                         D3D12_RESOURCE_STATES state, QD3D12Window *window)
+{
+    target = resource;
+    targetRtv = rtv;
+    targetState = state;
+    targetWindow = window;
+}
+
+// Waits until the GPU is done with the frame slot that is about to be
+// reused. Textures not used since the frame before it are idle as well.
+void QD3D12PaintEnginePrivate::nextFrame()
+{
+    frame = (frame + 1) % FrameCount;
+    QD3D12PaintFrame &f(frames[frame]);
+    if (fence->GetCompletedValue() < f.fenceValue) {
+        if (SUCCEEDED(fence->SetEventOnCompletion(f.fenceValue, fenceEvent)))
+            WaitForSingleObject(fenceEvent, INFINITE);
+    }
+    f.allocator->Reset();
+    f.usedLists = 0;
+    f.uploadUsed = 0;
+    f.retired.clear();
+
+    ++frameNumber;
+    evictTextures(false);
+}
+
+void QD3D12PaintEnginePrivate::signalFrame()
+{
+    commandQueue->Signal(fence.Get(), ++fenceValue);
+    frames[frame].fenceValue = fenceValue;
+}
+
+// Sub-allocates from the frame's upload buffer. A buffer that is too small
+// is replaced by one twice the size, the old one is kept alive until the
+// frame slot comes around again since recorded copies may refer to it.
+bool QD3D12PaintEnginePrivate::allocateUpload(quint32 size, quint32 alignment, ID3D12Resource **buffer,
+                                              quint32 *offset, quint8 **data)
+{
+    QD3D12PaintFrame &f(frames[frame]);
+    quint32 alignedOffset = (f.uploadUsed + alignment - 1) & ~(alignment - 1);
+    if (!f.upload || alignedOffset + quint64(size) > f.uploadSize) {
+        quint32 newSize = qMax(f.uploadSize * 2, UPLOAD_BUFFER_SIZE);
+        while (newSize < size)
+            newSize *= 2;
+
+        D3D12_HEAP_PROPERTIES heapProp = {};
+        heapProp.Type = D3D12_HEAP_TYPE_UPLOAD;
+        D3D12_RESOURCE_DESC bufDesc = {};
+        bufDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+        bufDesc.Width = newSize;
+        bufDesc.Height = 1;
+        bufDesc.DepthOrArraySize = 1;
+        bufDesc.MipLevels = 1;
+        bufDesc.Format = DXGI_FORMAT_UNKNOWN;
+        bufDesc.SampleDesc.Count = 1;
+        bufDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+        ComPtr<ID3D12Resource> upload;
+        if (FAILED(device->CreateCommittedResource(&heapProp, D3D12_HEAP_FLAG_NONE, &bufDesc,
+                                                   D3D12_RESOURCE_STATE_GENERIC_READ, Q_NULLPTR, IID_PPV_ARGS(&upload)))) {
+            qWarning("QD3D12PaintEngine: Failed to create upload buffer of %u bytes", newSize);
+            return false;
+        }
+        quint8 *p = Q_NULLPTR;
+        D3D12_RANGE readRange = { 0, 0 };
+        if (FAILED(upload->Map(0, &readRange, reinterpret_cast<void **>(&p)))) {
+            qWarning("QD3D12PaintEngine: Map failed (upload buffer)");
+            return false;
+        }
+
+        if (f.upload)
+            f.retired.append(f.upload);
+        f.upload = upload;
+        f.uploadData = p;
+        f.uploadSize = newSize;
+        alignedOffset = 0;
+    }
+
+    f.uploadUsed = alignedOffset + size;
+    *buffer = f.upload.Get();
+    *offset = alignedOffset;
+    *data = f.uploadData + alignedOffset;
+    return true;
+}
+
+int QD3D12PaintEnginePrivate::cachedTexture(qint64 key)
+{
+    QHash<qint64, QD3D12PaintTexture>::iterator it = textures.find(key);
+    if (it == textures.end())
+        return -1;
+    it->lastUsed = frameNumber;
+    return it->slot;
+}
+
+// Returns the descriptor slot of the texture for key, creating it from
+// image when it is not cached yet. The contents are uploaded in flush().
+int QD3D12PaintEnginePrivate::textureForImage(const QImage &image, qint64 key)
+{
+    const int slot = cachedTexture(key);
+    if (slot >= 0)
+        return slot;
+
+    if (image.isNull())
+        return WhiteTexture;
+    if (image.width() > D3D12_REQ_TEXTURE2D_U_OR_V_DIMENSION || image.height() > D3D12_REQ_TEXTURE2D_U_OR_V_DIMENSION) {
+        qWarning("QD3D12PaintEngine: %dx%d image is too large", image.width(), image.height());
+        return WhiteTexture;
+    }
+    if (freeSlots.isEmpty())
+        evictTextures(true);
+    if (freeSlots.isEmpty()) {
+        qWarning("QD3D12PaintEngine: Out of texture slots (%d textures in use)", int(MaxTextures));
+        return WhiteTexture;
+    }
+
+    D3D12_RESOURCE_DESC desc = {};
+    desc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+    desc.Width = image.width();
+    desc.Height = image.height();
+    desc.DepthOrArraySize = 1;
+    desc.MipLevels = 1;
+    desc.Format = DXGI_FORMAT_B8G8R8A8_UNORM;
+    desc.SampleDesc.Count = 1;
+    desc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
+    D3D12_HEAP_PROPERTIES heapProp = {};
+    heapProp.Type = D3D12_HEAP_TYPE_DEFAULT;
+
+    QD3D12PaintTexture t;
+    if (FAILED(device->CreateCommittedResource(&heapProp, D3D12_HEAP_FLAG_NONE, &desc, D3D12_RESOURCE_STATE_COPY_DEST,
+                                               Q_NULLPTR, IID_PPV_ARGS(&t.resource)))) {
+        qWarning("QD3D12PaintEngine: Failed to create texture for %dx%d image", image.width(), image.height());
+        return WhiteTexture;
+    }
+
+    // ARGB32 is BGRA in memory.
+    t.pending = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    t.slot = freeSlots.takeLast();
+    t.bytes = quint32(image.width()) * image.height() * 4;
+    t.lastUsed = frameNumber;
+
+    D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+    srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+    srvDesc.Format = desc.Format;
+    srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+    srvDesc.Texture2D.MipLevels = 1;
+    D3D12_CPU_DESCRIPTOR_HANDLE h = heap->GetCPUDescriptorHandleForHeapStart();
+    h.ptr += t.slot * descriptorSize;
+    device->CreateShaderResourceView(t.resource.Get(), &srvDesc, h);
+
+    textures.insert(key, t);
+    pendingUploads.append(key);
+    textureBytes += t.bytes;
+    return t.slot;
+}
+
+// Gradients become a 1 pixel high color ramp, rendered with the raster
+// engine once per set of stops. Reflection is baked into a ramp of twice
+// the width, which is then repeated.
+int QD3D12PaintEnginePrivate::textureForGradient(const QGradient *gradient)
+{
+    uint key = uint(gradient->spread()) ^ (uint(gradient->interpolationMode()) << 4);
+    foreach (const QGradientStop &stop, gradient->stops())
+        key = 31 * (31 * key + qHash(stop.first)) + stop.second.rgba();
+
+    QImage ramp = gradientRamps.value(key);
+    if (ramp.isNull()) {
+        const bool reflect = gradient->spread() == QGradient::ReflectSpread;
+        ramp = QImage(reflect ? 2 * RAMP_WIDTH : RAMP_WIDTH, 1, QImage::Format_ARGB32_Premultiplied);
+        ramp.fill(Qt::transparent);
+        QLinearGradient g(0, 0, RAMP_WIDTH, 0);
+        g.setStops(gradient->stops());
+        g.setSpread(reflect ? QGradient::ReflectSpread : QGradient::PadSpread);
+        g.setInterpolationMode(gradient->interpolationMode());
+        QPainter p(&ramp);
+        p.setCompositionMode(QPainter::CompositionMode_Source);
+        p.fillRect(ramp.rect(), g);
+        p.end();
+        if (gradientRamps.count() >= 256)
+            gradientRamps.clear();
+        gradientRamps.insert(key, ramp);
+    }
+    return textureForImage(ramp, ramp.cacheKey());
+}
+
+// Releases the least recently used textures until the total is within the
+// budget, or, with force, until a slot is free. Only textures the GPU is
+// done with qualify.
+void QD3D12PaintEnginePrivate::evictTextures(bool force)
+{
+    if (!force && textureBytes <= textureBudget)
+        return;
+
+    QVector<QPair<quint64, qint64> > candidates;
+    for (QHash<qint64, QD3D12PaintTexture>::const_iterator it = textures.cbegin(); it != textures.cend(); ++it) {
+        if (it->slot != WhiteTexture && it->lastUsed + FrameCount <= frameNumber)
+            candidates.append(qMakePair(it->lastUsed, it.key()));
+    }
+    std::sort(candidates.begin(), candidates.end());
+
+    for (int i = 0; i < candidates.count(); ++i) {
+        if (force ? !freeSlots.isEmpty() : textureBytes <= textureBudget)
+            break;
+        QHash<qint64, QD3D12PaintTexture>::iterator it = textures.find(candidates[i].second);
+        freeSlots.append(it->slot);
+        textureBytes -= it->bytes;
+        textures.erase(it);
+    }
+}
+
+void QD3D12PaintEnginePrivate::uploadTexture(QD3D12PaintTexture *texture, ID3D12GraphicsCommandList *commandList)
+{
+    const D3D12_RESOURCE_DESC desc = texture->resource->GetDesc();
+    D3D12_PLACED_SUBRESOURCE_FOOTPRINT layout;
+    UINT64 totalBytes = 0;
+    device->GetCopyableFootprints(&desc, 0, 1, 0, &layout, Q_NULLPTR, Q_NULLPTR, &totalBytes);
+
+    ID3D12Resource *buffer;
+    quint32 offset;
+    quint8 *data;
+    if (!allocateUpload(quint32(totalBytes), D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT, &buffer, &offset, &data))
+        return;
+
+    const QImage &image(texture->pending);
+    const int rowSize = image.width() * 4;
+    for (int y = 0; y < image.height(); ++y)
+        memcpy(data + y * layout.Footprint.RowPitch, image.constScanLine(y), rowSize);
+    layout.Offset = offset;
+
+    D3D12_TEXTURE_COPY_LOCATION dst;
+    dst.pResource = texture->resource.Get();
+    dst.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+    dst.SubresourceIndex = 0;
+    D3D12_TEXTURE_COPY_LOCATION src;
+    src.pResource = buffer;
+    src.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
+    src.PlacedFootprint = layout;
+    commandList->CopyTextureRegion(&dst, 0, 0, 0, &src, Q_NULLPTR);
+    QD3D12Util::transitionResource(texture->resource.Get(), commandList,
+                                   D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+    texture->pending = QImage();
+}
+
+const QD3D12PaintTriangles *QD3D12PaintEnginePrivate::triangulate(const QPainterPath &path, const QPen *pen, int lod)
+{
+    QD3D12PaintTrianglesKey key;
+    key.hash = pathHash(path);
+    if (pen)
+        key.hash = ~(key.hash ^ strokeHash(*pen));
+    key.lod = lod;
+
+    QD3D12PaintTriangles *t = triangles.object(key);
+    if (t && t->stroke == (pen != Q_NULLPTR) && t->path == path && (!pen || sameStroke(t->pen, *pen)))
+        return t;
+
+    QPainterPath fillable = path;
+    if (pen) {
+        QPainterPathStroker stroker;
+        stroker.setWidth(pen->widthF() > 0 ? pen->widthF() : 1);
+        stroker.setCapStyle(pen->capStyle());
+        stroker.setJoinStyle(pen->joinStyle());
+        stroker.setMiterLimit(pen->miterLimit());
+        if (pen->style() != Qt::SolidLine) {
+            stroker.setDashPattern(pen->dashPattern());
+            stroker.setDashOffset(pen->dashOffset());
+        }
+        fillable = stroker.createStroke(path);
+    }
+
+    // Triangulated at the target scale and scaled back, like the OpenGL
+    // paint engine does.
+    const QTriangleSet set = qTriangulate(fillable, QTransform::fromScale(lod, lod));
+
+    t = new QD3D12PaintTriangles;
+    t->path = path;
+    t->stroke = pen != Q_NULLPTR;
+    if (pen)
+        t->pen = *pen;
+    const float invLod = 1.0f / lod;
+    t->vertices.resize(set.vertices.count());
+    for (int i = 0; i < set.vertices.count(); ++i)
+        t->vertices[i] = float(set.vertices.at(i)) * invLod;
+    t->indices.resize(set.indices.size());
+    if (set.indices.type() == QVertexIndexVector::UnsignedInt) {
+        const quint32 *src = static_cast<const quint32 *>(set.indices.data());
+        std::copy(src, src + set.indices.size(), t->indices.begin());
+    } else {
+        const quint16 *src = static_cast<const quint16 *>(set.indices.data());
+        std::copy(src, src + set.indices.size(), t->indices.begin());
+    }
+
+    const int cost = (t->vertices.count() + t->indices.count()) * 4 / 1024 + 1;
+    if (cost > triangles.maxCost()) {
+        uncachedTriangles.reset(t);
+        return t;
+    }
+    triangles.insert(key, t, cost);
+    return t;
+}
+
+// Clipping is done with the scissor rectangle, non-rectangular clips are
+// reduced to their bounding rectangle.
+void QD3D12PaintEnginePrivate::updateClip()
+{
+    Q_Q(QD3D12PaintEngine);
+    QPainter *p = q->painter();
+    hasClip = p && p->hasClipping();
+    if (hasClip)
+        clipRect = transform.mapRect(p->clipBoundingRect()).toAlignedRect();
+}
+
+bool QD3D12PaintEnginePrivate::prepareFill(const QBrush &brush, QD3D12PaintFill *fill)
+{
+    fill->mode = QD3D12PaintFill::Solid;
+    fill->texture = WhiteTexture;
+    fill->wrap = false;
+    fill->color = packColor(qPremultiply(qRgba(255, 255, 255, qRound(opacity * 255))));
+
+    switch (brush.style()) {
+    case Qt::NoBrush:
+        return false;
+    case Qt::LinearGradientPattern:
+    {
+        const QLinearGradient *g = static_cast<const QLinearGradient *>(brush.gradient());
+        const QPointF d = g->finalStop() - g->start();
+        const qreal length2 = d.x() * d.x() + d.y() * d.y();
+        fill->mode = QD3D12PaintFill::Gradient;
+        fill->texture = textureForGradient(g);
+        fill->logicalToBrush = (brush.transform() * QTransform::fromTranslate(brushOrigin.x(), brushOrigin.y())).inverted();
+        fill->start = g->start();
+        fill->delta = length2 > 0 ? d / length2 : QPointF();
+        switch (g->spread()) {
+        case QGradient::RepeatSpread:
+            fill->wrap = true;
+            fill->rampScale = 1;
+            fill->rampBias = 0;
+            break;
+        case QGradient::ReflectSpread:
+            fill->wrap = true;
+            fill->rampScale = 0.5f;
+            fill->rampBias = 0;
+            break;
+        default:
+            // Maps 0 and 1 to the centers of the first and last texel.
+            fill->rampScale = float(RAMP_WIDTH - 1) / RAMP_WIDTH;
+            fill->rampBias = 0.5f / RAMP_WIDTH;
+            break;
+        }
+        return true;
+    }
+    case Qt::TexturePattern:
+    {
+        const QImage image = brush.textureImage();
+        if (image.isNull())
+            return false;
+        fill->mode = QD3D12PaintFill::Texture;
+        fill->texture = textureForImage(image, image.cacheKey());
+        fill->wrap = true;
+        fill->logicalToBrush = (brush.transform() * QTransform::fromTranslate(brushOrigin.x(), brushOrigin.y())).inverted();
+        fill->textureSize = image.size();
+        return true;
+    }
+    default:
+    {
+        // Solid colors. Patterns and the other gradients are emulated by
+        // QPainter, whatever still ends up here is drawn in the brush color.
+        const QRgb c = brush.color().rgba();
+        const int alpha = qRound(qAlpha(c) * opacity);
+        if (!alpha)
+            return false;
+        fill->color = packColor(qPremultiply(qRgba(qRed(c), qGreen(c), qBlue(c), alpha)));
+        return true;
+    }
+    }
+}
+
+void QD3D12PaintEnginePrivate::addVertex(const QD3D12PaintFill &fill, const QPointF &logical, const QPointF &device)
+{
+    QD3D12PaintVertex v;
+    v.x = float(device.x());
+    v.y = float(device.y());
+    switch (fill.mode) {
+    case QD3D12PaintFill::Gradient:
+    {
+        const QPointF p = fill.logicalToBrush.map(logical) - fill.start;
+        const float t = float(p.x() * fill.delta.x() + p.y() * fill.delta.y());
+        v.u = t * fill.rampScale + fill.rampBias;
+        v.v = 0.5f;
+        break;
+    }
+    case QD3D12PaintFill::Texture:
+    {
+        const QPointF p = fill.logicalToBrush.map(logical);
+        v.u = float(p.x() / fill.textureSize.width());
+        v.v = float(p.y() / fill.textureSize.height());
+        break;
+    }
+    default:
+        v.u = v.v = 0.5f;
+        break;
+    }
+    v.color = fill.color;
+    vertices.append(v);
+}
+
+// Extends the last draw when the texture and the scissor are the same,
+// must be called before the indices are added.
+void QD3D12PaintEnginePrivate::beginDraw(int texture, bool wrap, int indexCount)
+{
+    const QRect bounds(QPoint(0, 0), targetSize);
+    const QRect scissor = hasClip ? clipRect & bounds : bounds;
+    if (!draws.isEmpty()) {
+        QD3D12PaintDraw &last(draws.last());
+        if (last.texture == texture && last.wrap == wrap && last.scissor == scissor) {
+            last.indexCount += indexCount;
+            return;
+        }
+    }
+    QD3D12PaintDraw draw;
+    draw.texture = texture;
+    draw.wrap = wrap;
+    draw.scissor = scissor;
+    draw.firstIndex = indices.count();
+    draw.indexCount = indexCount;
+    draws.append(draw);
+}
+
+void QD3D12PaintEnginePrivate::addTriangles(const QD3D12PaintTriangles *t, const QTransform &toLogical,
+                                            const QTransform &toDevice, const QD3D12PaintFill &fill)
+{
+    if (t->indices.isEmpty())
+        return;
+
+    beginDraw(fill.texture, fill.wrap, t->indices.count());
+    const quint32 base = vertices.count();
+    const float *v = t->vertices.constData();
+    for (int i = 0; i < t->vertices.count(); i += 2) {
+        const QPointF p(v[i], v[i + 1]);
+        addVertex(fill, toLogical.map(p), toDevice.map(p));
+    }
+    foreach (quint32 index, t->indices)
+        indices.append(base + index);
+}
+
+// pathTransform maps path to logical coordinates.
+void QD3D12PaintEnginePrivate::fillPath(const QPainterPath &path, const QBrush &brush, const QTransform &pathTransform)
+{
+    QD3D12PaintFill fill;
+    if (path.isEmpty() || !prepareFill(brush, &fill))
+        return;
+
+    const QTransform toDevice = pathTransform * transform;
+    const QD3D12PaintTriangles *t = triangulate(path, Q_NULLPTR, levelOfDetail(toDevice));
+    addTriangles(t, pathTransform, toDevice, fill);
+}
+
+void QD3D12PaintEnginePrivate::strokePath(const QPainterPath &path, const QPen &pen)
+{
+    QD3D12PaintFill fill;
+    if (pen.style() == Qt::NoPen || path.isEmpty() || !prepareFill(pen.brush(), &fill))
+        return;
+
+    if (pen.isCosmetic()) {
+        // Stroked in device space so that the width stays in pixels.
+        const QD3D12PaintTriangles *t = triangulate(transform.map(path), &pen, 1);
+        addTriangles(t, transform.inverted(), QTransform(), fill);
+    } else {
+        const QD3D12PaintTriangles *t = triangulate(path, &pen, levelOfDetail(transform));
+        addTriangles(t, QTransform(), transform, fill);
+    }
+}
+
+void QD3D12PaintEnginePrivate::fillConvex(const QPointF *points, int pointCount, const QBrush &brush)
+{
+    QD3D12PaintFill fill;
+    if (pointCount < 3 || !prepareFill(brush, &fill))
+        return;
+
+    beginDraw(fill.texture, fill.wrap, (pointCount - 2) * 3);
+    const quint32 base = vertices.count();
+    for (int i = 0; i < pointCount; ++i)
+        addVertex(fill, points[i], transform.map(points[i]));
+    for (int i = 1; i < pointCount - 1; ++i)
+        indices << base << base + i << base + i + 1;
+}
+
+// uv is in normalized texture coordinates.
+void QD3D12PaintEnginePrivate::drawTexture(const QRectF &r, int texture, const QRectF &uv)
+{
+    const quint32 color = packColor(qPremultiply(qRgba(255, 255, 255, qRound(opacity * 255))));
+    const QPointF corners[] = { r.topLeft(), r.topRight(), r.bottomRight(), r.bottomLeft() };
+    const QPointF uvs[] = { uv.topLeft(), uv.topRight(), uv.bottomRight(), uv.bottomLeft() };
+
+    beginDraw(texture, false, 6);
+    const quint32 base = vertices.count();
+    for (int i = 0; i < 4; ++i) {
+        const QPointF p = transform.map(corners[i]);
+        QD3D12PaintVertex v;
+        v.x = float(p.x());
+        v.y = float(p.y());
+        v.u = float(uvs[i].x());
+        v.v = float(uvs[i].y());
+        v.color = color;
+        vertices.append(v);
+    }
+    indices << base << base + 1 << base + 2 << base << base + 2 << base + 3;
+}
+
+// origin is the start of the baseline in pixels.
+void QD3D12PaintEnginePrivate::drawGlyphRun(const QVector<QD3D12GlyphAtlas::Glyph> &run, const QPoint &origin,
+                                            quint32 color)
+{
+    if (run.isEmpty())
+        return;
+
+    beginDraw(glyphAtlasTexture, false, run.count() * 6);
+    foreach (const QD3D12GlyphAtlas::Glyph &g, run) {
+        const QRect r = g.rect.translated(origin);
+        const QRectF &uv(g.textureRect);
+        const quint32 base = vertices.count();
+        const QD3D12PaintVertex quad[] = {
+            { float(r.left()), float(r.top()), float(uv.left()), float(uv.top()), color },
+            { float(r.left() + r.width()), float(r.top()), float(uv.right()), float(uv.top()), color },
+            { float(r.left() + r.width()), float(r.top() + r.height()), float(uv.right()), float(uv.bottom()), color },
+            { float(r.left()), float(r.top() + r.height()), float(uv.left()), float(uv.bottom()), color }
+        };
+        vertices.append(quad[0]);
+        vertices.append(quad[1]);
+        vertices.append(quad[2]);
+        vertices.append(quad[3]);
+        indices << base << base + 1 << base + 2 << base << base + 2 << base + 3;
+    }
+}
+
+// Records the pending texture uploads and all batched geometry into one
+// command list. For a window target the list goes through
+// QD3D12Window::executeCommandLists(), so it is ordered with the rest of the
+// window's frame.
+void QD3D12PaintEnginePrivate::flush()
+{
+    if (indices.isEmpty() && pendingUploads.isEmpty() && !glyphAtlas.pendingUploadSize())
+        return;
+
+    QD3D12PaintFrame &f(frames[frame]);
+    ComPtr<ID3D12GraphicsCommandList> commandList;
+    if (f.usedLists < f.commandLists.count()) {
+        commandList = f.commandLists[f.usedLists];
+        if (FAILED(commandList->Reset(f.allocator.Get(), Q_NULLPTR))) {
+            qWarning("QD3D12PaintEngine: Failed to reset command list");
+            return;
+        }
+    } else {
+        if (FAILED(device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, f.allocator.Get(), Q_NULLPTR,
+                                             IID_PPV_ARGS(&commandList)))) {
+            qWarning("QD3D12PaintEngine: Failed to create command list");
+            return;
+        }
+        f.commandLists.append(commandList);
+    }
+    ++f.usedLists;
+
+    foreach (qint64 key, pendingUploads) {
+        QHash<qint64, QD3D12PaintTexture>::iterator it = textures.find(key);
+        if (it != textures.end() && !it->pending.isNull())
+            uploadTexture(&*it, commandList.Get());
+    }
+    pendingUploads.clear();
+
+    if (const quint32 glyphUploadSize = glyphAtlas.pendingUploadSize()) {
+        ID3D12Resource *buffer;
+        quint32 offset;
+        quint8 *data;
+        if (allocateUpload(glyphUploadSize, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT, &buffer, &offset, &data))
+            glyphAtlas.upload(commandList.Get(), buffer, offset, data);
+    }
+
+    ID3D12PipelineState *pso = Q_NULLPTR;
+    D3D12_VERTEX_BUFFER_VIEW vbView = {};
+    D3D12_INDEX_BUFFER_VIEW ibView = {};
+    if (!indices.isEmpty() && target) {
+        const D3D12_RESOURCE_DESC desc = target->GetDesc();
+        pso = pipelineState(desc.Format, desc.SampleDesc);
+
+        ID3D12Resource *buffer;
+        quint32 offset;
+        quint8 *data;
+        const quint32 vbSize = vertices.count() * sizeof(QD3D12PaintVertex);
+        if (pso && allocateUpload(vbSize, 16, &buffer, &offset, &data)) {
+            memcpy(data, vertices.constData(), vbSize);
+            vbView.BufferLocation = buffer->GetGPUVirtualAddress() + offset;
+            vbView.SizeInBytes = vbSize;
+            vbView.StrideInBytes = sizeof(QD3D12PaintVertex);
+        } else {
+            pso = Q_NULLPTR;
+        }
+        const quint32 ibSize = indices.count() * sizeof(quint32);
+        if (pso && allocateUpload(ibSize, 16, &buffer, &offset, &data)) {
+            memcpy(data, indices.constData(), ibSize);
+            ibView.BufferLocation = buffer->GetGPUVirtualAddress() + offset;
+            ibView.SizeInBytes = ibSize;
+            ibView.Format = DXGI_FORMAT_R32_UINT;
+        } else {
+            pso = Q_NULLPTR;
+        }
+    }
+
+    if (pso) {
+        if (targetState != D3D12_RESOURCE_STATE_RENDER_TARGET)
+            QD3D12Util::transitionResource(target.Get(), commandList.Get(), targetState, D3D12_RESOURCE_STATE_RENDER_TARGET);
+
+        commandList->OMSetRenderTargets(1, &targetRtv, FALSE, Q_NULLPTR);
+        const D3D12_VIEWPORT viewport = { 0, 0, float(targetSize.width()), float(targetSize.height()), 0, 1 };
+        commandList->RSSetViewports(1, &viewport);
+        commandList->SetPipelineState(pso);
+        commandList->SetGraphicsRootSignature(rootSignature.Get());
+        ID3D12DescriptorHeap *heaps[] = { heap.Get() };
+        commandList->SetDescriptorHeaps(_countof(heaps), heaps);
+        const float pixelToClip[] = { 2.0f / qMax(1, targetSize.width()), 2.0f / qMax(1, targetSize.height()) };
+        commandList->SetGraphicsRoot32BitConstants(1, 2, pixelToClip, 0);
+        commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+        commandList->IASetVertexBuffers(0, 1, &vbView);
+        commandList->IASetIndexBuffer(&ibView);
+
+        const D3D12_GPU_DESCRIPTOR_HANDLE heapStart = heap->GetGPUDescriptorHandleForHeapStart();
+        int boundTexture = -1;
+        int boundWrap = -1;
+        QRect boundScissor;
+        foreach (const QD3D12PaintDraw &draw, draws) {
+            if (draw.scissor.isEmpty())
+                continue;
+            if (draw.texture != boundTexture) {
+                D3D12_GPU_DESCRIPTOR_HANDLE h = heapStart;
+                h.ptr += draw.texture * descriptorSize;
+                commandList->SetGraphicsRootDescriptorTable(0, h);
+                boundTexture = draw.texture;
+            }
+            if (int(draw.wrap) != boundWrap) {
+                commandList->SetGraphicsRoot32BitConstant(1, draw.wrap ? 1 : 0, 2);
+                boundWrap = draw.wrap;
+            }
+            if (draw.scissor != boundScissor) {
+                const D3D12_RECT r = { draw.scissor.left(), draw.scissor.top(),
+                                       draw.scissor.right() + 1, draw.scissor.bottom() + 1 };
+                commandList->RSSetScissorRects(1, &r);
+                boundScissor = draw.scissor;
+            }
+            commandList->DrawIndexedInstanced(draw.indexCount, 1, draw.firstIndex, 0, 0);
+            ++drawCallCount;
+        }
+
+        if (targetState != D3D12_RESOURCE_STATE_RENDER_TARGET)
+            QD3D12Util::transitionResource(target.Get(), commandList.Get(), D3D12_RESOURCE_STATE_RENDER_TARGET, targetState);
+    }
+
+    commandList->Close();
+    ID3D12CommandList *commandLists[] = { commandList.Get() };
+    if (targetWindow)
+        targetWindow->executeCommandLists(_countof(commandLists), commandLists);
+    else
+        commandQueue->ExecuteCommandLists(_countof(commandLists), commandLists);
+
+    vertices.resize(0);
+    indices.resize(0);
+    draws.resize(0);
+}
+
+// One pipeline per render target format and sample count.
+ID3D12PipelineState *QD3D12PaintEnginePrivate::pipelineState(DXGI_FORMAT format, const DXGI_SAMPLE_DESC &sampleDesc)
+{
+    const quint64 key = (quint64(format) << 32) | (quint64(sampleDesc.Count) << 16) | sampleDesc.Quality;
+    QHash<quint64, ComPtr<ID3D12PipelineState> >::const_iterator it = pipelineStates.constFind(key);
+    if (it != pipelineStates.cend())
+        return it->Get();
+
+    D3D12_INPUT_ELEMENT_DESC inputElementDescs[] = {
+        { "POSITION", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+        { "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 8, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+        { "COLOR", 0, DXGI_FORMAT_R8G8B8A8_UNORM, 0, 16, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 }
+    };
+
+    D3D12_RASTERIZER_DESC rastDesc = {};
+    rastDesc.FillMode = D3D12_FILL_MODE_SOLID;
+    rastDesc.CullMode = D3D12_CULL_MODE_NONE;
+    rastDesc.DepthClipEnable = TRUE;
+    rastDesc.MultisampleEnable = sampleDesc.Count > 1;
+
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC psoDesc = {};
+    psoDesc.InputLayout = { inputElementDescs, _countof(inputElementDescs) };
+    psoDesc.pRootSignature = rootSignature.Get();
+    psoDesc.VS.pShaderBytecode = g_VS_Paint;
+    psoDesc.VS.BytecodeLength = sizeof(g_VS_Paint);
+    psoDesc.PS.pShaderBytecode = g_PS_Paint;
+    psoDesc.PS.BytecodeLength = sizeof(g_PS_Paint);
+    psoDesc.RasterizerState = rastDesc;
+
+    // Source over with premultiplied colors.
+    D3D12_RENDER_TARGET_BLEND_DESC &blend(psoDesc.BlendState.RenderTarget[0]);
+    blend.BlendEnable = TRUE;
+    blend.SrcBlend = blend.SrcBlendAlpha = D3D12_BLEND_ONE;
+    blend.DestBlend = blend.DestBlendAlpha = D3D12_BLEND_INV_SRC_ALPHA;
+    blend.BlendOp = blend.BlendOpAlpha = D3D12_BLEND_OP_ADD;
+    blend.LogicOp = D3D12_LOGIC_OP_NOOP;
+    blend.RenderTargetWriteMask = D3D12_COLOR_WRITE_ENABLE_ALL;
+
+    psoDesc.DepthStencilState.DepthEnable = FALSE;
+    psoDesc.DepthStencilState.StencilEnable = FALSE;
+    psoDesc.SampleMask = UINT_MAX;
+    psoDesc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+    psoDesc.NumRenderTargets = 1;
+    psoDesc.RTVFormats[0] = format;
+    psoDesc.SampleDesc = sampleDesc;
+
+    ComPtr<ID3D12PipelineState> pso;
+    if (FAILED(device->CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(&pso)))) {
+        qWarning("QD3D12PaintEngine: Failed to create pipeline state for format %d", int(format));
+        return Q_NULLPTR;
+    }
+    pipelineStates.insert(key, pso);
+    return pso.Get();
+}
+
+// A QPaintEngine that turns QPainter calls into D3D12 draws. Fills and
+// strokes are triangulated on the CPU and cached per path, so static
+// content is triangulated once. Images, pixmaps and gradient ramps are
+// cached as textures by their cache key. All geometry of a begin()/end()
+// pair is batched into one vertex and index buffer and drawn with as few
+// draw calls as the textures and clip rectangles allow.
+//
+// Painting on a QD3D12Window uses an engine owned by the window and renders
+// to the current back buffer; submit the window's own command lists before
+// ending the painter to have the QPainter content on top. For other render
+// targets use a QD3D12PaintDevice.
+//
+// Clipping is done with the scissor, so clips are reduced to their bounding
+// rectangle. Radial and conical gradients, patterns and perspective
+// transforms are not supported in hardware and are emulated by QPainter.
+// Composition modes other than source over are not supported at all;
+// QPainter warns and ignores setCompositionMode(). Edges are antialiased
+// only when the target is multisampled.
+QD3D12PaintEngine::QD3D12PaintEngine()
+    : QPaintEngine(*(new QD3D12PaintEnginePrivate),
+                   PrimitiveTransform | PatternTransform | PixmapTransform | PainterPaths
+                   | AlphaBlend | LinearGradientFill | ConstantOpacity | BrushStroke)
+{
+}
+
+QD3D12PaintEngine::~QD3D12PaintEngine()
+{
+    destroy();
+}
+
+bool QD3D12PaintEngine::create(ID3D12Device *device, ID3D12CommandQueue *commandQueue)
+{
+    Q_D(QD3D12PaintEngine);
+    destroy();
+
+    D3D12_STATIC_SAMPLER_DESC samplers[2] = {};
+    for (int i = 0; i < 2; ++i) {
+        const D3D12_TEXTURE_ADDRESS_MODE mode = i ? D3D12_TEXTURE_ADDRESS_MODE_WRAP : D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
+        samplers[i].Filter = D3D12_FILTER_MIN_MAG_MIP_LINEAR;
+        samplers[i].AddressU = mode;
+        samplers[i].AddressV = mode;
+        samplers[i].AddressW = mode;
+        samplers[i].MaxLOD = D3D12_FLOAT32_MAX;
+        samplers[i].ShaderRegister = i; // s0, s1
+        samplers[i].ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL;
+    }
+
+    D3D12_DESCRIPTOR_RANGE descRange;
+    descRange.RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_SRV;
+    descRange.NumDescriptors = 1;
+    descRange.BaseShaderRegister = 0; // t0
+    descRange.RegisterSpace = 0;
+    descRange.OffsetInDescriptorsFromTableStart = 0;
+
+    D3D12_ROOT_PARAMETER rootParameters[2];
+    rootParameters[0].ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
+    rootParameters[0].ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL;
+    rootParameters[0].DescriptorTable.NumDescriptorRanges = 1;
+    rootParameters[0].DescriptorTable.pDescriptorRanges = &descRange;
+    rootParameters[1].ParameterType = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;
+    rootParameters[1].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+    rootParameters[1].Constants.Num32BitValues = 3;
+    rootParameters[1].Constants.ShaderRegister = 0; // b0
+    rootParameters[1].Constants.RegisterSpace = 0;
+
+    D3D12_ROOT_SIGNATURE_DESC desc = {};
+    desc.NumParameters = 2;
+    desc.pParameters = rootParameters;
+    desc.NumStaticSamplers = 2;
+    desc.pStaticSamplers = samplers;
+    desc.Flags = D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT;
+
+    ComPtr<ID3DBlob> signature;
+    ComPtr<ID3DBlob> error;
+    if (FAILED(D3D12SerializeRootSignature(&desc, D3D_ROOT_SIGNATURE_VERSION_1, &signature, &error))) {
+        QByteArray msg;
+        if (error)
+            msg = QByteArray(static_cast<const char *>(error->GetBufferPointer()), int(error->GetBufferSize()));
+        qWarning("QD3D12PaintEngine: Failed to serialize root signature: %s", msg.constData());
+        return false;
+    }
+    if (FAILED(device->CreateRootSignature(0, signature->GetBufferPointer(), signature->GetBufferSize(),
+                                           IID_PPV_ARGS(&d->rootSignature)))) {
+        qWarning("QD3D12PaintEngine: Failed to create root signature");
+        return false;
+    }
+
+    D3D12_DESCRIPTOR_HEAP_DESC heapDesc = {};
+    heapDesc.NumDescriptors = QD3D12PaintEnginePrivate::MaxTextures;
+    heapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+    heapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
+    if (FAILED(device->CreateDescriptorHeap(&heapDesc, IID_PPV_ARGS(&d->heap)))) {
+        qWarning("QD3D12PaintEngine: Failed to create descriptor heap");
+        destroy();
+        return false;
+    }
+
+    if (FAILED(device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&d->fence)))) {
+        qWarning("QD3D12PaintEngine: Failed to create fence");
+        destroy();
+        return false;
+    }
+    if (!d->fenceEvent)
+        d->fenceEvent = CreateEvent(Q_NULLPTR, FALSE, FALSE, Q_NULLPTR);
+
+    for (int i = 0; i < QD3D12PaintEnginePrivate::FrameCount; ++i) {
+        if (FAILED(device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT,
+                                                  IID_PPV_ARGS(&d->frames[i].allocator)))) {
+            qWarning("QD3D12PaintEngine: Failed to create command allocator");
+            destroy();
+            return false;
+        }
+    }
+
+    d->device = device;
+    d->commandQueue = commandQueue;
+    d->descriptorSize = device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+    for (int i = QD3D12PaintEnginePrivate::MaxTextures - 1; i >= 0; --i)
+        d->freeSlots.append(i);
+
+    // Slot 0, sampled by solid fills.
+    QImage white(1, 1, QImage::Format_ARGB32_Premultiplied);
+    white.fill(Qt::white);
+    d->textureForImage(white, white.cacheKey());
+
+    if (d->glyphAtlas.create(device)) {
+        d->glyphAtlasTexture = d->freeSlots.takeLast();
+        D3D12_CPU_DESCRIPTOR_HANDLE h = d->heap->GetCPUDescriptorHandleForHeapStart();
+        h.ptr += d->glyphAtlasTexture * d->descriptorSize;
+        d->glyphAtlas.createShaderResourceView(h);
+    }
+    return true;
+}
+
+void QD3D12PaintEngine::destroy()
+{
+    Q_D(QD3D12PaintEngine);
+    if (d->fence && d->commandQueue) {
+        // Textures and upload buffers may still be in use.
+        d->commandQueue->Signal(d->fence.Get(), ++d->fenceValue);
+        if (d->fence->GetCompletedValue() < d->fenceValue
+                && SUCCEEDED(d->fence->SetEventOnCompletion(d->fenceValue, d->fenceEvent)))
+            WaitForSingleObject(d->fenceEvent, INFINITE);
+    }
+
+    for (int i = 0; i < QD3D12PaintEnginePrivate::FrameCount; ++i)
+        d->frames[i] = QD3D12PaintFrame();
+    d->frame = 0;
+    d->frameActive = false;
+    d->ownsFrame = false;
+    d->textures.clear();
+    d->pendingUploads.clear();
+    d->textureBytes = 0;
+    d->freeSlots.clear();
+    d->glyphAtlas.destroy();
+    d->glyphAtlasTexture = -1;
+    d->vertices.clear();
+    d->indices.clear();
+    d->draws.clear();
+    d->target.Reset();
+    d->targetWindow = Q_NULLPTR;
+    d->pipelineStates.clear();
+    d->heap.Reset();
+    d->rootSignature.Reset();
+    d->fence.Reset();
+    d->fenceValue = 0;
+    d->commandQueue.Reset();
+    d->device.Reset();
+}
+
+bool QD3D12PaintEngine::isCreated() const
+{
+    Q_D(const QD3D12PaintEngine);
+    return d->heap.Get() != Q_NULLPTR;
+}
+
+bool QD3D12PaintEngine::begin(QPaintDevice *pdev)
+{
+    Q_UNUSED(pdev);
+    Q_D(QD3D12PaintEngine);
+    if (!d->heap) {
+        qWarning("QD3D12PaintEngine: begin() called before create()");
+        return false;
+    }
+    if (!d->target) {
+        qWarning("QD3D12PaintEngine: No render target");
+        return false;
+    }
+
+    const D3D12_RESOURCE_DESC desc = d->target->GetDesc();
+    d->targetSize = QSize(int(desc.Width), int(desc.Height));
+
+    // Outside a window's frame each painter gets its own.
+    if (!d->frameActive) {
+        d->nextFrame();
+        d->ownsFrame = true;
+    }
+
+    d->transform = QTransform();
+    d->pen = QPen();
+    d->brush = QBrush();
+    d->brushOrigin = QPointF();
+    d->opacity = 1;
+    d->hasClip = false;
+    d->drawCallCount = 0;
+    return true;
+}
+
+bool QD3D12PaintEngine::end()
+{
+    Q_D(QD3D12PaintEngine);
+    d->flush();
+    if (d->ownsFrame) {
+        d->signalFrame();
+        d->ownsFrame = false;
+    }
+    d->target.Reset();
+    d->targetWindow = Q_NULLPTR;
+    return true;
+}
+
+void QD3D12PaintEngine::updateState(const QPaintEngineState &state)
+{
+    Q_D(QD3D12PaintEngine);
+    const DirtyFlags flags = state.state();
+    if (flags & DirtyTransform)
+        d->transform = state.transform();
+    if (flags & DirtyPen)
+        d->pen = state.pen();
+    if (flags & DirtyBrush)
+        d->brush = state.brush();
+    if (flags & DirtyBrushOrigin)
+        d->brushOrigin = state.brushOrigin();
+    if (flags & DirtyOpacity)
+        d->opacity = state.opacity();
+    if (flags & (DirtyClipPath | DirtyClipRegion | DirtyClipEnabled | DirtyTransform))
+        d->updateClip();
+}
+
+void QD3D12PaintEngine::drawRects(const QRectF *rects, int rectCount)
+{
+    Q_D(QD3D12PaintEngine);
+    for (int i = 0; i < rectCount; ++i) {
+        const QRectF &r(rects[i]);
+        const QPointF corners[] = { r.topLeft(), r.topRight(), r.bottomRight(), r.bottomLeft() };
+        d->fillConvex(corners, 4, d->brush);
+        if (d->pen.style() != Qt::NoPen) {
+            QPainterPath path;
+            path.addRect(r);
+            d->strokePath(path, d->pen);
+        }
+    }
+}
+
+void QD3D12PaintEngine::drawPath(const QPainterPath &path)
+{
+    Q_D(QD3D12PaintEngine);
+    d->fillPath(path, d->brush);
+    d->strokePath(path, d->pen);
+}
+
+void QD3D12PaintEngine::drawPolygon(const QPointF *points, int pointCount, PolygonDrawMode mode)
+{
+    Q_D(QD3D12PaintEngine);
+    if (pointCount < 2)
+        return;
+
+    QPainterPath path;
+    path.setFillRule(mode == WindingMode ? Qt::WindingFill : Qt::OddEvenFill);
+    path.moveTo(points[0]);
+    for (int i = 1; i < pointCount; ++i)
+        path.lineTo(points[i]);
+    if (mode != PolylineMode) {
+        path.closeSubpath();
+        if (mode == ConvexMode)
+            d->fillConvex(points, pointCount, d->brush);
+        else
+            d->fillPath(path, d->brush);
+    }
+    d->strokePath(path, d->pen);
+}
+
+void QD3D12PaintEngine::drawPixmap(const QRectF &r, const QPixmap &pm, const QRectF &sr)
+{
+    Q_D(QD3D12PaintEngine);
+    if (pm.isNull())
+        return;
+
+    // Only converted to an image when not cached yet.
+    int texture = d->cachedTexture(pm.cacheKey());
+    if (texture < 0)
+        texture = d->textureForImage(pm.toImage(), pm.cacheKey());
+    const qreal w = pm.width();
+    const qreal h = pm.height();
+    d->drawTexture(r, texture, QRectF(sr.x() / w, sr.y() / h, sr.width() / w, sr.height() / h));
+}
+
+void QD3D12PaintEngine::drawImage(const QRectF &r, const QImage &image, const QRectF &sr,
+                                  Qt::ImageConversionFlags flags)
+{
+    Q_UNUSED(flags);
+    Q_D(QD3D12PaintEngine);
+    if (image.isNull())
+        return;
+
+    const int texture = d->textureForImage(image, image.cacheKey());
+    const qreal w = image.width();
+    const qreal h = image.height();
+    d->drawTexture(r, texture, QRectF(sr.x() / w, sr.y() / h, sr.width() / w, sr.height() / h));
+}
+
+// Text in a solid color, drawn with at most a scaling transform, comes from
+// the glyph atlas: each glyph is a textured quad and laying out a string
+// that was drawn before is a cache lookup. Everything else is filled as
+// outlines, cached by font and string, with the triangulation coming from
+// the path cache.
+void QD3D12PaintEngine::drawTextItem(const QPointF &p, const QTextItem &textItem)
+{
+    Q_D(QD3D12PaintEngine);
+    const QFont font = textItem.font();
+    const QString text = textItem.text();
+
+    const qreal scale = d->transform.m11();
+    if (d->glyphAtlasTexture >= 0 && d->pen.brush().style() == Qt::SolidPattern
+            && d->transform.type() <= QTransform::TxScale && scale > 0 && qFuzzyCompare(scale, d->transform.m22())
+            && QFontInfo(font).pixelSize() * scale <= MAX_ATLAS_PIXEL_SIZE) {
+        QVector<QD3D12GlyphAtlas::Glyph> run = d->glyphAtlas.textRun(font, text, scale);
+        if (d->glyphAtlas.isFull()) {
+            // What is batched so far refers to the current contents.
+            d->flush();
+            d->glyphAtlas.clear();
+            run = d->glyphAtlas.textRun(font, text, scale);
+        }
+        QD3D12PaintFill fill;
+        if (d->prepareFill(d->pen.brush(), &fill)) {
+            const QPointF origin = d->transform.map(p);
+            d->drawGlyphRun(run, QPoint(qRound(origin.x()), qRound(origin.y())), fill.color);
+        }
+        return;
+    }
+
+    const QString key = font.key() + QLatin1Char('\n') + text;
+    QHash<QString, QPainterPath>::const_iterator it = d->textPaths.constFind(key);
+    if (it == d->textPaths.cend()) {
+        QPainterPath path;
+        path.addText(0, 0, font, text);
+        if (d->textPaths.count() >= 1024)
+            d->textPaths.clear();
+        it = d->textPaths.insert(key, path);
+    }
+    d->fillPath(*it, d->pen.brush(), QTransform::fromTranslate(p.x(), p.y()));
+}
+
+QPaintEngine::Type QD3D12PaintEngine::type() const
+{
+    return QPaintEngine::Direct3D;
+}
+
+// Draw calls issued since the last begin().
+int QD3D12PaintEngine::drawCallCount() const
+{
+    Q_D(const QD3D12PaintEngine);
+    return d->drawCallCount;
+}
+
+// A QPainter target for render targets other than a window's back buffer,
+// for example one created with QD3D12Window::createExtraRenderTargetAndView().
+// Several devices may share one engine, but only one can be painted on at a
+// time.
+QD3D12PaintDevice::QD3D12PaintDevice(QD3D12PaintEngine *engine)
+    : d_ptr(new QD3D12PaintDevicePrivate)
+{
+    Q_D(QD3D12PaintDevice);
+    d->engine = engine;
+}
+
+QD3D12PaintDevice::~QD3D12PaintDevice()
+{
+}
+
+// rtv must be a view with the format of the resource.
+void QD3D12PaintDevice::setRenderTarget(ID3D12Resource *renderTarget, D3D12_CPU_DESCRIPTOR_HANDLE rtv,
+                                        D3D12_RESOURCE_STATES state)
+{
+    Q_D(QD3D12PaintDevice);
+    d->renderTarget = renderTarget;
+    d->rtv = rtv;
+    d->state = state;
+}
+
+ID3D12Resource *QD3D12PaintDevice::renderTarget() const
+{
+    Q_D(const QD3D12PaintDevice);
+    return d->renderTarget.Get();
+}
+
+QPaintEngine *QD3D12PaintDevice::paintEngine() const
+{
+    Q_D(const QD3D12PaintDevice);
+    if (d->engine)
+        QD3D12PaintEnginePrivate::get(d->engine)->setTarget(d->renderTarget.Get(), d->rtv, d->state, Q_NULLPTR);
+    return d->engine;
+}
+
+int QD3D12PaintDevice::metric(PaintDeviceMetric metric) const
+{
+    Q_D(const QD3D12PaintDevice);
+    D3D12_RESOURCE_DESC desc = {};
+    if (d->renderTarget)
+        desc = d->renderTarget->GetDesc();
+
+    switch (metric) {
+    case PdmWidth:
+        return int(desc.Width);
+    case PdmHeight:
+        return int(desc.Height);
+    case PdmWidthMM:
+        return qRound(desc.Width * 25.4 / qt_defaultDpiX());
+    case PdmHeightMM:
+        return qRound(desc.Height * 25.4 / qt_defaultDpiY());
+    case PdmNumColors:
+        return INT_MAX;
+    case PdmDepth:
+        return 32;
+    case PdmDpiX:
+    case PdmPhysicalDpiX:
+        return qt_defaultDpiX();
+    case PdmDpiY:
+    case PdmPhysicalDpiY:
+        return qt_defaultDpiY();
+    case PdmDevicePixelRatio:
+        return 1;
+    default:
+        return QPaintDevice::metric(metric);
+    }
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,108 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtD3D12Window module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QD3D12PAINTENGINE_H
+#define QD3D12PAINTENGINE_H
+
+#include <QtCore/QScopedPointer>
+#include <QtGui/QPaintEngine>
+#include <QtGui/QPaintDevice>
+#include <QtD3D12Window/qd3d12window.h>
+
+QT_BEGIN_NAMESPACE
+
+class QD3D12PaintEnginePrivate;
+class QD3D12PaintDevicePrivate;
+
+class QD3D12_EXPORT QD3D12PaintEngine : public QPaintEngine
+{
+    Q_DECLARE_PRIVATE(QD3D12PaintEngine)
+
+public:
+    QD3D12PaintEngine();
+    ~QD3D12PaintEngine();
+
+    bool create(ID3D12Device *device, ID3D12CommandQueue *commandQueue);
+    void destroy();
+    bool isCreated() const;
+
+    bool begin(QPaintDevice *pdev) Q_DECL_OVERRIDE;
+    bool end() Q_DECL_OVERRIDE;
+    void updateState(const QPaintEngineState &state) Q_DECL_OVERRIDE;
+
+    void drawRects(const QRectF *rects, int rectCount) Q_DECL_OVERRIDE;
+    void drawPath(const QPainterPath &path) Q_DECL_OVERRIDE;
+    void drawPolygon(const QPointF *points, int pointCount, PolygonDrawMode mode) Q_DECL_OVERRIDE;
+    void drawPixmap(const QRectF &r, const QPixmap &pm, const QRectF &sr) Q_DECL_OVERRIDE;
+    void drawImage(const QRectF &r, const QImage &image, const QRectF &sr,
+                   Qt::ImageConversionFlags flags = Qt::AutoColor) Q_DECL_OVERRIDE;
+    void drawTextItem(const QPointF &p, const QTextItem &textItem) Q_DECL_OVERRIDE;
+
+    Type type() const Q_DECL_OVERRIDE;
+
+    int drawCallCount() const;
+
+private:
+    Q_DISABLE_COPY(QD3D12PaintEngine)
+};
+
+class QD3D12_EXPORT QD3D12PaintDevice : public QPaintDevice
+{
+    Q_DECLARE_PRIVATE(QD3D12PaintDevice)
+
+public:
+    explicit QD3D12PaintDevice(QD3D12PaintEngine *engine);
+    ~QD3D12PaintDevice();
+
+    // The target is expected to be in state when painting begins and is
+    // left in state when it ends.
+    void setRenderTarget(ID3D12Resource *renderTarget, D3D12_CPU_DESCRIPTOR_HANDLE rtv,
+                         D3D12_RESOURCE_STATES state = D3D12_RESOURCE_STATE_RENDER_TARGET);
+    ID3D12Resource *renderTarget() const;
+
+    QPaintEngine *paintEngine() const Q_DECL_OVERRIDE;
+
+protected:
+    int metric(PaintDeviceMetric metric) const Q_DECL_OVERRIDE;
+
+private:
+    Q_DISABLE_COPY(QD3D12PaintDevice)
+    QScopedPointer<QD3D12PaintDevicePrivate> d_ptr;
+};
+
+QT_END_NAMESPACE
+
+#endif
@@ -0,0 +1,42 @@
+// QD3D12PaintEngine. Vertices arrive in pixels with premultiplied colors,
+// everything else (transforms, brushes, opacity) has been resolved on the
+// CPU. Solid fills sample a white texel, so there is only one pipeline.
+
+Texture2D tex : register(t0);
+SamplerState linearClamp : register(s0);
+SamplerState linearWrap : register(s1);
+
+cbuffer PaintConstants : register(b0)
+{
+    float2 pixelToClip; // 2 / target size
+    uint wrap; // repeating textures and gradients
+}
+
+struct VSInput
+{
+    float2 position : POSITION;
+    float2 uv : TEXCOORD0;
+    float4 color : COLOR;
+};
+
+struct PSInput
+{
+    float4 position : SV_POSITION;
+    float2 uv : TEXCOORD0;
+    float4 color : COLOR;
+};
+
+PSInput VS_Paint(VSInput input)
+{
+    PSInput output;
+    output.position = float4(input.position.x * pixelToClip.x - 1.0, 1.0 - input.position.y * pixelToClip.y, 0.0, 1.0);
+    output.uv = input.uv;
+    output.color = input.color;
+    return output;
+}
+
+float4 PS_Paint(PSInput input) : SV_TARGET
+{
+    const float4 t = wrap ? tex.Sample(linearWrap, input.uv) : tex.Sample(linearClamp, input.uv);
+    return input.color * t;
+}
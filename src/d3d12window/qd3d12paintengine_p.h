@@ -0,0 +1,300 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtD3D12Window module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QD3D12PAINTENGINE_P_H
+#define QD3D12PAINTENGINE_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "qd3d12paintengine.h"
+#include "qd3d12glyphatlas.h"
+#include "qd3d12window_p.h"
+#include <QtCore/QCache>
+#include <QtCore/QHash>
+#include <QtCore/QVector>
+#include <QtGui/QPainterPath>
+#include <QtGui/QPen>
+#include <QtGui/private/qpaintengine_p.h>
+
+QT_BEGIN_NAMESPACE
+
+// The vertex format, see qd3d12paintengine.hlsl. Positions are in pixels,
+// transformed on the CPU, colors are premultiplied.
+struct QD3D12PaintVertex
+{
+    float x;
+    float y;
+    float u;
+    float v;
+    quint32 color; // R8G8B8A8_UNORM
+};
+
+// A run of indices sharing the texture and the scissor.
+struct QD3D12PaintDraw
+{
+    int texture;
+    bool wrap;
+    QRect scissor;
+    quint32 firstIndex;
+    quint32 indexCount;
+};
+
+struct QD3D12PaintTexture
+{
+    QD3D12PaintTexture() : slot(-1), bytes(0), lastUsed(0) { }
+    ComPtr<ID3D12Resource> resource;
+    int slot;
+    QImage pending; // waiting for the upload in the next flush
+    quint32 bytes;
+    quint64 lastUsed;
+};
+
+// Triangulated fill or stroke of a path in the path's coordinates. The
+// source path and pen are kept to tell hash collisions apart.
+struct QD3D12PaintTriangles
+{
+    QPainterPath path;
+    QPen pen;
+    bool stroke;
+    QVector<float> vertices; // x, y pairs
+    QVector<quint32> indices;
+};
+
+struct QD3D12PaintTrianglesKey
+{
+    uint hash;
+    int lod;
+};
+
+inline bool operator==(const QD3D12PaintTrianglesKey &a, const QD3D12PaintTrianglesKey &b)
+{
+    return a.hash == b.hash && a.lod == b.lod;
+}
+
+inline uint qHash(const QD3D12PaintTrianglesKey &key, uint seed = 0)
+{
+    return key.hash ^ uint(key.lod) ^ seed;
+}
+
+// How a brush turns into vertex colors and texture coordinates.
+struct QD3D12PaintFill
+{
+    enum Mode {
+        Solid,
+        Gradient,
+        Texture
+    };
+
+    Mode mode;
+    int texture;
+    bool wrap;
+    quint32 color;
+    QTransform logicalToBrush;
+    QPointF start;
+    QPointF delta; // gradient direction divided by its squared length
+    float rampScale;
+    float rampBias;
+    QSizeF textureSize;
+};
+
+// Everything recorded while painting in one frame. The frame is reused once
+// the GPU is done with it.
+struct QD3D12PaintFrame
+{
+    QD3D12PaintFrame() : uploadData(Q_NULLPTR), uploadSize(0), uploadUsed(0), usedLists(0), fenceValue(0) { }
+    ComPtr<ID3D12CommandAllocator> allocator;
+    QVector<ComPtr<ID3D12GraphicsCommandList> > commandLists;
+    ComPtr<ID3D12Resource> upload;
+    quint8 *uploadData;
+    quint32 uploadSize;
+    quint32 uploadUsed;
+    int usedLists;
+    UINT64 fenceValue;
+    QVector<ComPtr<ID3D12Resource> > retired;
+};
+
+class QD3D12PaintEnginePrivate : public QPaintEnginePrivate, public QD3D12FrameObserver
+{
+    Q_DECLARE_PUBLIC(QD3D12PaintEngine)
+
+public:
+    // The number of frames the CPU may be ahead of the GPU.
+    enum { FrameCount = 3 };
+    enum { MaxTextures = 1024 };
+    enum { WhiteTexture = 0 };
+
+    QD3D12PaintEnginePrivate()
+        : descriptorSize(0),
+          fenceEvent(Q_NULLPTR),
+          fenceValue(0),
+          frame(0),
+          frameNumber(0),
+          frameActive(false),
+          ownsFrame(false),
+          targetWindow(Q_NULLPTR),
+          targetState(D3D12_RESOURCE_STATE_RENDER_TARGET),
+          textureBytes(0),
+          textureBudget(64 * 1024 * 1024),
+          glyphAtlasTexture(-1),
+          triangles(16 * 1024),
+          opacity(1),
+          hasClip(false),
+          drawCallCount(0)
+    {
+        targetRtv.ptr = 0;
+    }
+    ~QD3D12PaintEnginePrivate();
+
+    static QD3D12PaintEnginePrivate *get(QD3D12PaintEngine *e) { return e->d_func(); }
+
+    // Only called when the engine belongs to a window.
+    void beginFrame() Q_DECL_OVERRIDE;
+    void endFrame() Q_DECL_OVERRIDE;
+    void releaseResources() Q_DECL_OVERRIDE;
+
+    void setTarget(ID3D12Resource *resource, D3D12_CPU_DESCRIPTOR_HANDLE rtv,
+                   D3D12_RESOURCE_STATES state, QD3D12Window *window);
+    void nextFrame();
+    void signalFrame();
+
+    bool allocateUpload(quint32 size, quint32 alignment, ID3D12Resource **buffer, quint32 *offset, quint8 **data);
+    int cachedTexture(qint64 key);
+    int textureForImage(const QImage &image, qint64 key);
+    int textureForGradient(const QGradient *gradient);
+    void evictTextures(bool force);
+    void uploadTexture(QD3D12PaintTexture *texture, ID3D12GraphicsCommandList *commandList);
+    const QD3D12PaintTriangles *triangulate(const QPainterPath &path, const QPen *pen, int lod);
+
+    void updateClip();
+    bool prepareFill(const QBrush &brush, QD3D12PaintFill *fill);
+    void addVertex(const QD3D12PaintFill &fill, const QPointF &logical, const QPointF &device);
+    void beginDraw(int texture, bool wrap, int indexCount);
+    void addTriangles(const QD3D12PaintTriangles *t, const QTransform &toLogical,
+                      const QTransform &toDevice, const QD3D12PaintFill &fill);
+    void fillPath(const QPainterPath &path, const QBrush &brush, const QTransform &pathTransform = QTransform());
+    void strokePath(const QPainterPath &path, const QPen &pen);
+    void fillConvex(const QPointF *points, int pointCount, const QBrush &brush);
+    void drawTexture(const QRectF &r, int texture, const QRectF &uv);
+    void drawGlyphRun(const QVector<QD3D12GlyphAtlas::Glyph> &run, const QPoint &origin, quint32 color);
+
+    void flush();
+    ID3D12PipelineState *pipelineState(DXGI_FORMAT format, const DXGI_SAMPLE_DESC &sampleDesc);
+
+    ComPtr<ID3D12Device> device;
+    ComPtr<ID3D12CommandQueue> commandQueue;
+    ComPtr<ID3D12RootSignature> rootSignature;
+    QHash<quint64, ComPtr<ID3D12PipelineState> > pipelineStates;
+
+    // One descriptor per texture, handed out from freeSlots.
+    ComPtr<ID3D12DescriptorHeap> heap;
+    UINT descriptorSize;
+    QVector<int> freeSlots;
+
+    ComPtr<ID3D12Fence> fence;
+    HANDLE fenceEvent;
+    UINT64 fenceValue;
+    QD3D12PaintFrame frames[FrameCount];
+    int frame;
+    quint64 frameNumber;
+    bool frameActive;
+    bool ownsFrame;
+
+    ComPtr<ID3D12Resource> target;
+    D3D12_CPU_DESCRIPTOR_HANDLE targetRtv;
+    D3D12_RESOURCE_STATES targetState;
+    QD3D12Window *targetWindow;
+    QSize targetSize;
+
+    // Images by cache key. Textures not used for a few frames are evicted
+    // when textureBytes goes over textureBudget.
+    QHash<qint64, QD3D12PaintTexture> textures;
+    QVector<qint64> pendingUploads;
+    quint64 textureBytes;
+    quint64 textureBudget;
+    QHash<uint, QImage> gradientRamps;
+
+    // Text drawn without rotation or shearing, in solid colors.
+    QD3D12GlyphAtlas glyphAtlas;
+    int glyphAtlasTexture;
+
+    // The cost is the size of the geometry in kilobytes.
+    QCache<QD3D12PaintTrianglesKey, QD3D12PaintTriangles> triangles;
+    QScopedPointer<QD3D12PaintTriangles> uncachedTriangles;
+    QHash<QString, QPainterPath> textPaths;
+
+    // State, as last passed to updateState().
+    QTransform transform;
+    QPen pen;
+    QBrush brush;
+    QPointF brushOrigin;
+    qreal opacity;
+    bool hasClip;
+    QRect clipRect;
+
+    QVector<QD3D12PaintVertex> vertices;
+    QVector<quint32> indices;
+    QVector<QD3D12PaintDraw> draws;
+    int drawCallCount;
+};
+
+class QD3D12PaintDevicePrivate
+{
+public:
+    QD3D12PaintDevicePrivate()
+        : engine(Q_NULLPTR),
+          state(D3D12_RESOURCE_STATE_RENDER_TARGET)
+    {
+        rtv.ptr = 0;
+    }
+
+    QD3D12PaintEngine *engine;
+    ComPtr<ID3D12Resource> renderTarget;
+    D3D12_CPU_DESCRIPTOR_HANDLE rtv;
+    D3D12_RESOURCE_STATES state;
+};
+
+QT_END_NAMESPACE
+
+#endif
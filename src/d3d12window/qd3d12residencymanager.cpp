@@ -0,0 +1,301 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtD3D12Window module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qd3d12residencymanager_p.h"
+#include <QtCore/QWinEventNotifier>
+#include <algorithm>
+
+QT_BEGIN_NAMESPACE
+
+QD3D12ResidencyManagerPrivate::~QD3D12ResidencyManagerPrivate()
+{
+}
+
+bool QD3D12ResidencyManagerPrivate::initialize(ID3D12Device *dev, ID3D12CommandQueue *queue)
+{
+    Q_Q(QD3D12ResidencyManager);
+
+    device = dev;
+    commandQueue = queue;
+
+    fenceValue = 0;
+    if (FAILED(device->CreateFence(fenceValue, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&fence)))) {
+        qWarning("Failed to create fence (residency)");
+        return false;
+    }
+
+    // The budget is per adapter, find the one the device was created on.
+    ComPtr<IDXGIFactory4> factory;
+    if (FAILED(CreateDXGIFactory2(0, IID_PPV_ARGS(&factory)))) {
+        qWarning("Failed to create DXGI factory (residency)");
+        return false;
+    }
+    if (FAILED(factory->EnumAdapterByLuid(device->GetAdapterLuid(), IID_PPV_ARGS(&adapter)))) {
+        qWarning("Failed to query IDXGIAdapter3, video memory budget is not available");
+        return false;
+    }
+
+    budgetEvent = CreateEvent(Q_NULLPTR, FALSE, FALSE, Q_NULLPTR);
+    if (SUCCEEDED(adapter->RegisterVideoMemoryBudgetChangeNotificationEvent(budgetEvent, &budgetCookie))) {
+        budgetNotifier = new QWinEventNotifier(budgetEvent, q);
+        QObject::connect(budgetNotifier, &QWinEventNotifier::activated, q, [this]() { budgetNotification(); });
+    } else {
+        qWarning("Failed to register for video memory budget notifications");
+    }
+
+    budgetNotification();
+    return true;
+}
+
+void QD3D12ResidencyManagerPrivate::releaseResources()
+{
+    if (budgetNotifier) {
+        delete budgetNotifier;
+        budgetNotifier = Q_NULLPTR;
+    }
+    if (adapter && budgetCookie) {
+        adapter->UnregisterVideoMemoryBudgetChangeNotification(budgetCookie);
+        budgetCookie = 0;
+    }
+    if (budgetEvent) {
+        CloseHandle(budgetEvent);
+        budgetEvent = Q_NULLPTR;
+    }
+
+    // The objects belong to the old device, there is nothing to evict.
+    entries.clear();
+    trackedSize = evictedSize = 0;
+    lastBudget = 0;
+
+    fence = Q_NULLPTR;
+    adapter = Q_NULLPTR;
+    commandQueue = Q_NULLPTR;
+    device = Q_NULLPTR;
+}
+
+void QD3D12ResidencyManagerPrivate::budgetNotification()
+{
+    Q_Q(QD3D12ResidencyManager);
+    if (!adapter)
+        return;
+
+    DXGI_QUERY_VIDEO_MEMORY_INFO info;
+    if (FAILED(adapter->QueryVideoMemoryInfo(0, DXGI_MEMORY_SEGMENT_GROUP_LOCAL, &info)))
+        return;
+
+    // The OS shrinks the budget when other applications need the memory,
+    // react right away instead of waiting for the next frame.
+    trim(info);
+
+    if (info.Budget != lastBudget) {
+        lastBudget = info.Budget;
+        emit q->budgetChanged(info.Budget, info.CurrentUsage);
+    }
+}
+
+void QD3D12ResidencyManagerPrivate::endFrame()
+{
+    if (!fence)
+        return;
+
+    // Everything marked as used in this frame is covered by this value.
+    commandQueue->Signal(fence.Get(), ++fenceValue);
+
+    DXGI_QUERY_VIDEO_MEMORY_INFO info;
+    if (adapter && SUCCEEDED(adapter->QueryVideoMemoryInfo(0, DXGI_MEMORY_SEGMENT_GROUP_LOCAL, &info)))
+        trim(info);
+}
+
+void QD3D12ResidencyManagerPrivate::trim(const DXGI_QUERY_VIDEO_MEMORY_INFO &info)
+{
+    const quint64 target = quint64(info.Budget * double(targetUsage));
+    if (info.CurrentUsage <= target || !fence)
+        return;
+
+    // Least recently used first, only what the GPU is done with.
+    const UINT64 completed = fence->GetCompletedValue();
+    QVector<QPair<UINT64, ID3D12Pageable *> > candidates;
+    for (auto it = entries.cbegin(), end = entries.cend(); it != end; ++it) {
+        if (it->resident && it->lastUsed <= completed)
+            candidates.append(qMakePair(it->lastUsed, it.key()));
+    }
+    std::sort(candidates.begin(), candidates.end());
+
+    const quint64 excess = info.CurrentUsage - target;
+    quint64 freed = 0;
+    QVector<ID3D12Pageable *> evict;
+    for (int i = 0; i < candidates.count() && freed < excess; ++i) {
+        Entry &e(entries[candidates[i].second]);
+        e.resident = false;
+        freed += e.size;
+        evict.append(candidates[i].second);
+    }
+
+    if (evict.isEmpty())
+        return;
+
+    if (FAILED(device->Evict(evict.count(), evict.constData()))) {
+        qWarning("Evict failed");
+        foreach (ID3D12Pageable *object, evict)
+            entries[object].resident = true;
+        return;
+    }
+    evictedSize += freed;
+}
+
+// Tracks resources and heaps by the frame that last used them. When the
+// local video memory usage goes over targetUsage() of the budget, either at
+// the end of a frame or when the OS reports a budget change, the least
+// recently used objects the GPU is done with are evicted. markUsed() makes
+// them resident again before they are referenced by a command list.
+QD3D12ResidencyManager::QD3D12ResidencyManager(QObject *parent)
+    : QObject(*(new QD3D12ResidencyManagerPrivate), parent)
+{
+}
+
+QD3D12ResidencyManager::~QD3D12ResidencyManager()
+{
+    Q_D(QD3D12ResidencyManager);
+    d->releaseResources();
+}
+
+// The object must be untracked before it is released.
+void QD3D12ResidencyManager::track(ID3D12Pageable *object, quint64 size)
+{
+    Q_D(QD3D12ResidencyManager);
+    if (!object || d->entries.contains(object))
+        return;
+
+    QD3D12ResidencyManagerPrivate::Entry e;
+    e.size = size;
+    e.lastUsed = d->fenceValue + 1;
+    d->entries.insert(object, e);
+    d->trackedSize += size;
+}
+
+void QD3D12ResidencyManager::untrack(ID3D12Pageable *object)
+{
+    Q_D(QD3D12ResidencyManager);
+    auto it = d->entries.find(object);
+    if (it == d->entries.end())
+        return;
+
+    d->trackedSize -= it->size;
+    if (!it->resident)
+        d->evictedSize -= it->size;
+    d->entries.erase(it);
+}
+
+// Call for every tracked object a command list recorded in the current
+// frame references.
+void QD3D12ResidencyManager::markUsed(ID3D12Pageable *object)
+{
+    markUsed(1, &object);
+}
+
+void QD3D12ResidencyManager::markUsed(int count, ID3D12Pageable *const *objects)
+{
+    Q_D(QD3D12ResidencyManager);
+
+    QVector<ID3D12Pageable *> makeResident;
+    for (int i = 0; i < count; ++i) {
+        auto it = d->entries.find(objects[i]);
+        if (it == d->entries.end())
+            continue;
+        it->lastUsed = d->fenceValue + 1;
+        if (!it->resident) {
+            it->resident = true;
+            d->evictedSize -= it->size;
+            makeResident.append(objects[i]);
+        }
+    }
+
+    // Blocks until the memory is available again.
+    if (!makeResident.isEmpty() && FAILED(d->device->MakeResident(makeResident.count(), makeResident.constData())))
+        qWarning("MakeResident failed for %d object(s)", makeResident.count());
+}
+
+bool QD3D12ResidencyManager::isResident(ID3D12Pageable *object) const
+{
+    Q_D(const QD3D12ResidencyManager);
+    return d->entries.value(object).resident;
+}
+
+// Eviction starts when the usage goes above this fraction of the budget.
+void QD3D12ResidencyManager::setTargetUsage(float fractionOfBudget)
+{
+    Q_D(QD3D12ResidencyManager);
+    d->targetUsage = qBound(0.1f, fractionOfBudget, 1.0f);
+}
+
+float QD3D12ResidencyManager::targetUsage() const
+{
+    Q_D(const QD3D12ResidencyManager);
+    return d->targetUsage;
+}
+
+QD3D12ResidencyManager::VideoMemoryInfo QD3D12ResidencyManager::videoMemoryInfo(MemorySegment segment) const
+{
+    Q_D(const QD3D12ResidencyManager);
+    VideoMemoryInfo result;
+    if (!d->adapter)
+        return result;
+
+    DXGI_QUERY_VIDEO_MEMORY_INFO info;
+    const DXGI_MEMORY_SEGMENT_GROUP group = segment == LocalMemory ? DXGI_MEMORY_SEGMENT_GROUP_LOCAL
+                                                                   : DXGI_MEMORY_SEGMENT_GROUP_NON_LOCAL;
+    if (SUCCEEDED(d->adapter->QueryVideoMemoryInfo(0, group, &info))) {
+        result.budget = info.Budget;
+        result.currentUsage = info.CurrentUsage;
+        result.availableForReservation = info.AvailableForReservation;
+        result.currentReservation = info.CurrentReservation;
+    }
+    return result;
+}
+
+quint64 QD3D12ResidencyManager::trackedSize() const
+{
+    Q_D(const QD3D12ResidencyManager);
+    return d->trackedSize;
+}
+
+quint64 QD3D12ResidencyManager::evictedSize() const
+{
+    Q_D(const QD3D12ResidencyManager);
+    return d->evictedSize;
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,92 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtD3D12Window module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QD3D12RESIDENCYMANAGER_H
+#define QD3D12RESIDENCYMANAGER_H
+
+#include <QtCore/QObject>
+#include <QtD3D12Window/qd3d12window.h>
+
+QT_BEGIN_NAMESPACE
+
+class QD3D12ResidencyManagerPrivate;
+
+class QD3D12_EXPORT QD3D12ResidencyManager : public QObject
+{
+    Q_OBJECT
+    Q_DECLARE_PRIVATE(QD3D12ResidencyManager)
+
+public:
+    enum MemorySegment {
+        LocalMemory,
+        NonLocalMemory
+    };
+
+    struct VideoMemoryInfo {
+        VideoMemoryInfo() : budget(0), currentUsage(0), availableForReservation(0), currentReservation(0) { }
+        quint64 budget;
+        quint64 currentUsage;
+        quint64 availableForReservation;
+        quint64 currentReservation;
+    };
+
+    ~QD3D12ResidencyManager();
+
+    void track(ID3D12Pageable *object, quint64 size);
+    void untrack(ID3D12Pageable *object);
+    void markUsed(ID3D12Pageable *object);
+    void markUsed(int count, ID3D12Pageable *const *objects);
+    bool isResident(ID3D12Pageable *object) const;
+
+    void setTargetUsage(float fractionOfBudget);
+    float targetUsage() const;
+
+    VideoMemoryInfo videoMemoryInfo(MemorySegment segment = LocalMemory) const;
+    quint64 trackedSize() const;
+    quint64 evictedSize() const;
+
+signals:
+    void budgetChanged(quint64 budget, quint64 currentUsage);
+
+private:
+    explicit QD3D12ResidencyManager(QObject *parent);
+    Q_DISABLE_COPY(QD3D12ResidencyManager)
+    friend class QD3D12Window;
+};
+
+QT_END_NAMESPACE
+
+#endif
@@ -0,0 +1,115 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtD3D12Window module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QD3D12RESIDENCYMANAGER_P_H
+#define QD3D12RESIDENCYMANAGER_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "qd3d12residencymanager.h"
+#include "qd3d12window_p.h"
+#include <QtCore/QHash>
+#include <QtCore/private/qobject_p.h>
+
+QT_BEGIN_NAMESPACE
+
+class QWinEventNotifier;
+
+class QD3D12ResidencyManagerPrivate : public QObjectPrivate, public QD3D12FrameObserver
+{
+    Q_DECLARE_PUBLIC(QD3D12ResidencyManager)
+
+public:
+    QD3D12ResidencyManagerPrivate()
+        : targetUsage(0.95f),
+          budgetEvent(Q_NULLPTR),
+          budgetCookie(0),
+          budgetNotifier(Q_NULLPTR),
+          lastBudget(0),
+          fenceValue(0),
+          trackedSize(0),
+          evictedSize(0)
+    { }
+    ~QD3D12ResidencyManagerPrivate();
+
+    static QD3D12ResidencyManagerPrivate *get(QD3D12ResidencyManager *p) { return p->d_func(); }
+
+    bool initialize(ID3D12Device *device, ID3D12CommandQueue *commandQueue);
+
+    void beginFrame() Q_DECL_OVERRIDE { }
+    void endFrame() Q_DECL_OVERRIDE;
+    void releaseResources() Q_DECL_OVERRIDE;
+
+    void budgetNotification();
+    void trim(const DXGI_QUERY_VIDEO_MEMORY_INFO &info);
+
+    struct Entry {
+        Entry() : size(0), lastUsed(0), resident(true) { }
+        quint64 size;
+        UINT64 lastUsed; // fence value of the frame that last used it
+        bool resident;
+    };
+
+    float targetUsage;
+
+    ComPtr<ID3D12Device> device;
+    ComPtr<ID3D12CommandQueue> commandQueue;
+    ComPtr<IDXGIAdapter3> adapter;
+    HANDLE budgetEvent;
+    DWORD budgetCookie;
+    QWinEventNotifier *budgetNotifier;
+    quint64 lastBudget;
+
+    ComPtr<ID3D12Fence> fence;
+    UINT64 fenceValue;
+
+    QHash<ID3D12Pageable *, Entry> entries;
+    quint64 trackedSize;
+    quint64 evictedSize;
+};
+
+QT_END_NAMESPACE
+
+#endif
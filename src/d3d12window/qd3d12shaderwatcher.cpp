@@ -0,0 +1,572 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtD3D12Window module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qd3d12shaderwatcher.h"
+#include "qd3d12window_p.h"
+#include <QtCore/private/qobject_p.h>
+#include <QDir>
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QHash>
+#include <QMutex>
+#include <QRunnable>
+#include <QSet>
+#include <QThreadPool>
+#include <QTimer>
+#include <d3dcompiler.h>
+
+QT_BEGIN_NAMESPACE
+
+// Number of frame boundaries a replaced pipeline state object is kept alive
+// for, so that command lists still in flight can finish with it.
+static const int RETIRE_FRAME_COUNT = 3;
+
+struct QD3D12WatchedShader
+{
+    QString sourceFile;
+    QByteArray entryPoint;
+    QByteArray target;
+    QByteArray bytecode;
+};
+
+struct QD3D12WatchedPipeline
+{
+    QD3D12WatchedPipeline() : compute(false), generation(0), graphicsDesc(), computeDesc() { stages[0] = stages[1] = -1; }
+
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC makeGraphicsDesc(const QByteArray &vs, const QByteArray &ps) const;
+    D3D12_COMPUTE_PIPELINE_STATE_DESC makeComputeDesc(const QByteArray &cs) const;
+
+    bool compute;
+    int stages[2]; // VS and PS, or CS
+    int generation; // bumped whenever a stage gets new bytecode
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC graphicsDesc;
+    D3D12_COMPUTE_PIPELINE_STATE_DESC computeDesc;
+    QVector<D3D12_INPUT_ELEMENT_DESC> inputElements;
+    QByteArrayList semanticNames;
+    ComPtr<ID3D12RootSignature> rootSignature;
+    ComPtr<ID3D12PipelineState> pipelineState;
+};
+
+D3D12_GRAPHICS_PIPELINE_STATE_DESC QD3D12WatchedPipeline::makeGraphicsDesc(const QByteArray &vs, const QByteArray &ps) const
+{
+    // The stored descriptions do not own anything, patch up the pointers for
+    // this particular copy.
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC desc = graphicsDesc;
+    desc.pRootSignature = rootSignature.Get();
+    desc.InputLayout.pInputElementDescs = inputElements.constData();
+    desc.InputLayout.NumElements = inputElements.count();
+    desc.VS.pShaderBytecode = vs.constData();
+    desc.VS.BytecodeLength = vs.size();
+    desc.PS.pShaderBytecode = ps.constData();
+    desc.PS.BytecodeLength = ps.size();
+    return desc;
+}
+
+D3D12_COMPUTE_PIPELINE_STATE_DESC QD3D12WatchedPipeline::makeComputeDesc(const QByteArray &cs) const
+{
+    D3D12_COMPUTE_PIPELINE_STATE_DESC desc = computeDesc;
+    desc.pRootSignature = rootSignature.Get();
+    desc.CS.pShaderBytecode = cs.constData();
+    desc.CS.BytecodeLength = cs.size();
+    return desc;
+}
+
+// Either the shaders recompiled from one source file, or the pipeline states
+// rebuilt afterwards, in which case sourceFile is empty.
+struct QD3D12ShaderReloadResult
+{
+    QD3D12ShaderReloadResult() : generation(0) { }
+
+    QString sourceFile;
+    int generation;
+    QHash<int, QByteArray> shaders;
+    QHash<int, ComPtr<ID3D12PipelineState> > pipelines;
+    QHash<int, int> pipelineGenerations;
+    QHash<int, QString> pipelineErrors;
+    QString log;
+};
+
+class QD3D12ShaderWatcherPrivate : public QObjectPrivate, public QD3D12FrameObserver
+{
+    Q_DECLARE_PUBLIC(QD3D12ShaderWatcher)
+
+public:
+    QD3D12ShaderWatcherPrivate()
+        : window(Q_NULLPTR),
+          fileWatcher(Q_NULLPTR),
+          frameCount(0)
+    { }
+    ~QD3D12ShaderWatcherPrivate();
+
+    void beginFrame() Q_DECL_OVERRIDE;
+    void releaseResources() Q_DECL_OVERRIDE;
+
+    void fileChanged(const QString &path);
+    void recompile();
+    void rebuildPipelines(const QSet<int> &ids);
+    void watch(const QString &path);
+    void postResult(const QD3D12ShaderReloadResult &result);
+
+    static QByteArray reloadKey(const QD3D12WatchedShader &shader);
+
+    QD3D12Window *window;
+    QFileSystemWatcher *fileWatcher;
+    QTimer recompileTimer;
+    QSet<QString> changedFiles;
+    QThreadPool pool;
+
+    QVector<QD3D12WatchedShader> shaders;
+    QVector<QD3D12WatchedPipeline> pipelines;
+
+    // Bytecode that replaced the built-in one, survives device loss so that
+    // re-registering after a reset picks up the latest edits.
+    QHash<QByteArray, QByteArray> reloadedBytecode;
+
+    QHash<QString, int> fileGeneration;
+    QMutex pendingMutex;
+    QVector<QD3D12ShaderReloadResult> pending;
+
+    QVector<QPair<quint64, ComPtr<ID3D12PipelineState> > > retired;
+    quint64 frameCount;
+};
+
+namespace {
+
+class QD3D12ShaderCompileJob : public QRunnable
+{
+public:
+    QD3D12ShaderCompileJob(QD3D12ShaderWatcherPrivate *d, const QString &sourceFile, int generation)
+        : d(d), sourceFile(sourceFile), generation(generation)
+    { }
+
+    void run() Q_DECL_OVERRIDE;
+
+    QD3D12ShaderWatcherPrivate *d;
+    QString sourceFile;
+    int generation;
+    QHash<int, QD3D12WatchedShader> shaders; // snapshots of the ones to compile
+};
+
+// Pipeline states are only rebuilt once all the new bytecode is in place, so
+// that a pipeline whose stages live in different files, or were saved in
+// quick succession, never ends up with an outdated stage.
+class QD3D12PipelineRebuildJob : public QRunnable
+{
+public:
+    QD3D12PipelineRebuildJob(QD3D12ShaderWatcherPrivate *d, ID3D12Device *device)
+        : d(d), device(device)
+    { }
+
+    void run() Q_DECL_OVERRIDE;
+
+    QD3D12ShaderWatcherPrivate *d;
+    ComPtr<ID3D12Device> device;
+    // Snapshots taken on the GUI thread, with the bytecode of each stage.
+    QHash<int, QD3D12WatchedPipeline> pipelines;
+    QHash<int, QPair<QByteArray, QByteArray> > stages;
+};
+
+} // namespace
+
+void QD3D12ShaderCompileJob::run()
+{
+    QD3D12ShaderReloadResult result;
+    result.sourceFile = sourceFile;
+    result.generation = generation;
+
+    const QString nativePath = QDir::toNativeSeparators(sourceFile);
+    for (auto it = shaders.cbegin(), end = shaders.cend(); it != end; ++it) {
+        ComPtr<ID3DBlob> code;
+        ComPtr<ID3DBlob> errors;
+        HRESULT hr = D3DCompileFromFile(reinterpret_cast<LPCWSTR>(nativePath.utf16()), Q_NULLPTR,
+                                        D3D_COMPILE_STANDARD_FILE_INCLUDE,
+                                        it->entryPoint.constData(), it->target.constData(),
+                                        D3DCOMPILE_ENABLE_STRICTNESS, 0, &code, &errors);
+        if (errors) {
+            const QString msg = QString::fromUtf8(static_cast<const char *>(errors->GetBufferPointer()),
+                                                  int(errors->GetBufferSize()));
+            result.log += msg;
+        }
+        if (FAILED(hr)) {
+            qWarning("Failed to compile %s (%s) from %s: 0x%x", it->entryPoint.constData(), it->target.constData(),
+                     qPrintable(sourceFile), hr);
+            result.shaders.clear();
+            d->postResult(result);
+            return;
+        }
+        result.shaders.insert(it.key(), QByteArray(static_cast<const char *>(code->GetBufferPointer()),
+                                                   int(code->GetBufferSize())));
+    }
+
+    d->postResult(result);
+}
+
+// Creating pipeline states is safe from any thread. This is where most of the
+// time goes, so keep it off the GUI thread as well.
+void QD3D12PipelineRebuildJob::run()
+{
+    QD3D12ShaderReloadResult result;
+
+    for (auto it = pipelines.cbegin(), end = pipelines.cend(); it != end; ++it) {
+        const QD3D12WatchedPipeline &p(*it);
+        const QPair<QByteArray, QByteArray> &bytecode(stages[it.key()]);
+        ComPtr<ID3D12PipelineState> pso;
+        HRESULT hr;
+        if (p.compute) {
+            D3D12_COMPUTE_PIPELINE_STATE_DESC desc = p.makeComputeDesc(bytecode.first);
+            hr = device->CreateComputePipelineState(&desc, IID_PPV_ARGS(&pso));
+        } else {
+            D3D12_GRAPHICS_PIPELINE_STATE_DESC desc = p.makeGraphicsDesc(bytecode.first, bytecode.second);
+            hr = device->CreateGraphicsPipelineState(&desc, IID_PPV_ARGS(&pso));
+        }
+        result.pipelineGenerations.insert(it.key(), p.generation);
+        if (FAILED(hr)) {
+            qWarning("Failed to recreate pipeline state %d after reloading its shaders: 0x%x", it.key(), hr);
+            result.pipelineErrors.insert(it.key(), QStringLiteral("Failed to create pipeline state %1\n").arg(it.key()));
+            continue;
+        }
+        result.pipelines.insert(it.key(), pso);
+    }
+
+    d->postResult(result);
+}
+
+QD3D12ShaderWatcherPrivate::~QD3D12ShaderWatcherPrivate()
+{
+    pool.waitForDone();
+}
+
+QByteArray QD3D12ShaderWatcherPrivate::reloadKey(const QD3D12WatchedShader &shader)
+{
+    return shader.sourceFile.toUtf8() + '|' + shader.entryPoint + '|' + shader.target;
+}
+
+void QD3D12ShaderWatcherPrivate::watch(const QString &path)
+{
+    if (fileWatcher && !fileWatcher->files().contains(path))
+        fileWatcher->addPath(path);
+}
+
+void QD3D12ShaderWatcherPrivate::fileChanged(const QString &path)
+{
+    // Many editors save by writing a new file and renaming it over the old
+    // one, which makes QFileSystemWatcher drop the path.
+    watch(path);
+
+    changedFiles.insert(path);
+    recompileTimer.start();
+}
+
+void QD3D12ShaderWatcherPrivate::recompile()
+{
+    if (!window->device())
+        return;
+
+    foreach (const QString &file, changedFiles) {
+        QD3D12ShaderCompileJob *job = new QD3D12ShaderCompileJob(this, file, ++fileGeneration[file]);
+        for (int i = 0; i < shaders.count(); ++i) {
+            if (shaders[i].sourceFile == file)
+                job->shaders.insert(i, shaders[i]);
+        }
+        if (job->shaders.isEmpty()) {
+            delete job;
+            continue;
+        }
+        pool.start(job);
+    }
+
+    changedFiles.clear();
+}
+
+void QD3D12ShaderWatcherPrivate::rebuildPipelines(const QSet<int> &ids)
+{
+    ID3D12Device *device = window->device();
+    if (ids.isEmpty() || !device)
+        return;
+
+    auto stageBytecode = [this](int id) { return id >= 0 ? shaders[id].bytecode : QByteArray(); };
+    QD3D12PipelineRebuildJob *job = new QD3D12PipelineRebuildJob(this, device);
+    foreach (int id, ids) {
+        QD3D12WatchedPipeline &p(pipelines[id]);
+        ++p.generation; // results from rebuilds still in flight are outdated now
+        job->pipelines.insert(id, p);
+        job->stages.insert(id, qMakePair(stageBytecode(p.stages[0]), p.compute ? QByteArray() : stageBytecode(p.stages[1])));
+    }
+    pool.start(job);
+}
+
+void QD3D12ShaderWatcherPrivate::postResult(const QD3D12ShaderReloadResult &result)
+{
+    {
+        QMutexLocker lock(&pendingMutex);
+        pending.append(result);
+    }
+    // Make sure there is a frame boundary coming even when the window is not
+    // continuously animating.
+    QMetaObject::invokeMethod(window, "requestUpdate", Qt::QueuedConnection);
+}
+
+void QD3D12ShaderWatcherPrivate::beginFrame()
+{
+    Q_Q(QD3D12ShaderWatcher);
+
+    ++frameCount;
+    while (!retired.isEmpty() && retired.first().first + RETIRE_FRAME_COUNT <= frameCount)
+        retired.removeFirst();
+
+    QVector<QD3D12ShaderReloadResult> results;
+    {
+        QMutexLocker lock(&pendingMutex);
+        results.swap(pending);
+    }
+
+    QSet<int> changedPipelines;
+    foreach (const QD3D12ShaderReloadResult &result, results) {
+        if (result.sourceFile.isEmpty()) {
+            for (auto it = result.pipelineGenerations.cbegin(), end = result.pipelineGenerations.cend(); it != end; ++it) {
+                QD3D12WatchedPipeline &p(pipelines[it.key()]);
+                if (p.generation != it.value())
+                    continue; // a stage has changed again since, a newer rebuild is on its way
+                if (result.pipelineErrors.contains(it.key())) {
+                    const int stage = p.stages[0] >= 0 ? p.stages[0] : p.stages[1];
+                    emit q->compilationFailed(stage >= 0 ? shaders[stage].sourceFile : QString(),
+                                              result.pipelineErrors.value(it.key()));
+                    continue;
+                }
+                retired.append(qMakePair(frameCount, p.pipelineState));
+                p.pipelineState = result.pipelines.value(it.key());
+                emit q->pipelineStateChanged(it.key());
+            }
+            continue;
+        }
+
+        if (fileGeneration.value(result.sourceFile) != result.generation)
+            continue; // the file has changed again since, a newer job is on its way
+
+        if (result.shaders.isEmpty()) {
+            emit q->compilationFailed(result.sourceFile, result.log);
+            continue;
+        }
+
+        for (auto it = result.shaders.cbegin(), end = result.shaders.cend(); it != end; ++it) {
+            QD3D12WatchedShader &shader(shaders[it.key()]);
+            shader.bytecode = it.value();
+            reloadedBytecode.insert(reloadKey(shader), shader.bytecode);
+        }
+
+        for (int i = 0; i < pipelines.count(); ++i) {
+            const QD3D12WatchedPipeline &p(pipelines[i]);
+            if (result.shaders.contains(p.stages[0]) || (!p.compute && result.shaders.contains(p.stages[1])))
+                changedPipelines.insert(i);
+        }
+    }
+
+    // Built from the current bytecode of every stage, so all the reloads that
+    // arrived this frame are in.
+    rebuildPipelines(changedPipelines);
+}
+
+void QD3D12ShaderWatcherPrivate::releaseResources()
+{
+    pool.waitForDone();
+    {
+        QMutexLocker lock(&pendingMutex);
+        pending.clear();
+    }
+    retired.clear();
+    pipelines.clear();
+    shaders.clear();
+    fileGeneration.clear();
+    changedFiles.clear();
+    if (fileWatcher && !fileWatcher->files().isEmpty())
+        fileWatcher->removePaths(fileWatcher->files());
+}
+
+// Shaders and pipeline states start out with the bytecode compiled in at
+// build time. When watching is enabled (the default when
+// QT_D3D12_SHADER_HOT_RELOAD is set), the HLSL sources are monitored and the
+// changed entry points are recompiled on worker threads. New bytecode is
+// swapped in at the next frame boundary, and the pipeline states using it are
+// then rebuilt from the latest bytecode of all their stages, also on worker
+// threads, and swapped in at a later frame boundary. Registrations are
+// dropped on device loss, and are expected to be made again from
+// initializeD3D().
+QD3D12ShaderWatcher::QD3D12ShaderWatcher(QD3D12Window *window)
+    : QObject(*(new QD3D12ShaderWatcherPrivate), window)
+{
+    Q_D(QD3D12ShaderWatcher);
+    d->window = window;
+    d->pool.setMaxThreadCount(2);
+    d->recompileTimer.setSingleShot(true);
+    d->recompileTimer.setInterval(100); // coalesce the bursts of notifications a save generates
+    connect(&d->recompileTimer, &QTimer::timeout, this, [d]() { d->recompile(); });
+    QD3D12WindowPrivate::get(window)->frameObservers.append(d);
+
+    setWatchingEnabled(qEnvironmentVariableIntValue("QT_D3D12_SHADER_HOT_RELOAD") != 0);
+}
+
+QD3D12ShaderWatcher::~QD3D12ShaderWatcher()
+{
+    Q_D(QD3D12ShaderWatcher);
+    d->pool.waitForDone();
+    QD3D12WindowPrivate::get(d->window)->frameObservers.removeOne(d);
+}
+
+void QD3D12ShaderWatcher::setWatchingEnabled(bool enable)
+{
+    Q_D(QD3D12ShaderWatcher);
+    if (enable == isWatchingEnabled())
+        return;
+
+    if (enable) {
+        d->fileWatcher = new QFileSystemWatcher(this);
+        connect(d->fileWatcher, &QFileSystemWatcher::fileChanged, this, [d](const QString &path) { d->fileChanged(path); });
+        foreach (const QD3D12WatchedShader &shader, d->shaders)
+            d->watch(shader.sourceFile);
+    } else {
+        delete d->fileWatcher;
+        d->fileWatcher = Q_NULLPTR;
+        d->recompileTimer.stop();
+        d->changedFiles.clear();
+    }
+}
+
+bool QD3D12ShaderWatcher::isWatchingEnabled() const
+{
+    Q_D(const QD3D12ShaderWatcher);
+    return d->fileWatcher != Q_NULLPTR;
+}
+
+int QD3D12ShaderWatcher::addShader(const QString &sourceFile, const QByteArray &entryPoint, const QByteArray &target,
+                                   const void *bytecode, size_t bytecodeLength)
+{
+    Q_D(QD3D12ShaderWatcher);
+    QD3D12WatchedShader shader;
+    shader.sourceFile = QFileInfo(sourceFile).absoluteFilePath();
+    shader.entryPoint = entryPoint;
+    shader.target = target;
+    shader.bytecode = d->reloadedBytecode.value(QD3D12ShaderWatcherPrivate::reloadKey(shader),
+                                                QByteArray(static_cast<const char *>(bytecode), int(bytecodeLength)));
+    d->shaders.append(shader);
+    d->watch(shader.sourceFile);
+    return d->shaders.count() - 1;
+}
+
+D3D12_SHADER_BYTECODE QD3D12ShaderWatcher::shader(int shaderId) const
+{
+    Q_D(const QD3D12ShaderWatcher);
+    D3D12_SHADER_BYTECODE bc = {};
+    if (shaderId >= 0 && shaderId < d->shaders.count()) {
+        bc.pShaderBytecode = d->shaders[shaderId].bytecode.constData();
+        bc.BytecodeLength = d->shaders[shaderId].bytecode.size();
+    }
+    return bc;
+}
+
+int QD3D12ShaderWatcher::addGraphicsPipeline(const D3D12_GRAPHICS_PIPELINE_STATE_DESC &desc,
+                                             int vertexShaderId, int pixelShaderId)
+{
+    Q_D(QD3D12ShaderWatcher);
+    if (vertexShaderId < -1 || vertexShaderId >= d->shaders.count()
+            || pixelShaderId < -1 || pixelShaderId >= d->shaders.count()) {
+        qWarning("QD3D12ShaderWatcher: Invalid shader id %d or %d for graphics pipeline", vertexShaderId, pixelShaderId);
+        return -1;
+    }
+    if (desc.StreamOutput.NumEntries)
+        qWarning("QD3D12ShaderWatcher: Stream output is not supported");
+
+    QD3D12WatchedPipeline p;
+    p.stages[0] = vertexShaderId;
+    p.stages[1] = pixelShaderId;
+    p.graphicsDesc = desc;
+    p.graphicsDesc.StreamOutput = D3D12_STREAM_OUTPUT_DESC();
+    p.graphicsDesc.CachedPSO = D3D12_CACHED_PIPELINE_STATE();
+    p.rootSignature = desc.pRootSignature;
+    for (UINT i = 0; i < desc.InputLayout.NumElements; ++i)
+        p.semanticNames.append(QByteArray(desc.InputLayout.pInputElementDescs[i].SemanticName));
+    for (UINT i = 0; i < desc.InputLayout.NumElements; ++i) {
+        D3D12_INPUT_ELEMENT_DESC e = desc.InputLayout.pInputElementDescs[i];
+        e.SemanticName = p.semanticNames[i].constData();
+        p.inputElements.append(e);
+    }
+
+    const QByteArray vs = vertexShaderId >= 0 ? d->shaders[vertexShaderId].bytecode : QByteArray();
+    const QByteArray ps = pixelShaderId >= 0 ? d->shaders[pixelShaderId].bytecode : QByteArray();
+    const D3D12_GRAPHICS_PIPELINE_STATE_DESC psoDesc = p.makeGraphicsDesc(vs, ps);
+    if (FAILED(d->window->device()->CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(&p.pipelineState)))) {
+        qWarning("Failed to create graphics pipeline state");
+        return -1;
+    }
+
+    d->pipelines.append(p);
+    return d->pipelines.count() - 1;
+}
+
+int QD3D12ShaderWatcher::addComputePipeline(const D3D12_COMPUTE_PIPELINE_STATE_DESC &desc, int computeShaderId)
+{
+    Q_D(QD3D12ShaderWatcher);
+    if (computeShaderId < 0 || computeShaderId >= d->shaders.count()) {
+        qWarning("QD3D12ShaderWatcher: Invalid shader id %d for compute pipeline", computeShaderId);
+        return -1;
+    }
+
+    QD3D12WatchedPipeline p;
+    p.compute = true;
+    p.stages[0] = computeShaderId;
+    p.computeDesc = desc;
+    p.computeDesc.CachedPSO = D3D12_CACHED_PIPELINE_STATE();
+    p.rootSignature = desc.pRootSignature;
+
+    const D3D12_COMPUTE_PIPELINE_STATE_DESC psoDesc = p.makeComputeDesc(d->shaders[computeShaderId].bytecode);
+    if (FAILED(d->window->device()->CreateComputePipelineState(&psoDesc, IID_PPV_ARGS(&p.pipelineState)))) {
+        qWarning("Failed to create compute pipeline state");
+        return -1;
+    }
+
+    d->pipelines.append(p);
+    return d->pipelines.count() - 1;
+}
+
+// May change at frame boundaries, so query it every frame.
+ID3D12PipelineState *QD3D12ShaderWatcher::pipelineState(int pipelineId) const
+{
+    Q_D(const QD3D12ShaderWatcher);
+    if (pipelineId < 0 || pipelineId >= d->pipelines.count())
+        return Q_NULLPTR;
+    return d->pipelines[pipelineId].pipelineState.Get();
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,77 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtD3D12Window module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QD3D12SHADERWATCHER_H
+#define QD3D12SHADERWATCHER_H
+
+#include <QtCore/QObject>
+#include <QtD3D12Window/qd3d12window.h>
+
+QT_BEGIN_NAMESPACE
+
+class QD3D12ShaderWatcherPrivate;
+
+class QD3D12_EXPORT QD3D12ShaderWatcher : public QObject
+{
+    Q_OBJECT
+    Q_DECLARE_PRIVATE(QD3D12ShaderWatcher)
+
+public:
+    explicit QD3D12ShaderWatcher(QD3D12Window *window);
+    ~QD3D12ShaderWatcher();
+
+    void setWatchingEnabled(bool enable);
+    bool isWatchingEnabled() const;
+
+    int addShader(const QString &sourceFile, const QByteArray &entryPoint, const QByteArray &target,
+                  const void *bytecode, size_t bytecodeLength);
+    D3D12_SHADER_BYTECODE shader(int shaderId) const;
+
+    int addGraphicsPipeline(const D3D12_GRAPHICS_PIPELINE_STATE_DESC &desc, int vertexShaderId, int pixelShaderId);
+    int addComputePipeline(const D3D12_COMPUTE_PIPELINE_STATE_DESC &desc, int computeShaderId);
+    ID3D12PipelineState *pipelineState(int pipelineId) const;
+
+signals:
+    void pipelineStateChanged(int pipelineId);
+    void compilationFailed(const QString &sourceFile, const QString &log);
+
+private:
+    Q_DISABLE_COPY(QD3D12ShaderWatcher)
+};
+
+QT_END_NAMESPACE
+
+#endif
@@ -0,0 +1,417 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtD3D12Window module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include "qd3d12spritebatcher_p.h"
+#include "qd3d12spritebatcher_vs.h"
+#include "qd3d12spritebatcher_ps.h"
+#include "qd3d12streamingbuffer.h"
+#include "qd3d12util_p.h"
+
+QT_BEGIN_NAMESPACE
+
+Q_STATIC_ASSERT(sizeof(QD3D12SpriteInstance) == 32);
+
+static const quint32 NO_TEXTURE = 0xFFFFFFFF;
+
+// Resource binding tier 1 allows 128 SRVs per stage, the others far more
+// than a sprite table needs.
+static const int MAX_TEXTURES_TIER1 = 128;
+static const int MAX_TEXTURES = 4096;
+
+static inline quint16 toUnorm16(qreal v)
+{
+    return quint16(qBound(qreal(0), v, qreal(1)) * 65535 + qreal(0.5));
+}
+
+void QD3D12SpriteBatcherPrivate::append(const QRectF &rect, quint32 texture, const QRectF &source,
+                                        const QColor &color, QD3D12SpriteBatcher::BlendMode blend, int layer)
+{
+    if (!currentLayer || layer != currentLayerId) {
+        currentLayer = &layers[layer];
+        currentLayerId = layer;
+    }
+
+    QD3D12SpriteInstance s;
+    s.rect[0] = rect.x();
+    s.rect[1] = rect.y();
+    s.rect[2] = rect.width();
+    s.rect[3] = rect.height();
+    s.uvRect[0] = toUnorm16(source.left());
+    s.uvRect[1] = toUnorm16(source.top());
+    s.uvRect[2] = toUnorm16(source.right());
+    s.uvRect[3] = toUnorm16(source.bottom());
+    QRgb c = color.rgba();
+    if (blend == QD3D12SpriteBatcher::PremultipliedAlpha)
+        c = qPremultiply(c);
+    s.color = qRed(c) | (qGreen(c) << 8) | (qBlue(c) << 16) | (quint32(qAlpha(c)) << 24);
+    s.texture = texture;
+    currentLayer->sprites[blend].append(s);
+    ++spriteCount;
+}
+
+// Draws large numbers of textured and colored rectangles with a handful of
+// instanced draw calls. Sprites are grouped by layer and blend mode while
+// they are added; textures do not split batches since every sprite indexes
+// into one bindless texture table. Within a layer, opaque sprites are drawn
+// first, then alpha blended, premultiplied and additive ones, each group in
+// the order they were added. Put sprites that have to cover sprites with a
+// different blend mode into a higher layer.
+QD3D12SpriteBatcher::QD3D12SpriteBatcher()
+    : d_ptr(new QD3D12SpriteBatcherPrivate)
+{
+}
+
+QD3D12SpriteBatcher::~QD3D12SpriteBatcher()
+{
+}
+
+bool QD3D12SpriteBatcher::create(QD3D12Window *window, int samples)
+{
+    Q_D(QD3D12SpriteBatcher);
+    destroy();
+
+    ID3D12Device *device = window->device();
+    if (!device) {
+        qWarning("QD3D12SpriteBatcher: create() called before the window is initialized");
+        return false;
+    }
+    if (!window->streamingBuffer())
+        qWarning("QD3D12SpriteBatcher: The window has no streaming buffer, nothing will be drawn");
+
+    D3D12_FEATURE_DATA_D3D12_OPTIONS options = {};
+    const bool tier1 = FAILED(device->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS, &options, sizeof(options)))
+            || options.ResourceBindingTier == D3D12_RESOURCE_BINDING_TIER_1;
+    d->maxTextures = tier1 ? MAX_TEXTURES_TIER1 : MAX_TEXTURES;
+
+    D3D12_STATIC_SAMPLER_DESC sampler = {};
+    sampler.Filter = D3D12_FILTER_MIN_MAG_MIP_LINEAR;
+    sampler.AddressU = D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
+    sampler.AddressV = D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
+    sampler.AddressW = D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
+    sampler.MaxLOD = D3D12_FLOAT32_MAX;
+    sampler.ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL;
+
+    D3D12_DESCRIPTOR_RANGE descRange;
+    descRange.RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_SRV;
+    descRange.NumDescriptors = d->maxTextures;
+    descRange.BaseShaderRegister = 0; // t0
+    descRange.RegisterSpace = 0;
+    descRange.OffsetInDescriptorsFromTableStart = 0;
+
+    D3D12_ROOT_PARAMETER rootParameters[2];
+    rootParameters[0].ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
+    rootParameters[0].ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL;
+    rootParameters[0].DescriptorTable.NumDescriptorRanges = 1;
+    rootParameters[0].DescriptorTable.pDescriptorRanges = &descRange;
+    rootParameters[1].ParameterType = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;
+    rootParameters[1].ShaderVisibility = D3D12_SHADER_VISIBILITY_VERTEX;
+    rootParameters[1].Constants.Num32BitValues = 2;
+    rootParameters[1].Constants.ShaderRegister = 0; // b0
+    rootParameters[1].Constants.RegisterSpace = 0;
+
+    D3D12_ROOT_SIGNATURE_DESC desc = {};
+    desc.NumParameters = 2;
+    desc.pParameters = rootParameters;
+    desc.NumStaticSamplers = 1;
+    desc.pStaticSamplers = &sampler;
+    desc.Flags = D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT;
+
+    ComPtr<ID3DBlob> signature;
+    ComPtr<ID3DBlob> error;
+    if (FAILED(D3D12SerializeRootSignature(&desc, D3D_ROOT_SIGNATURE_VERSION_1, &signature, &error))) {
+        QByteArray msg;
+        if (error)
+            msg = QByteArray(static_cast<const char *>(error->GetBufferPointer()), int(error->GetBufferSize()));
+        qWarning("QD3D12SpriteBatcher: Failed to serialize root signature: %s", msg.constData());
+        return false;
+    }
+    if (FAILED(device->CreateRootSignature(0, signature->GetBufferPointer(), signature->GetBufferSize(),
+                                           IID_PPV_ARGS(&d->rootSignature)))) {
+        qWarning("QD3D12SpriteBatcher: Failed to create root signature");
+        return false;
+    }
+
+    D3D12_INPUT_ELEMENT_DESC inputElementDescs[] = {
+        { "RECT", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
+        { "UVRECT", 0, DXGI_FORMAT_R16G16B16A16_UNORM, 0, 16, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
+        { "COLOR", 0, DXGI_FORMAT_R8G8B8A8_UNORM, 0, 24, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
+        { "TEXINDEX", 0, DXGI_FORMAT_R32_UINT, 0, 28, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 }
+    };
+
+    D3D12_RASTERIZER_DESC rastDesc = {};
+    rastDesc.FillMode = D3D12_FILL_MODE_SOLID;
+    rastDesc.CullMode = D3D12_CULL_MODE_NONE;
+    rastDesc.DepthClipEnable = TRUE;
+
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC psoDesc = {};
+    psoDesc.InputLayout = { inputElementDescs, _countof(inputElementDescs) };
+    psoDesc.pRootSignature = d->rootSignature.Get();
+    psoDesc.VS.pShaderBytecode = g_VS_Sprite;
+    psoDesc.VS.BytecodeLength = sizeof(g_VS_Sprite);
+    psoDesc.PS.pShaderBytecode = g_PS_Sprite;
+    psoDesc.PS.BytecodeLength = sizeof(g_PS_Sprite);
+    psoDesc.RasterizerState = rastDesc;
+    psoDesc.DepthStencilState.DepthEnable = FALSE;
+    psoDesc.DepthStencilState.StencilEnable = FALSE;
+    psoDesc.SampleMask = UINT_MAX;
+    psoDesc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+    psoDesc.NumRenderTargets = 1;
+    psoDesc.RTVFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM;
+    psoDesc.DSVFormat = DXGI_FORMAT_D32_FLOAT;
+    psoDesc.SampleDesc = QD3D12Util::makeSampleDesc(device, DXGI_FORMAT_R8G8B8A8_UNORM, samples);
+
+    for (int mode = 0; mode < BlendModeCount; ++mode) {
+        D3D12_RENDER_TARGET_BLEND_DESC &blend(psoDesc.BlendState.RenderTarget[0]);
+        blend = D3D12_RENDER_TARGET_BLEND_DESC();
+        blend.RenderTargetWriteMask = D3D12_COLOR_WRITE_ENABLE_ALL;
+        blend.SrcBlend = D3D12_BLEND_ONE;
+        blend.DestBlend = D3D12_BLEND_ZERO;
+        blend.BlendOp = blend.BlendOpAlpha = D3D12_BLEND_OP_ADD;
+        blend.LogicOp = D3D12_LOGIC_OP_NOOP;
+        blend.SrcBlendAlpha = D3D12_BLEND_ONE;
+        blend.DestBlendAlpha = D3D12_BLEND_INV_SRC_ALPHA;
+        switch (mode) {
+        case Alpha:
+            blend.BlendEnable = TRUE;
+            blend.SrcBlend = D3D12_BLEND_SRC_ALPHA;
+            blend.DestBlend = D3D12_BLEND_INV_SRC_ALPHA;
+            break;
+        case PremultipliedAlpha:
+            blend.BlendEnable = TRUE;
+            blend.SrcBlend = D3D12_BLEND_ONE;
+            blend.DestBlend = D3D12_BLEND_INV_SRC_ALPHA;
+            break;
+        case Additive:
+            blend.BlendEnable = TRUE;
+            blend.SrcBlend = D3D12_BLEND_SRC_ALPHA;
+            blend.DestBlend = D3D12_BLEND_ONE;
+            blend.DestBlendAlpha = D3D12_BLEND_ONE;
+            break;
+        default:
+            break;
+        }
+        if (FAILED(device->CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(&d->pipelineStates[mode])))) {
+            qWarning("QD3D12SpriteBatcher: Failed to create pipeline state for blend mode %d", mode);
+            destroy();
+            return false;
+        }
+    }
+
+    D3D12_DESCRIPTOR_HEAP_DESC heapDesc = {};
+    heapDesc.NumDescriptors = d->maxTextures;
+    heapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+    heapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
+    if (FAILED(device->CreateDescriptorHeap(&heapDesc, IID_PPV_ARGS(&d->heap)))) {
+        qWarning("QD3D12SpriteBatcher: Failed to create descriptor heap");
+        destroy();
+        return false;
+    }
+
+    d->window = window;
+    d->device = device;
+    d->descriptorSize = device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+    clearTextures();
+    return true;
+}
+
+void QD3D12SpriteBatcher::destroy()
+{
+    Q_D(QD3D12SpriteBatcher);
+    d->heap.Reset();
+    d->maxTextures = 0;
+    d->textureCount = 0;
+    for (int mode = 0; mode < BlendModeCount; ++mode)
+        d->pipelineStates[mode].Reset();
+    d->rootSignature.Reset();
+    d->device.Reset();
+    d->window = Q_NULLPTR;
+    d->layers.clear();
+    d->currentLayer = Q_NULLPTR;
+    d->spriteCount = 0;
+    d->batchCount = 0;
+}
+
+bool QD3D12SpriteBatcher::isCreated() const
+{
+    Q_D(const QD3D12SpriteBatcher);
+    return d->heap.Get() != Q_NULLPTR;
+}
+
+int QD3D12SpriteBatcher::addTexture(ID3D12Resource *texture, DXGI_FORMAT format)
+{
+    Q_D(QD3D12SpriteBatcher);
+    if (!d->heap) {
+        qWarning("QD3D12SpriteBatcher: addTexture() called before create()");
+        return -1;
+    }
+    if (d->textureCount == d->maxTextures) {
+        qWarning("QD3D12SpriteBatcher: The texture table is full (%d textures)", d->maxTextures);
+        return -1;
+    }
+
+    const D3D12_RESOURCE_DESC desc = texture->GetDesc();
+    D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+    srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+    srvDesc.Format = format == DXGI_FORMAT_UNKNOWN ? desc.Format : format;
+    srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+    srvDesc.Texture2D.MipLevels = desc.MipLevels;
+
+    D3D12_CPU_DESCRIPTOR_HANDLE h = d->heap->GetCPUDescriptorHandleForHeapStart();
+    h.ptr += d->textureCount * d->descriptorSize;
+    d->device->CreateShaderResourceView(texture, &srvDesc, h);
+    return d->textureCount++;
+}
+
+int QD3D12SpriteBatcher::textureCount() const
+{
+    Q_D(const QD3D12SpriteBatcher);
+    return d->textureCount;
+}
+
+int QD3D12SpriteBatcher::maxTextureCount() const
+{
+    Q_D(const QD3D12SpriteBatcher);
+    return d->maxTextures;
+}
+
+void QD3D12SpriteBatcher::clearTextures()
+{
+    Q_D(QD3D12SpriteBatcher);
+    if (!d->heap)
+        return;
+
+    // Tier 1 hardware wants every descriptor of a bound table to be valid.
+    D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+    srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+    srvDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+    srvDesc.Texture2D.MipLevels = 1;
+    D3D12_CPU_DESCRIPTOR_HANDLE h = d->heap->GetCPUDescriptorHandleForHeapStart();
+    for (int i = 0; i < d->maxTextures; ++i, h.ptr += d->descriptorSize)
+        d->device->CreateShaderResourceView(Q_NULLPTR, &srvDesc, h);
+    d->textureCount = 0;
+}
+
+void QD3D12SpriteBatcher::begin(const QSize &viewportSize)
+{
+    Q_D(QD3D12SpriteBatcher);
+    d->pixelToClip[0] = 2.0f / qMax(1, viewportSize.width());
+    d->pixelToClip[1] = 2.0f / qMax(1, viewportSize.height());
+    for (QMap<int, QD3D12SpriteLayer>::iterator it = d->layers.begin(); it != d->layers.end(); ++it) {
+        for (int mode = 0; mode < BlendModeCount; ++mode)
+            it->sprites[mode].resize(0); // keeps the capacity
+    }
+    d->currentLayer = Q_NULLPTR;
+    d->spriteCount = 0;
+}
+
+// source is in normalized texture coordinates.
+void QD3D12SpriteBatcher::draw(const QRectF &rect, int texture, const QRectF &source,
+                               const QColor &color, BlendMode blend, int layer)
+{
+    Q_D(QD3D12SpriteBatcher);
+    if (texture < 0 || texture >= d->textureCount) {
+        qWarning("QD3D12SpriteBatcher: Invalid texture index %d", texture);
+        return;
+    }
+    d->append(rect, quint32(texture), source, color, blend, layer);
+}
+
+void QD3D12SpriteBatcher::fillRect(const QRectF &rect, const QColor &color, BlendMode blend, int layer)
+{
+    Q_D(QD3D12SpriteBatcher);
+    d->append(rect, NO_TEXTURE, QRectF(), color, blend, layer);
+}
+
+void QD3D12SpriteBatcher::end(ID3D12GraphicsCommandList *commandList)
+{
+    Q_D(QD3D12SpriteBatcher);
+    d->batchCount = 0;
+    if (!d->heap || !d->spriteCount)
+        return;
+    QD3D12StreamingBuffer *streamingBuffer = d->window->streamingBuffer();
+    if (!streamingBuffer)
+        return;
+
+    commandList->SetGraphicsRootSignature(d->rootSignature.Get());
+    ID3D12DescriptorHeap *heaps[] = { d->heap.Get() };
+    commandList->SetDescriptorHeaps(_countof(heaps), heaps);
+    commandList->SetGraphicsRootDescriptorTable(0, d->heap->GetGPUDescriptorHandleForHeapStart());
+    commandList->SetGraphicsRoot32BitConstants(1, 2, d->pixelToClip, 0);
+    commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
+
+    int boundMode = -1;
+    for (QMap<int, QD3D12SpriteLayer>::const_iterator it = d->layers.cbegin(); it != d->layers.cend(); ++it) {
+        for (int mode = 0; mode < BlendModeCount; ++mode) {
+            const QVector<QD3D12SpriteInstance> &sprites(it->sprites[mode]);
+            if (sprites.isEmpty())
+                continue;
+
+            // allocate() warns on overflow, the remaining sprites are dropped.
+            const quint32 size = sprites.count() * sizeof(QD3D12SpriteInstance);
+            const QD3D12StreamingBuffer::Range range = streamingBuffer->allocate(size);
+            if (range.isNull())
+                return;
+            QD3D12StreamingBuffer::streamCopy(range.data, sprites.constData(), size);
+
+            if (mode != boundMode) {
+                commandList->SetPipelineState(d->pipelineStates[mode].Get());
+                boundMode = mode;
+            }
+            const D3D12_VERTEX_BUFFER_VIEW view =
+                    QD3D12StreamingBuffer::vertexBufferView(range, sizeof(QD3D12SpriteInstance));
+            commandList->IASetVertexBuffers(0, 1, &view);
+            commandList->DrawInstanced(4, sprites.count(), 0, 0);
+            ++d->batchCount;
+        }
+    }
+}
+
+int QD3D12SpriteBatcher::spriteCount() const
+{
+    Q_D(const QD3D12SpriteBatcher);
+    return d->spriteCount;
+}
+
+// The number of draw calls made by the last end().
+int QD3D12SpriteBatcher::batchCount() const
+{
+    Q_D(const QD3D12SpriteBatcher);
+    return d->batchCount;
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,104 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtD3D12Window module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#ifndef QD3D12SPRITEBATCHER_H
+#define QD3D12SPRITEBATCHER_H
+
+#include <QtCore/QScopedPointer>
+#include <QtCore/QRectF>
+#include <QtGui/QColor>
+#include <QtD3D12Window/qd3d12window.h>
+
+QT_BEGIN_NAMESPACE
+
+class QD3D12SpriteBatcherPrivate;
+
+class QD3D12_EXPORT QD3D12SpriteBatcher
+{
+    Q_DECLARE_PRIVATE(QD3D12SpriteBatcher)
+
+public:
+    enum BlendMode {
+        Opaque,
+        Alpha,
+        PremultipliedAlpha,
+        Additive,
+        BlendModeCount
+    };
+
+    QD3D12SpriteBatcher();
+    ~QD3D12SpriteBatcher();
+
+    // The instances go into window->streamingBuffer(), so the window needs
+    // setStreamingBufferSize(), 32 bytes per sprite. The pipelines are for
+    // R8G8B8A8_UNORM targets with samples samples and a D32_FLOAT depth
+    // buffer, with depth testing disabled.
+    bool create(QD3D12Window *window, int samples = 1);
+    void destroy();
+    bool isCreated() const;
+
+    // Textures are registered once, in the PIXEL_SHADER_RESOURCE state, and
+    // then referred to by the returned index. Returns -1 when the table is
+    // full.
+    int addTexture(ID3D12Resource *texture, DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN);
+    int textureCount() const;
+    int maxTextureCount() const;
+    // Only call this when the GPU is not using the table anymore.
+    void clearTextures();
+
+    // Coordinates are in pixels of a viewport of size viewportSize, with the
+    // origin at the top left.
+    void begin(const QSize &viewportSize);
+    void draw(const QRectF &rect, int texture, const QRectF &source = QRectF(0, 0, 1, 1),
+              const QColor &color = Qt::white, BlendMode blend = Alpha, int layer = 0);
+    void fillRect(const QRectF &rect, const QColor &color, BlendMode blend = Alpha, int layer = 0);
+    // Records the sprites. The render target, viewport and scissor must be
+    // set already, this sets the root signature, descriptor heap and
+    // pipeline states.
+    void end(ID3D12GraphicsCommandList *commandList);
+
+    int spriteCount() const;
+    int batchCount() const;
+
+private:
+    Q_DISABLE_COPY(QD3D12SpriteBatcher)
+    QScopedPointer<QD3D12SpriteBatcherPrivate> d_ptr;
+};
+
+QT_END_NAMESPACE
+
+#endif
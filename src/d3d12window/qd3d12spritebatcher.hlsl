@@ -0,0 +1,51 @@
+// Sprites for QD3D12SpriteBatcher. Each instance is one quad, expanded from
+// SV_VertexID into a 4 vertex triangle strip, so the instance data is the
+// only vertex input. Textures come from one bindless table, so sprites with
+// different textures still share a draw call.
+
+Texture2D textures[] : register(t0);
+SamplerState linearClamp : register(s0);
+
+cbuffer SpriteConstants : register(b0)
+{
+    float2 pixelToClip; // 2 / viewport size
+}
+
+static const uint NO_TEXTURE = 0xFFFFFFFF;
+
+struct VSInput
+{
+    float4 rect : RECT; // x, y, width and height in pixels, y down
+    float4 uvRect : UVRECT; // left, top, right, bottom
+    float4 color : COLOR;
+    uint texIndex : TEXINDEX;
+    uint vertexId : SV_VertexID;
+};
+
+struct PSInput
+{
+    float4 position : SV_POSITION;
+    float2 uv : TEXCOORD0;
+    float4 color : COLOR;
+    nointerpolation uint texIndex : TEXINDEX;
+};
+
+PSInput VS_Sprite(VSInput input)
+{
+    const float2 corner = float2(input.vertexId & 1, input.vertexId >> 1);
+    const float2 pos = input.rect.xy + corner * input.rect.zw;
+
+    PSInput output;
+    output.position = float4(pos.x * pixelToClip.x - 1.0, 1.0 - pos.y * pixelToClip.y, 0.0, 1.0);
+    output.uv = lerp(input.uvRect.xy, input.uvRect.zw, corner);
+    output.color = input.color;
+    output.texIndex = input.texIndex;
+    return output;
+}
+
+float4 PS_Sprite(PSInput input) : SV_TARGET
+{
+    if (input.texIndex == NO_TEXTURE)
+        return input.color;
+    return input.color * textures[NonUniformResourceIndex(input.texIndex)].Sample(linearClamp, input.uv);
+}
@@ -0,0 +1,118 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtD3D12Window module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#ifndef QD3D12SPRITEBATCHER_P_H
+#define QD3D12SPRITEBATCHER_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "qd3d12spritebatcher.h"
+#include <QtCore/QMap>
+#include <QtCore/QSize>
+#include <QtCore/QVector>
+
+QT_BEGIN_NAMESPACE
+
+// The per-instance vertex data, see qd3d12spritebatcher.hlsl.
+struct QD3D12SpriteInstance
+{
+    float rect[4];
+    quint16 uvRect[4]; // UNORM
+    quint32 color; // R8G8B8A8_UNORM
+    quint32 texture;
+};
+
+// Sprites are bucketed on the fly, one bucket per blend mode, so that end()
+// has nothing left to sort.
+struct QD3D12SpriteLayer
+{
+    QVector<QD3D12SpriteInstance> sprites[QD3D12SpriteBatcher::BlendModeCount];
+};
+
+class QD3D12SpriteBatcherPrivate
+{
+public:
+    QD3D12SpriteBatcherPrivate()
+        : window(Q_NULLPTR),
+          descriptorSize(0),
+          maxTextures(0),
+          textureCount(0),
+          currentLayerId(0),
+          currentLayer(Q_NULLPTR),
+          spriteCount(0),
+          batchCount(0)
+    {
+        pixelToClip[0] = pixelToClip[1] = 0.0f;
+    }
+
+    void append(const QRectF &rect, quint32 texture, const QRectF &source, const QColor &color,
+                QD3D12SpriteBatcher::BlendMode blend, int layer);
+
+    QD3D12Window *window;
+    ComPtr<ID3D12Device> device;
+    ComPtr<ID3D12RootSignature> rootSignature;
+    ComPtr<ID3D12PipelineState> pipelineStates[QD3D12SpriteBatcher::BlendModeCount];
+
+    // The bindless texture table.
+    ComPtr<ID3D12DescriptorHeap> heap;
+    UINT descriptorSize;
+    int maxTextures;
+    int textureCount;
+
+    // Buckets keep their capacity across frames. Map nodes do not move, so
+    // the bucket of the last layer used can be cached.
+    QMap<int, QD3D12SpriteLayer> layers;
+    int currentLayerId;
+    QD3D12SpriteLayer *currentLayer;
+    float pixelToClip[2];
+
+    int spriteCount;
+    int batchCount;
+};
+
+QT_END_NAMESPACE
+
+#endif
@@ -0,0 +1,753 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtD3D12Window module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qd3d12staticresources_p.h"
+#include "qd3d12cpumipmapgenerator.h"
+#include "qd3d12formatinfo.h"
+#include "qd3d12util_p.h"
+#include <QtCore/QDataStream>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QRunnable>
+#include <QtCore/QSaveFile>
+#include <QtCore/QThread>
+#include <QtGui/QImage>
+
+QT_BEGIN_NAMESPACE
+
+static const quint32 PIPELINE_CACHE_MAGIC = 0x51443350; // QD3P
+static const quint32 PIPELINE_CACHE_VERSION = 1;
+
+D3D12_GRAPHICS_PIPELINE_STATE_DESC QD3D12ShadowPipeline::makeGraphicsDesc(ID3D12RootSignature *rs) const
+{
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC desc = graphicsDesc;
+    desc.pRootSignature = rs;
+    D3D12_SHADER_BYTECODE *bytecode[] = { &desc.VS, &desc.PS, &desc.DS, &desc.HS, &desc.GS };
+    for (int i = 0; i < 5; ++i) {
+        bytecode[i]->pShaderBytecode = stages[i].isEmpty() ? Q_NULLPTR : stages[i].constData();
+        bytecode[i]->BytecodeLength = stages[i].size();
+    }
+    // The semantic names point into semanticNames, which is never modified.
+    desc.InputLayout.pInputElementDescs = inputElements.constData();
+    desc.InputLayout.NumElements = inputElements.count();
+    desc.StreamOutput = D3D12_STREAM_OUTPUT_DESC();
+    desc.CachedPSO = D3D12_CACHED_PIPELINE_STATE();
+    return desc;
+}
+
+D3D12_COMPUTE_PIPELINE_STATE_DESC QD3D12ShadowPipeline::makeComputeDesc(ID3D12RootSignature *rs) const
+{
+    D3D12_COMPUTE_PIPELINE_STATE_DESC desc = computeDesc;
+    desc.pRootSignature = rs;
+    desc.CS.pShaderBytecode = stages[0].constData();
+    desc.CS.BytecodeLength = stages[0].size();
+    desc.CachedPSO = D3D12_CACHED_PIPELINE_STATE();
+    return desc;
+}
+
+namespace {
+
+class QD3D12PipelineJob : public QRunnable
+{
+public:
+    QD3D12PipelineJob(ID3D12Device *device, QD3D12ShadowPipeline *pipeline, ID3D12RootSignature *rs)
+        : device(device), pipeline(pipeline), rs(rs)
+    { }
+
+    void run() Q_DECL_OVERRIDE;
+    HRESULT create(const D3D12_CACHED_PIPELINE_STATE &cached);
+
+    ID3D12Device *device;
+    QD3D12ShadowPipeline *pipeline;
+    ID3D12RootSignature *rs;
+};
+
+} // namespace
+
+HRESULT QD3D12PipelineJob::create(const D3D12_CACHED_PIPELINE_STATE &cached)
+{
+    if (pipeline->compute) {
+        D3D12_COMPUTE_PIPELINE_STATE_DESC desc = pipeline->makeComputeDesc(rs);
+        desc.CachedPSO = cached;
+        return device->CreateComputePipelineState(&desc, IID_PPV_ARGS(&pipeline->object));
+    }
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC desc = pipeline->makeGraphicsDesc(rs);
+    desc.CachedPSO = cached;
+    return device->CreateGraphicsPipelineState(&desc, IID_PPV_ARGS(&pipeline->object));
+}
+
+void QD3D12PipelineJob::run()
+{
+    D3D12_CACHED_PIPELINE_STATE cached = {};
+    if (!pipeline->cachedBlob.isEmpty()) {
+        cached.pCachedBlob = pipeline->cachedBlob.constData();
+        cached.CachedBlobSizeInBytes = pipeline->cachedBlob.size();
+        // A driver update or a different adapter invalidates the blob.
+        if (FAILED(create(cached))) {
+            pipeline->cachedBlob.clear();
+            cached = D3D12_CACHED_PIPELINE_STATE();
+        }
+    }
+
+    if (!pipeline->object) {
+        HRESULT hr = create(cached);
+        if (FAILED(hr)) {
+            qWarning("Failed to create pipeline state: 0x%x", hr);
+            return;
+        }
+    }
+
+    if (pipeline->cachedBlob.isEmpty()) {
+        ComPtr<ID3DBlob> blob;
+        if (SUCCEEDED(pipeline->object->GetCachedBlob(&blob))) {
+            pipeline->cachedBlob = QByteArray(static_cast<const char *>(blob->GetBufferPointer()),
+                                              int(blob->GetBufferSize()));
+            pipeline->blobUpdated = true;
+        }
+    }
+}
+
+namespace {
+
+class QD3D12ResourceJob : public QRunnable
+{
+public:
+    QD3D12ResourceJob(ID3D12Device *device, const D3D12_HEAP_PROPERTIES *umaHeap, QD3D12ShadowResource *resource)
+        : device(device), umaHeap(umaHeap), resource(resource)
+    { }
+
+    void run() Q_DECL_OVERRIDE;
+    bool write();
+
+    ID3D12Device *device;
+    const D3D12_HEAP_PROPERTIES *umaHeap;
+    QD3D12ShadowResource *resource;
+};
+
+} // namespace
+
+// Copies the tightly packed rows of each subresource to their place in a
+// buffer laid out according to layouts. Short data fails the whole resource
+// rather than leaving undefined contents behind.
+static bool copySubresources(const QD3D12ShadowResource *resource, const D3D12_PLACED_SUBRESOURCE_FOOTPRINT *layouts,
+                             const UINT *numRows, const UINT64 *rowSizes, quint8 *p)
+{
+    for (int i = 0; i < resource->subresources.count(); ++i) {
+        const D3D12_PLACED_SUBRESOURCE_FOOTPRINT &layout(layouts[i]);
+        const UINT rows = numRows[i] * layout.Footprint.Depth;
+        const quint64 rowSize = rowSizes[i];
+        const QByteArray &data(resource->subresources[i]);
+        if (quint64(data.size()) < rows * rowSize) {
+            qWarning("Static resource subresource %d has %d bytes, expected %llu", i, data.size(), rows * rowSize);
+            return false;
+        }
+        const char *src = data.constData();
+        quint8 *dst = p + layout.Offset;
+        for (UINT y = 0; y < rows; ++y) {
+            memcpy(dst, src, rowSize);
+            src += rowSize;
+            dst += layout.Footprint.RowPitch;
+        }
+    }
+    return true;
+}
+
+// The data goes straight into a CPU writable resource, no upload buffer and
+// no copy on the GPU.
+bool QD3D12ResourceJob::write()
+{
+    if (FAILED(device->CreateCommittedResource(umaHeap, D3D12_HEAP_FLAG_NONE, &resource->desc,
+                                               D3D12_RESOURCE_STATE_COMMON, Q_NULLPTR, IID_PPV_ARGS(&resource->object)))) {
+        qWarning("Failed to create static resource");
+        return false;
+    }
+
+    if (resource->desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER) {
+        const QByteArray &data(resource->subresources.first());
+        quint8 *p = Q_NULLPTR;
+        D3D12_RANGE readRange = { 0, 0 };
+        if (FAILED(resource->object->Map(0, &readRange, reinterpret_cast<void **>(&p)))) {
+            qWarning("Map failed (static buffer)");
+            resource->object = Q_NULLPTR;
+            return false;
+        }
+        memcpy(p, data.constData(), qMin<quint64>(data.size(), resource->desc.Width));
+        resource->object->Unmap(0, Q_NULLPTR);
+        return true;
+    }
+
+    // The tightly packed subresources are laid out like an upload buffer
+    // first, so that they can go through the common write helper.
+    const int count = resource->subresources.count();
+    QVector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> layouts(count);
+    QVector<UINT> numRows(count);
+    QVector<UINT64> rowSizes(count);
+    UINT64 totalSize = 0;
+    if (!QD3D12FormatInfo::copyableFootprints(resource->desc, 0, count, 0, layouts.data(),
+                                              numRows.data(), rowSizes.data(), &totalSize)) {
+        qWarning("Static resource has an invalid format or %d subresources that do not match its description", count);
+        resource->object = Q_NULLPTR;
+        return false;
+    }
+    QByteArray staging(int(totalSize), Qt::Uninitialized);
+    if (!copySubresources(resource, layouts.constData(), numRows.constData(), rowSizes.constData(),
+                          reinterpret_cast<quint8 *>(staging.data()))
+            || !QD3D12Util::writeSubresources(resource->object.Get(), reinterpret_cast<const quint8 *>(staging.constData()),
+                                              layouts.constData(), count)) {
+        resource->object = Q_NULLPTR;
+        return false;
+    }
+    return true;
+}
+
+void QD3D12ResourceJob::run()
+{
+    resource->written = false;
+    if (umaHeap) {
+        resource->written = write();
+        if (resource->written)
+            return;
+        // Try again through an upload buffer and a copy on the GPU.
+    }
+
+    // Creating resources and filling mapped upload buffers is safe from any
+    // thread. Only the copy commands are recorded on the GUI thread.
+    D3D12_HEAP_PROPERTIES defaultHeapProp = {};
+    defaultHeapProp.Type = D3D12_HEAP_TYPE_DEFAULT;
+    if (FAILED(device->CreateCommittedResource(&defaultHeapProp, D3D12_HEAP_FLAG_NONE, &resource->desc,
+                                               D3D12_RESOURCE_STATE_COPY_DEST, Q_NULLPTR, IID_PPV_ARGS(&resource->object)))) {
+        qWarning("Failed to create static resource");
+        return;
+    }
+
+    const int count = resource->subresources.count();
+    resource->layouts.resize(count);
+    QVector<UINT> numRows(count);
+    QVector<UINT64> rowSizes(count);
+    UINT64 totalSize = 0;
+    device->GetCopyableFootprints(&resource->desc, 0, count, 0, resource->layouts.data(),
+                                  numRows.data(), rowSizes.data(), &totalSize);
+
+    D3D12_HEAP_PROPERTIES uploadHeapProp = {};
+    uploadHeapProp.Type = D3D12_HEAP_TYPE_UPLOAD;
+
+    D3D12_RESOURCE_DESC bufDesc = {};
+    bufDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+    bufDesc.Width = totalSize;
+    bufDesc.Height = 1;
+    bufDesc.DepthOrArraySize = 1;
+    bufDesc.MipLevels = 1;
+    bufDesc.Format = DXGI_FORMAT_UNKNOWN;
+    bufDesc.SampleDesc.Count = 1;
+    bufDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+
+    if (FAILED(device->CreateCommittedResource(&uploadHeapProp, D3D12_HEAP_FLAG_NONE, &bufDesc,
+                                               D3D12_RESOURCE_STATE_GENERIC_READ, Q_NULLPTR, IID_PPV_ARGS(&resource->upload)))) {
+        qWarning("Failed to create upload buffer for static resource");
+        resource->object = Q_NULLPTR;
+        return;
+    }
+
+    quint8 *p = Q_NULLPTR;
+    D3D12_RANGE readRange = { 0, 0 };
+    if (FAILED(resource->upload->Map(0, &readRange, reinterpret_cast<void **>(&p)))) {
+        qWarning("Map failed (static resource upload buffer)");
+        resource->object = Q_NULLPTR;
+        resource->upload = Q_NULLPTR;
+        return;
+    }
+
+    const bool copied = copySubresources(resource, resource->layouts.constData(), numRows.constData(),
+                                         rowSizes.constData(), p);
+    resource->upload->Unmap(0, Q_NULLPTR);
+    if (!copied) {
+        resource->object = Q_NULLPTR;
+        resource->upload = Q_NULLPTR;
+    }
+}
+
+QD3D12StaticResourcesPrivate::~QD3D12StaticResourcesPrivate()
+{
+}
+
+void QD3D12StaticResourcesPrivate::initializeResources()
+{
+    Q_Q(QD3D12StaticResources);
+    if (!q->isEmpty())
+        q->create();
+}
+
+void QD3D12StaticResourcesPrivate::releaseResources()
+{
+    pool.waitForDone();
+
+    for (int i = 0; i < rootSignatures.count(); ++i)
+        rootSignatures[i].object = Q_NULLPTR;
+    for (int i = 0; i < pipelines.count(); ++i)
+        pipelines[i].object = Q_NULLPTR;
+    for (int i = 0; i < resources.count(); ++i) {
+        resources[i].object = Q_NULLPTR;
+        resources[i].upload = Q_NULLPTR;
+    }
+}
+
+bool QD3D12StaticResourcesPrivate::loadPipelineCache()
+{
+    QFile f(cacheFileName);
+    if (!f.open(QIODevice::ReadOnly))
+        return false;
+
+    QDataStream ds(&f);
+    quint32 magic = 0, version = 0;
+    ds >> magic >> version;
+    if (magic != PIPELINE_CACHE_MAGIC || version != PIPELINE_CACHE_VERSION) {
+        qWarning("Ignoring pipeline cache %s: unknown format", qPrintable(cacheFileName));
+        return false;
+    }
+
+    QHash<QByteArray, QByteArray> blobs;
+    ds >> blobs;
+    if (ds.status() != QDataStream::Ok) {
+        qWarning("Ignoring pipeline cache %s: corrupt", qPrintable(cacheFileName));
+        return false;
+    }
+
+    cachedBlobs.swap(blobs);
+    return true;
+}
+
+// Keeps what is needed to rebuild root signatures, pipeline states, static
+// buffers and textures on the CPU, so that recovering from device loss does
+// not have to decode images or compile pipelines on the GUI thread again.
+// Everything registered is rebuilt on worker threads before initializeD3D()
+// is invoked for the new device; initializeD3D() then only fetches the
+// objects by id. With setPipelineCacheFileName() the driver's compiled
+// pipelines are also kept across runs.
+QD3D12StaticResources::QD3D12StaticResources(QD3D12Window *window)
+    : QObject(*(new QD3D12StaticResourcesPrivate), window)
+{
+    Q_D(QD3D12StaticResources);
+    d->window = window;
+    QD3D12WindowPrivate::get(window)->frameObservers.append(d);
+}
+
+QD3D12StaticResources::~QD3D12StaticResources()
+{
+    Q_D(QD3D12StaticResources);
+    d->pool.waitForDone();
+    if (d->cacheDirty)
+        savePipelineCache();
+    QD3D12WindowPrivate::get(d->window)->frameObservers.removeOne(d);
+}
+
+// Blobs from the file are used for pipelines registered afterwards. Relative
+// paths are resolved against the current directory.
+void QD3D12StaticResources::setPipelineCacheFileName(const QString &fileName)
+{
+    Q_D(QD3D12StaticResources);
+    d->cacheFileName = fileName;
+    d->cachedBlobs.clear();
+    d->cacheDirty = false;
+    if (!fileName.isEmpty())
+        d->loadPipelineCache();
+}
+
+QString QD3D12StaticResources::pipelineCacheFileName() const
+{
+    Q_D(const QD3D12StaticResources);
+    return d->cacheFileName;
+}
+
+bool QD3D12StaticResources::savePipelineCache()
+{
+    Q_D(QD3D12StaticResources);
+    if (d->cacheFileName.isEmpty())
+        return false;
+
+    foreach (const QD3D12ShadowPipeline &p, d->pipelines) {
+        if (!p.cachedBlob.isEmpty())
+            d->cachedBlobs.insert(p.key, p.cachedBlob);
+    }
+
+    QDir().mkpath(QFileInfo(d->cacheFileName).absolutePath());
+    QSaveFile f(d->cacheFileName);
+    if (!f.open(QIODevice::WriteOnly)) {
+        qWarning("Failed to write pipeline cache %s", qPrintable(d->cacheFileName));
+        return false;
+    }
+    QDataStream ds(&f);
+    ds << PIPELINE_CACHE_MAGIC << PIPELINE_CACHE_VERSION << d->cachedBlobs;
+    if (!f.commit()) {
+        qWarning("Failed to write pipeline cache %s", qPrintable(d->cacheFileName));
+        return false;
+    }
+
+    d->cacheDirty = false;
+    return true;
+}
+
+int QD3D12StaticResources::addRootSignature(const D3D12_ROOT_SIGNATURE_DESC &desc)
+{
+    Q_D(QD3D12StaticResources);
+
+    ComPtr<ID3DBlob> signature;
+    ComPtr<ID3DBlob> error;
+    if (FAILED(D3D12SerializeRootSignature(&desc, D3D_ROOT_SIGNATURE_VERSION_1, &signature, &error))) {
+        QByteArray msg;
+        if (error)
+            msg = QByteArray(static_cast<const char *>(error->GetBufferPointer()), int(error->GetBufferSize()));
+        qWarning("Failed to serialize root signature: %s", msg.constData());
+        return -1;
+    }
+
+    QD3D12ShadowRootSignature rs;
+    rs.blob = QByteArray(static_cast<const char *>(signature->GetBufferPointer()), int(signature->GetBufferSize()));
+    d->rootSignatures.append(rs);
+    return d->rootSignatures.count() - 1;
+}
+
+// The description is copied, including the bytecode and the input layout.
+// pRootSignature is ignored, the root signature comes from rootSignatureId.
+int QD3D12StaticResources::addGraphicsPipeline(const D3D12_GRAPHICS_PIPELINE_STATE_DESC &desc, int rootSignatureId)
+{
+    Q_D(QD3D12StaticResources);
+    if (rootSignatureId < 0 || rootSignatureId >= d->rootSignatures.count()) {
+        qWarning("addGraphicsPipeline: Invalid root signature %d", rootSignatureId);
+        return -1;
+    }
+    if (desc.StreamOutput.NumEntries)
+        qWarning("addGraphicsPipeline: Stream output is not supported and will be ignored");
+
+    QD3D12ShadowPipeline p;
+    p.rootSignature = rootSignatureId;
+    p.graphicsDesc = desc;
+    const D3D12_SHADER_BYTECODE *bytecode[] = { &desc.VS, &desc.PS, &desc.DS, &desc.HS, &desc.GS };
+    for (int i = 0; i < 5; ++i) {
+        if (bytecode[i]->BytecodeLength)
+            p.stages[i] = QByteArray(static_cast<const char *>(bytecode[i]->pShaderBytecode), int(bytecode[i]->BytecodeLength));
+    }
+    p.semanticNames.reserve(desc.InputLayout.NumElements);
+    for (UINT i = 0; i < desc.InputLayout.NumElements; ++i)
+        p.semanticNames.append(QByteArray(desc.InputLayout.pInputElementDescs[i].SemanticName));
+    for (UINT i = 0; i < desc.InputLayout.NumElements; ++i) {
+        D3D12_INPUT_ELEMENT_DESC e = desc.InputLayout.pInputElementDescs[i];
+        e.SemanticName = p.semanticNames[i].constData();
+        p.inputElements.append(e);
+    }
+    p.key = QD3D12Util::pipelineKey(p.makeGraphicsDesc(Q_NULLPTR), d->rootSignatures[rootSignatureId].blob);
+    p.cachedBlob = d->cachedBlobs.value(p.key);
+
+    d->pipelines.append(p);
+    return d->pipelines.count() - 1;
+}
+
+int QD3D12StaticResources::addComputePipeline(const D3D12_COMPUTE_PIPELINE_STATE_DESC &desc, int rootSignatureId)
+{
+    Q_D(QD3D12StaticResources);
+    if (rootSignatureId < 0 || rootSignatureId >= d->rootSignatures.count()) {
+        qWarning("addComputePipeline: Invalid root signature %d", rootSignatureId);
+        return -1;
+    }
+
+    QD3D12ShadowPipeline p;
+    p.compute = true;
+    p.rootSignature = rootSignatureId;
+    p.computeDesc = desc;
+    p.stages[0] = QByteArray(static_cast<const char *>(desc.CS.pShaderBytecode), int(desc.CS.BytecodeLength));
+    p.key = QD3D12Util::pipelineKey(p.makeComputeDesc(Q_NULLPTR), d->rootSignatures[rootSignatureId].blob);
+    p.cachedBlob = d->cachedBlobs.value(p.key);
+
+    d->pipelines.append(p);
+    return d->pipelines.count() - 1;
+}
+
+// A buffer in a default heap, initialized with a copy of data.
+int QD3D12StaticResources::addBuffer(const void *data, quint32 size, D3D12_RESOURCE_STATES state)
+{
+    Q_D(QD3D12StaticResources);
+
+    QD3D12ShadowResource r;
+    r.desc = D3D12_RESOURCE_DESC();
+    r.desc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+    r.desc.Width = size;
+    r.desc.Height = 1;
+    r.desc.DepthOrArraySize = 1;
+    r.desc.MipLevels = 1;
+    r.desc.Format = DXGI_FORMAT_UNKNOWN;
+    r.desc.SampleDesc.Count = 1;
+    r.desc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+    r.subresources.append(QByteArray(static_cast<const char *>(data), int(size)));
+    r.state = state;
+
+    d->resources.append(r);
+    return d->resources.count() - 1;
+}
+
+// subresources holds the data for each subresource in the usual D3D12
+// order, with rows (or rows of blocks for compressed formats) tightly
+// packed.
+int QD3D12StaticResources::addTexture(const D3D12_RESOURCE_DESC &desc, const QVector<QByteArray> &subresources,
+                                      D3D12_RESOURCE_STATES state)
+{
+    Q_D(QD3D12StaticResources);
+    if (subresources.isEmpty()) {
+        qWarning("addTexture: No data");
+        return -1;
+    }
+
+    QD3D12ShadowResource r;
+    r.desc = desc;
+    r.subresources = subresources;
+    r.state = state;
+
+    d->resources.append(r);
+    return d->resources.count() - 1;
+}
+
+// An RGBA8 texture from image. The mip chain is generated here when
+// mipLevels is greater than 1, 0 means a full chain.
+int QD3D12StaticResources::addImage(const QImage &image, int mipLevels, D3D12_RESOURCE_STATES state)
+{
+    if (image.isNull()) {
+        qWarning("addImage: Null image");
+        return -1;
+    }
+
+    const QImage img = image.convertToFormat(QImage::Format_RGBA8888);
+    int w = img.width();
+    int h = img.height();
+    if (mipLevels <= 0) {
+        mipLevels = 1;
+        for (int s = qMax(w, h); s > 1; s >>= 1)
+            ++mipLevels;
+    }
+
+    D3D12_RESOURCE_DESC desc = {};
+    desc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+    desc.Width = w;
+    desc.Height = h;
+    desc.DepthOrArraySize = 1;
+    desc.MipLevels = mipLevels;
+    desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    desc.SampleDesc.Count = 1;
+    desc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
+
+    // Tightly packed levels in one block, then split per subresource.
+    QVector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> layouts(mipLevels);
+    quint64 size = 0;
+    for (int level = 0; level < mipLevels; ++level) {
+        layouts[level].Offset = size;
+        layouts[level].Footprint.Format = desc.Format;
+        layouts[level].Footprint.Width = w;
+        layouts[level].Footprint.Height = h;
+        layouts[level].Footprint.Depth = 1;
+        layouts[level].Footprint.RowPitch = w * 4;
+        size += w * h * 4;
+        w = qMax(1, w / 2);
+        h = qMax(1, h / 2);
+    }
+    QByteArray chain(int(size), Qt::Uninitialized);
+    // The image is sRGB encoded, filter the levels accordingly.
+    QD3D12CpuMipmapGenerator::generate(img.constBits(), img.bytesPerLine(), img.size(), DXGI_FORMAT_R8G8B8A8_UNORM_SRGB,
+                                       reinterpret_cast<quint8 *>(chain.data()), layouts.constData(), mipLevels);
+
+    QVector<QByteArray> subresources;
+    for (int level = 0; level < mipLevels; ++level) {
+        const D3D12_SUBRESOURCE_FOOTPRINT &f(layouts[level].Footprint);
+        subresources.append(chain.mid(int(layouts[level].Offset), f.RowPitch * f.Height));
+    }
+
+    return addTexture(desc, subresources, state);
+}
+
+bool QD3D12StaticResources::isEmpty() const
+{
+    Q_D(const QD3D12StaticResources);
+    return d->rootSignatures.isEmpty() && d->pipelines.isEmpty() && d->resources.isEmpty();
+}
+
+// Creates everything registered that does not exist yet. Pipeline states and
+// resources are created in parallel, then all uploads are submitted in a
+// single command list. Blocks until the GPU has finished the copies.
+bool QD3D12StaticResources::create()
+{
+    Q_D(QD3D12StaticResources);
+
+    ID3D12Device *device = d->window->device();
+    if (!device) {
+        qWarning("QD3D12StaticResources: No device");
+        return false;
+    }
+
+    QD3D12_TRACE_SCOPE("static resources");
+
+    bool ok = true;
+
+    for (int i = 0; i < d->rootSignatures.count(); ++i) {
+        QD3D12ShadowRootSignature &rs(d->rootSignatures[i]);
+        if (rs.object)
+            continue;
+        if (FAILED(device->CreateRootSignature(0, rs.blob.constData(), rs.blob.size(), IID_PPV_ARGS(&rs.object)))) {
+            qWarning("Failed to create root signature %d", i);
+            ok = false;
+        }
+    }
+
+    d->pool.setMaxThreadCount(qMax(2, QThread::idealThreadCount()));
+
+    for (int i = 0; i < d->pipelines.count(); ++i) {
+        QD3D12ShadowPipeline *p = &d->pipelines[i];
+        if (p->object)
+            continue;
+        ID3D12RootSignature *rs = d->rootSignatures[p->rootSignature].object.Get();
+        if (!rs) {
+            ok = false;
+            continue;
+        }
+        d->pool.start(new QD3D12PipelineJob(device, p, rs));
+    }
+
+    D3D12_HEAP_PROPERTIES umaHeapProp;
+    const bool uma = QD3D12Util::umaHeapProperties(device, &umaHeapProp);
+    QVector<QD3D12ShadowResource *> uploads;
+    for (int i = 0; i < d->resources.count(); ++i) {
+        QD3D12ShadowResource *r = &d->resources[i];
+        if (r->object)
+            continue;
+        uploads.append(r);
+        d->pool.start(new QD3D12ResourceJob(device, uma ? &umaHeapProp : Q_NULLPTR, r));
+    }
+
+    d->pool.waitForDone();
+
+    for (int i = 0; i < d->pipelines.count(); ++i) {
+        QD3D12ShadowPipeline &p(d->pipelines[i]);
+        if (!p.object)
+            ok = false;
+        if (p.blobUpdated) {
+            p.blobUpdated = false;
+            d->cacheDirty = true;
+        }
+    }
+
+    ComPtr<ID3D12CommandAllocator> allocator;
+    ComPtr<ID3D12GraphicsCommandList> commandList;
+    bool recorded = false;
+    foreach (QD3D12ShadowResource *r, uploads) {
+        if (!r->object || (!r->upload && !r->written)) {
+            ok = false;
+            continue;
+        }
+        if (!commandList) {
+            if (FAILED(device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&allocator)))) {
+                qWarning("Failed to create command allocator");
+                return false;
+            }
+            if (FAILED(device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, allocator.Get(), Q_NULLPTR,
+                                                 IID_PPV_ARGS(&commandList)))) {
+                qWarning("Failed to create command list");
+                return false;
+            }
+        }
+
+        if (r->written) {
+            if (r->state != D3D12_RESOURCE_STATE_COMMON)
+                QD3D12Util::transitionResource(r->object.Get(), commandList.Get(), D3D12_RESOURCE_STATE_COMMON, r->state);
+            recorded = true;
+            continue;
+        }
+        if (r->desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER) {
+            commandList->CopyBufferRegion(r->object.Get(), 0, r->upload.Get(), 0, r->desc.Width);
+        } else {
+            for (int i = 0; i < r->layouts.count(); ++i) {
+                D3D12_TEXTURE_COPY_LOCATION dstLoc;
+                dstLoc.pResource = r->object.Get();
+                dstLoc.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+                dstLoc.SubresourceIndex = i;
+                D3D12_TEXTURE_COPY_LOCATION srcLoc;
+                srcLoc.pResource = r->upload.Get();
+                srcLoc.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
+                srcLoc.PlacedFootprint = r->layouts[i];
+                commandList->CopyTextureRegion(&dstLoc, 0, 0, 0, &srcLoc, Q_NULLPTR);
+            }
+        }
+        if (r->state != D3D12_RESOURCE_STATE_COPY_DEST)
+            QD3D12Util::transitionResource(r->object.Get(), commandList.Get(), D3D12_RESOURCE_STATE_COPY_DEST, r->state);
+        recorded = true;
+    }
+
+    if (recorded) {
+        commandList->Close();
+        ID3D12CommandList *commandLists[] = { commandList.Get() };
+        d->window->commandQueue()->ExecuteCommandLists(_countof(commandLists), commandLists);
+        QScopedPointer<QD3D12Window::Fence> f(QD3D12Util::createFence(device));
+        QD3D12Util::waitForGPU(d->window->commandQueue(), f.data());
+    }
+
+    foreach (QD3D12ShadowResource *r, uploads) {
+        r->upload = Q_NULLPTR;
+        r->layouts.clear();
+    }
+
+    if (d->cacheDirty)
+        savePipelineCache();
+
+    return ok;
+}
+
+ID3D12RootSignature *QD3D12StaticResources::rootSignature(int rootSignatureId) const
+{
+    Q_D(const QD3D12StaticResources);
+    return rootSignatureId >= 0 && rootSignatureId < d->rootSignatures.count()
+            ? d->rootSignatures[rootSignatureId].object.Get() : Q_NULLPTR;
+}
+
+ID3D12PipelineState *QD3D12StaticResources::pipelineState(int pipelineId) const
+{
+    Q_D(const QD3D12StaticResources);
+    return pipelineId >= 0 && pipelineId < d->pipelines.count()
+            ? d->pipelines[pipelineId].object.Get() : Q_NULLPTR;
+}
+
+ID3D12Resource *QD3D12StaticResources::resource(int resourceId) const
+{
+    Q_D(const QD3D12StaticResources);
+    return resourceId >= 0 && resourceId < d->resources.count()
+            ? d->resources[resourceId].object.Get() : Q_NULLPTR;
+}
+
+QT_END_NAMESPACE
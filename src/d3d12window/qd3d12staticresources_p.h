@@ -0,0 +1,131 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtD3D12Window module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QD3D12STATICRESOURCES_P_H
+#define QD3D12STATICRESOURCES_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "qd3d12staticresources.h"
+#include "qd3d12window_p.h"
+#include <QtCore/QHash>
+#include <QtCore/QThreadPool>
+#include <QtCore/private/qobject_p.h>
+
+QT_BEGIN_NAMESPACE
+
+// CPU side shadows. These survive device loss, only the D3D objects are
+// dropped and later rebuilt from them.
+
+struct QD3D12ShadowRootSignature
+{
+    QByteArray blob;
+    ComPtr<ID3D12RootSignature> object;
+};
+
+struct QD3D12ShadowPipeline
+{
+    QD3D12ShadowPipeline() : compute(false), rootSignature(-1), blobUpdated(false) { }
+
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC makeGraphicsDesc(ID3D12RootSignature *rs) const;
+    D3D12_COMPUTE_PIPELINE_STATE_DESC makeComputeDesc(ID3D12RootSignature *rs) const;
+
+    bool compute;
+    int rootSignature;
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC graphicsDesc; // pointers are patched in makeGraphicsDesc()
+    D3D12_COMPUTE_PIPELINE_STATE_DESC computeDesc;
+    QByteArray stages[5]; // VS, PS, DS, HS, GS or just CS
+    QVector<D3D12_INPUT_ELEMENT_DESC> inputElements;
+    QVector<QByteArray> semanticNames;
+    QByteArray key;
+    QByteArray cachedBlob;
+    bool blobUpdated;
+    ComPtr<ID3D12PipelineState> object;
+};
+
+struct QD3D12ShadowResource
+{
+    D3D12_RESOURCE_DESC desc;
+    QVector<QByteArray> subresources; // rows tightly packed
+    D3D12_RESOURCE_STATES state;
+    ComPtr<ID3D12Resource> object;
+    // Only valid between the worker jobs and the copy submission.
+    ComPtr<ID3D12Resource> upload;
+    QVector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> layouts;
+    bool written; // by the CPU on UMA, object is in the COMMON state
+};
+
+class QD3D12StaticResourcesPrivate : public QObjectPrivate, public QD3D12FrameObserver
+{
+    Q_DECLARE_PUBLIC(QD3D12StaticResources)
+
+public:
+    QD3D12StaticResourcesPrivate()
+        : window(Q_NULLPTR),
+          cacheDirty(false)
+    { }
+    ~QD3D12StaticResourcesPrivate();
+
+    void beginFrame() Q_DECL_OVERRIDE { }
+    void initializeResources() Q_DECL_OVERRIDE;
+    void releaseResources() Q_DECL_OVERRIDE;
+
+    bool loadPipelineCache();
+
+    QD3D12Window *window;
+    QThreadPool pool;
+
+    QVector<QD3D12ShadowRootSignature> rootSignatures;
+    QVector<QD3D12ShadowPipeline> pipelines;
+    QVector<QD3D12ShadowResource> resources;
+
+    QString cacheFileName;
+    QHash<QByteArray, QByteArray> cachedBlobs;
+    bool cacheDirty;
+};
+
+QT_END_NAMESPACE
+
+#endif
@@ -0,0 +1,275 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtD3D12Window module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include "qd3d12streamingbuffer_p.h"
+#include "qd3d12util_p.h"
+#include <QtCore/private/qsimd_p.h>
+
+QT_BEGIN_NAMESPACE
+
+QD3D12StreamingBufferPrivate::~QD3D12StreamingBufferPrivate()
+{
+    releaseResources();
+    if (fenceEvent)
+        CloseHandle(fenceEvent);
+}
+
+bool QD3D12StreamingBufferPrivate::initialize(ID3D12Device *device, ID3D12CommandQueue *queue)
+{
+    commandQueue = queue;
+
+    fenceValue = 0;
+    for (int i = 0; i < RegionCount; ++i)
+        regionFenceValues[i] = 0;
+    if (FAILED(device->CreateFence(fenceValue, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&fence)))) {
+        qWarning("Failed to create fence (streaming buffer)");
+        return false;
+    }
+    if (!fenceEvent)
+        fenceEvent = CreateEvent(Q_NULLPTR, FALSE, FALSE, Q_NULLPTR);
+
+    // Upload heaps are write-combined, which suits data that is only ever
+    // written sequentially by the CPU and read once by the GPU.
+    D3D12_HEAP_PROPERTIES heapProp = {};
+    heapProp.Type = D3D12_HEAP_TYPE_UPLOAD;
+    D3D12_RESOURCE_DESC bufDesc = {};
+    bufDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+    bufDesc.Width = quint64(frameSize) * RegionCount;
+    bufDesc.Height = 1;
+    bufDesc.DepthOrArraySize = 1;
+    bufDesc.MipLevels = 1;
+    bufDesc.Format = DXGI_FORMAT_UNKNOWN;
+    bufDesc.SampleDesc.Count = 1;
+    bufDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+    if (FAILED(device->CreateCommittedResource(&heapProp, D3D12_HEAP_FLAG_NONE, &bufDesc,
+                                               D3D12_RESOURCE_STATE_GENERIC_READ, Q_NULLPTR, IID_PPV_ARGS(&buffer)))) {
+        qWarning("Failed to create streaming buffer of %llu bytes", bufDesc.Width);
+        return false;
+    }
+
+    D3D12_RANGE readRange = { 0, 0 };
+    if (FAILED(buffer->Map(0, &readRange, reinterpret_cast<void **>(&data)))) {
+        qWarning("Map failed (streaming buffer)");
+        buffer = Q_NULLPTR;
+        return false;
+    }
+    gpuAddress = buffer->GetGPUVirtualAddress();
+
+    region = 0;
+    used = 0;
+    peakUsed = 0;
+    return true;
+}
+
+// Moves on to the next region, which is only waited for when the GPU is
+// more than RegionCount - 1 frames behind.
+void QD3D12StreamingBufferPrivate::beginFrame()
+{
+    if (!fence)
+        return;
+
+    region = (region + 1) % RegionCount;
+    const UINT64 value = regionFenceValues[region];
+    if (fence->GetCompletedValue() < value) {
+        if (SUCCEEDED(fence->SetEventOnCompletion(value, fenceEvent)))
+            WaitForSingleObject(fenceEvent, INFINITE);
+    }
+    used = 0;
+    overflowed = false;
+}
+
+void QD3D12StreamingBufferPrivate::endFrame()
+{
+    if (!fence)
+        return;
+
+    // Covers everything the command lists of this frame read from the region.
+    commandQueue->Signal(fence.Get(), ++fenceValue);
+    regionFenceValues[region] = fenceValue;
+}
+
+void QD3D12StreamingBufferPrivate::releaseResources()
+{
+    if (buffer && data)
+        buffer->Unmap(0, Q_NULLPTR);
+    data = Q_NULLPTR;
+    gpuAddress = 0;
+    buffer = Q_NULLPTR;
+    fence = Q_NULLPTR;
+    commandQueue = Q_NULLPTR;
+}
+
+// Per-frame memory for geometry and other data that changes every frame.
+// Enabled with QD3D12Window::setStreamingBufferSize(). The buffer is mapped
+// once and split into a region for each frame in flight, allocate() is a
+// bump of an offset in the current region. What is written in a frame stays
+// valid until the command lists of that frame have executed, nothing has to
+// be released.
+//
+// The memory is write-combined: write it sequentially, preferably with
+// streamCopy(), and never read from it.
+QD3D12StreamingBuffer::QD3D12StreamingBuffer(quint32 frameSize, QObject *parent)
+    : QObject(*(new QD3D12StreamingBufferPrivate), parent)
+{
+    Q_D(QD3D12StreamingBuffer);
+    d->frameSize = QD3D12Util::alignedTextureOffset(frameSize);
+}
+
+QD3D12StreamingBuffer::~QD3D12StreamingBuffer()
+{
+}
+
+quint32 QD3D12StreamingBuffer::frameSize() const
+{
+    Q_D(const QD3D12StreamingBuffer);
+    return d->frameSize;
+}
+
+// Bytes allocated in the current frame.
+quint32 QD3D12StreamingBuffer::usedSize() const
+{
+    Q_D(const QD3D12StreamingBuffer);
+    return d->used;
+}
+
+// The most ever allocated in a frame, including failed requests. Useful for
+// choosing the size.
+quint32 QD3D12StreamingBuffer::peakUsedSize() const
+{
+    Q_D(const QD3D12StreamingBuffer);
+    return d->peakUsed;
+}
+
+// alignment must be a power of two. Returns a null range when the frame's
+// region is full.
+QD3D12StreamingBuffer::Range QD3D12StreamingBuffer::allocate(quint32 size, quint32 alignment)
+{
+    Q_D(QD3D12StreamingBuffer);
+    Range range;
+    if (!d->data)
+        return range;
+
+    alignment = qMax(16u, alignment);
+    const quint32 offset = (d->used + alignment - 1) & ~(alignment - 1);
+    if (offset + quint64(size) > d->frameSize) {
+        d->peakUsed = qMax(d->peakUsed, quint32(qMin<quint64>(offset + quint64(size), 0xFFFFFFFFu)));
+        if (!d->overflowed) {
+            qWarning("QD3D12StreamingBuffer: Out of space, %u bytes requested with %u of %u used",
+                     size, d->used, d->frameSize);
+            d->overflowed = true;
+        }
+        return range;
+    }
+
+    const quint32 regionOffset = quint32(d->region) * d->frameSize + offset;
+    range.data = d->data + regionOffset;
+    range.gpuAddress = d->gpuAddress + regionOffset;
+    range.size = size;
+    d->used = offset + size;
+    d->peakUsed = qMax(d->peakUsed, d->used);
+    return range;
+}
+
+// Copies size bytes of vertex data into the buffer. The returned view is
+// empty when it did not fit.
+D3D12_VERTEX_BUFFER_VIEW QD3D12StreamingBuffer::uploadVertices(const void *data, quint32 size, quint32 stride)
+{
+    const Range range = allocate(size);
+    if (!range.isNull())
+        streamCopy(range.data, data, size);
+    return vertexBufferView(range, stride);
+}
+
+D3D12_INDEX_BUFFER_VIEW QD3D12StreamingBuffer::uploadIndices(const void *data, quint32 size, DXGI_FORMAT format)
+{
+    const Range range = allocate(size);
+    if (!range.isNull())
+        streamCopy(range.data, data, size);
+    return indexBufferView(range, format);
+}
+
+D3D12_VERTEX_BUFFER_VIEW QD3D12StreamingBuffer::vertexBufferView(const Range &range, quint32 stride)
+{
+    D3D12_VERTEX_BUFFER_VIEW view;
+    view.BufferLocation = range.gpuAddress;
+    view.SizeInBytes = range.size;
+    view.StrideInBytes = stride;
+    return view;
+}
+
+D3D12_INDEX_BUFFER_VIEW QD3D12StreamingBuffer::indexBufferView(const Range &range, DXGI_FORMAT format)
+{
+    D3D12_INDEX_BUFFER_VIEW view;
+    view.BufferLocation = range.gpuAddress;
+    view.SizeInBytes = range.size;
+    view.Format = format;
+    return view;
+}
+
+// memcpy for write-combined destinations. Aligned non-temporal stores fill
+// whole write-combining buffers and bypass the cache, so the copy neither
+// evicts useful data nor causes partial bus writes.
+void QD3D12StreamingBuffer::streamCopy(void *dst, const void *src, quint32 size)
+{
+    quint8 *d = static_cast<quint8 *>(dst);
+    const quint8 *s = static_cast<const quint8 *>(src);
+#ifdef __SSE2__
+    const quint32 head = qMin(size, quint32(-quintptr(d) & 15));
+    memcpy(d, s, head);
+    d += head;
+    s += head;
+    size -= head;
+    for (; size >= 64; size -= 64, d += 64, s += 64) {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + 16));
+        const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + 32));
+        const __m128i e = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + 48));
+        _mm_stream_si128(reinterpret_cast<__m128i *>(d), a);
+        _mm_stream_si128(reinterpret_cast<__m128i *>(d + 16), b);
+        _mm_stream_si128(reinterpret_cast<__m128i *>(d + 32), c);
+        _mm_stream_si128(reinterpret_cast<__m128i *>(d + 48), e);
+    }
+    for (; size >= 16; size -= 16, d += 16, s += 16)
+        _mm_stream_si128(reinterpret_cast<__m128i *>(d), _mm_loadu_si128(reinterpret_cast<const __m128i *>(s)));
+    memcpy(d, s, size);
+    _mm_sfence();
+#else
+    memcpy(d, s, size);
+#endif
+}
+
+QT_END_NAMESPACE
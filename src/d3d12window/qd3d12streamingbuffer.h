@@ -0,0 +1,86 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtD3D12Window module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#ifndef QD3D12STREAMINGBUFFER_H
+#define QD3D12STREAMINGBUFFER_H
+
+#include <QtCore/QObject>
+#include <QtD3D12Window/qd3d12window.h>
+
+QT_BEGIN_NAMESPACE
+
+class QD3D12StreamingBufferPrivate;
+
+class QD3D12_EXPORT QD3D12StreamingBuffer : public QObject
+{
+    Q_OBJECT
+    Q_DECLARE_PRIVATE(QD3D12StreamingBuffer)
+
+public:
+    struct Range {
+        Range() : data(Q_NULLPTR), gpuAddress(0), size(0) { }
+        bool isNull() const { return !data; }
+        quint8 *data; // write-combined, never read from it
+        D3D12_GPU_VIRTUAL_ADDRESS gpuAddress;
+        quint32 size;
+    };
+
+    ~QD3D12StreamingBuffer();
+
+    quint32 frameSize() const;
+    quint32 usedSize() const;
+    quint32 peakUsedSize() const;
+
+    Range allocate(quint32 size, quint32 alignment = 16);
+
+    D3D12_VERTEX_BUFFER_VIEW uploadVertices(const void *data, quint32 size, quint32 stride);
+    D3D12_INDEX_BUFFER_VIEW uploadIndices(const void *data, quint32 size,
+                                          DXGI_FORMAT format = DXGI_FORMAT_R16_UINT);
+
+    static D3D12_VERTEX_BUFFER_VIEW vertexBufferView(const Range &range, quint32 stride);
+    static D3D12_INDEX_BUFFER_VIEW indexBufferView(const Range &range, DXGI_FORMAT format = DXGI_FORMAT_R16_UINT);
+    static void streamCopy(void *dst, const void *src, quint32 size);
+
+private:
+    explicit QD3D12StreamingBuffer(quint32 frameSize, QObject *parent);
+    Q_DISABLE_COPY(QD3D12StreamingBuffer)
+    friend class QD3D12Window;
+};
+
+QT_END_NAMESPACE
+
+#endif
@@ -0,0 +1,110 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtD3D12Window module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#ifndef QD3D12STREAMINGBUFFER_P_H
+#define QD3D12STREAMINGBUFFER_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "qd3d12streamingbuffer.h"
+#include "qd3d12window_p.h"
+#include <QtCore/private/qobject_p.h>
+
+QT_BEGIN_NAMESPACE
+
+class QD3D12StreamingBufferPrivate : public QObjectPrivate, public QD3D12FrameObserver
+{
+    Q_DECLARE_PUBLIC(QD3D12StreamingBuffer)
+
+public:
+    // One region per frame the CPU may be ahead of the GPU.
+    enum { RegionCount = 3 };
+
+    QD3D12StreamingBufferPrivate()
+        : frameSize(0),
+          data(Q_NULLPTR),
+          gpuAddress(0),
+          fenceEvent(Q_NULLPTR),
+          fenceValue(0),
+          region(0),
+          used(0),
+          peakUsed(0),
+          overflowed(false)
+    {
+        for (int i = 0; i < RegionCount; ++i)
+            regionFenceValues[i] = 0;
+    }
+    ~QD3D12StreamingBufferPrivate();
+
+    static QD3D12StreamingBufferPrivate *get(QD3D12StreamingBuffer *p) { return p->d_func(); }
+
+    bool initialize(ID3D12Device *device, ID3D12CommandQueue *commandQueue);
+
+    void beginFrame() Q_DECL_OVERRIDE;
+    void endFrame() Q_DECL_OVERRIDE;
+    void releaseResources() Q_DECL_OVERRIDE;
+
+    quint32 frameSize;
+
+    ComPtr<ID3D12CommandQueue> commandQueue;
+    ComPtr<ID3D12Resource> buffer;
+    quint8 *data; // mapped for the lifetime of the buffer
+    D3D12_GPU_VIRTUAL_ADDRESS gpuAddress;
+
+    ComPtr<ID3D12Fence> fence;
+    HANDLE fenceEvent;
+    UINT64 fenceValue;
+    UINT64 regionFenceValues[RegionCount];
+
+    int region;
+    quint32 used;
+    quint32 peakUsed;
+    bool overflowed;
+};
+
+QT_END_NAMESPACE
+
+#endif
@@ -0,0 +1,658 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtD3D12Window module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qd3d12textureloader_p.h"
+#include "qd3d12cpumipmapgenerator.h"
+#include "qd3d12formatinfo.h"
+#include "qd3d12util_p.h"
+#include <QtCore/QRunnable>
+#include <QtCore/QWinEventNotifier>
+#include <QtGui/QImageReader>
+
+QT_BEGIN_NAMESPACE
+
+namespace {
+
+class QD3D12TextureJob : public QRunnable
+{
+public:
+    QD3D12TextureJob(ID3D12Device *device, const D3D12_HEAP_PROPERTIES &textureHeap,
+                     QD3D12TextureRequest *request, HANDLE doneEvent)
+        : device(device), textureHeap(textureHeap), request(request), doneEvent(doneEvent)
+    { }
+
+    void run() Q_DECL_OVERRIDE;
+    bool decode();
+    void writeLevels(const QImage &img, DXGI_FORMAT format, quint8 *dst);
+
+    ID3D12Device *device;
+    D3D12_HEAP_PROPERTIES textureHeap;
+    QD3D12TextureRequest *request;
+    HANDLE doneEvent;
+};
+
+} // namespace
+
+void QD3D12TextureJob::run()
+{
+    const bool ok = decode();
+    // The request may be gone right after this.
+    request->status.storeRelease(ok ? QD3D12TextureRequest::Decoded : QD3D12TextureRequest::Failed);
+    SetEvent(doneEvent);
+}
+
+// Decodes, converts and builds the mip chain on the worker thread, creates
+// the texture and writes every level into its upload buffer. Only the copy
+// commands are left for the GUI thread. On UMA adapters the texture is CPU
+// writable instead and the levels are written into it directly, leaving
+// just a barrier.
+bool QD3D12TextureJob::decode()
+{
+    QImage img;
+    if (!request->fileName.isEmpty()) {
+        QImageReader reader(request->fileName);
+        if (!reader.read(&img)) {
+            qWarning("Failed to load %s: %s", qPrintable(request->fileName), qPrintable(reader.errorString()));
+            return false;
+        }
+    } else {
+        img = request->image;
+    }
+    if (img.isNull())
+        return false;
+
+    img = img.convertToFormat(QImage::Format_RGBA8888);
+    const int w = img.width();
+    const int h = img.height();
+    // BC textures need a top level that is a whole number of blocks.
+    DXGI_FORMAT format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    if (request->compression != QD3D12TextureLoader::NoCompression && !(w % 4) && !(h % 4))
+        format = QD3D12BcEncoder::selectFormat(img, request->compression == QD3D12TextureLoader::Bc7Compression);
+    int mipLevels = request->mipLevels;
+    if (mipLevels <= 0) {
+        mipLevels = 1;
+        for (int s = qMax(w, h); s > 1; s >>= 1)
+            ++mipLevels;
+    }
+
+    D3D12_RESOURCE_DESC &desc(request->desc);
+    desc = D3D12_RESOURCE_DESC();
+    desc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+    desc.Width = w;
+    desc.Height = h;
+    desc.DepthOrArraySize = 1;
+    desc.MipLevels = mipLevels;
+    desc.Format = format;
+    desc.SampleDesc.Count = 1;
+    desc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
+
+    // CPU access to a texture requires the COMMON state.
+    const bool direct = textureHeap.Type == D3D12_HEAP_TYPE_CUSTOM;
+    if (FAILED(device->CreateCommittedResource(&textureHeap, D3D12_HEAP_FLAG_NONE, &desc,
+                                               direct ? D3D12_RESOURCE_STATE_COMMON : D3D12_RESOURCE_STATE_COPY_DEST,
+                                               Q_NULLPTR, IID_PPV_ARGS(&request->texture)))) {
+        qWarning("Failed to create texture resource");
+        return false;
+    }
+
+    UINT64 uploadSize = 0;
+    request->layouts.resize(mipLevels);
+    QD3D12FormatInfo::copyableFootprints(desc, 0, mipLevels, 0, request->layouts.data(), Q_NULLPTR, Q_NULLPTR, &uploadSize);
+
+    if (direct) {
+        QByteArray staging(int(uploadSize), Qt::Uninitialized);
+        quint8 *p = reinterpret_cast<quint8 *>(staging.data());
+        writeLevels(img, format, p);
+        const bool ok = QD3D12Util::writeSubresources(request->texture.Get(), p, request->layouts.constData(), mipLevels);
+        request->layouts.clear();
+        if (!ok)
+            request->texture.Reset();
+        return ok;
+    }
+
+    D3D12_HEAP_PROPERTIES uploadHeapProp = {};
+    uploadHeapProp.Type = D3D12_HEAP_TYPE_UPLOAD;
+    D3D12_RESOURCE_DESC bufDesc = {};
+    bufDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+    bufDesc.Width = uploadSize;
+    bufDesc.Height = 1;
+    bufDesc.DepthOrArraySize = 1;
+    bufDesc.MipLevels = 1;
+    bufDesc.Format = DXGI_FORMAT_UNKNOWN;
+    bufDesc.SampleDesc.Count = 1;
+    bufDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+    if (FAILED(device->CreateCommittedResource(&uploadHeapProp, D3D12_HEAP_FLAG_NONE, &bufDesc,
+                                               D3D12_RESOURCE_STATE_GENERIC_READ, Q_NULLPTR,
+                                               IID_PPV_ARGS(&request->upload)))) {
+        qWarning("Failed to create texture upload buffer resource");
+        request->texture.Reset();
+        return false;
+    }
+
+    quint8 *p = Q_NULLPTR;
+    D3D12_RANGE readRange = { 0, 0 };
+    if (FAILED(request->upload->Map(0, &readRange, reinterpret_cast<void **>(&p)))) {
+        qWarning("Map failed (texture upload buffer)");
+        request->texture.Reset();
+        request->upload.Reset();
+        return false;
+    }
+
+    writeLevels(img, format, p);
+    request->upload->Unmap(0, Q_NULLPTR);
+
+    return true;
+}
+
+void QD3D12TextureJob::writeLevels(const QImage &img, DXGI_FORMAT format, quint8 *dst)
+{
+    // Images are sRGB encoded, so the levels are filtered as sRGB even though
+    // the texture itself is UNORM.
+    const int mipLevels = request->layouts.count();
+    if (format == DXGI_FORMAT_R8G8B8A8_UNORM) {
+        QD3D12CpuMipmapGenerator::generate(img.constBits(), img.bytesPerLine(), img.size(),
+                                           DXGI_FORMAT_R8G8B8A8_UNORM_SRGB, dst, request->layouts.constData(), mipLevels);
+    } else {
+        QD3D12BcEncoder::encodeImage(img, format, dst, request->layouts.constData(), mipLevels, request->quality);
+    }
+}
+
+void QD3D12TextureLoaderPrivate::initializeResources()
+{
+    initialize();
+}
+
+void QD3D12TextureLoaderPrivate::beginFrame()
+{
+    submit();
+}
+
+// Everything goes, the requests are started again for the new device.
+void QD3D12TextureLoaderPrivate::releaseResources()
+{
+    pool.waitForDone();
+
+    delete fenceNotifier;
+    fenceNotifier = Q_NULLPTR;
+    delete fence;
+    fence = Q_NULLPTR;
+
+    batches.clear();
+    freeAllocators.clear();
+    commandList.Reset();
+    placeholder.Reset();
+
+    qDeleteAll(released);
+    released.clear();
+    foreach (QD3D12TextureRequest *r, requests) {
+        r->texture.Reset();
+        r->upload.Reset();
+        r->layouts.clear();
+        r->status.storeRelease(QD3D12TextureRequest::Decoding);
+    }
+}
+
+bool QD3D12TextureLoaderPrivate::initialize()
+{
+    Q_Q(QD3D12TextureLoader);
+    if (fence)
+        return true;
+
+    ID3D12Device *device = window->device();
+    if (!device)
+        return false;
+
+    if (!QD3D12Util::umaHeapProperties(device, &textureHeap)) {
+        textureHeap = D3D12_HEAP_PROPERTIES();
+        textureHeap.Type = D3D12_HEAP_TYPE_DEFAULT;
+    }
+
+    fence = QD3D12Util::createFence(device);
+    fenceNotifier = new QWinEventNotifier(fence->event, q);
+    QObject::connect(fenceNotifier, &QWinEventNotifier::activated, q, [this]() { retire(); });
+
+    createPlaceholder();
+
+    foreach (QD3D12TextureRequest *r, requests)
+        start(r);
+
+    return true;
+}
+
+void QD3D12TextureLoaderPrivate::start(QD3D12TextureRequest *request)
+{
+    request->status.storeRelease(QD3D12TextureRequest::Decoding);
+    pool.start(new QD3D12TextureJob(window->device(), textureHeap, request, decodedEvent));
+}
+
+ID3D12GraphicsCommandList *QD3D12TextureLoaderPrivate::beginBatch(QD3D12TextureBatch *batch)
+{
+    ID3D12Device *device = window->device();
+    if (freeAllocators.isEmpty()) {
+        if (FAILED(device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&batch->allocator)))) {
+            qWarning("Failed to create command allocator");
+            return Q_NULLPTR;
+        }
+    } else {
+        batch->allocator = freeAllocators.takeLast();
+    }
+
+    if (!commandList) {
+        if (FAILED(device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, batch->allocator.Get(),
+                                             Q_NULLPTR, IID_PPV_ARGS(&commandList)))) {
+            qWarning("Failed to create command list");
+            return Q_NULLPTR;
+        }
+    } else {
+        commandList->Reset(batch->allocator.Get(), Q_NULLPTR);
+    }
+
+    return commandList.Get();
+}
+
+// The copies go straight to the queue, ahead of the next frame's command
+// lists, and are tracked with the loader's own fence.
+void QD3D12TextureLoaderPrivate::endBatch(QD3D12TextureBatch *batch)
+{
+    commandList->Close();
+    ID3D12CommandList *commandLists[] = { commandList.Get() };
+    ID3D12CommandQueue *queue = window->commandQueue();
+    queue->ExecuteCommandLists(_countof(commandLists), commandLists);
+
+    batch->fenceValue = fence->value.fetchAndAddAcquire(1) + 1;
+    queue->Signal(fence->fence.Get(), batch->fenceValue);
+    batches.append(*batch);
+
+    if (FAILED(fence->fence->SetEventOnCompletion(batch->fenceValue, fence->event)))
+        qWarning("SetEventOnCompletion failed");
+}
+
+bool QD3D12TextureLoaderPrivate::createPlaceholder()
+{
+    ID3D12Device *device = window->device();
+
+    D3D12_RESOURCE_DESC desc = {};
+    desc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+    desc.Width = 1;
+    desc.Height = 1;
+    desc.DepthOrArraySize = 1;
+    desc.MipLevels = 1;
+    desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    desc.SampleDesc.Count = 1;
+    desc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
+
+    D3D12_HEAP_PROPERTIES defaultHeapProp = {};
+    defaultHeapProp.Type = D3D12_HEAP_TYPE_DEFAULT;
+    if (FAILED(device->CreateCommittedResource(&defaultHeapProp, D3D12_HEAP_FLAG_NONE, &desc,
+                                               D3D12_RESOURCE_STATE_COPY_DEST, Q_NULLPTR, IID_PPV_ARGS(&placeholder)))) {
+        qWarning("Failed to create placeholder texture");
+        return false;
+    }
+
+    D3D12_PLACED_SUBRESOURCE_FOOTPRINT layout;
+    UINT64 uploadSize = 0;
+    QD3D12FormatInfo::copyableFootprints(desc, 0, 1, 0, &layout, Q_NULLPTR, Q_NULLPTR, &uploadSize);
+
+    D3D12_HEAP_PROPERTIES uploadHeapProp = {};
+    uploadHeapProp.Type = D3D12_HEAP_TYPE_UPLOAD;
+    D3D12_RESOURCE_DESC bufDesc = {};
+    bufDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+    bufDesc.Width = uploadSize;
+    bufDesc.Height = 1;
+    bufDesc.DepthOrArraySize = 1;
+    bufDesc.MipLevels = 1;
+    bufDesc.Format = DXGI_FORMAT_UNKNOWN;
+    bufDesc.SampleDesc.Count = 1;
+    bufDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+    ComPtr<ID3D12Resource> upload;
+    if (FAILED(device->CreateCommittedResource(&uploadHeapProp, D3D12_HEAP_FLAG_NONE, &bufDesc,
+                                               D3D12_RESOURCE_STATE_GENERIC_READ, Q_NULLPTR, IID_PPV_ARGS(&upload)))) {
+        qWarning("Failed to create placeholder upload buffer");
+        placeholder.Reset();
+        return false;
+    }
+
+    quint8 *p = Q_NULLPTR;
+    D3D12_RANGE readRange = { 0, 0 };
+    if (FAILED(upload->Map(0, &readRange, reinterpret_cast<void **>(&p)))) {
+        qWarning("Map failed (placeholder upload buffer)");
+        placeholder.Reset();
+        return false;
+    }
+    const quint8 texel[] = { quint8(placeholderColor.red()), quint8(placeholderColor.green()),
+                             quint8(placeholderColor.blue()), quint8(placeholderColor.alpha()) };
+    memcpy(p + layout.Offset, texel, sizeof(texel));
+    upload->Unmap(0, Q_NULLPTR);
+
+    QD3D12TextureBatch batch;
+    ID3D12GraphicsCommandList *cl = beginBatch(&batch);
+    if (!cl) {
+        placeholder.Reset();
+        return false;
+    }
+
+    D3D12_TEXTURE_COPY_LOCATION dstLoc;
+    dstLoc.pResource = placeholder.Get();
+    dstLoc.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+    dstLoc.SubresourceIndex = 0;
+    D3D12_TEXTURE_COPY_LOCATION srcLoc;
+    srcLoc.pResource = upload.Get();
+    srcLoc.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
+    srcLoc.PlacedFootprint = layout;
+    cl->CopyTextureRegion(&dstLoc, 0, 0, 0, &srcLoc, Q_NULLPTR);
+    QD3D12Util::transitionResource(placeholder.Get(), cl, D3D12_RESOURCE_STATE_COPY_DEST,
+                                   D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+
+    batch.uploads.append(upload);
+    endBatch(&batch);
+    return true;
+}
+
+// Records the copies for everything decoded since the last call into a
+// single command list.
+void QD3D12TextureLoaderPrivate::submit()
+{
+    retire();
+    if (!fence)
+        return;
+
+    QD3D12TextureBatch batch;
+    ID3D12GraphicsCommandList *cl = Q_NULLPTR;
+    QVector<QD3D12TextureRequest *> submitted;
+
+    foreach (QD3D12TextureRequest *r, requests) {
+        if (r->status.loadAcquire() != QD3D12TextureRequest::Decoded)
+            continue;
+        if (!cl) {
+            cl = beginBatch(&batch);
+            if (!cl)
+                return;
+        }
+        // Textures written directly by the job have no layouts and start out
+        // in the COMMON state.
+        for (int level = 0; level < r->layouts.count(); ++level) {
+            D3D12_TEXTURE_COPY_LOCATION dstLoc;
+            dstLoc.pResource = r->texture.Get();
+            dstLoc.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+            dstLoc.SubresourceIndex = level;
+            D3D12_TEXTURE_COPY_LOCATION srcLoc;
+            srcLoc.pResource = r->upload.Get();
+            srcLoc.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
+            srcLoc.PlacedFootprint = r->layouts[level];
+            cl->CopyTextureRegion(&dstLoc, 0, 0, 0, &srcLoc, Q_NULLPTR);
+        }
+        const D3D12_RESOURCE_STATES before = r->upload ? D3D12_RESOURCE_STATE_COPY_DEST : D3D12_RESOURCE_STATE_COMMON;
+        if (r->state != before)
+            QD3D12Util::transitionResource(r->texture.Get(), cl, before, r->state);
+        if (r->upload)
+            batch.uploads.append(r->upload);
+        r->upload.Reset();
+        r->layouts.clear();
+        submitted.append(r);
+    }
+
+    if (!cl)
+        return;
+
+    endBatch(&batch);
+    foreach (QD3D12TextureRequest *r, submitted) {
+        r->fenceValue = batch.fenceValue;
+        r->status.storeRelease(QD3D12TextureRequest::Submitted);
+    }
+}
+
+// Recycles the batches the GPU is done with and reports the textures that
+// became usable.
+void QD3D12TextureLoaderPrivate::retire()
+{
+    Q_Q(QD3D12TextureLoader);
+    if (!fence)
+        return;
+
+    const quint64 completed = fence->fence->GetCompletedValue();
+    while (!batches.isEmpty() && batches.first().fenceValue <= completed) {
+        QD3D12TextureBatch batch = batches.takeFirst();
+        batch.allocator->Reset();
+        freeAllocators.append(batch.allocator);
+    }
+
+    for (int i = released.count() - 1; i >= 0; --i) {
+        QD3D12TextureRequest *r = released[i];
+        const int status = r->status.loadAcquire();
+        if (status == QD3D12TextureRequest::Decoding
+                || (status == QD3D12TextureRequest::Submitted && r->fenceValue > completed))
+            continue;
+        delete r;
+        released.remove(i);
+    }
+
+    QVector<int> ready;
+    for (QHash<int, QD3D12TextureRequest *>::const_iterator it = requests.cbegin(); it != requests.cend(); ++it) {
+        QD3D12TextureRequest *r = it.value();
+        if (r->status.loadAcquire() == QD3D12TextureRequest::Submitted && r->fenceValue <= completed) {
+            r->status.storeRelease(QD3D12TextureRequest::Ready);
+            ready.append(it.key());
+        }
+    }
+
+    foreach (int id, ready)
+        emit q->textureReady(id);
+}
+
+// Loads textures without stalling the GUI thread. Images are decoded,
+// converted and mipmapped on a thread pool, and written directly into the
+// mapped upload buffers. The copies of everything that finished decoding
+// are then submitted in one command list, and a texture becomes ready once
+// the GPU has passed the fence of its batch. Until then texture() returns a
+// 1x1 placeholder, so views can be created right away and updated when
+// textureReady() is emitted.
+//
+// Loaded textures are rebuilt automatically after device loss.
+QD3D12TextureLoader::QD3D12TextureLoader(QD3D12Window *window)
+    : QObject(*(new QD3D12TextureLoaderPrivate), window)
+{
+    Q_D(QD3D12TextureLoader);
+    d->window = window;
+    d->decodedEvent = CreateEvent(Q_NULLPTR, FALSE, FALSE, Q_NULLPTR);
+    d->decodedNotifier = new QWinEventNotifier(d->decodedEvent, this);
+    connect(d->decodedNotifier, &QWinEventNotifier::activated, this, [d]() { d->submit(); });
+    QD3D12WindowPrivate::get(window)->frameObservers.append(d);
+}
+
+QD3D12TextureLoader::~QD3D12TextureLoader()
+{
+    Q_D(QD3D12TextureLoader);
+    d->pool.waitForDone();
+    if (d->fence && d->window->commandQueue())
+        QD3D12Util::waitForGPU(d->window->commandQueue(), d->fence);
+    d->releaseResources();
+    qDeleteAll(d->requests);
+    d->requests.clear();
+
+    delete d->decodedNotifier;
+    CloseHandle(d->decodedEvent);
+    QD3D12WindowPrivate::get(d->window)->frameObservers.removeOne(d);
+}
+
+// Only affects placeholders created afterwards, so it is best set right
+// after construction.
+void QD3D12TextureLoader::setPlaceholderColor(const QColor &color)
+{
+    Q_D(QD3D12TextureLoader);
+    d->placeholderColor = color;
+}
+
+QColor QD3D12TextureLoader::placeholderColor() const
+{
+    Q_D(const QD3D12TextureLoader);
+    return d->placeholderColor;
+}
+
+// Applies to the loads started afterwards. Images whose size is not a
+// multiple of 4 stay uncompressed.
+void QD3D12TextureLoader::setCompression(Compression compression, QD3D12BcEncoder::Quality quality)
+{
+    Q_D(QD3D12TextureLoader);
+    d->compression = compression;
+    d->quality = quality;
+}
+
+QD3D12TextureLoader::Compression QD3D12TextureLoader::compression() const
+{
+    Q_D(const QD3D12TextureLoader);
+    return d->compression;
+}
+
+QD3D12BcEncoder::Quality QD3D12TextureLoader::compressionQuality() const
+{
+    Q_D(const QD3D12TextureLoader);
+    return d->quality;
+}
+
+// Returns an id right away. A mipLevels value of 0 or less requests the
+// full chain. state is the state the texture is left in after the upload.
+int QD3D12TextureLoader::load(const QString &fileName, int mipLevels, D3D12_RESOURCE_STATES state)
+{
+    Q_D(QD3D12TextureLoader);
+    QD3D12TextureRequest *r = new QD3D12TextureRequest;
+    r->fileName = fileName;
+    r->mipLevels = mipLevels;
+    r->state = state;
+    r->compression = d->compression;
+    r->quality = d->quality;
+
+    const int id = d->nextId++;
+    d->requests.insert(id, r);
+    if (d->fence)
+        d->start(r);
+    else
+        d->initialize();
+
+    return id;
+}
+
+int QD3D12TextureLoader::load(const QImage &image, int mipLevels, D3D12_RESOURCE_STATES state)
+{
+    Q_D(QD3D12TextureLoader);
+    QD3D12TextureRequest *r = new QD3D12TextureRequest;
+    r->image = image;
+    r->mipLevels = mipLevels;
+    r->state = state;
+    r->compression = d->compression;
+    r->quality = d->quality;
+
+    const int id = d->nextId++;
+    d->requests.insert(id, r);
+    if (d->fence)
+        d->start(r);
+    else
+        d->initialize();
+
+    return id;
+}
+
+// The texture is destroyed once no job and no pending copy refer to it.
+// Frames still using it must have been waited for.
+void QD3D12TextureLoader::release(int id)
+{
+    Q_D(QD3D12TextureLoader);
+    QD3D12TextureRequest *r = d->requests.take(id);
+    if (!r)
+        return;
+
+    if (d->fence) {
+        d->released.append(r);
+        d->retire();
+    } else {
+        delete r;
+    }
+}
+
+bool QD3D12TextureLoader::isReady(int id) const
+{
+    Q_D(const QD3D12TextureLoader);
+    QD3D12TextureRequest *r = d->requests.value(id);
+    return r && r->status.loadAcquire() == QD3D12TextureRequest::Ready;
+}
+
+bool QD3D12TextureLoader::hasFailed(int id) const
+{
+    Q_D(const QD3D12TextureLoader);
+    QD3D12TextureRequest *r = d->requests.value(id);
+    return !r || r->status.loadAcquire() == QD3D12TextureRequest::Failed;
+}
+
+int QD3D12TextureLoader::pendingCount() const
+{
+    Q_D(const QD3D12TextureLoader);
+    int count = 0;
+    foreach (QD3D12TextureRequest *r, d->requests) {
+        const int status = r->status.loadAcquire();
+        if (status != QD3D12TextureRequest::Ready && status != QD3D12TextureRequest::Failed)
+            ++count;
+    }
+    return count;
+}
+
+// The placeholder until the texture is ready.
+ID3D12Resource *QD3D12TextureLoader::texture(int id) const
+{
+    Q_D(const QD3D12TextureLoader);
+    QD3D12TextureRequest *r = d->requests.value(id);
+    if (r && r->status.loadAcquire() == QD3D12TextureRequest::Ready)
+        return r->texture.Get();
+    return d->placeholder.Get();
+}
+
+// Matches texture(), so this also changes when the texture becomes ready.
+D3D12_SHADER_RESOURCE_VIEW_DESC QD3D12TextureLoader::shaderResourceViewDesc(int id) const
+{
+    Q_D(const QD3D12TextureLoader);
+    D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+    srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+    srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+    srvDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    srvDesc.Texture2D.MipLevels = 1;
+
+    QD3D12TextureRequest *r = d->requests.value(id);
+    if (r && r->status.loadAcquire() == QD3D12TextureRequest::Ready) {
+        srvDesc.Format = r->desc.Format;
+        srvDesc.Texture2D.MipLevels = r->desc.MipLevels;
+    }
+    return srvDesc;
+}
+
+QT_END_NAMESPACE
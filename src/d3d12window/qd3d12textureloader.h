@@ -0,0 +1,93 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtD3D12Window module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QD3D12TEXTURELOADER_H
+#define QD3D12TEXTURELOADER_H
+
+#include <QtCore/QObject>
+#include <QtGui/QColor>
+#include <QtD3D12Window/qd3d12window.h>
+#include <QtD3D12Window/qd3d12bcencoder.h>
+
+QT_BEGIN_NAMESPACE
+
+class QD3D12TextureLoaderPrivate;
+
+class QD3D12_EXPORT QD3D12TextureLoader : public QObject
+{
+    Q_OBJECT
+    Q_DECLARE_PRIVATE(QD3D12TextureLoader)
+
+public:
+    enum Compression {
+        NoCompression,
+        BcCompression, // BC1, or BC3 for images with transparency
+        Bc7Compression
+    };
+
+    explicit QD3D12TextureLoader(QD3D12Window *window);
+    ~QD3D12TextureLoader();
+
+    void setPlaceholderColor(const QColor &color);
+    QColor placeholderColor() const;
+
+    void setCompression(Compression compression, QD3D12BcEncoder::Quality quality = QD3D12BcEncoder::NormalQuality);
+    Compression compression() const;
+    QD3D12BcEncoder::Quality compressionQuality() const;
+
+    int load(const QString &fileName, int mipLevels = 1,
+             D3D12_RESOURCE_STATES state = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+    int load(const QImage &image, int mipLevels = 1,
+             D3D12_RESOURCE_STATES state = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+    void release(int id);
+
+    bool isReady(int id) const;
+    bool hasFailed(int id) const;
+    int pendingCount() const;
+
+    ID3D12Resource *texture(int id) const;
+    D3D12_SHADER_RESOURCE_VIEW_DESC shaderResourceViewDesc(int id) const;
+
+Q_SIGNALS:
+    void textureReady(int id);
+
+private:
+    Q_DISABLE_COPY(QD3D12TextureLoader)
+};
+
+QT_END_NAMESPACE
+
+#endif
@@ -0,0 +1,159 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtD3D12Window module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QD3D12TEXTURELOADER_P_H
+#define QD3D12TEXTURELOADER_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "qd3d12textureloader.h"
+#include "qd3d12window_p.h"
+#include <QtCore/QHash>
+#include <QtCore/QThreadPool>
+#include <QtCore/private/qobject_p.h>
+#include <QtGui/QImage>
+
+QT_BEGIN_NAMESPACE
+
+class QWinEventNotifier;
+
+struct QD3D12TextureRequest
+{
+    // Decoding and Decoded belong to the worker job, the rest to the GUI thread.
+    enum Status {
+        Decoding,
+        Decoded,
+        Failed,
+        Submitted,
+        Ready
+    };
+
+    QD3D12TextureRequest()
+        : mipLevels(1),
+          state(D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE),
+          compression(QD3D12TextureLoader::NoCompression),
+          quality(QD3D12BcEncoder::NormalQuality),
+          status(Decoding),
+          fenceValue(0)
+    { }
+
+    // The source is kept so the texture can be rebuilt after device loss.
+    QString fileName;
+    QImage image;
+    int mipLevels;
+    D3D12_RESOURCE_STATES state;
+    QD3D12TextureLoader::Compression compression;
+    QD3D12BcEncoder::Quality quality;
+
+    QAtomicInt status;
+    D3D12_RESOURCE_DESC desc;
+    ComPtr<ID3D12Resource> texture;
+    ComPtr<ID3D12Resource> upload;
+    QVector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> layouts;
+    quint64 fenceValue;
+};
+
+struct QD3D12TextureBatch
+{
+    ComPtr<ID3D12CommandAllocator> allocator;
+    QVector<ComPtr<ID3D12Resource> > uploads;
+    quint64 fenceValue;
+};
+
+class QD3D12TextureLoaderPrivate : public QObjectPrivate, public QD3D12FrameObserver
+{
+    Q_DECLARE_PUBLIC(QD3D12TextureLoader)
+
+public:
+    QD3D12TextureLoaderPrivate()
+        : window(Q_NULLPTR),
+          nextId(0),
+          placeholderColor(Qt::transparent),
+          compression(QD3D12TextureLoader::NoCompression),
+          quality(QD3D12BcEncoder::NormalQuality),
+          decodedEvent(Q_NULLPTR),
+          decodedNotifier(Q_NULLPTR),
+          fence(Q_NULLPTR),
+          fenceNotifier(Q_NULLPTR)
+    { }
+
+    void initializeResources() Q_DECL_OVERRIDE;
+    void beginFrame() Q_DECL_OVERRIDE;
+    void releaseResources() Q_DECL_OVERRIDE;
+
+    bool initialize();
+    void start(QD3D12TextureRequest *request);
+    bool createPlaceholder();
+    ID3D12GraphicsCommandList *beginBatch(QD3D12TextureBatch *batch);
+    void endBatch(QD3D12TextureBatch *batch);
+    void submit();
+    void retire();
+
+    QD3D12Window *window;
+    QThreadPool pool;
+    QHash<int, QD3D12TextureRequest *> requests;
+    QVector<QD3D12TextureRequest *> released; // still referenced by a job or the GPU
+    int nextId;
+
+    QColor placeholderColor;
+    QD3D12TextureLoader::Compression compression;
+    QD3D12BcEncoder::Quality quality;
+    ComPtr<ID3D12Resource> placeholder;
+    D3D12_HEAP_PROPERTIES textureHeap; // CUSTOM on UMA adapters
+
+    // Set by the jobs, the notifier gets the copies submitted on the GUI thread.
+    HANDLE decodedEvent;
+    QWinEventNotifier *decodedNotifier;
+
+    QD3D12Window::Fence *fence;
+    QWinEventNotifier *fenceNotifier;
+    ComPtr<ID3D12GraphicsCommandList> commandList;
+    QVector<QD3D12TextureBatch> batches;
+    QVector<ComPtr<ID3D12CommandAllocator> > freeAllocators;
+};
+
+QT_END_NAMESPACE
+
+#endif
@@ -0,0 +1,434 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtD3D12Window module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qd3d12util_p.h"
+#include "qd3d12adapter_p.h"
+#include "qd3d12formatinfo.h"
+#include <QtCore/QCryptographicHash>
+
+QT_BEGIN_NAMESPACE
+
+bool QD3D12Util::createDevice(QD3D12Adapter::Preference preference, quint64 luid,
+                              ComPtr<IDXGIFactory4> *factory, ComPtr<ID3D12Device> *device)
+{
+    ComPtr<ID3D12Debug> debugController;
+    if (SUCCEEDED(D3D12GetDebugInterface(IID_PPV_ARGS(&debugController))))
+        debugController->EnableDebugLayer();
+
+    if (FAILED(CreateDXGIFactory2(0, IID_PPV_ARGS(factory->ReleaseAndGetAddressOf())))) {
+        qWarning("Failed to create DXGI");
+        return false;
+    }
+
+    bool warp = true;
+    ComPtr<IDXGIAdapter1> adapter = QD3D12AdapterSelection::select(factory->Get(), preference, luid);
+    if (adapter) {
+        HRESULT hr = D3D12CreateDevice(adapter.Get(), D3D_FEATURE_LEVEL_11_0, IID_PPV_ARGS(device->ReleaseAndGetAddressOf()));
+        if (SUCCEEDED(hr))
+            warp = false;
+        else
+            qWarning("Failed to create device: 0x%x", hr);
+    }
+
+    if (warp) {
+        qDebug("Using WARP");
+        ComPtr<IDXGIAdapter> warpAdapter;
+        (*factory)->EnumWarpAdapter(IID_PPV_ARGS(&warpAdapter));
+        HRESULT hr = D3D12CreateDevice(warpAdapter.Get(), D3D_FEATURE_LEVEL_11_0, IID_PPV_ARGS(device->ReleaseAndGetAddressOf()));
+        if (FAILED(hr)) {
+            qWarning("Failed to create WARP device: 0x%x", hr);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+DXGI_SAMPLE_DESC QD3D12Util::makeSampleDesc(ID3D12Device *device, DXGI_FORMAT format, int samples)
+{
+    DXGI_SAMPLE_DESC sampleDesc;
+    sampleDesc.Count = 1;
+    sampleDesc.Quality = 0;
+
+    if (samples > 1) {
+        D3D12_FEATURE_DATA_MULTISAMPLE_QUALITY_LEVELS msaaInfo = {};
+        msaaInfo.Format = format;
+        msaaInfo.SampleCount = samples;
+        if (SUCCEEDED(device->CheckFeatureSupport(D3D12_FEATURE_MULTISAMPLE_QUALITY_LEVELS, &msaaInfo, sizeof(msaaInfo)))) {
+            if (msaaInfo.NumQualityLevels > 0) {
+                sampleDesc.Count = samples;
+                sampleDesc.Quality = msaaInfo.NumQualityLevels - 1;
+            } else {
+                qWarning("No quality levels for multisampling?");
+            }
+        } else {
+            qWarning("Failed to query multisample quality levels");
+        }
+    }
+
+    return sampleDesc;
+}
+
+ID3D12Resource *QD3D12Util::createRenderTarget(ID3D12Device *device, D3D12_CPU_DESCRIPTOR_HANDLE viewHandle,
+                                               const QSize &size, const float *clearColor, int samples,
+                                               D3D12_RESOURCE_STATES initialState)
+{
+    D3D12_CLEAR_VALUE clearValue = {};
+    clearValue.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    if (clearColor)
+        memcpy(clearValue.Color, clearColor, 4 * sizeof(float));
+
+    D3D12_HEAP_PROPERTIES heapProp = {};
+    heapProp.Type = D3D12_HEAP_TYPE_DEFAULT;
+
+    D3D12_RESOURCE_DESC rtDesc = {};
+    rtDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+    rtDesc.Width = size.width();
+    rtDesc.Height = size.height();
+    rtDesc.DepthOrArraySize = 1;
+    rtDesc.MipLevels = 1;
+    rtDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    rtDesc.SampleDesc = makeSampleDesc(device, rtDesc.Format, samples); // MSAA works here, unlike the backbuffer
+    rtDesc.Flags = D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET;
+
+    ID3D12Resource *resource = Q_NULLPTR;
+    if (FAILED(device->CreateCommittedResource(&heapProp, D3D12_HEAP_FLAG_NONE, &rtDesc,
+                                               initialState, &clearValue, IID_PPV_ARGS(&resource)))) {
+        qWarning("Failed to create offscreen render target of size %dx%d", size.width(), size.height());
+        return Q_NULLPTR;
+    }
+
+    device->CreateRenderTargetView(resource, Q_NULLPTR, viewHandle);
+
+    return resource;
+}
+
+ID3D12Resource *QD3D12Util::createDepthStencil(ID3D12Device *device, D3D12_CPU_DESCRIPTOR_HANDLE viewHandle,
+                                               const QSize &size, int samples)
+{
+    D3D12_CLEAR_VALUE depthClearValue = {};
+    depthClearValue.Format = DXGI_FORMAT_D32_FLOAT;
+    depthClearValue.DepthStencil.Depth = 1.0f;
+    depthClearValue.DepthStencil.Stencil = 0;
+
+    D3D12_HEAP_PROPERTIES heapProp = {};
+    heapProp.Type = D3D12_HEAP_TYPE_DEFAULT;
+
+    D3D12_RESOURCE_DESC bufDesc = {};
+    bufDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+    bufDesc.Width = size.width();
+    bufDesc.Height = size.height();
+    bufDesc.DepthOrArraySize = 1;
+    bufDesc.MipLevels = 1;
+    // Typeless so that the depth can also be read as R32_FLOAT, for example
+    // by QD3D12GpuCuller.
+    bufDesc.Format = DXGI_FORMAT_R32_TYPELESS;
+    bufDesc.SampleDesc = makeSampleDesc(device, DXGI_FORMAT_D32_FLOAT, samples);
+    bufDesc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
+    bufDesc.Flags = D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL;
+
+    ID3D12Resource *resource = Q_NULLPTR;
+    if (FAILED(device->CreateCommittedResource(&heapProp, D3D12_HEAP_FLAG_NONE, &bufDesc,
+                                               D3D12_RESOURCE_STATE_DEPTH_WRITE, &depthClearValue, IID_PPV_ARGS(&resource)))) {
+        qWarning("Failed to create depth-stencil buffer of size %dx%d", size.width(), size.height());
+        return Q_NULLPTR;
+    }
+
+    D3D12_DEPTH_STENCIL_VIEW_DESC depthStencilDesc = {};
+    depthStencilDesc.Format = DXGI_FORMAT_D32_FLOAT;
+    depthStencilDesc.ViewDimension = bufDesc.SampleDesc.Count <= 1 ? D3D12_DSV_DIMENSION_TEXTURE2D : D3D12_DSV_DIMENSION_TEXTURE2DMS;
+
+    device->CreateDepthStencilView(resource, &depthStencilDesc, viewHandle);
+
+    return resource;
+}
+
+QD3D12Window::Fence *QD3D12Util::createFence(ID3D12Device *device)
+{
+    QD3D12Window::Fence *f = new QD3D12Window::Fence;
+    if (FAILED(device->CreateFence(f->value, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&f->fence)))) {
+        qWarning("Failed to create fence");
+        return f;
+    }
+    f->event = CreateEvent(Q_NULLPTR, FALSE, FALSE, Q_NULLPTR);
+    return f;
+}
+
+void QD3D12Util::waitForGPU(ID3D12CommandQueue *commandQueue, QD3D12Window::Fence *f)
+{
+    const UINT64 newValue = f->value.fetchAndAddAcquire(1) + 1;
+    commandQueue->Signal(f->fence.Get(), newValue);
+    if (f->fence->GetCompletedValue() < newValue) {
+        if (FAILED(f->fence->SetEventOnCompletion(newValue, f->event))) {
+            qWarning("SetEventOnCompletion failed");
+            return;
+        }
+        WaitForSingleObject(f->event, INFINITE);
+    }
+}
+
+void QD3D12Util::transitionResource(ID3D12Resource *resource, ID3D12GraphicsCommandList *commandList,
+                                    D3D12_RESOURCE_STATES before, D3D12_RESOURCE_STATES after)
+{
+    D3D12_RESOURCE_BARRIER barrier;
+    barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+    barrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+    barrier.Transition.pResource = resource;
+    barrier.Transition.StateBefore = before;
+    barrier.Transition.StateAfter = after;
+    barrier.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+
+    commandList->ResourceBarrier(1, &barrier);
+}
+
+void QD3D12Util::uavBarrier(ID3D12Resource *resource, ID3D12GraphicsCommandList *commandList)
+{
+    D3D12_RESOURCE_BARRIER barrier = {};
+    barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
+    barrier.UAV.pResource = resource;
+
+    commandList->ResourceBarrier(1, &barrier);
+}
+
+// On UMA adapters the GPU uses system memory, so static data is better
+// written by the CPU straight into the resource than staged in an upload
+// buffer and copied. Gives the properties of a CPU writable heap for that,
+// write-back when the caches are coherent, write-combined otherwise.
+// Returns false for discrete GPUs. QT_D3D12_NO_UMA_UPLOAD disables it.
+bool QD3D12Util::umaHeapProperties(ID3D12Device *device, D3D12_HEAP_PROPERTIES *heapProp)
+{
+    if (qEnvironmentVariableIntValue("QT_D3D12_NO_UMA_UPLOAD"))
+        return false;
+
+    D3D12_FEATURE_DATA_ARCHITECTURE arch = {};
+    if (FAILED(device->CheckFeatureSupport(D3D12_FEATURE_ARCHITECTURE, &arch, sizeof(arch))) || !arch.UMA)
+        return false;
+
+    *heapProp = D3D12_HEAP_PROPERTIES();
+    heapProp->Type = D3D12_HEAP_TYPE_CUSTOM;
+    heapProp->CPUPageProperty = arch.CacheCoherentUMA ? D3D12_CPU_PAGE_PROPERTY_WRITE_BACK
+                                                      : D3D12_CPU_PAGE_PROPERTY_WRITE_COMBINE;
+    heapProp->MemoryPoolPreference = D3D12_MEMORY_POOL_L0;
+    return true;
+}
+
+// Writes count subresources of a texture created on a heap from
+// umaHeapProperties(), in the COMMON state. src is laid out as described by
+// layouts, like an upload buffer would be.
+bool QD3D12Util::writeSubresources(ID3D12Resource *resource, const quint8 *src,
+                                   const D3D12_PLACED_SUBRESOURCE_FOOTPRINT *layouts, int count)
+{
+    for (int i = 0; i < count; ++i) {
+        const D3D12_SUBRESOURCE_FOOTPRINT &footprint(layouts[i].Footprint);
+        const QD3D12FormatInfo formatInfo = QD3D12FormatInfo::forFormat(footprint.Format);
+        const UINT depthPitch = footprint.RowPitch * formatInfo.rowCount(footprint.Height);
+        if (FAILED(resource->Map(i, Q_NULLPTR, Q_NULLPTR))) {
+            qWarning("Map failed (subresource %d)", i);
+            return false;
+        }
+        const HRESULT hr = resource->WriteToSubresource(i, Q_NULLPTR, src + layouts[i].Offset,
+                                                        footprint.RowPitch, depthPitch);
+        resource->Unmap(i, Q_NULLPTR);
+        if (FAILED(hr)) {
+            qWarning("WriteToSubresource failed for subresource %d: 0x%x", i, uint(hr));
+            return false;
+        }
+    }
+    return true;
+}
+
+QImage QD3D12Util::readbackRGBA8888(ID3D12Device *device, ID3D12CommandQueue *commandQueue,
+                                    ID3D12Resource *rt, D3D12_RESOURCE_STATES rtState,
+                                    ID3D12GraphicsCommandList *commandList)
+{
+    ComPtr<ID3D12Resource> readbackBuf;
+
+    D3D12_RESOURCE_DESC rtDesc = rt->GetDesc();
+    // The bytes are copied as they are, so only normalized RGBA8 data fits.
+    switch (rtDesc.Format) {
+    case DXGI_FORMAT_R8G8B8A8_TYPELESS:
+    case DXGI_FORMAT_R8G8B8A8_UNORM:
+    case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+        break;
+    default:
+        qWarning("Cannot read back format %d as RGBA8888", int(rtDesc.Format));
+        return QImage();
+    }
+    UINT64 textureByteSize = 0;
+    UINT64 rowSize = 0;
+    D3D12_PLACED_SUBRESOURCE_FOOTPRINT textureLayout = {};
+    QD3D12FormatInfo::copyableFootprints(rtDesc, 0, 1, 0, &textureLayout, Q_NULLPTR, &rowSize, &textureByteSize);
+
+    D3D12_HEAP_PROPERTIES heapProp = {};
+    heapProp.Type = D3D12_HEAP_TYPE_READBACK;
+
+    D3D12_RESOURCE_DESC bufDesc = {};
+    bufDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+    bufDesc.Width = textureByteSize;
+    bufDesc.Height = 1;
+    bufDesc.DepthOrArraySize = 1;
+    bufDesc.MipLevels = 1;
+    bufDesc.Format = DXGI_FORMAT_UNKNOWN;
+    bufDesc.SampleDesc.Count = 1;
+    bufDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+
+    if (FAILED(device->CreateCommittedResource(&heapProp, D3D12_HEAP_FLAG_NONE, &bufDesc,
+                                               D3D12_RESOURCE_STATE_COPY_DEST, Q_NULLPTR, IID_PPV_ARGS(&readbackBuf)))) {
+        qWarning("Failed to create committed resource (readback buffer)");
+        return QImage();
+    }
+
+    D3D12_TEXTURE_COPY_LOCATION dstLoc;
+    dstLoc.pResource = readbackBuf.Get();
+    dstLoc.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
+    dstLoc.PlacedFootprint = textureLayout;
+    D3D12_TEXTURE_COPY_LOCATION srcLoc;
+    srcLoc.pResource = rt;
+    srcLoc.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+    srcLoc.SubresourceIndex = 0;
+
+    transitionResource(rt, commandList, rtState, D3D12_RESOURCE_STATE_COPY_SOURCE);
+    commandList->CopyTextureRegion(&dstLoc, 0, 0, 0, &srcLoc, Q_NULLPTR);
+    transitionResource(rt, commandList, D3D12_RESOURCE_STATE_COPY_SOURCE, rtState);
+    commandList->Close();
+
+    ID3D12CommandList *commandLists[] = { commandList };
+    commandQueue->ExecuteCommandLists(_countof(commandLists), commandLists);
+    QScopedPointer<QD3D12Window::Fence> f(createFence(device));
+    waitForGPU(commandQueue, f.data());
+
+    QImage img(rtDesc.Width, rtDesc.Height, QImage::Format_RGBA8888);
+    quint8 *p = Q_NULLPTR;
+    D3D12_RANGE readRange = { 0, 0 };
+    if (FAILED(readbackBuf->Map(0, &readRange, reinterpret_cast<void **>(&p)))) {
+        qWarning("Mapping the readback buffer failed");
+        return QImage();
+    }
+    for (UINT y = 0; y < rtDesc.Height; ++y) {
+        quint8 *dst = img.scanLine(y);
+        memcpy(dst, p, rowSize);
+        p += textureLayout.Footprint.RowPitch;
+    }
+    readbackBuf->Unmap(0, Q_NULLPTR);
+
+    return img;
+}
+
+// Pipeline states are keyed on the contents of the description, including
+// the shader bytecode and the input layout. The root signature is identified
+// by its pointer, or by rootSignatureKey when the key has to be stable across
+// devices and runs.
+
+static void addBytecode(QCryptographicHash *hash, const D3D12_SHADER_BYTECODE &bytecode)
+{
+    hash->addData(reinterpret_cast<const char *>(&bytecode.BytecodeLength), sizeof(bytecode.BytecodeLength));
+    if (bytecode.BytecodeLength)
+        hash->addData(static_cast<const char *>(bytecode.pShaderBytecode), int(bytecode.BytecodeLength));
+}
+
+template <typename T>
+static void addValue(QCryptographicHash *hash, const T &value)
+{
+    hash->addData(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+QByteArray QD3D12Util::pipelineKey(const D3D12_GRAPHICS_PIPELINE_STATE_DESC &desc, const QByteArray &rootSignatureKey)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    if (rootSignatureKey.isEmpty())
+        addValue(&hash, desc.pRootSignature);
+    else
+        hash.addData(rootSignatureKey);
+    addBytecode(&hash, desc.VS);
+    addBytecode(&hash, desc.PS);
+    addBytecode(&hash, desc.DS);
+    addBytecode(&hash, desc.HS);
+    addBytecode(&hash, desc.GS);
+    for (UINT i = 0; i < desc.StreamOutput.NumEntries; ++i) {
+        const D3D12_SO_DECLARATION_ENTRY &e(desc.StreamOutput.pSODeclaration[i]);
+        addValue(&hash, e.Stream);
+        if (e.SemanticName)
+            hash.addData(e.SemanticName);
+        addValue(&hash, e.SemanticIndex);
+        addValue(&hash, e.StartComponent);
+        addValue(&hash, e.ComponentCount);
+        addValue(&hash, e.OutputSlot);
+    }
+    for (UINT i = 0; i < desc.StreamOutput.NumStrides; ++i)
+        addValue(&hash, desc.StreamOutput.pBufferStrides[i]);
+    addValue(&hash, desc.StreamOutput.RasterizedStream);
+    // Padding in these structs is not cleared by everyone. That only costs
+    // a cache miss, never a wrong pipeline.
+    addValue(&hash, desc.BlendState);
+    addValue(&hash, desc.SampleMask);
+    addValue(&hash, desc.RasterizerState);
+    addValue(&hash, desc.DepthStencilState);
+    for (UINT i = 0; i < desc.InputLayout.NumElements; ++i) {
+        const D3D12_INPUT_ELEMENT_DESC &e(desc.InputLayout.pInputElementDescs[i]);
+        hash.addData(e.SemanticName);
+        addValue(&hash, e.SemanticIndex);
+        addValue(&hash, e.Format);
+        addValue(&hash, e.InputSlot);
+        addValue(&hash, e.AlignedByteOffset);
+        addValue(&hash, e.InputSlotClass);
+        addValue(&hash, e.InstanceDataStepRate);
+    }
+    addValue(&hash, desc.IBStripCutValue);
+    addValue(&hash, desc.PrimitiveTopologyType);
+    addValue(&hash, desc.NumRenderTargets);
+    for (UINT i = 0; i < desc.NumRenderTargets; ++i)
+        addValue(&hash, desc.RTVFormats[i]);
+    addValue(&hash, desc.DSVFormat);
+    addValue(&hash, desc.SampleDesc);
+    addValue(&hash, desc.NodeMask);
+    addValue(&hash, desc.Flags);
+    return QByteArrayLiteral("g") + hash.result();
+}
+
+QByteArray QD3D12Util::pipelineKey(const D3D12_COMPUTE_PIPELINE_STATE_DESC &desc, const QByteArray &rootSignatureKey)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    if (rootSignatureKey.isEmpty())
+        addValue(&hash, desc.pRootSignature);
+    else
+        hash.addData(rootSignatureKey);
+    addBytecode(&hash, desc.CS);
+    addValue(&hash, desc.NodeMask);
+    addValue(&hash, desc.Flags);
+    return QByteArrayLiteral("c") + hash.result();
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,104 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtD3D12Window module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QD3D12UTIL_P_H
+#define QD3D12UTIL_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "qd3d12window.h"
+
+QT_BEGIN_NAMESPACE
+
+// Device level helpers shared by QD3D12Window and QD3D12OffscreenRenderer.
+namespace QD3D12Util
+{
+    bool createDevice(QD3D12Adapter::Preference preference, quint64 luid,
+                      ComPtr<IDXGIFactory4> *factory, ComPtr<ID3D12Device> *device);
+
+    DXGI_SAMPLE_DESC makeSampleDesc(ID3D12Device *device, DXGI_FORMAT format, int samples);
+    ID3D12Resource *createRenderTarget(ID3D12Device *device, D3D12_CPU_DESCRIPTOR_HANDLE viewHandle,
+                                       const QSize &size, const float *clearColor, int samples,
+                                       D3D12_RESOURCE_STATES initialState = D3D12_RESOURCE_STATE_RENDER_TARGET);
+    ID3D12Resource *createDepthStencil(ID3D12Device *device, D3D12_CPU_DESCRIPTOR_HANDLE viewHandle,
+                                       const QSize &size, int samples);
+
+    QD3D12Window::Fence *createFence(ID3D12Device *device);
+    void waitForGPU(ID3D12CommandQueue *commandQueue, QD3D12Window::Fence *f);
+
+    void transitionResource(ID3D12Resource *resource, ID3D12GraphicsCommandList *commandList,
+                            D3D12_RESOURCE_STATES before, D3D12_RESOURCE_STATES after);
+    void uavBarrier(ID3D12Resource *resource, ID3D12GraphicsCommandList *commandList);
+
+    bool umaHeapProperties(ID3D12Device *device, D3D12_HEAP_PROPERTIES *heapProp);
+    bool writeSubresources(ID3D12Resource *resource, const quint8 *src,
+                           const D3D12_PLACED_SUBRESOURCE_FOOTPRINT *layouts, int count);
+
+    inline quint32 alignedCBSize(quint32 size)
+    {
+        return (size + D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT - 1) & ~(D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT - 1);
+    }
+    inline quint32 alignedTexturePitch(quint32 rowPitch)
+    {
+        return (rowPitch + D3D12_TEXTURE_DATA_PITCH_ALIGNMENT - 1) & ~(D3D12_TEXTURE_DATA_PITCH_ALIGNMENT - 1);
+    }
+    inline quint32 alignedTextureOffset(quint32 offset)
+    {
+        return (offset + D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT - 1) & ~(D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT - 1);
+    }
+
+    QImage readbackRGBA8888(ID3D12Device *device, ID3D12CommandQueue *commandQueue,
+                            ID3D12Resource *rt, D3D12_RESOURCE_STATES rtState,
+                            ID3D12GraphicsCommandList *commandList);
+
+    QByteArray pipelineKey(const D3D12_GRAPHICS_PIPELINE_STATE_DESC &desc,
+                           const QByteArray &rootSignatureKey = QByteArray());
+    QByteArray pipelineKey(const D3D12_COMPUTE_PIPELINE_STATE_DESC &desc,
+                           const QByteArray &rootSignatureKey = QByteArray());
+}
+
+QT_END_NAMESPACE
+
+#endif
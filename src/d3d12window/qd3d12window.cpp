@@ -34,71 +34,16 @@
 **
 ****************************************************************************/
 
-#include "qd3d12window.h"
-#include <QtGui/private/qpaintdevicewindow_p.h>
+#include "qd3d12window_p.h"
+#include "qd3d12devicecontext_p.h"
+#include "qd3d12gpuprofiler_p.h"
+#include "qd3d12paintengine_p.h"
+#include "qd3d12residencymanager_p.h"
+#include "qd3d12streamingbuffer_p.h"
+#include "qd3d12util_p.h"
 
 QT_BEGIN_NAMESPACE
 
-class QD3D12WindowPrivate : public QPaintDeviceWindowPrivate
-{
-    Q_DECLARE_PUBLIC(QD3D12Window)
-
-public:
-    QD3D12WindowPrivate()
-        : initialized(false),
-          extraRenderTargetCount(0)
-    { }
-    ~QD3D12WindowPrivate();
-
-    void beginPaint(const QRegion &region) Q_DECL_OVERRIDE;
-    void flush(const QRegion &region) Q_DECL_OVERRIDE;
-
-    void initialize();
-    void setupRenderTargets();
-    void resize();
-    void deviceLost();
-    DXGI_SAMPLE_DESC makeSampleDesc(DXGI_FORMAT format, int samples);
-    ID3D12Resource *createOffscreenRenderTarget(D3D12_CPU_DESCRIPTOR_HANDLE viewHandle,
-                                                const QSize &size, const float *clearColor, int samples);
-    ID3D12Resource *createDepthStencil(D3D12_CPU_DESCRIPTOR_HANDLE viewHandle, const QSize &size, int samples);
-
-    bool initialized;
-    int swapChainBufferCount;
-    int extraRenderTargetCount;
-    ComPtr<ID3D12Device> device;
-    ComPtr<ID3D12CommandQueue> commandQueue;
-    ComPtr<IDXGISwapChain3> swapChain;
-    ComPtr<ID3D12DescriptorHeap> rtvHeap;
-    ComPtr<ID3D12DescriptorHeap> dsvHeap;
-    ComPtr<ID3D12Resource> renderTargets[2];
-    ComPtr<ID3D12Resource> depthStencil;
-    UINT rtvStride;
-    UINT dsvStride;
-    ComPtr<ID3D12CommandAllocator> commandAllocator;
-    ComPtr<ID3D12CommandAllocator> bundleAllocator;
-};
-
-static void getHardwareAdapter(IDXGIFactory1 *factory, IDXGIAdapter1 **outAdapter)
-{
-    ComPtr<IDXGIAdapter1> adapter;
-
-    for (int adapterIndex = 0; factory->EnumAdapters1(adapterIndex, &adapter) != DXGI_ERROR_NOT_FOUND; ++adapterIndex) {
-        DXGI_ADAPTER_DESC1 desc;
-        adapter->GetDesc1(&desc);
-
-        if (desc.Flags & DXGI_ADAPTER_FLAG_SOFTWARE)
-            continue;
-
-        if (SUCCEEDED(D3D12CreateDevice(adapter.Get(), D3D_FEATURE_LEVEL_11_0, _uuidof(ID3D12Device), Q_NULLPTR))) {
-            const QString name = QString::fromUtf16((char16_t *) desc.Description);
-            qDebug("Using adapter '%s'", qPrintable(name));
-            break;
-        }
-    }
-
-    *outAdapter = adapter.Detach();
-}
-
 void QD3D12WindowPrivate::initialize()
 {
     Q_Q(QD3D12Window);
@@ -106,51 +51,32 @@ void QD3D12WindowPrivate::initialize()
     if (initialized)
         return;
 
+    QD3D12_TRACE_SCOPE("initialize");
+
     swapChainBufferCount = 2;
 
     HWND hwnd = reinterpret_cast<HWND>(q->winId());
 
-    ComPtr<ID3D12Debug> debugController;
-    if (SUCCEEDED(D3D12GetDebugInterface(IID_PPV_ARGS(&debugController))))
-        debugController->EnableDebugLayer();
-
     ComPtr<IDXGIFactory4> factory;
-    if (FAILED(CreateDXGIFactory2(0, IID_PPV_ARGS(&factory)))) {
-        qWarning("Failed to create DXGI");
-        return;
-    }
-
-    ComPtr<IDXGIAdapter1> adapter;
-    getHardwareAdapter(factory.Get(), &adapter);
-
-    bool warp = true;
-    if (adapter) {
-        HRESULT hr = D3D12CreateDevice(adapter.Get(), D3D_FEATURE_LEVEL_11_0, IID_PPV_ARGS(&device));
-        if (SUCCEEDED(hr))
-            warp = false;
-        else
-            qWarning("Failed to create device: 0x%x", hr);
+    if (deviceContext) {
+        // Device and queue are shared, the rest is per window.
+        if (!deviceContext->create())
+            return;
+        QD3D12DeviceContextPrivate *cd = QD3D12DeviceContextPrivate::get(deviceContext);
+        factory = cd->factory;
+        device = cd->device;
+        commandQueue = cd->commandQueue;
     } else {
-        qWarning("No usable hardware adapters found");
-    }
-
-    if (warp) {
-        qDebug("Using WARP");
-        ComPtr<IDXGIAdapter> warpAdapter;
-        factory->EnumWarpAdapter(IID_PPV_ARGS(&warpAdapter));
-        HRESULT hr = D3D12CreateDevice(warpAdapter.Get(), D3D_FEATURE_LEVEL_11_0, IID_PPV_ARGS(&device));
-        if (FAILED(hr)) {
-            qWarning("Failed to create WARP device: 0x%x", hr);
+        if (!QD3D12Util::createDevice(adapterPreference, adapterLuid, &factory, &device))
             return;
-        }
-    }
 
-    D3D12_COMMAND_QUEUE_DESC queueDesc = {};
-    queueDesc.Type = D3D12_COMMAND_LIST_TYPE_DIRECT;
+        D3D12_COMMAND_QUEUE_DESC queueDesc = {};
+        queueDesc.Type = D3D12_COMMAND_LIST_TYPE_DIRECT;
 
-    if (FAILED(device->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&commandQueue)))) {
-        qWarning("Failed to create command queue");
-        return;
+        if (FAILED(device->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&commandQueue)))) {
+            qWarning("Failed to create command queue");
+            return;
+        }
     }
 
     DXGI_SWAP_CHAIN_DESC swapChainDesc = {};
@@ -207,104 +133,29 @@ void QD3D12WindowPrivate::initialize()
 
     setupRenderTargets();
 
-    initialized = true;
-
-    q->initializeD3D();
-}
-
-DXGI_SAMPLE_DESC QD3D12WindowPrivate::makeSampleDesc(DXGI_FORMAT format, int samples)
-{
-    DXGI_SAMPLE_DESC sampleDesc;
-    sampleDesc.Count = 1;
-    sampleDesc.Quality = 0;
-
-    if (samples > 1) {
-        D3D12_FEATURE_DATA_MULTISAMPLE_QUALITY_LEVELS msaaInfo = {};
-        msaaInfo.Format = format;
-        msaaInfo.SampleCount = samples;
-        if (SUCCEEDED(device->CheckFeatureSupport(D3D12_FEATURE_MULTISAMPLE_QUALITY_LEVELS, &msaaInfo, sizeof(msaaInfo)))) {
-            if (msaaInfo.NumQualityLevels > 0) {
-                sampleDesc.Count = samples;
-                sampleDesc.Quality = msaaInfo.NumQualityLevels - 1;
-            } else {
-                qWarning("No quality levels for multisampling?");
-            }
-        } else {
-            qWarning("Failed to query multisample quality levels");
-        }
-    }
-
-    return sampleDesc;
-}
-
-ID3D12Resource *QD3D12WindowPrivate::createOffscreenRenderTarget(D3D12_CPU_DESCRIPTOR_HANDLE viewHandle,
-                                                                 const QSize &size, const float *clearColor, int samples)
-{
-    D3D12_CLEAR_VALUE clearValue = {};
-    clearValue.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-    if (clearColor)
-        memcpy(clearValue.Color, clearColor, 4 * sizeof(float));
-
-    D3D12_HEAP_PROPERTIES heapProp = {};
-    heapProp.Type = D3D12_HEAP_TYPE_DEFAULT;
-
-    D3D12_RESOURCE_DESC rtDesc = {};
-    rtDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
-    rtDesc.Width = size.width();
-    rtDesc.Height = size.height();
-    rtDesc.DepthOrArraySize = 1;
-    rtDesc.MipLevels = 1;
-    rtDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-    rtDesc.SampleDesc = makeSampleDesc(rtDesc.Format, samples); // MSAA works here, unlike the backbuffer
-    rtDesc.Flags = D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET;
-
-    ID3D12Resource *resource = Q_NULLPTR;
-    if (FAILED(device->CreateCommittedResource(&heapProp, D3D12_HEAP_FLAG_NONE, &rtDesc,
-                                               D3D12_RESOURCE_STATE_RENDER_TARGET, &clearValue, IID_PPV_ARGS(&resource)))) {
-        qWarning("Failed to create offscreen render target of size %dx%d", size.width(), size.height());
-        return Q_NULLPTR;
-    }
-
-    device->CreateRenderTargetView(resource, Q_NULLPTR, viewHandle);
-
-    return resource;
-}
-
-ID3D12Resource *QD3D12WindowPrivate::createDepthStencil(D3D12_CPU_DESCRIPTOR_HANDLE viewHandle, const QSize &size, int samples)
-{
-    D3D12_CLEAR_VALUE depthClearValue = {};
-    depthClearValue.Format = DXGI_FORMAT_D32_FLOAT;
-    depthClearValue.DepthStencil.Depth = 1.0f;
-    depthClearValue.DepthStencil.Stencil = 0;
+    if (gpuProfiler && !QD3D12GpuProfilerPrivate::get(gpuProfiler)->initialize(device.Get(), commandQueue.Get()))
+        qWarning("GPU profiling is not available");
 
-    D3D12_HEAP_PROPERTIES heapProp = {};
-    heapProp.Type = D3D12_HEAP_TYPE_DEFAULT;
+    if (residencyManager && !QD3D12ResidencyManagerPrivate::get(residencyManager)->initialize(device.Get(), commandQueue.Get()))
+        qWarning("Residency management is not available");
 
-    D3D12_RESOURCE_DESC bufDesc = {};
-    bufDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
-    bufDesc.Width = size.width();
-    bufDesc.Height = size.height();
-    bufDesc.DepthOrArraySize = 1;
-    bufDesc.MipLevels = 1;
-    bufDesc.Format = DXGI_FORMAT_D32_FLOAT;
-    bufDesc.SampleDesc = makeSampleDesc(bufDesc.Format, samples);
-    bufDesc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
-    bufDesc.Flags = D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL;
+    if (streamingBuffer && !QD3D12StreamingBufferPrivate::get(streamingBuffer)->initialize(device.Get(), commandQueue.Get()))
+        qWarning("The streaming buffer is not available");
 
-    ID3D12Resource *resource = Q_NULLPTR;
-    if (FAILED(device->CreateCommittedResource(&heapProp, D3D12_HEAP_FLAG_NONE, &bufDesc,
-                                               D3D12_RESOURCE_STATE_DEPTH_WRITE, &depthClearValue, IID_PPV_ARGS(&resource)))) {
-        qWarning("Failed to create depth-stencil buffer of size %dx%d", size.width(), size.height());
-        return Q_NULLPTR;
+    // The paint engine is ready before the first beginPaint() so that
+    // QPainter can be used in any frame.
+    if (!paintEngine) {
+        paintEngine = new QD3D12PaintEngine;
+        frameObservers.append(QD3D12PaintEnginePrivate::get(paintEngine));
     }
+    paintEngine->create(device.Get(), commandQueue.Get());
 
-    D3D12_DEPTH_STENCIL_VIEW_DESC depthStencilDesc = {};
-    depthStencilDesc.Format = DXGI_FORMAT_D32_FLOAT;
-    depthStencilDesc.ViewDimension = bufDesc.SampleDesc.Count <= 1 ? D3D12_DSV_DIMENSION_TEXTURE2D : D3D12_DSV_DIMENSION_TEXTURE2DMS;
+    initialized = true;
 
-    device->CreateDepthStencilView(resource, &depthStencilDesc, viewHandle);
+    foreach (QD3D12FrameObserver *observer, frameObservers)
+        observer->initializeResources();
 
-    return resource;
+    q->initializeD3D();
 }
 
 void QD3D12WindowPrivate::setupRenderTargets()
@@ -321,7 +172,7 @@ void QD3D12WindowPrivate::setupRenderTargets()
         rtvHandle.ptr += rtvStride;
     }
 
-    ID3D12Resource *ds = createDepthStencil(dsvHeap->GetCPUDescriptorHandleForHeapStart(), q->size(), 0);
+    ID3D12Resource *ds = QD3D12Util::createDepthStencil(device.Get(), dsvHeap->GetCPUDescriptorHandleForHeapStart(), q->size(), 0);
     if (ds)
         depthStencil.Attach(ds);
 }
@@ -333,6 +184,12 @@ void QD3D12WindowPrivate::resize()
     if (!initialized)
         return;
 
+    // The batch may still reference the old buffers.
+    if (presentPending)
+        QD3D12DeviceContextPrivate::get(deviceContext)->flushBatch();
+    if (!initialized)
+        return;
+
     // Clear these, otherwise resizing will fail.
     depthStencil = Q_NULLPTR;
     for (int i = 0; i < swapChainBufferCount; ++i)
@@ -350,15 +207,17 @@ void QD3D12WindowPrivate::resize()
     setupRenderTargets();
 }
 
-void QD3D12WindowPrivate::deviceLost()
+void QD3D12WindowPrivate::releaseResources()
 {
     Q_Q(QD3D12Window);
-    qWarning("D3D device lost");
 
     // Release all resources. This is important because otherwise reinitialization may fail.
 
     q->releaseD3D();
 
+    foreach (QD3D12FrameObserver *observer, frameObservers)
+        observer->releaseResources();
+
     bundleAllocator = Q_NULLPTR;
     commandAllocator = Q_NULLPTR;
     rtvStride = dsvStride = 0;
@@ -371,27 +230,93 @@ void QD3D12WindowPrivate::deviceLost()
     swapChain = Q_NULLPTR;
     device = Q_NULLPTR;
 
+    inFrame = false;
+    presentPending = false;
     initialized = false;
+}
+
+void QD3D12WindowPrivate::deviceLost()
+{
+    if (deviceContext) {
+        // Takes down all windows sharing the device. This one comes back
+        // right away since the caller continues with the frame.
+        QD3D12DeviceContextPrivate::get(deviceContext)->deviceLost();
+        initialize();
+        return;
+    }
+
+    qWarning("D3D device lost");
+    releaseResources();
     initialize();
 }
 
+// The shared device went away.
+void QD3D12WindowPrivate::contextLost()
+{
+    Q_Q(QD3D12Window);
+    if (!initialized)
+        return;
+
+    releaseResources();
+    q->requestUpdate();
+}
+
 QD3D12WindowPrivate::~QD3D12WindowPrivate()
 {
+    if (deviceContext)
+        QD3D12DeviceContextPrivate::get(deviceContext)->detach(this);
+    delete paintEngine;
 }
 
 void QD3D12WindowPrivate::beginPaint(const QRegion &region)
 {
     Q_UNUSED(region);
 
+#ifdef QD3D12_FRAME_TRACE
+    const qint64 now = QD3D12FrameTrace::now();
+    if (frameStart)
+        frameTrace.histograms[QD3D12Window::FrameInterval].add((now - frameStart) / 1000000.0f);
+    frameStart = now;
+#endif
+
+    // The previous frame must be presented before rendering the next one.
+    if (presentPending)
+        QD3D12DeviceContextPrivate::get(deviceContext)->flushBatch();
+
     initialize();
+
+    foreach (QD3D12FrameObserver *observer, frameObservers)
+        observer->beginFrame();
+
+    inFrame = true;
 }
 
 void QD3D12WindowPrivate::flush(const QRegion &region)
 {
-    Q_Q(QD3D12Window);
     Q_UNUSED(region);
 
-    HRESULT hr = swapChain->Present(1, 0);
+    inFrame = false;
+
+    if (deviceContext && initialized) {
+        QD3D12DeviceContextPrivate::get(deviceContext)->queuePresent(this);
+        return;
+    }
+
+    present();
+}
+
+void QD3D12WindowPrivate::present()
+{
+    Q_Q(QD3D12Window);
+
+    foreach (QD3D12FrameObserver *observer, frameObservers)
+        observer->endFrame();
+
+    HRESULT hr;
+    {
+        QD3D12_TRACE_PHASE(this, QD3D12Window::PresentPhase, "Present");
+        hr = swapChain->Present(1, 0);
+    }
     if (hr == DXGI_ERROR_DEVICE_REMOVED || hr == DXGI_ERROR_DEVICE_RESET) {
         deviceLost();
         return;
@@ -400,7 +325,16 @@ void QD3D12WindowPrivate::flush(const QRegion &region)
         return;
     }
 
-    q->afterPresent();
+    {
+        QD3D12_TRACE_PHASE(this, QD3D12Window::AfterPresentPhase, "afterPresent");
+        q->afterPresent();
+    }
+
+#ifdef QD3D12_FRAME_TRACE
+    const qint64 frameEnd = QD3D12FrameTrace::now();
+    QD3D12TraceRing::current()->record("frame", frameStart, frameEnd);
+    frameTrace.histograms[QD3D12Window::FrameTime].add((frameEnd - frameStart) / 1000000.0f);
+#endif
 }
 
 QD3D12Window::QD3D12Window(QWindow *parent)
@@ -419,13 +353,192 @@ void QD3D12Window::setExtraRenderTargetCount(int count)
     d->extraRenderTargetCount = qMax(0, count);
 }
 
+// Enables the timestamp based GPU profiler, see gpuProfiler(). Must be called
+// before the window is first exposed.
+void QD3D12Window::setGpuProfilingEnabled(bool enable)
+{
+    Q_D(QD3D12Window);
+    if (d->initialized) {
+        qWarning("setGpuProfilingEnabled: Already initialized, request ignored.");
+        return;
+    }
+    if (enable == (d->gpuProfiler != Q_NULLPTR))
+        return;
+
+    if (enable) {
+        d->gpuProfiler = new QD3D12GpuProfiler(this);
+        d->frameObservers.append(QD3D12GpuProfilerPrivate::get(d->gpuProfiler));
+    } else {
+        d->frameObservers.removeOne(QD3D12GpuProfilerPrivate::get(d->gpuProfiler));
+        delete d->gpuProfiler;
+        d->gpuProfiler = Q_NULLPTR;
+    }
+}
+
+// Enables tracking the video memory budget and evicting least recently used
+// resources when going over it, see residencyManager(). Must be called
+// before the window is first exposed.
+void QD3D12Window::setResidencyManagementEnabled(bool enable)
+{
+    Q_D(QD3D12Window);
+    if (d->initialized) {
+        qWarning("setResidencyManagementEnabled: Already initialized, request ignored.");
+        return;
+    }
+    if (enable == (d->residencyManager != Q_NULLPTR))
+        return;
+
+    if (enable) {
+        d->residencyManager = new QD3D12ResidencyManager(this);
+        d->frameObservers.append(QD3D12ResidencyManagerPrivate::get(d->residencyManager));
+    } else {
+        d->frameObservers.removeOne(QD3D12ResidencyManagerPrivate::get(d->residencyManager));
+        delete d->residencyManager;
+        d->residencyManager = Q_NULLPTR;
+    }
+}
+
+// Enables a persistently mapped buffer with frameSize bytes per frame for
+// vertices, indices and constants that change every frame, see
+// streamingBuffer(). 0 disables it. Must be called before the window is
+// first exposed.
+void QD3D12Window::setStreamingBufferSize(quint32 frameSize)
+{
+    Q_D(QD3D12Window);
+    if (d->initialized) {
+        qWarning("setStreamingBufferSize: Already initialized, request ignored.");
+        return;
+    }
+
+    if (d->streamingBuffer) {
+        d->frameObservers.removeOne(QD3D12StreamingBufferPrivate::get(d->streamingBuffer));
+        delete d->streamingBuffer;
+        d->streamingBuffer = Q_NULLPTR;
+    }
+    if (frameSize) {
+        d->streamingBuffer = new QD3D12StreamingBuffer(frameSize, this);
+        d->frameObservers.append(QD3D12StreamingBufferPrivate::get(d->streamingBuffer));
+    }
+}
+
+// Selects the adapter when there is more than one, for example the
+// discrete instead of the integrated GPU on hybrid laptops. The
+// QT_D3D12_ADAPTER environment variable takes precedence.
+void QD3D12Window::setAdapterPreference(QD3D12Adapter::Preference preference)
+{
+    Q_D(QD3D12Window);
+    if (d->initialized) {
+        qWarning("setAdapterPreference: Already initialized, request ignored.");
+        return;
+    }
+    d->adapterPreference = preference;
+}
+
+QD3D12Adapter::Preference QD3D12Window::adapterPreference() const
+{
+    Q_D(const QD3D12Window);
+    return d->adapterPreference;
+}
+
+// Requests a specific adapter, see QD3D12Adapter::adapters(). Takes
+// precedence over the preference, 0 means no specific adapter.
+void QD3D12Window::setAdapterLuid(quint64 luid)
+{
+    Q_D(QD3D12Window);
+    if (d->initialized) {
+        qWarning("setAdapterLuid: Already initialized, request ignored.");
+        return;
+    }
+    d->adapterLuid = luid;
+}
+
+quint64 QD3D12Window::adapterLuid() const
+{
+    Q_D(const QD3D12Window);
+    return d->adapterLuid;
+}
+
+QD3D12GpuProfiler *QD3D12Window::gpuProfiler() const
+{
+    Q_D(const QD3D12Window);
+    return d->gpuProfiler;
+}
+
+QD3D12ResidencyManager *QD3D12Window::residencyManager() const
+{
+    Q_D(const QD3D12Window);
+    return d->residencyManager;
+}
+
+QD3D12StreamingBuffer *QD3D12Window::streamingBuffer() const
+{
+    Q_D(const QD3D12Window);
+    return d->streamingBuffer;
+}
+
+// Shares the device, the queue and the caches of context with the other
+// windows attached to it. Must be called before the window is first exposed.
+void QD3D12Window::setDeviceContext(QD3D12DeviceContext *context)
+{
+    Q_D(QD3D12Window);
+    if (d->initialized) {
+        qWarning("setDeviceContext: Already initialized, request ignored.");
+        return;
+    }
+    if (d->deviceContext == context)
+        return;
+
+    if (d->deviceContext)
+        QD3D12DeviceContextPrivate::get(d->deviceContext)->detach(d);
+    d->deviceContext = context;
+    if (d->deviceContext)
+        QD3D12DeviceContextPrivate::get(d->deviceContext)->attach(d);
+}
+
+QD3D12DeviceContext *QD3D12Window::deviceContext() const
+{
+    Q_D(const QD3D12Window);
+    return d->deviceContext;
+}
+
+// Same as commandQueue()->ExecuteCommandLists(), except that with a device
+// context the lists submitted from paintD3D() are held back and executed
+// together with the other windows' frames. Work that has to complete within
+// paintD3D(), like a readback, should go to commandQueue() directly.
+void QD3D12Window::executeCommandLists(int count, ID3D12CommandList *const *commandLists)
+{
+    Q_D(QD3D12Window);
+    if (d->deviceContext && d->inFrame)
+        QD3D12DeviceContextPrivate::get(d->deviceContext)->submit(d, count, commandLists);
+    else
+        d->commandQueue->ExecuteCommandLists(count, commandLists);
+}
+
 void QD3D12Window::paintEvent(QPaintEvent *event)
 {
     Q_UNUSED(event);
+    Q_D(QD3D12Window);
+    Q_UNUSED(d);
 
+    QD3D12_TRACE_PHASE(d, PaintPhase, "paintD3D");
     paintD3D();
 }
 
+// Makes QPainter work on the window, see QD3D12PaintEngine. Painting is
+// meant to happen in paintD3D() and ends up on the current back buffer. The
+// engine is created together with the device.
+QPaintEngine *QD3D12Window::paintEngine() const
+{
+    Q_D(const QD3D12Window);
+    if (d->initialized) {
+        QD3D12PaintEnginePrivate::get(d->paintEngine)->setTarget(backBufferRenderTarget(),
+                                                                 backBufferRenderTargetCPUHandle(),
+                                                                 D3D12_RESOURCE_STATE_PRESENT,
+                                                                 const_cast<QD3D12Window *>(this));
+    }
+    return d->paintEngine;
+}
+
 void QD3D12Window::resizeEvent(QResizeEvent *event)
 {
     Q_UNUSED(event);
@@ -434,6 +547,8 @@ void QD3D12Window::resizeEvent(QResizeEvent *event)
     if (!isExposed() || size().isEmpty())
         return;
 
+    QD3D12_TRACE_PHASE(d, ResizePhase, "resize");
+
     d->resize();
     resizeD3D(size());
     paintD3D();
@@ -467,50 +582,24 @@ ID3D12CommandAllocator *QD3D12Window::bundleAllocator() const
 QD3D12Window::Fence *QD3D12Window::createFence() const
 {
     Q_D(const QD3D12Window);
-    Fence *f = new Fence;
-    if (FAILED(d->device->CreateFence(f->value, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&f->fence)))) {
-        qWarning("Failed to create fence");
-        return f;
-    }
-    f->event = CreateEvent(Q_NULLPTR, FALSE, FALSE, Q_NULLPTR);
-    return f;
+    return QD3D12Util::createFence(d->device.Get());
 }
 
 void QD3D12Window::waitForGPU(Fence *f) const
 {
     Q_D(const QD3D12Window);
-    const UINT64 newValue = f->value.fetchAndAddAcquire(1) + 1;
-    d->commandQueue->Signal(f->fence.Get(), newValue);
-    if (f->fence->GetCompletedValue() < newValue) {
-        if (FAILED(f->fence->SetEventOnCompletion(newValue, f->event))) {
-            qWarning("SetEventOnCompletion failed");
-            return;
-        }
-        WaitForSingleObject(f->event, INFINITE);
-    }
+    QD3D12Util::waitForGPU(d->commandQueue.Get(), f);
 }
 
 void QD3D12Window::transitionResource(ID3D12Resource *resource, ID3D12GraphicsCommandList *commandList,
                                       D3D12_RESOURCE_STATES before, D3D12_RESOURCE_STATES after) const
 {
-    D3D12_RESOURCE_BARRIER barrier;
-    barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
-    barrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
-    barrier.Transition.pResource = resource;
-    barrier.Transition.StateBefore = before;
-    barrier.Transition.StateAfter = after;
-    barrier.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
-
-    commandList->ResourceBarrier(1, &barrier);
+    QD3D12Util::transitionResource(resource, commandList, before, after);
 }
 
 void QD3D12Window::uavBarrier(ID3D12Resource *resource, ID3D12GraphicsCommandList *commandList) const
 {
-    D3D12_RESOURCE_BARRIER barrier = {};
-    barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
-    barrier.UAV.pResource = resource;
-
-    commandList->ResourceBarrier(1, &barrier);
+    QD3D12Util::uavBarrier(resource, commandList);
 }
 
 ID3D12Resource *QD3D12Window::backBufferRenderTarget() const
@@ -534,6 +623,14 @@ D3D12_CPU_DESCRIPTOR_HANDLE QD3D12Window::depthStencilCPUHandle() const
     return d->dsvHeap->GetCPUDescriptorHandleForHeapStart();
 }
 
+// Kept in the DEPTH_WRITE state. The format is R32_TYPELESS,
+// so that it can be read as R32_FLOAT too.
+ID3D12Resource *QD3D12Window::depthStencil() const
+{
+    Q_D(const QD3D12Window);
+    return d->depthStencil.Get();
+}
+
 D3D12_CPU_DESCRIPTOR_HANDLE QD3D12Window::extraRenderTargetCPUHandle(int idx) const
 {
     Q_D(const QD3D12Window);
@@ -558,7 +655,7 @@ ID3D12Resource *QD3D12Window::createExtraRenderTargetAndView(D3D12_CPU_DESCRIPTO
                                                              int samples)
 {
     Q_D(QD3D12Window);
-    return d->createOffscreenRenderTarget(viewHandle, size, clearColor, samples);
+    return QD3D12Util::createRenderTarget(d->device.Get(), viewHandle, size, clearColor, samples);
 }
 
 ID3D12Resource *QD3D12Window::createExtraDepthStencilAndView(D3D12_CPU_DESCRIPTOR_HANDLE viewHandle,
@@ -566,86 +663,56 @@ ID3D12Resource *QD3D12Window::createExtraDepthStencilAndView(D3D12_CPU_DESCRIPTO
                                                              int samples)
 {
     Q_D(QD3D12Window);
-    return d->createDepthStencil(viewHandle, size, samples);
+    return QD3D12Util::createDepthStencil(d->device.Get(), viewHandle, size, samples);
 }
 
 quint32 QD3D12Window::alignedCBSize(quint32 size) const
 {
-    return (size + D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT - 1) & ~(D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT - 1);
+    return QD3D12Util::alignedCBSize(size);
 }
 
 quint32 QD3D12Window::alignedTexturePitch(quint32 rowPitch) const
 {
-    return (rowPitch + D3D12_TEXTURE_DATA_PITCH_ALIGNMENT - 1) & ~(D3D12_TEXTURE_DATA_PITCH_ALIGNMENT - 1);
+    return QD3D12Util::alignedTexturePitch(rowPitch);
 }
 
 quint32 QD3D12Window::alignedTextureOffset(quint32 offset) const
 {
-    return (offset + D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT - 1) & ~(D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT - 1);
+    return QD3D12Util::alignedTextureOffset(offset);
 }
 
 QImage QD3D12Window::readbackRGBA8888(ID3D12Resource *rt, D3D12_RESOURCE_STATES rtState, ID3D12GraphicsCommandList *commandList)
 {
-    ComPtr<ID3D12Resource> readbackBuf;
-
-    D3D12_RESOURCE_DESC rtDesc = rt->GetDesc();
-    UINT64 textureByteSize = 0;
-    D3D12_PLACED_SUBRESOURCE_FOOTPRINT textureLayout = {};
-    device()->GetCopyableFootprints(&rtDesc, 0, 1, 0, &textureLayout, Q_NULLPTR, Q_NULLPTR, &textureByteSize);
-
-    D3D12_HEAP_PROPERTIES heapProp = {};
-    heapProp.Type = D3D12_HEAP_TYPE_READBACK;
-
-    D3D12_RESOURCE_DESC bufDesc = {};
-    bufDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
-    bufDesc.Width = textureByteSize;
-    bufDesc.Height = 1;
-    bufDesc.DepthOrArraySize = 1;
-    bufDesc.MipLevels = 1;
-    bufDesc.Format = DXGI_FORMAT_UNKNOWN;
-    bufDesc.SampleDesc.Count = 1;
-    bufDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
-
-    if (FAILED(device()->CreateCommittedResource(&heapProp, D3D12_HEAP_FLAG_NONE, &bufDesc,
-                                            D3D12_RESOURCE_STATE_COPY_DEST, Q_NULLPTR, IID_PPV_ARGS(&readbackBuf)))) {
-        qWarning("Failed to create committed resource (readback buffer)");
-        return QImage();
-    }
-
-    D3D12_TEXTURE_COPY_LOCATION dstLoc;
-    dstLoc.pResource = readbackBuf.Get();
-    dstLoc.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
-    dstLoc.PlacedFootprint = textureLayout;
-    D3D12_TEXTURE_COPY_LOCATION srcLoc;
-    srcLoc.pResource = rt;
-    srcLoc.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
-    srcLoc.SubresourceIndex = 0;
-
-    transitionResource(rt, commandList, rtState, D3D12_RESOURCE_STATE_COPY_SOURCE);
-    commandList->CopyTextureRegion(&dstLoc, 0, 0, 0, &srcLoc, Q_NULLPTR);
-    transitionResource(rt, commandList, D3D12_RESOURCE_STATE_COPY_SOURCE, rtState);
-    commandList->Close();
-
-    ID3D12CommandList *commandLists[] = { commandList };
-    commandQueue()->ExecuteCommandLists(_countof(commandLists), commandLists);
-    QScopedPointer<Fence> f(createFence());
-    waitForGPU(f.data());
-
-    QImage img(rtDesc.Width, rtDesc.Height, QImage::Format_RGBA8888);
-    quint8 *p = Q_NULLPTR;
-    D3D12_RANGE readRange = { 0, 0 };
-    if (FAILED(readbackBuf->Map(0, &readRange, reinterpret_cast<void **>(&p)))) {
-        qWarning("Mapping the readback buffer failed");
-        return QImage();
-    }
-    for (UINT y = 0; y < rtDesc.Height; ++y) {
-        quint8 *dst = img.scanLine(y);
-        memcpy(dst, p, rtDesc.Width * 4);
-        p += textureLayout.Footprint.RowPitch;
-    }
-    readbackBuf->Unmap(0, Q_NULLPTR);
+    Q_D(QD3D12Window);
+    return QD3D12Util::readbackRGBA8888(d->device.Get(), d->commandQueue.Get(), rt, rtState, commandList);
+}
 
-    return img;
+// Percentiles over the last 1024 samples of phase. Only available when the
+// module is built with CONFIG+=d3d12_frame_trace, returns an empty result
+// otherwise.
+QD3D12Window::FrameTimeStatistics QD3D12Window::frameTimeStatistics(FramePhase phase) const
+{
+#ifdef QD3D12_FRAME_TRACE
+    Q_D(const QD3D12Window);
+    return d->frameTrace.histograms[phase].statistics();
+#else
+    Q_UNUSED(phase);
+    return FrameTimeStatistics();
+#endif
+}
+
+// Writes the recorded frame phases of all windows and threads to fileName as
+// Chrome/Perfetto trace JSON. Returns false when tracing is not compiled in or
+// the file cannot be written.
+bool QD3D12Window::exportFrameTrace(const QString &fileName)
+{
+#ifdef QD3D12_FRAME_TRACE
+    return QD3D12FrameTrace::exportChromeTrace(fileName);
+#else
+    Q_UNUSED(fileName);
+    qWarning("exportFrameTrace: Frame tracing is not enabled in this build");
+    return false;
+#endif
 }
 
 void QD3D12Window::initializeD3D()
@@ -41,6 +41,7 @@
 #include <QPaintDeviceWindow>
 #include <QImage>
 #include <QtD3D12Window/qd3d12windowglobal.h>
+#include <QtD3D12Window/qd3d12adapter.h>
 
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
@@ -53,6 +54,10 @@ using namespace Microsoft::WRL;
 QT_BEGIN_NAMESPACE
 
 class QD3D12WindowPrivate;
+class QD3D12GpuProfiler;
+class QD3D12ResidencyManager;
+class QD3D12StreamingBuffer;
+class QD3D12DeviceContext;
 
 class QD3D12_EXPORT QD3D12Window : public QPaintDeviceWindow
 {
@@ -70,9 +75,36 @@ public:
         Q_DISABLE_COPY(Fence)
     };
 
+    enum FramePhase {
+        FrameTime,
+        FrameInterval,
+        PaintPhase,
+        PresentPhase,
+        AfterPresentPhase,
+        ResizePhase
+    };
+
+    struct FrameTimeStatistics {
+        FrameTimeStatistics() : sampleCount(0), p50(0), p95(0), p99(0), max(0) { }
+        int sampleCount;
+        float p50;
+        float p95;
+        float p99;
+        float max;
+    };
+
     QD3D12Window(QWindow *parent = Q_NULLPTR);
 
     void setExtraRenderTargetCount(int count);
+    void setGpuProfilingEnabled(bool enable);
+    void setResidencyManagementEnabled(bool enable);
+    void setStreamingBufferSize(quint32 frameSize);
+    void setAdapterPreference(QD3D12Adapter::Preference preference);
+    QD3D12Adapter::Preference adapterPreference() const;
+    void setAdapterLuid(quint64 luid);
+    quint64 adapterLuid() const;
+    void setDeviceContext(QD3D12DeviceContext *context);
+    QD3D12DeviceContext *deviceContext() const;
 
     virtual void initializeD3D();
     virtual void releaseD3D();
@@ -84,6 +116,11 @@ public:
     ID3D12CommandQueue *commandQueue() const;
     ID3D12CommandAllocator *commandAllocator() const;
     ID3D12CommandAllocator *bundleAllocator() const;
+    QD3D12GpuProfiler *gpuProfiler() const;
+    QD3D12ResidencyManager *residencyManager() const;
+    QD3D12StreamingBuffer *streamingBuffer() const;
+
+    void executeCommandLists(int count, ID3D12CommandList *const *commandLists);
 
     Fence *createFence() const;
     void waitForGPU(Fence *f) const;
@@ -96,6 +133,7 @@ public:
     D3D12_CPU_DESCRIPTOR_HANDLE backBufferRenderTargetCPUHandle() const;
 
     D3D12_CPU_DESCRIPTOR_HANDLE depthStencilCPUHandle() const;
+    ID3D12Resource *depthStencil() const;
 
     D3D12_CPU_DESCRIPTOR_HANDLE extraRenderTargetCPUHandle(int idx) const;
     D3D12_CPU_DESCRIPTOR_HANDLE extraDepthStencilCPUHandle(int idx) const;
@@ -114,9 +152,13 @@ public:
 
     QImage readbackRGBA8888(ID3D12Resource *rt, D3D12_RESOURCE_STATES rtState, ID3D12GraphicsCommandList *commandList);
 
+    FrameTimeStatistics frameTimeStatistics(FramePhase phase = FrameTime) const;
+    static bool exportFrameTrace(const QString &fileName);
+
 protected:
     void paintEvent(QPaintEvent *event) Q_DECL_OVERRIDE;
     void resizeEvent(QResizeEvent *) Q_DECL_OVERRIDE;
+    QPaintEngine *paintEngine() const Q_DECL_OVERRIDE;
 
 private:
     Q_DISABLE_COPY(QD3D12Window)
@@ -0,0 +1,154 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtD3D12Window module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QD3D12WINDOW_P_H
+#define QD3D12WINDOW_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "qd3d12window.h"
+#include "qd3d12frametrace_p.h"
+#include <QtCore/QVector>
+#include <QtGui/private/qpaintdevicewindow_p.h>
+
+QT_BEGIN_NAMESPACE
+
+// Internal helpers that need to be told about frame boundaries and device
+// loss. Registered with the window's private; all calls happen on the GUI
+// thread.
+class QD3D12FrameObserver
+{
+public:
+    virtual ~QD3D12FrameObserver() { }
+
+    // Called when the device has been (re)created, right before
+    // initializeD3D().
+    virtual void initializeResources() { }
+
+    // Called from beginPaint(), before paintD3D(). The previous frame has
+    // been presented at this point.
+    virtual void beginFrame() = 0;
+
+    // Called from flush(), after paintD3D() and right before Present.
+    virtual void endFrame() { }
+
+    // Called when the device is about to go away. All D3D objects created
+    // with the old device must be dropped.
+    virtual void releaseResources() = 0;
+};
+
+class QD3D12GpuProfiler;
+class QD3D12ResidencyManager;
+class QD3D12StreamingBuffer;
+class QD3D12DeviceContext;
+class QD3D12PaintEngine;
+
+class QD3D12WindowPrivate : public QPaintDeviceWindowPrivate
+{
+    Q_DECLARE_PUBLIC(QD3D12Window)
+
+public:
+    QD3D12WindowPrivate()
+        : initialized(false),
+          extraRenderTargetCount(0),
+          adapterPreference(QD3D12Adapter::DefaultPreference),
+          adapterLuid(0),
+          deviceContext(Q_NULLPTR),
+          inFrame(false),
+          presentPending(false),
+          gpuProfiler(Q_NULLPTR),
+          residencyManager(Q_NULLPTR),
+          streamingBuffer(Q_NULLPTR),
+          paintEngine(Q_NULLPTR),
+          frameStart(0)
+    { }
+    ~QD3D12WindowPrivate();
+
+    static QD3D12WindowPrivate *get(QD3D12Window *w) { return w->d_func(); }
+
+    void beginPaint(const QRegion &region) Q_DECL_OVERRIDE;
+    void flush(const QRegion &region) Q_DECL_OVERRIDE;
+
+    void initialize();
+    void setupRenderTargets();
+    void resize();
+    void present();
+    void releaseResources();
+    void deviceLost();
+    void contextLost();
+
+    bool initialized;
+    int swapChainBufferCount;
+    int extraRenderTargetCount;
+    QD3D12Adapter::Preference adapterPreference;
+    quint64 adapterLuid;
+    QD3D12DeviceContext *deviceContext;
+    bool inFrame;
+    bool presentPending;
+    ComPtr<ID3D12Device> device;
+    ComPtr<ID3D12CommandQueue> commandQueue;
+    ComPtr<IDXGISwapChain3> swapChain;
+    ComPtr<ID3D12DescriptorHeap> rtvHeap;
+    ComPtr<ID3D12DescriptorHeap> dsvHeap;
+    ComPtr<ID3D12Resource> renderTargets[2];
+    ComPtr<ID3D12Resource> depthStencil;
+    UINT rtvStride;
+    UINT dsvStride;
+    ComPtr<ID3D12CommandAllocator> commandAllocator;
+    ComPtr<ID3D12CommandAllocator> bundleAllocator;
+    QVector<QD3D12FrameObserver *> frameObservers;
+    QD3D12GpuProfiler *gpuProfiler;
+    QD3D12ResidencyManager *residencyManager;
+    QD3D12StreamingBuffer *streamingBuffer;
+    QD3D12PaintEngine *paintEngine; // created with the device
+    qint64 frameStart;
+#ifdef QD3D12_FRAME_TRACE
+    QD3D12FrameTrace frameTrace;
+#endif
+};
+
+QT_END_NAMESPACE
+
+#endif
@@ -0,0 +1,2 @@
+TEMPLATE = subdirs
+SUBDIRS += qd3d12formatinfo
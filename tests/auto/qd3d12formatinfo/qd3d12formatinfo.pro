@@ -0,0 +1,15 @@
+CONFIG += testcase
+TARGET = tst_qd3d12formatinfo
+
+SOURCES += tst_qd3d12formatinfo.cpp
+
+win32 {
+    QT = core testlib d3d12window
+    LIBS += -ld3d12
+} else {
+    # No Windows SDK: build the format code into the test against the minimal
+    # d3d12.h in nodevice and check the recorded footprints only.
+    QT = core testlib
+    INCLUDEPATH += nodevice
+    SOURCES += ../../../src/d3d12window/qd3d12formatinfo.cpp
+}
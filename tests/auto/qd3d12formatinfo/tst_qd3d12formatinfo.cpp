@@ -0,0 +1,336 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtD3D12Window module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include <QtTest/QtTest>
+#include <QtD3D12Window/qd3d12formatinfo.h>
+
+#ifdef Q_OS_WIN
+#include <wrl/client.h>
+
+using namespace Microsoft::WRL;
+#endif
+
+struct Footprint
+{
+    UINT64 offset;
+    DXGI_FORMAT format;
+    UINT width;
+    UINT height;
+    UINT depth;
+    UINT rowPitch;
+    UINT numRows;
+    UINT64 rowSize;
+};
+
+typedef QVector<Footprint> FootprintList;
+Q_DECLARE_METATYPE(D3D12_RESOURCE_DESC)
+Q_DECLARE_METATYPE(FootprintList)
+
+class tst_QD3D12FormatInfo : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void mipLevelCount_data();
+    void mipLevelCount();
+    void copyableFootprints_data();
+    void copyableFootprints();
+    void outOfRange();
+
+#ifdef Q_OS_WIN
+private:
+    ComPtr<ID3D12Device> device;
+#endif
+};
+
+static D3D12_RESOURCE_DESC resourceDesc(D3D12_RESOURCE_DIMENSION dimension, DXGI_FORMAT format,
+                                        UINT64 width, UINT height, UINT16 depthOrArraySize, UINT16 mipLevels)
+{
+    D3D12_RESOURCE_DESC desc = {};
+    desc.Dimension = dimension;
+    desc.Format = format;
+    desc.Width = width;
+    desc.Height = height;
+    desc.DepthOrArraySize = depthOrArraySize;
+    desc.MipLevels = mipLevels;
+    desc.SampleDesc.Count = 1;
+    desc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
+    return desc;
+}
+
+template <int N>
+static FootprintList footprints(const Footprint (&expected)[N])
+{
+    FootprintList list;
+    for (int i = 0; i < N; ++i)
+        list.append(expected[i]);
+    return list;
+}
+
+// Without a device only the recorded values are checked. With one, the same
+// descs also go through the runtime so that the recorded values stay honest.
+void tst_QD3D12FormatInfo::initTestCase()
+{
+#ifdef Q_OS_WIN
+    if (FAILED(D3D12CreateDevice(Q_NULLPTR, D3D_FEATURE_LEVEL_11_0, IID_PPV_ARGS(&device))))
+        qWarning("No D3D12 device, comparing against recorded footprints only");
+#endif
+}
+
+void tst_QD3D12FormatInfo::mipLevelCount_data()
+{
+    QTest::addColumn<D3D12_RESOURCE_DESC>("desc");
+    QTest::addColumn<UINT>("levels");
+
+    QTest::newRow("explicit") << resourceDesc(D3D12_RESOURCE_DIMENSION_TEXTURE2D, DXGI_FORMAT_R8G8B8A8_UNORM, 300, 200, 1, 4) << 4u;
+    QTest::newRow("npot") << resourceDesc(D3D12_RESOURCE_DIMENSION_TEXTURE2D, DXGI_FORMAT_R8G8B8A8_UNORM, 300, 200, 1, 0) << 9u;
+    QTest::newRow("pot") << resourceDesc(D3D12_RESOURCE_DIMENSION_TEXTURE2D, DXGI_FORMAT_R8G8B8A8_UNORM, 256, 16, 1, 0) << 9u;
+    QTest::newRow("1x1") << resourceDesc(D3D12_RESOURCE_DIMENSION_TEXTURE2D, DXGI_FORMAT_R8G8B8A8_UNORM, 1, 1, 1, 0) << 1u;
+    QTest::newRow("array") << resourceDesc(D3D12_RESOURCE_DIMENSION_TEXTURE2D, DXGI_FORMAT_R8G8B8A8_UNORM, 4, 4, 64, 0) << 3u;
+    QTest::newRow("volume") << resourceDesc(D3D12_RESOURCE_DIMENSION_TEXTURE3D, DXGI_FORMAT_R8G8B8A8_UNORM, 4, 4, 64, 0) << 7u;
+    QTest::newRow("1d") << resourceDesc(D3D12_RESOURCE_DIMENSION_TEXTURE1D, DXGI_FORMAT_R8G8B8A8_UNORM, 1000, 1, 1, 0) << 10u;
+}
+
+void tst_QD3D12FormatInfo::mipLevelCount()
+{
+    QFETCH(D3D12_RESOURCE_DESC, desc);
+    QFETCH(UINT, levels);
+
+    QCOMPARE(QD3D12FormatInfo::mipLevelCount(desc), levels);
+}
+
+void tst_QD3D12FormatInfo::copyableFootprints_data()
+{
+    QTest::addColumn<D3D12_RESOURCE_DESC>("desc");
+    QTest::addColumn<UINT>("firstSubresource");
+    QTest::addColumn<UINT64>("baseOffset");
+    QTest::addColumn<FootprintList>("expected");
+    QTest::addColumn<UINT64>("totalBytes");
+
+    {
+        static const Footprint expected[] = {
+            { 0, DXGI_FORMAT_R8G8B8A8_UNORM, 300, 200, 1, 1280, 200, 1200 },
+            { 256000, DXGI_FORMAT_R8G8B8A8_UNORM, 150, 100, 1, 768, 100, 600 },
+            { 332800, DXGI_FORMAT_R8G8B8A8_UNORM, 75, 50, 1, 512, 50, 300 },
+            { 358400, DXGI_FORMAT_R8G8B8A8_UNORM, 37, 25, 1, 256, 25, 148 },
+            { 365056, DXGI_FORMAT_R8G8B8A8_UNORM, 18, 12, 1, 256, 12, 72 },
+            { 368128, DXGI_FORMAT_R8G8B8A8_UNORM, 9, 6, 1, 256, 6, 36 },
+            { 369664, DXGI_FORMAT_R8G8B8A8_UNORM, 4, 3, 1, 256, 3, 16 },
+            { 370688, DXGI_FORMAT_R8G8B8A8_UNORM, 2, 1, 1, 256, 1, 8 },
+            { 371200, DXGI_FORMAT_R8G8B8A8_UNORM, 1, 1, 1, 256, 1, 4 },
+        };
+        QTest::newRow("rgba8NpotFullChain") << resourceDesc(D3D12_RESOURCE_DIMENSION_TEXTURE2D, DXGI_FORMAT_R8G8B8A8_UNORM, 300, 200, 1, 0)
+            << 0u << 0ull << footprints(expected) << 371204ull;
+    }
+    {
+        static const Footprint expected[] = {
+            { 0, DXGI_FORMAT_R8G8B8A8_UNORM, 37, 19, 1, 256, 19, 148 },
+            { 5120, DXGI_FORMAT_R8G8B8A8_UNORM, 18, 9, 1, 256, 9, 72 },
+            { 7680, DXGI_FORMAT_R8G8B8A8_UNORM, 9, 4, 1, 256, 4, 36 },
+            { 8704, DXGI_FORMAT_R8G8B8A8_UNORM, 37, 19, 1, 256, 19, 148 },
+            { 13824, DXGI_FORMAT_R8G8B8A8_UNORM, 18, 9, 1, 256, 9, 72 },
+            { 16384, DXGI_FORMAT_R8G8B8A8_UNORM, 9, 4, 1, 256, 4, 36 },
+        };
+        QTest::newRow("rgba8NpotArray") << resourceDesc(D3D12_RESOURCE_DIMENSION_TEXTURE2D, DXGI_FORMAT_R8G8B8A8_UNORM, 37, 19, 2, 3)
+            << 0u << 0ull << footprints(expected) << 17188ull;
+    }
+    {
+        static const Footprint expected[] = {
+            { 1024, DXGI_FORMAT_R8G8B8A8_UNORM, 75, 50, 1, 512, 50, 300 },
+            { 26624, DXGI_FORMAT_R8G8B8A8_UNORM, 37, 25, 1, 256, 25, 148 },
+            { 33280, DXGI_FORMAT_R8G8B8A8_UNORM, 18, 12, 1, 256, 12, 72 },
+        };
+        QTest::newRow("rgba8Range") << resourceDesc(D3D12_RESOURCE_DIMENSION_TEXTURE2D, DXGI_FORMAT_R8G8B8A8_UNORM, 300, 200, 1, 0)
+            << 2u << 1024ull << footprints(expected) << 35144ull;
+    }
+    {
+        static const Footprint expected[] = {
+            { 0, DXGI_FORMAT_BC1_UNORM, 12, 8, 1, 256, 2, 24 },
+            { 512, DXGI_FORMAT_BC1_UNORM, 8, 4, 1, 256, 1, 16 },
+            { 1024, DXGI_FORMAT_BC1_UNORM, 4, 4, 1, 256, 1, 8 },
+        };
+        QTest::newRow("bc1Unaligned") << resourceDesc(D3D12_RESOURCE_DIMENSION_TEXTURE2D, DXGI_FORMAT_BC1_UNORM, 10, 6, 1, 3)
+            << 0u << 0ull << footprints(expected) << 1032ull;
+    }
+    {
+        static const Footprint expected[] = {
+            { 0, DXGI_FORMAT_BC7_UNORM, 16, 8, 1, 256, 2, 64 },
+            { 512, DXGI_FORMAT_BC7_UNORM, 8, 4, 1, 256, 1, 32 },
+            { 1024, DXGI_FORMAT_BC7_UNORM, 4, 4, 1, 256, 1, 16 },
+            { 1536, DXGI_FORMAT_BC7_UNORM, 4, 4, 1, 256, 1, 16 },
+            { 2048, DXGI_FORMAT_BC7_UNORM, 16, 8, 1, 256, 2, 64 },
+            { 2560, DXGI_FORMAT_BC7_UNORM, 8, 4, 1, 256, 1, 32 },
+            { 3072, DXGI_FORMAT_BC7_UNORM, 4, 4, 1, 256, 1, 16 },
+            { 3584, DXGI_FORMAT_BC7_UNORM, 4, 4, 1, 256, 1, 16 },
+        };
+        QTest::newRow("bc7Unaligned") << resourceDesc(D3D12_RESOURCE_DIMENSION_TEXTURE2D, DXGI_FORMAT_BC7_UNORM, 13, 7, 2, 0)
+            << 0u << 0ull << footprints(expected) << 3600ull;
+    }
+    {
+        static const Footprint expected[] = {
+            { 0, DXGI_FORMAT_R1_UNORM, 16, 3, 1, 256, 3, 2 },
+        };
+        QTest::newRow("r1") << resourceDesc(D3D12_RESOURCE_DIMENSION_TEXTURE2D, DXGI_FORMAT_R1_UNORM, 13, 3, 1, 1)
+            << 0u << 0ull << footprints(expected) << 514ull;
+    }
+    {
+        static const Footprint expected[] = {
+            { 0, DXGI_FORMAT_YUY2, 8, 4, 1, 256, 4, 16 },
+        };
+        QTest::newRow("yuy2") << resourceDesc(D3D12_RESOURCE_DIMENSION_TEXTURE2D, DXGI_FORMAT_YUY2, 7, 4, 1, 1)
+            << 0u << 0ull << footprints(expected) << 784ull;
+    }
+    {
+        static const Footprint expected[] = {
+            { 0, DXGI_FORMAT_R32_TYPELESS, 17, 9, 1, 256, 9, 68 },
+            { 2560, DXGI_FORMAT_R32_TYPELESS, 8, 4, 1, 256, 4, 32 },
+            { 3584, DXGI_FORMAT_R8_TYPELESS, 17, 9, 1, 256, 9, 17 },
+            { 6144, DXGI_FORMAT_R8_TYPELESS, 8, 4, 1, 256, 4, 8 },
+        };
+        QTest::newRow("d24s8") << resourceDesc(D3D12_RESOURCE_DIMENSION_TEXTURE2D, DXGI_FORMAT_D24_UNORM_S8_UINT, 17, 9, 1, 2)
+            << 0u << 0ull << footprints(expected) << 6920ull;
+    }
+    {
+        static const Footprint expected[] = {
+            { 0, DXGI_FORMAT_R32_TYPELESS, 17, 9, 1, 256, 9, 68 },
+            { 2560, DXGI_FORMAT_R8_TYPELESS, 17, 9, 1, 256, 9, 17 },
+        };
+        QTest::newRow("d32s8") << resourceDesc(D3D12_RESOURCE_DIMENSION_TEXTURE2D, DXGI_FORMAT_D32_FLOAT_S8X24_UINT, 17, 9, 1, 1)
+            << 0u << 0ull << footprints(expected) << 4625ull;
+    }
+    {
+        static const Footprint expected[] = {
+            { 0, DXGI_FORMAT_R8_TYPELESS, 64, 36, 1, 256, 36, 64 },
+            { 9216, DXGI_FORMAT_R8G8_TYPELESS, 32, 18, 1, 256, 18, 64 },
+        };
+        QTest::newRow("nv12") << resourceDesc(D3D12_RESOURCE_DIMENSION_TEXTURE2D, DXGI_FORMAT_NV12, 64, 36, 1, 1)
+            << 0u << 0ull << footprints(expected) << 13632ull;
+    }
+    {
+        static const Footprint expected[] = {
+            { 0, DXGI_FORMAT_R16_UNORM, 9, 5, 3, 256, 5, 18 },
+            { 4096, DXGI_FORMAT_R16_UNORM, 4, 2, 1, 256, 2, 8 },
+            { 4608, DXGI_FORMAT_R16_UNORM, 2, 1, 1, 256, 1, 4 },
+            { 5120, DXGI_FORMAT_R16_UNORM, 1, 1, 1, 256, 1, 2 },
+        };
+        QTest::newRow("r16Volume") << resourceDesc(D3D12_RESOURCE_DIMENSION_TEXTURE3D, DXGI_FORMAT_R16_UNORM, 9, 5, 3, 0)
+            << 0u << 0ull << footprints(expected) << 5122ull;
+    }
+}
+
+void tst_QD3D12FormatInfo::copyableFootprints()
+{
+    QFETCH(D3D12_RESOURCE_DESC, desc);
+    QFETCH(UINT, firstSubresource);
+    QFETCH(UINT64, baseOffset);
+    QFETCH(FootprintList, expected);
+    QFETCH(UINT64, totalBytes);
+
+    const UINT count = UINT(expected.count());
+    QVector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> layouts(count);
+    QVector<UINT> numRows(count);
+    QVector<UINT64> rowSizes(count);
+    UINT64 total = 0;
+    QVERIFY(QD3D12FormatInfo::copyableFootprints(desc, firstSubresource, count, baseOffset, layouts.data(),
+                                                 numRows.data(), rowSizes.data(), &total));
+
+    for (UINT i = 0; i < count; ++i) {
+        const Footprint &e(expected.at(i));
+        QCOMPARE(layouts[i].Offset, e.offset);
+        QCOMPARE(layouts[i].Footprint.Format, e.format);
+        QCOMPARE(layouts[i].Footprint.Width, e.width);
+        QCOMPARE(layouts[i].Footprint.Height, e.height);
+        QCOMPARE(layouts[i].Footprint.Depth, e.depth);
+        QCOMPARE(layouts[i].Footprint.RowPitch, e.rowPitch);
+        QCOMPARE(numRows[i], e.numRows);
+        QCOMPARE(rowSizes[i], e.rowSize);
+    }
+    QCOMPARE(total, totalBytes);
+
+#ifdef Q_OS_WIN
+    if (!device)
+        return;
+
+    QVector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> deviceLayouts(count);
+    QVector<UINT> deviceNumRows(count);
+    QVector<UINT64> deviceRowSizes(count);
+    UINT64 deviceTotal = 0;
+    device->GetCopyableFootprints(&desc, firstSubresource, count, baseOffset, deviceLayouts.data(),
+                                  deviceNumRows.data(), deviceRowSizes.data(), &deviceTotal);
+    // The runtime reports UINT64_MAX for formats this device cannot create.
+    if (deviceTotal == UINT64(-1))
+        QSKIP("Format not supported by the device");
+
+    for (UINT i = 0; i < count; ++i) {
+        QCOMPARE(layouts[i].Offset, deviceLayouts[i].Offset);
+        QCOMPARE(layouts[i].Footprint.Format, deviceLayouts[i].Footprint.Format);
+        QCOMPARE(layouts[i].Footprint.Width, deviceLayouts[i].Footprint.Width);
+        QCOMPARE(layouts[i].Footprint.Height, deviceLayouts[i].Footprint.Height);
+        QCOMPARE(layouts[i].Footprint.Depth, deviceLayouts[i].Footprint.Depth);
+        QCOMPARE(layouts[i].Footprint.RowPitch, deviceLayouts[i].Footprint.RowPitch);
+        QCOMPARE(numRows[i], deviceNumRows[i]);
+        QCOMPARE(rowSizes[i], deviceRowSizes[i]);
+    }
+    QCOMPARE(total, deviceTotal);
+#endif
+}
+
+void tst_QD3D12FormatInfo::outOfRange()
+{
+    D3D12_PLACED_SUBRESOURCE_FOOTPRINT layout;
+
+    // 9 levels, one past the end of the full chain.
+    const D3D12_RESOURCE_DESC fullChain = resourceDesc(D3D12_RESOURCE_DIMENSION_TEXTURE2D,
+                                                       DXGI_FORMAT_R8G8B8A8_UNORM, 300, 200, 1, 0);
+    QVERIFY(QD3D12FormatInfo::copyableFootprints(fullChain, 8, 1, 0, &layout));
+    QVERIFY(!QD3D12FormatInfo::copyableFootprints(fullChain, 9, 1, 0, &layout));
+
+    // Two planes, one level.
+    const D3D12_RESOURCE_DESC depthStencil = resourceDesc(D3D12_RESOURCE_DIMENSION_TEXTURE2D,
+                                                          DXGI_FORMAT_D24_UNORM_S8_UINT, 16, 16, 1, 1);
+    QVERIFY(QD3D12FormatInfo::copyableFootprints(depthStencil, 1, 1, 0, &layout));
+    QVERIFY(!QD3D12FormatInfo::copyableFootprints(depthStencil, 2, 1, 0, &layout));
+
+    const D3D12_RESOURCE_DESC unknown = resourceDesc(D3D12_RESOURCE_DIMENSION_TEXTURE2D,
+                                                     DXGI_FORMAT_UNKNOWN, 16, 16, 1, 1);
+    QVERIFY(!QD3D12FormatInfo::copyableFootprints(unknown, 0, 1, 0, &layout));
+}
+
+QTEST_MAIN(tst_QD3D12FormatInfo)
+
+#include "tst_qd3d12formatinfo.moc"
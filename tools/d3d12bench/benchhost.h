@@ -0,0 +1,183 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtD3D12Window module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef BENCHHOST_H
+#define BENCHHOST_H
+
+#include "benchscene.h"
+#include "benchreport.h"
+#include <QD3D12OffscreenRenderer>
+#include <QElapsedTimer>
+#include <QEventLoop>
+
+// A window schedules its next frame itself, offscreen frames are driven by
+// the caller's renderFrame() loop.
+inline void requestNextFrame(QD3D12Window *window) { window->update(); }
+inline void requestNextFrame(QD3D12OffscreenRenderer *) { }
+
+// Runs a BenchScene in either a QD3D12Window or a QD3D12OffscreenRenderer
+// and records the per-frame timings into a BenchResult.
+template <class Base>
+class BenchHost : public Base, public BenchTarget
+{
+public:
+    BenchHost(BenchScene *scene, int warmupFrames, int frames, BenchResult *result)
+        : m_scene(scene),
+          m_warmupFrames(warmupFrames),
+          m_frames(frames),
+          m_frameCount(0),
+          m_frameStart(0),
+          m_lastPresent(-1),
+          m_failed(false),
+          m_result(result),
+          m_loop(Q_NULLPTR)
+    {
+        Base::setExtraRenderTargetCount(scene->extraRenderTargetCount());
+        Base::setGpuProfilingEnabled(true);
+        QD3D12GpuProfiler *profiler = Base::gpuProfiler();
+        QObject::connect(profiler, &QD3D12GpuProfiler::timingsReady, [this, profiler]() {
+            if (profiler->timingsFrame() >= quint64(m_warmupFrames) && m_result->gpuMs.count() < m_frames)
+                m_result->gpuMs.append(profiler->milliseconds("frame"));
+        });
+        m_clock.start();
+    }
+
+    // Quits the loop once all frames are done, for the windowed case.
+    void setEventLoop(QEventLoop *loop) { m_loop = loop; }
+    bool isFinished() const { return m_failed || m_frameCount >= m_warmupFrames + m_frames; }
+
+    void initializeD3D() Q_DECL_OVERRIDE
+    {
+        QElapsedTimer t;
+        t.start();
+        m_result->ok = m_scene->initialize(this);
+        m_result->initMs = t.nsecsElapsed() / 1000000.0;
+        if (!m_result->ok)
+            finish(true);
+    }
+
+    void releaseD3D() Q_DECL_OVERRIDE
+    {
+        m_scene->release();
+    }
+
+    void resizeD3D(const QSize &size) Q_DECL_OVERRIDE
+    {
+        if (!isFinished())
+            m_scene->resize(size);
+    }
+
+    void paintD3D() Q_DECL_OVERRIDE
+    {
+        if (isFinished())
+            return;
+        m_frameStart = m_clock.nsecsElapsed();
+        m_scene->render();
+        if (m_frameCount >= m_warmupFrames)
+            m_result->cpuMs.append((m_clock.nsecsElapsed() - m_frameStart) / 1000000.0);
+    }
+
+    void afterPresent() Q_DECL_OVERRIDE
+    {
+        if (isFinished())
+            return;
+        m_scene->afterPresent();
+
+        const qint64 now = m_clock.nsecsElapsed();
+        if (m_frameCount >= m_warmupFrames) {
+            m_result->frameMs.append((now - m_frameStart) / 1000000.0);
+            if (m_lastPresent >= 0)
+                m_result->intervalMs.append((now - m_lastPresent) / 1000000.0);
+        }
+        m_lastPresent = now;
+
+        if (++m_frameCount >= m_warmupFrames + m_frames)
+            finish(false);
+        else
+            requestNextFrame(this);
+    }
+
+    ID3D12Device *device() const Q_DECL_OVERRIDE { return Base::device(); }
+    ID3D12CommandQueue *commandQueue() const Q_DECL_OVERRIDE { return Base::commandQueue(); }
+    ID3D12CommandAllocator *commandAllocator() const Q_DECL_OVERRIDE { return Base::commandAllocator(); }
+    QD3D12GpuProfiler *gpuProfiler() const Q_DECL_OVERRIDE { return Base::gpuProfiler(); }
+    QSize size() const Q_DECL_OVERRIDE { return Base::size(); }
+    BenchTarget::Fence *createFence() const Q_DECL_OVERRIDE { return Base::createFence(); }
+    void waitForGPU(BenchTarget::Fence *f) const Q_DECL_OVERRIDE { Base::waitForGPU(f); }
+    ID3D12Resource *backBufferRenderTarget() const Q_DECL_OVERRIDE { return Base::backBufferRenderTarget(); }
+    D3D12_CPU_DESCRIPTOR_HANDLE backBufferRenderTargetCPUHandle() const Q_DECL_OVERRIDE { return Base::backBufferRenderTargetCPUHandle(); }
+    D3D12_CPU_DESCRIPTOR_HANDLE depthStencilCPUHandle() const Q_DECL_OVERRIDE { return Base::depthStencilCPUHandle(); }
+    D3D12_CPU_DESCRIPTOR_HANDLE extraRenderTargetCPUHandle(int idx) const Q_DECL_OVERRIDE { return Base::extraRenderTargetCPUHandle(idx); }
+    D3D12_CPU_DESCRIPTOR_HANDLE extraDepthStencilCPUHandle(int idx) const Q_DECL_OVERRIDE { return Base::extraDepthStencilCPUHandle(idx); }
+    ID3D12Resource *createExtraRenderTargetAndView(D3D12_CPU_DESCRIPTOR_HANDLE viewHandle, const QSize &size,
+                                                   const float *clearColor, int samples) Q_DECL_OVERRIDE
+    {
+        return Base::createExtraRenderTargetAndView(viewHandle, size, clearColor, samples);
+    }
+    ID3D12Resource *createExtraDepthStencilAndView(D3D12_CPU_DESCRIPTOR_HANDLE viewHandle, const QSize &size,
+                                                   int samples) Q_DECL_OVERRIDE
+    {
+        return Base::createExtraDepthStencilAndView(viewHandle, size, samples);
+    }
+
+private:
+    void finish(bool failed)
+    {
+        m_failed = failed;
+        if (!failed) {
+            m_frameCount = m_warmupFrames + m_frames;
+            // The GPU timings of the last few frames are still in flight.
+            Base::gpuProfiler()->flush();
+        }
+        collectMemoryStatistics(Base::device(), m_result);
+        m_result->size = Base::size();
+        if (m_loop)
+            m_loop->quit();
+    }
+
+    BenchScene *m_scene;
+    int m_warmupFrames;
+    int m_frames;
+    int m_frameCount;
+    qint64 m_frameStart;
+    qint64 m_lastPresent;
+    bool m_failed;
+    BenchResult *m_result;
+    QEventLoop *m_loop;
+    QElapsedTimer m_clock;
+};
+
+#endif
@@ -0,0 +1,214 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtD3D12Window module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "benchreport.h"
+#include <QFile>
+#include <QTextStream>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QtMath>
+#include <algorithm>
+#include <dxgi1_4.h>
+#include <psapi.h>
+#include <wrl/client.h>
+
+using namespace Microsoft::WRL;
+
+struct Statistics
+{
+    Statistics() : count(0), mean(0), p50(0), p95(0), p99(0), max(0) { }
+    int count;
+    double mean;
+    double p50;
+    double p95;
+    double p99;
+    double max;
+};
+
+static Statistics statistics(QVector<double> samples)
+{
+    Statistics s;
+    s.count = samples.count();
+    if (!s.count)
+        return s;
+
+    std::sort(samples.begin(), samples.end());
+    double sum = 0;
+    foreach (double v, samples)
+        sum += v;
+    s.mean = sum / s.count;
+    // nearest-rank percentiles
+    s.p50 = samples[qMax(0, qCeil(0.50 * s.count) - 1)];
+    s.p95 = samples[qMax(0, qCeil(0.95 * s.count) - 1)];
+    s.p99 = samples[qMax(0, qCeil(0.99 * s.count) - 1)];
+    s.max = samples.last();
+    return s;
+}
+
+void collectMemoryStatistics(ID3D12Device *device, BenchResult *result)
+{
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+        result->peakWorkingSet = pmc.PeakWorkingSetSize;
+
+    if (!device)
+        return;
+
+    ComPtr<IDXGIFactory4> factory;
+    ComPtr<IDXGIAdapter3> adapter;
+    if (FAILED(CreateDXGIFactory1(IID_PPV_ARGS(&factory)))
+            || FAILED(factory->EnumAdapterByLuid(device->GetAdapterLuid(), IID_PPV_ARGS(&adapter))))
+        return;
+
+    DXGI_ADAPTER_DESC1 desc;
+    if (SUCCEEDED(adapter->GetDesc1(&desc)))
+        result->adapter = QString::fromWCharArray(desc.Description);
+
+    DXGI_QUERY_VIDEO_MEMORY_INFO info;
+    if (SUCCEEDED(adapter->QueryVideoMemoryInfo(0, DXGI_MEMORY_SEGMENT_GROUP_LOCAL, &info)))
+        result->videoMemoryUsage = info.CurrentUsage;
+}
+
+static const char *metricNames[] = { "cpu", "frame", "gpu", "interval" };
+
+static inline const QVector<double> &metric(const BenchResult &r, int idx)
+{
+    switch (idx) {
+    case 0:
+        return r.cpuMs;
+    case 1:
+        return r.frameMs;
+    case 2:
+        return r.gpuMs;
+    default:
+        return r.intervalMs;
+    }
+}
+
+bool writeCsv(const QString &fileName, const QVector<BenchResult> &results)
+{
+    QFile f(fileName);
+    if (!f.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        qWarning("Failed to open %s", qPrintable(fileName));
+        return false;
+    }
+
+    QTextStream out(&f);
+    out << "scene,mode,adapter,width,height,ok,init_ms";
+    for (int m = 0; m < 4; ++m) {
+        const QString n = QLatin1String(metricNames[m]);
+        out << ',' << n << "_count," << n << "_mean_ms," << n << "_p50_ms," << n << "_p95_ms,"
+            << n << "_p99_ms," << n << "_max_ms";
+    }
+    out << ",peak_working_set_bytes,video_memory_usage_bytes\n";
+
+    foreach (const BenchResult &r, results) {
+        QString adapter = r.adapter;
+        adapter.replace(QLatin1Char('"'), QLatin1String("\"\""));
+        out << r.scene << ',' << r.mode << ",\"" << adapter << "\"," << r.size.width() << ',' << r.size.height()
+            << ',' << (r.ok ? 1 : 0) << ',' << r.initMs;
+        for (int m = 0; m < 4; ++m) {
+            const Statistics s = statistics(metric(r, m));
+            out << ',' << s.count << ',' << s.mean << ',' << s.p50 << ',' << s.p95 << ',' << s.p99 << ',' << s.max;
+        }
+        out << ',' << r.peakWorkingSet << ',' << r.videoMemoryUsage << '\n';
+    }
+
+    return true;
+}
+
+bool writeJson(const QString &fileName, const QVector<BenchResult> &results)
+{
+    QFile f(fileName);
+    if (!f.open(QIODevice::WriteOnly)) {
+        qWarning("Failed to open %s", qPrintable(fileName));
+        return false;
+    }
+
+    QJsonArray scenes;
+    foreach (const BenchResult &r, results) {
+        QJsonObject o;
+        o[QStringLiteral("scene")] = r.scene;
+        o[QStringLiteral("mode")] = r.mode;
+        o[QStringLiteral("adapter")] = r.adapter;
+        o[QStringLiteral("width")] = r.size.width();
+        o[QStringLiteral("height")] = r.size.height();
+        o[QStringLiteral("ok")] = r.ok;
+        o[QStringLiteral("initMs")] = r.initMs;
+        o[QStringLiteral("peakWorkingSetBytes")] = double(r.peakWorkingSet);
+        o[QStringLiteral("videoMemoryUsageBytes")] = double(r.videoMemoryUsage);
+        for (int m = 0; m < 4; ++m) {
+            const QVector<double> &samples(metric(r, m));
+            const Statistics s = statistics(samples);
+            QJsonObject stats;
+            stats[QStringLiteral("count")] = s.count;
+            stats[QStringLiteral("meanMs")] = s.mean;
+            stats[QStringLiteral("p50Ms")] = s.p50;
+            stats[QStringLiteral("p95Ms")] = s.p95;
+            stats[QStringLiteral("p99Ms")] = s.p99;
+            stats[QStringLiteral("maxMs")] = s.max;
+            QJsonArray values;
+            foreach (double v, samples)
+                values.append(v);
+            stats[QStringLiteral("samples")] = values;
+            o[QLatin1String(metricNames[m])] = stats;
+        }
+        scenes.append(o);
+    }
+
+    QJsonObject root;
+    root[QStringLiteral("scenes")] = scenes;
+    f.write(QJsonDocument(root).toJson());
+    return true;
+}
+
+void printSummary(const QVector<BenchResult> &results)
+{
+    foreach (const BenchResult &r, results) {
+        if (!r.ok) {
+            qDebug("%-18s %-9s FAILED", qPrintable(r.scene), qPrintable(r.mode));
+            continue;
+        }
+        const Statistics cpu = statistics(r.cpuMs);
+        const Statistics gpu = statistics(r.gpuMs);
+        const Statistics interval = statistics(r.intervalMs);
+        qDebug("%-18s %-9s init %7.2f ms | cpu p50 %6.3f p99 %6.3f | gpu p50 %6.3f p99 %6.3f | interval p50 %6.3f p99 %6.3f ms | %llu MB",
+               qPrintable(r.scene), qPrintable(r.mode), r.initMs,
+               cpu.p50, cpu.p99, gpu.p50, gpu.p99, interval.p50, interval.p99,
+               r.peakWorkingSet / (1024 * 1024));
+    }
+}
@@ -0,0 +1,69 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtD3D12Window module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef BENCHREPORT_H
+#define BENCHREPORT_H
+
+#include <QString>
+#include <QSize>
+#include <QVector>
+#include <d3d12.h>
+
+struct BenchResult
+{
+    BenchResult() : ok(false), initMs(0), peakWorkingSet(0), videoMemoryUsage(0) { }
+
+    QString scene;
+    QString mode;
+    QString adapter;
+    QSize size;
+    bool ok;
+    double initMs;
+    QVector<double> cpuMs;      // paintD3D(), i.e. recording and submitting
+    QVector<double> frameMs;    // paintD3D() up to the end of afterPresent()
+    QVector<double> gpuMs;      // GPU time of the frame, from the timestamp queries
+    QVector<double> intervalMs; // between two consecutive afterPresent() calls
+    quint64 peakWorkingSet;
+    quint64 videoMemoryUsage;
+};
+
+void collectMemoryStatistics(ID3D12Device *device, BenchResult *result);
+
+bool writeCsv(const QString &fileName, const QVector<BenchResult> &results);
+bool writeJson(const QString &fileName, const QVector<BenchResult> &results);
+void printSummary(const QVector<BenchResult> &results);
+
+#endif
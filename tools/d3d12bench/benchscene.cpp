@@ -0,0 +1,912 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtD3D12Window module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "benchscene.h"
+#include "bench_simple_vs.h"
+#include "bench_simple_ps.h"
+#include "bench_texture_vs.h"
+#include "bench_texture_ps.h"
+#include <QD3D12DdsTexture>
+#include <QD3D12GpuMipmapGenerator>
+#include <QImage>
+
+static const float clearColor[] = { 0.0f, 0.2f, 0.4f, 1.0f };
+
+static const D3D12_INPUT_ELEMENT_DESC colorInputElements[] = {
+    { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+    { "COLOR", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 }
+};
+
+static const D3D12_INPUT_ELEMENT_DESC texturedInputElements[] = {
+    { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+    { "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 }
+};
+
+static const float triangleVertices[] = {
+    0.0f, 0.707f, 0.0f, /* color */ 1.0f, 0.0f, 0.0f, 1.0f,
+    -0.5f, -0.5f, 0.0f,             0.0f, 1.0f, 0.0f, 1.0f,
+    0.5f, -0.5f, 0.0f,              0.0f, 0.0f, 1.0f, 1.0f
+};
+
+static const float quadVertices[] = {
+    -0.5f, -0.5f, 0, /* coords */ 0, 1,
+    0.5f, -0.5f, 0,               1, 1,
+    -0.5f, 0.5f, 0,               0, 0,
+
+    -0.5f, 0.5f, 0,               0, 0,
+    0.5f, -0.5f, 0,               1, 1,
+    0.5f, 0.5f, 0,                1, 0
+};
+
+static inline D3D12_VERTEX_BUFFER_VIEW vertexBufferView(ID3D12Resource *buf, quint32 stride, quint32 size)
+{
+    D3D12_VERTEX_BUFFER_VIEW view;
+    view.BufferLocation = buf->GetGPUVirtualAddress();
+    view.StrideInBytes = stride;
+    view.SizeInBytes = size;
+    return view;
+}
+
+static inline quint32 alignedCBSize(quint32 size)
+{
+    return (size + D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT - 1) & ~(D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT - 1);
+}
+
+static void transitionResource(ID3D12Resource *resource, ID3D12GraphicsCommandList *commandList,
+                               D3D12_RESOURCE_STATES before, D3D12_RESOURCE_STATES after)
+{
+    D3D12_RESOURCE_BARRIER barrier;
+    barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+    barrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+    barrier.Transition.pResource = resource;
+    barrier.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+    barrier.Transition.StateBefore = before;
+    barrier.Transition.StateAfter = after;
+    commandList->ResourceBarrier(1, &barrier);
+}
+
+static void uavBarrier(ID3D12Resource *resource, ID3D12GraphicsCommandList *commandList)
+{
+    D3D12_RESOURCE_BARRIER barrier;
+    barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
+    barrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+    barrier.UAV.pResource = resource;
+    commandList->ResourceBarrier(1, &barrier);
+}
+
+BenchScene::BenchScene()
+    : target(Q_NULLPTR),
+      f(Q_NULLPTR),
+      cbPtr(Q_NULLPTR),
+      rotationAngle(0)
+{
+}
+
+BenchScene::~BenchScene()
+{
+    release();
+}
+
+// Creates the common resources, then lets the scene record its one-time
+// setup (uploads etc.) into the command list and waits for it to finish.
+bool BenchScene::initialize(BenchTarget *t)
+{
+    target = t;
+    f = target->createFence();
+    ID3D12Device *dev = target->device();
+
+    if (FAILED(dev->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, target->commandAllocator(), Q_NULLPTR,
+                                      IID_PPV_ARGS(&commandList)))) {
+        qWarning("Failed to create command list");
+        return false;
+    }
+
+    constantBuffer = createUploadBuffer(alignedCBSize(128)); // 2 * float4x4
+    if (!constantBuffer)
+        return false;
+    D3D12_RANGE readRange = { 0, 0 };
+    if (FAILED(constantBuffer->Map(0, &readRange, reinterpret_cast<void **>(&cbPtr)))) {
+        qWarning("Map failed (constant buffer)");
+        return false;
+    }
+
+    resize(target->size());
+
+    const bool ok = initializeScene();
+
+    commandList->Close();
+    ID3D12CommandList *commandLists[] = { commandList.Get() };
+    target->commandQueue()->ExecuteCommandLists(_countof(commandLists), commandLists);
+    target->waitForGPU(f);
+    initResources.clear();
+
+    return ok;
+}
+
+void BenchScene::resize(const QSize &size)
+{
+    projection.setToIdentity();
+    projection.perspective(60.0f, size.width() / float(size.height()), 0.1f, 100.0f);
+}
+
+void BenchScene::render()
+{
+    writeConstants(cbPtr, projection);
+    rotationAngle += 1;
+
+    target->commandAllocator()->Reset();
+    commandList->Reset(target->commandAllocator(), Q_NULLPTR);
+    {
+        QD3D12GpuScope scope(target->gpuProfiler(), commandList.Get(), "frame");
+        renderScene();
+    }
+    commandList->Close();
+
+    ID3D12CommandList *commandLists[] = { commandList.Get() };
+    target->commandQueue()->ExecuteCommandLists(_countof(commandLists), commandLists);
+}
+
+// Like the examples, do not let the CPU get ahead of the GPU.
+void BenchScene::afterPresent()
+{
+    target->waitForGPU(f);
+}
+
+void BenchScene::release()
+{
+    if (!target)
+        return;
+
+    releaseScene();
+
+    if (cbPtr) {
+        constantBuffer->Unmap(0, Q_NULLPTR);
+        cbPtr = Q_NULLPTR;
+    }
+    constantBuffer = Q_NULLPTR;
+    commandList = Q_NULLPTR;
+    initResources.clear();
+    delete f;
+    f = Q_NULLPTR;
+    target = Q_NULLPTR;
+}
+
+ComPtr<ID3D12RootSignature> BenchScene::createRootSignature(const D3D12_ROOT_SIGNATURE_DESC &desc)
+{
+    ComPtr<ID3D12RootSignature> rootSignature;
+    ComPtr<ID3DBlob> signature;
+    ComPtr<ID3DBlob> error;
+    if (FAILED(D3D12SerializeRootSignature(&desc, D3D_ROOT_SIGNATURE_VERSION_1, &signature, &error))) {
+        QByteArray msg(static_cast<const char *>(error->GetBufferPointer()), int(error->GetBufferSize()));
+        qWarning("Failed to serialize root signature: %s", msg.constData());
+        return rootSignature;
+    }
+    if (FAILED(target->device()->CreateRootSignature(0, signature->GetBufferPointer(), signature->GetBufferSize(),
+                                                     IID_PPV_ARGS(&rootSignature))))
+        qWarning("Failed to create root signature");
+
+    return rootSignature;
+}
+
+// b0 as a root CBV, as in hellotriangle and hellomultisample.
+ComPtr<ID3D12RootSignature> BenchScene::createCbvRootSignature()
+{
+    D3D12_ROOT_PARAMETER rootParameter;
+    rootParameter.ParameterType = D3D12_ROOT_PARAMETER_TYPE_CBV;
+    rootParameter.ShaderVisibility = D3D12_SHADER_VISIBILITY_VERTEX;
+    rootParameter.Descriptor.ShaderRegister = 0; // b0
+    rootParameter.Descriptor.RegisterSpace = 0;
+
+    D3D12_ROOT_SIGNATURE_DESC desc = {};
+    desc.NumParameters = 1;
+    desc.pParameters = &rootParameter;
+    desc.Flags = D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT;
+
+    return createRootSignature(desc);
+}
+
+// A descriptor table with b0 and t0 plus a static sampler, as in hellotexture.
+ComPtr<ID3D12RootSignature> BenchScene::createCbvSrvRootSignature(D3D12_FILTER filter)
+{
+    D3D12_STATIC_SAMPLER_DESC sampler = {};
+    sampler.Filter = filter;
+    sampler.AddressU = D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
+    sampler.AddressV = D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
+    sampler.AddressW = D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
+    sampler.MaxLOD = D3D12_FLOAT32_MAX;
+    sampler.ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL;
+
+    D3D12_DESCRIPTOR_RANGE descRange[2];
+    descRange[0].RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_CBV;
+    descRange[0].NumDescriptors = 1;
+    descRange[0].BaseShaderRegister = 0; // b0
+    descRange[0].RegisterSpace = 0;
+    descRange[0].OffsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND;
+    descRange[1].RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_SRV;
+    descRange[1].NumDescriptors = 1;
+    descRange[1].BaseShaderRegister = 0; // t0
+    descRange[1].RegisterSpace = 0;
+    descRange[1].OffsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND;
+
+    D3D12_ROOT_PARAMETER rootParameter;
+    rootParameter.ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
+    rootParameter.ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+    rootParameter.DescriptorTable.NumDescriptorRanges = 2;
+    rootParameter.DescriptorTable.pDescriptorRanges = descRange;
+
+    D3D12_ROOT_SIGNATURE_DESC desc = {};
+    desc.NumParameters = 1;
+    desc.pParameters = &rootParameter;
+    desc.NumStaticSamplers = 1;
+    desc.pStaticSamplers = &sampler;
+    desc.Flags = D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT;
+
+    return createRootSignature(desc);
+}
+
+ComPtr<ID3D12PipelineState> BenchScene::createPipelineState(ID3D12RootSignature *rootSignature,
+                                                            const D3D12_INPUT_ELEMENT_DESC *inputElements, int inputElementCount,
+                                                            const void *vs, size_t vsSize, const void *ps, size_t psSize,
+                                                            bool blend, int samples)
+{
+    D3D12_RASTERIZER_DESC rastDesc = {};
+    rastDesc.FillMode = D3D12_FILL_MODE_SOLID;
+    rastDesc.CullMode = D3D12_CULL_MODE_BACK;
+    rastDesc.FrontCounterClockwise = TRUE; // Vertices are given CCW
+    rastDesc.DepthBias = D3D12_DEFAULT_DEPTH_BIAS;
+    rastDesc.DepthBiasClamp = D3D12_DEFAULT_DEPTH_BIAS_CLAMP;
+    rastDesc.SlopeScaledDepthBias = D3D12_DEFAULT_SLOPE_SCALED_DEPTH_BIAS;
+    rastDesc.DepthClipEnable = TRUE;
+    rastDesc.MultisampleEnable = samples > 1;
+
+    D3D12_BLEND_DESC blendDesc = {};
+    blendDesc.RenderTarget[0].RenderTargetWriteMask = D3D12_COLOR_WRITE_ENABLE_ALL;
+    if (blend) {
+        blendDesc.RenderTarget[0].BlendEnable = TRUE;
+        blendDesc.RenderTarget[0].SrcBlend = D3D12_BLEND_SRC_ALPHA;
+        blendDesc.RenderTarget[0].DestBlend = D3D12_BLEND_INV_SRC_ALPHA;
+        blendDesc.RenderTarget[0].BlendOp = D3D12_BLEND_OP_ADD;
+        blendDesc.RenderTarget[0].SrcBlendAlpha = D3D12_BLEND_ZERO;
+        blendDesc.RenderTarget[0].DestBlendAlpha = D3D12_BLEND_ZERO;
+        blendDesc.RenderTarget[0].BlendOpAlpha = D3D12_BLEND_OP_ADD;
+    }
+
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC psoDesc = {};
+    psoDesc.InputLayout = { inputElements, UINT(inputElementCount) };
+    psoDesc.pRootSignature = rootSignature;
+    psoDesc.VS.pShaderBytecode = vs;
+    psoDesc.VS.BytecodeLength = vsSize;
+    psoDesc.PS.pShaderBytecode = ps;
+    psoDesc.PS.BytecodeLength = psSize;
+    psoDesc.RasterizerState = rastDesc;
+    psoDesc.BlendState = blendDesc;
+    psoDesc.DepthStencilState.DepthEnable = TRUE;
+    psoDesc.DepthStencilState.DepthWriteMask = D3D12_DEPTH_WRITE_MASK_ALL;
+    psoDesc.DepthStencilState.DepthFunc = D3D12_COMPARISON_FUNC_LESS;
+    psoDesc.SampleMask = UINT_MAX;
+    psoDesc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+    psoDesc.NumRenderTargets = 1;
+    psoDesc.RTVFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM;
+    psoDesc.DSVFormat = DXGI_FORMAT_D32_FLOAT;
+    psoDesc.SampleDesc.Count = samples;
+
+    ComPtr<ID3D12PipelineState> pipelineState;
+    if (FAILED(target->device()->CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(&pipelineState))))
+        qWarning("Failed to create graphics pipeline state");
+
+    return pipelineState;
+}
+
+ComPtr<ID3D12Resource> BenchScene::createUploadBuffer(quint32 size, const void *data)
+{
+    D3D12_HEAP_PROPERTIES heapProp = {};
+    heapProp.Type = D3D12_HEAP_TYPE_UPLOAD;
+
+    D3D12_RESOURCE_DESC bufDesc = {};
+    bufDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+    bufDesc.Width = size;
+    bufDesc.Height = 1;
+    bufDesc.DepthOrArraySize = 1;
+    bufDesc.MipLevels = 1;
+    bufDesc.Format = DXGI_FORMAT_UNKNOWN;
+    bufDesc.SampleDesc.Count = 1;
+    bufDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+
+    ComPtr<ID3D12Resource> buf;
+    if (FAILED(target->device()->CreateCommittedResource(&heapProp, D3D12_HEAP_FLAG_NONE, &bufDesc,
+                                                         D3D12_RESOURCE_STATE_GENERIC_READ, Q_NULLPTR, IID_PPV_ARGS(&buf)))) {
+        qWarning("Failed to create committed resource (buffer)");
+        return buf;
+    }
+
+    if (data) {
+        quint8 *p = Q_NULLPTR;
+        D3D12_RANGE readRange = { 0, 0 };
+        if (FAILED(buf->Map(0, &readRange, reinterpret_cast<void **>(&p)))) {
+            qWarning("Map failed (buffer)");
+            return ComPtr<ID3D12Resource>();
+        }
+        memcpy(p, data, size);
+        buf->Unmap(0, Q_NULLPTR);
+    }
+
+    return buf;
+}
+
+// Records the upload of the first uploadedLevels levels into the command
+// list. The texture is left in COPY_DEST state.
+ComPtr<ID3D12Resource> BenchScene::createTexture(const QImage &image, int mipLevels, int uploadedLevels,
+                                                 D3D12_RESOURCE_FLAGS flags)
+{
+    ID3D12Device *dev = target->device();
+
+    D3D12_HEAP_PROPERTIES defaultHeapProp = {};
+    defaultHeapProp.Type = D3D12_HEAP_TYPE_DEFAULT;
+
+    D3D12_RESOURCE_DESC textureDesc = {};
+    textureDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+    textureDesc.Width = image.width();
+    textureDesc.Height = image.height();
+    textureDesc.DepthOrArraySize = 1;
+    textureDesc.MipLevels = mipLevels;
+    textureDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    textureDesc.SampleDesc.Count = 1;
+    textureDesc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
+    textureDesc.Flags = flags;
+
+    ComPtr<ID3D12Resource> texture;
+    if (FAILED(dev->CreateCommittedResource(&defaultHeapProp, D3D12_HEAP_FLAG_NONE, &textureDesc,
+                                            D3D12_RESOURCE_STATE_COPY_DEST, Q_NULLPTR, IID_PPV_ARGS(&texture)))) {
+        qWarning("Failed to create texture resource");
+        return texture;
+    }
+
+    QVector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> layout(uploadedLevels);
+    UINT64 uploadSize;
+    dev->GetCopyableFootprints(&textureDesc, 0, uploadedLevels, 0, layout.data(), Q_NULLPTR, Q_NULLPTR, &uploadSize);
+
+    ComPtr<ID3D12Resource> uploadBuffer = createUploadBuffer(quint32(uploadSize));
+    if (!uploadBuffer)
+        return ComPtr<ID3D12Resource>();
+
+    quint8 *p = Q_NULLPTR;
+    D3D12_RANGE readRange = { 0, 0 };
+    if (FAILED(uploadBuffer->Map(0, &readRange, reinterpret_cast<void **>(&p)))) {
+        qWarning("Map failed (texture upload buffer)");
+        return ComPtr<ID3D12Resource>();
+    }
+    for (int level = 0; level < uploadedLevels; ++level) {
+        const int w = layout[level].Footprint.Width;
+        const int h = layout[level].Footprint.Height;
+        const QImage img = level ? image.scaled(w, h) : image;
+        quint8 *mipP = p + layout[level].Offset;
+        for (int y = 0; y < h; ++y) {
+            memcpy(mipP, img.constScanLine(y), w * 4);
+            mipP += layout[level].Footprint.RowPitch;
+        }
+    }
+    uploadBuffer->Unmap(0, Q_NULLPTR);
+
+    for (int level = 0; level < uploadedLevels; ++level) {
+        D3D12_TEXTURE_COPY_LOCATION dstLoc;
+        dstLoc.pResource = texture.Get();
+        dstLoc.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+        dstLoc.SubresourceIndex = level;
+        D3D12_TEXTURE_COPY_LOCATION srcLoc;
+        srcLoc.pResource = uploadBuffer.Get();
+        srcLoc.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
+        srcLoc.PlacedFootprint = layout[level];
+        commandList->CopyTextureRegion(&dstLoc, 0, 0, 0, &srcLoc, Q_NULLPTR);
+    }
+
+    initResources.append(uploadBuffer);
+    return texture;
+}
+
+ComPtr<ID3D12DescriptorHeap> BenchScene::createShaderVisibleHeap(int descriptorCount)
+{
+    D3D12_DESCRIPTOR_HEAP_DESC heapDesc = {};
+    heapDesc.NumDescriptors = descriptorCount;
+    heapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
+    heapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+
+    ComPtr<ID3D12DescriptorHeap> heap;
+    if (FAILED(target->device()->CreateDescriptorHeap(&heapDesc, IID_PPV_ARGS(&heap))))
+        qWarning("Failed to create CBV/SRV/UAV descriptor heap");
+
+    return heap;
+}
+
+void BenchScene::writeConstants(quint8 *p, const QMatrix4x4 &proj) const
+{
+    QMatrix4x4 modelview;
+    modelview.translate(0, 0, -2);
+    modelview.rotate(rotationAngle, 0, 0, 1);
+
+    memcpy(p, modelview.constData(), 16 * sizeof(float));
+    memcpy(p + 16 * sizeof(float), proj.constData(), 16 * sizeof(float));
+}
+
+void BenchScene::setViewport(const QSize &viewportSize)
+{
+    D3D12_VIEWPORT viewport = { 0, 0, float(viewportSize.width()), float(viewportSize.height()), 0, 1 };
+    commandList->RSSetViewports(1, &viewport);
+    D3D12_RECT scissorRect = { 0, 0, viewportSize.width() - 1, viewportSize.height() - 1 };
+    commandList->RSSetScissorRects(1, &scissorRect);
+}
+
+void BenchScene::beginBackBufferPass(const float *color)
+{
+    setViewport(target->size());
+
+    transitionResource(target->backBufferRenderTarget(), commandList.Get(),
+                       D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET);
+
+    D3D12_CPU_DESCRIPTOR_HANDLE rtvHandle = target->backBufferRenderTargetCPUHandle();
+    D3D12_CPU_DESCRIPTOR_HANDLE dsvHandle = target->depthStencilCPUHandle();
+    commandList->OMSetRenderTargets(1, &rtvHandle, FALSE, &dsvHandle);
+
+    commandList->ClearRenderTargetView(rtvHandle, color, 0, Q_NULLPTR);
+    commandList->ClearDepthStencilView(dsvHandle, D3D12_CLEAR_FLAG_DEPTH, 1.0f, 0, 0, Q_NULLPTR);
+}
+
+void BenchScene::endBackBufferPass()
+{
+    transitionResource(target->backBufferRenderTarget(), commandList.Get(),
+                       D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT);
+}
+
+// hellowindow: a clear and nothing else.
+class ClearScene : public BenchScene
+{
+protected:
+    bool initializeScene() Q_DECL_OVERRIDE { return true; }
+    void renderScene() Q_DECL_OVERRIDE
+    {
+        const float green = (int(rotationAngle) % 100) / 100.0f;
+        const float color[] = { 0.0f, green, 0.0f, 1.0f };
+        transitionResource(target->backBufferRenderTarget(), commandList.Get(),
+                           D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET);
+        commandList->ClearRenderTargetView(target->backBufferRenderTargetCPUHandle(), color, 0, Q_NULLPTR);
+        endBackBufferPass();
+    }
+};
+
+// hellotriangle: one draw call with a root CBV.
+class TriangleScene : public BenchScene
+{
+protected:
+    bool initializeScene() Q_DECL_OVERRIDE
+    {
+        rootSignature = createCbvRootSignature();
+        if (!rootSignature)
+            return false;
+        pipelineState = createPipelineState(rootSignature.Get(), colorInputElements, _countof(colorInputElements),
+                                            g_VS_Simple, sizeof(g_VS_Simple), g_PS_Simple, sizeof(g_PS_Simple));
+        vertexBuffer = createUploadBuffer(sizeof(triangleVertices), triangleVertices);
+        if (!pipelineState || !vertexBuffer)
+            return false;
+        vbView = vertexBufferView(vertexBuffer.Get(), (3 + 4) * sizeof(float), sizeof(triangleVertices));
+        return true;
+    }
+
+    void renderScene() Q_DECL_OVERRIDE
+    {
+        commandList->SetPipelineState(pipelineState.Get());
+        commandList->SetGraphicsRootSignature(rootSignature.Get());
+        commandList->SetGraphicsRootConstantBufferView(0, constantBuffer->GetGPUVirtualAddress());
+        beginBackBufferPass(clearColor);
+        commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+        commandList->IASetVertexBuffers(0, 1, &vbView);
+        commandList->DrawInstanced(3, 1, 0, 0);
+        endBackBufferPass();
+    }
+
+    ComPtr<ID3D12RootSignature> rootSignature;
+    ComPtr<ID3D12PipelineState> pipelineState;
+    ComPtr<ID3D12Resource> vertexBuffer;
+    D3D12_VERTEX_BUFFER_VIEW vbView;
+};
+
+// hellotexture: a blended, textured quad sampling a 512x512 mipmapped texture.
+class TextureScene : public BenchScene
+{
+protected:
+    enum { TextureSize = 512, TextureMipLevels = 8 };
+
+    bool initializeScene() Q_DECL_OVERRIDE
+    {
+        QImage image = QImage(QStringLiteral(":/qt.png")).convertToFormat(QImage::Format_RGBA8888)
+                .scaled(TextureSize, TextureSize);
+        if (image.isNull()) {
+            qWarning("Failed to load image data");
+            return false;
+        }
+
+        rootSignature = createCbvSrvRootSignature(D3D12_FILTER_MIN_MAG_MIP_LINEAR);
+        if (!rootSignature)
+            return false;
+        pipelineState = createPipelineState(rootSignature.Get(), texturedInputElements, _countof(texturedInputElements),
+                                            g_VS_Texture, sizeof(g_VS_Texture), g_PS_Texture, sizeof(g_PS_Texture),
+                                            true);
+        vertexBuffer = createUploadBuffer(sizeof(quadVertices), quadVertices);
+        texture = createTextureAndViews(image);
+        if (!pipelineState || !vertexBuffer || !texture)
+            return false;
+        vbView = vertexBufferView(vertexBuffer.Get(), (3 + 2) * sizeof(float), sizeof(quadVertices));
+        return true;
+    }
+
+    virtual ComPtr<ID3D12Resource> createTextureAndViews(const QImage &image)
+    {
+        ComPtr<ID3D12Resource> t = createTexture(image, TextureMipLevels, TextureMipLevels, D3D12_RESOURCE_FLAG_NONE);
+        heap = createShaderVisibleHeap(2);
+        if (!t || !heap)
+            return ComPtr<ID3D12Resource>();
+        transitionResource(t.Get(), commandList.Get(), D3D12_RESOURCE_STATE_COPY_DEST,
+                           D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+        createCbvSrv(t.Get(), TextureMipLevels);
+        return t;
+    }
+
+    void createCbvSrv(ID3D12Resource *t, int mipLevels)
+    {
+        D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+        srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+        srvDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+        srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+        srvDesc.Texture2D.MipLevels = mipLevels;
+        createCbvSrv(t, srvDesc);
+    }
+
+    void createCbvSrv(ID3D12Resource *t, const D3D12_SHADER_RESOURCE_VIEW_DESC &srvDesc)
+    {
+        ID3D12Device *dev = target->device();
+        D3D12_CPU_DESCRIPTOR_HANDLE h = heap->GetCPUDescriptorHandleForHeapStart();
+
+        D3D12_CONSTANT_BUFFER_VIEW_DESC cbvDesc = {};
+        cbvDesc.BufferLocation = constantBuffer->GetGPUVirtualAddress();
+        cbvDesc.SizeInBytes = alignedCBSize(128);
+        dev->CreateConstantBufferView(&cbvDesc, h);
+        h.ptr += dev->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+        dev->CreateShaderResourceView(t, &srvDesc, h);
+    }
+
+    void renderScene() Q_DECL_OVERRIDE
+    {
+        drawQuad();
+    }
+
+    void drawQuad()
+    {
+        commandList->SetPipelineState(pipelineState.Get());
+        commandList->SetGraphicsRootSignature(rootSignature.Get());
+        ID3D12DescriptorHeap *heaps[] = { heap.Get() };
+        commandList->SetDescriptorHeaps(_countof(heaps), heaps);
+        commandList->SetGraphicsRootDescriptorTable(0, heap->GetGPUDescriptorHandleForHeapStart());
+        beginBackBufferPass(clearColor);
+        commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+        commandList->IASetVertexBuffers(0, 1, &vbView);
+        commandList->DrawInstanced(6, 1, 0, 0);
+        endBackBufferPass();
+    }
+
+    ComPtr<ID3D12RootSignature> rootSignature;
+    ComPtr<ID3D12PipelineState> pipelineState;
+    ComPtr<ID3D12Resource> vertexBuffer;
+    ComPtr<ID3D12Resource> texture;
+    ComPtr<ID3D12DescriptorHeap> heap;
+    D3D12_VERTEX_BUFFER_VIEW vbView;
+};
+
+// hellocompressedtexture: the textured quad with the block compressed mip
+// chain from qt.dds instead of the PNG.
+class CompressedTextureScene : public TextureScene
+{
+protected:
+    ComPtr<ID3D12Resource> createTextureAndViews(const QImage &) Q_DECL_OVERRIDE
+    {
+        ID3D12Device *dev = target->device();
+
+        QD3D12DdsTexture dds;
+        if (!dds.load(QStringLiteral(":/qt.dds")))
+            return ComPtr<ID3D12Resource>();
+
+        D3D12_HEAP_PROPERTIES defaultHeapProp = {};
+        defaultHeapProp.Type = D3D12_HEAP_TYPE_DEFAULT;
+        const D3D12_RESOURCE_DESC textureDesc = dds.resourceDesc();
+        ComPtr<ID3D12Resource> t;
+        if (FAILED(dev->CreateCommittedResource(&defaultHeapProp, D3D12_HEAP_FLAG_NONE, &textureDesc,
+                                                D3D12_RESOURCE_STATE_COPY_DEST, Q_NULLPTR, IID_PPV_ARGS(&t)))) {
+            qWarning("Failed to create texture resource");
+            return t;
+        }
+
+        quint64 uploadSize = 0;
+        const QVector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> layout = dds.footprints(dev, &uploadSize);
+        ComPtr<ID3D12Resource> uploadBuffer = createUploadBuffer(quint32(uploadSize));
+        heap = createShaderVisibleHeap(2);
+        if (!uploadBuffer || !heap)
+            return ComPtr<ID3D12Resource>();
+
+        quint8 *p = Q_NULLPTR;
+        D3D12_RANGE readRange = { 0, 0 };
+        if (FAILED(uploadBuffer->Map(0, &readRange, reinterpret_cast<void **>(&p)))) {
+            qWarning("Map failed (texture upload buffer)");
+            return ComPtr<ID3D12Resource>();
+        }
+        dds.writeSubresources(p, layout);
+        uploadBuffer->Unmap(0, Q_NULLPTR);
+
+        for (int i = 0; i < layout.count(); ++i) {
+            D3D12_TEXTURE_COPY_LOCATION dstLoc;
+            dstLoc.pResource = t.Get();
+            dstLoc.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+            dstLoc.SubresourceIndex = i;
+            D3D12_TEXTURE_COPY_LOCATION srcLoc;
+            srcLoc.pResource = uploadBuffer.Get();
+            srcLoc.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
+            srcLoc.PlacedFootprint = layout[i];
+            commandList->CopyTextureRegion(&dstLoc, 0, 0, 0, &srcLoc, Q_NULLPTR);
+        }
+        initResources.append(uploadBuffer);
+
+        transitionResource(t.Get(), commandList.Get(), D3D12_RESOURCE_STATE_COPY_DEST,
+                           D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+        createCbvSrv(t.Get(), dds.shaderResourceViewDesc());
+        return t;
+    }
+};
+
+// hellooffscreen: a triangle rendered into a 512x512 render target which is
+// then sampled when drawing onto the back buffer.
+class OffscreenScene : public TextureScene
+{
+public:
+    OffscreenScene() : offscreenCbPtr(Q_NULLPTR) { }
+    int extraRenderTargetCount() const Q_DECL_OVERRIDE { return 1; }
+
+protected:
+    enum { OffscreenSize = 512 };
+
+    bool initializeScene() Q_DECL_OVERRIDE
+    {
+        const QSize sz(OffscreenSize, OffscreenSize);
+        rt.Attach(target->createExtraRenderTargetAndView(target->extraRenderTargetCPUHandle(0), sz, clearColor, 0));
+        ds.Attach(target->createExtraDepthStencilAndView(target->extraDepthStencilCPUHandle(0), sz, 0));
+
+        offscreenRootSignature = createCbvRootSignature();
+        if (!rt || !ds || !offscreenRootSignature)
+            return false;
+        offscreenPipelineState = createPipelineState(offscreenRootSignature.Get(), colorInputElements, _countof(colorInputElements),
+                                                     g_VS_Simple, sizeof(g_VS_Simple), g_PS_Simple, sizeof(g_PS_Simple));
+        triangleBuffer = createUploadBuffer(sizeof(triangleVertices), triangleVertices);
+        offscreenConstantBuffer = createUploadBuffer(alignedCBSize(128));
+        if (!offscreenPipelineState || !triangleBuffer || !offscreenConstantBuffer)
+            return false;
+        triangleView = vertexBufferView(triangleBuffer.Get(), (3 + 4) * sizeof(float), sizeof(triangleVertices));
+
+        D3D12_RANGE readRange = { 0, 0 };
+        if (FAILED(offscreenConstantBuffer->Map(0, &readRange, reinterpret_cast<void **>(&offscreenCbPtr)))) {
+            qWarning("Map failed (constant buffer)");
+            return false;
+        }
+        offscreenProjection.perspective(60.0f, 1.0f, 0.1f, 100.0f);
+
+        rootSignature = createCbvSrvRootSignature(D3D12_FILTER_MIN_MAG_MIP_POINT);
+        if (!rootSignature)
+            return false;
+        pipelineState = createPipelineState(rootSignature.Get(), texturedInputElements, _countof(texturedInputElements),
+                                            g_VS_Texture, sizeof(g_VS_Texture), g_PS_Texture, sizeof(g_PS_Texture));
+        vertexBuffer = createUploadBuffer(sizeof(quadVertices), quadVertices);
+        heap = createShaderVisibleHeap(2);
+        if (!pipelineState || !vertexBuffer || !heap)
+            return false;
+        vbView = vertexBufferView(vertexBuffer.Get(), (3 + 2) * sizeof(float), sizeof(quadVertices));
+        createCbvSrv(rt.Get(), 1);
+        return true;
+    }
+
+    void renderScene() Q_DECL_OVERRIDE
+    {
+        writeConstants(offscreenCbPtr, offscreenProjection);
+
+        commandList->SetPipelineState(offscreenPipelineState.Get());
+        commandList->SetGraphicsRootSignature(offscreenRootSignature.Get());
+        commandList->SetGraphicsRootConstantBufferView(0, offscreenConstantBuffer->GetGPUVirtualAddress());
+        setViewport(QSize(OffscreenSize, OffscreenSize));
+
+        D3D12_CPU_DESCRIPTOR_HANDLE rtvHandle = target->extraRenderTargetCPUHandle(0);
+        D3D12_CPU_DESCRIPTOR_HANDLE dsvHandle = target->extraDepthStencilCPUHandle(0);
+        commandList->OMSetRenderTargets(1, &rtvHandle, FALSE, &dsvHandle);
+        commandList->ClearRenderTargetView(rtvHandle, clearColor, 0, Q_NULLPTR);
+        commandList->ClearDepthStencilView(dsvHandle, D3D12_CLEAR_FLAG_DEPTH, 1.0f, 0, 0, Q_NULLPTR);
+        commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+        commandList->IASetVertexBuffers(0, 1, &triangleView);
+        commandList->DrawInstanced(3, 1, 0, 0);
+
+        transitionResource(rt.Get(), commandList.Get(), D3D12_RESOURCE_STATE_RENDER_TARGET,
+                           D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+        drawQuad();
+        transitionResource(rt.Get(), commandList.Get(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
+                           D3D12_RESOURCE_STATE_RENDER_TARGET);
+    }
+
+    void releaseScene() Q_DECL_OVERRIDE
+    {
+        if (offscreenCbPtr) {
+            offscreenConstantBuffer->Unmap(0, Q_NULLPTR);
+            offscreenCbPtr = Q_NULLPTR;
+        }
+    }
+
+    ComPtr<ID3D12Resource> rt;
+    ComPtr<ID3D12Resource> ds;
+    ComPtr<ID3D12RootSignature> offscreenRootSignature;
+    ComPtr<ID3D12PipelineState> offscreenPipelineState;
+    ComPtr<ID3D12Resource> triangleBuffer;
+    ComPtr<ID3D12Resource> offscreenConstantBuffer;
+    quint8 *offscreenCbPtr;
+    D3D12_VERTEX_BUFFER_VIEW triangleView;
+    QMatrix4x4 offscreenProjection;
+};
+
+// hellomultisample: a triangle rendered with 4x MSAA, resolved into the back buffer.
+class MultisampleScene : public TriangleScene
+{
+public:
+    int extraRenderTargetCount() const Q_DECL_OVERRIDE { return 1; }
+
+    void resize(const QSize &size) Q_DECL_OVERRIDE
+    {
+        TriangleScene::resize(size);
+        msaaRT = Q_NULLPTR;
+        msaaDS = Q_NULLPTR;
+        msaaRT.Attach(target->createExtraRenderTargetAndView(target->extraRenderTargetCPUHandle(0), size, clearColor, Samples));
+        msaaDS.Attach(target->createExtraDepthStencilAndView(target->extraDepthStencilCPUHandle(0), size, Samples));
+    }
+
+protected:
+    enum { Samples = 4 };
+
+    bool initializeScene() Q_DECL_OVERRIDE
+    {
+        rootSignature = createCbvRootSignature();
+        if (!rootSignature || !msaaRT || !msaaDS)
+            return false;
+        pipelineState = createPipelineState(rootSignature.Get(), colorInputElements, _countof(colorInputElements),
+                                            g_VS_Simple, sizeof(g_VS_Simple), g_PS_Simple, sizeof(g_PS_Simple),
+                                            false, Samples);
+        vertexBuffer = createUploadBuffer(sizeof(triangleVertices), triangleVertices);
+        if (!pipelineState || !vertexBuffer)
+            return false;
+        vbView = vertexBufferView(vertexBuffer.Get(), (3 + 4) * sizeof(float), sizeof(triangleVertices));
+        return true;
+    }
+
+    void renderScene() Q_DECL_OVERRIDE
+    {
+        commandList->SetPipelineState(pipelineState.Get());
+        commandList->SetGraphicsRootSignature(rootSignature.Get());
+        commandList->SetGraphicsRootConstantBufferView(0, constantBuffer->GetGPUVirtualAddress());
+        setViewport(target->size());
+
+        D3D12_CPU_DESCRIPTOR_HANDLE rtvHandle = target->extraRenderTargetCPUHandle(0);
+        D3D12_CPU_DESCRIPTOR_HANDLE dsvHandle = target->extraDepthStencilCPUHandle(0);
+        commandList->OMSetRenderTargets(1, &rtvHandle, FALSE, &dsvHandle);
+        commandList->ClearRenderTargetView(rtvHandle, clearColor, 0, Q_NULLPTR);
+        commandList->ClearDepthStencilView(dsvHandle, D3D12_CLEAR_FLAG_DEPTH, 1.0f, 0, 0, Q_NULLPTR);
+        commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+        commandList->IASetVertexBuffers(0, 1, &vbView);
+        commandList->DrawInstanced(3, 1, 0, 0);
+
+        ID3D12Resource *backBuffer = target->backBufferRenderTarget();
+        transitionResource(msaaRT.Get(), commandList.Get(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_RESOLVE_SOURCE);
+        transitionResource(backBuffer, commandList.Get(), D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RESOLVE_DEST);
+        commandList->ResolveSubresource(backBuffer, 0, msaaRT.Get(), 0, DXGI_FORMAT_R8G8B8A8_UNORM);
+        transitionResource(backBuffer, commandList.Get(), D3D12_RESOURCE_STATE_RESOLVE_DEST, D3D12_RESOURCE_STATE_PRESENT);
+        transitionResource(msaaRT.Get(), commandList.Get(), D3D12_RESOURCE_STATE_RESOLVE_SOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET);
+    }
+
+    ComPtr<ID3D12Resource> msaaRT;
+    ComPtr<ID3D12Resource> msaaDS;
+};
+
+// hellogpumipmap: the compute shader mipmap generation of the example, run
+// every frame instead of once so that it shows up in the GPU timings.
+class GpuMipmapScene : public TextureScene
+{
+protected:
+    enum { MipLevels = 10 }; // for 512x512
+
+    ComPtr<ID3D12Resource> createTextureAndViews(const QImage &image) Q_DECL_OVERRIDE
+    {
+        ComPtr<ID3D12Resource> t = createTexture(image, MipLevels, 1, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+        heap = createShaderVisibleHeap(2);
+        if (!t || !heap || !mipmapGenerator.create(target->device()))
+            return ComPtr<ID3D12Resource>();
+
+        createCbvSrv(t.Get(), MipLevels);
+        transitionResource(t.Get(), commandList.Get(), D3D12_RESOURCE_STATE_COPY_DEST,
+                           D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+        return t;
+    }
+
+    void renderScene() Q_DECL_OVERRIDE
+    {
+        // The previous frame has finished, its descriptors can be reused.
+        mipmapGenerator.reset();
+        mipmapGenerator.generate(commandList.Get(), texture.Get());
+        drawQuad();
+    }
+
+    void releaseScene() Q_DECL_OVERRIDE
+    {
+        mipmapGenerator.destroy();
+    }
+
+    QD3D12GpuMipmapGenerator mipmapGenerator;
+};
+
+QStringList BenchScene::names()
+{
+    return QStringList() << QStringLiteral("hellowindow")
+                         << QStringLiteral("hellotriangle")
+                         << QStringLiteral("hellotexture")
+                         << QStringLiteral("hellocompressedtexture")
+                         << QStringLiteral("hellooffscreen")
+                         << QStringLiteral("hellomultisample")
+                         << QStringLiteral("hellogpumipmap");
+}
+
+BenchScene *BenchScene::create(const QString &name)
+{
+    if (name == QLatin1String("hellowindow"))
+        return new ClearScene;
+    if (name == QLatin1String("hellotriangle"))
+        return new TriangleScene;
+    if (name == QLatin1String("hellotexture"))
+        return new TextureScene;
+    if (name == QLatin1String("hellocompressedtexture"))
+        return new CompressedTextureScene;
+    if (name == QLatin1String("hellooffscreen"))
+        return new OffscreenScene;
+    if (name == QLatin1String("hellomultisample"))
+        return new MultisampleScene;
+    if (name == QLatin1String("hellogpumipmap"))
+        return new GpuMipmapScene;
+    return Q_NULLPTR;
+}
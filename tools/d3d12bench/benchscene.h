@@ -0,0 +1,125 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtD3D12Window module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef BENCHSCENE_H
+#define BENCHSCENE_H
+
+#include <QD3D12Window>
+#include <QD3D12GpuProfiler>
+#include <QMatrix4x4>
+#include <QStringList>
+#include <QVector>
+
+// What a scene needs from whatever it renders into. Implemented on top of
+// both QD3D12Window and QD3D12OffscreenRenderer, see BenchHost<>.
+class BenchTarget
+{
+public:
+    typedef QD3D12Window::Fence Fence;
+
+    virtual ~BenchTarget() { }
+
+    virtual ID3D12Device *device() const = 0;
+    virtual ID3D12CommandQueue *commandQueue() const = 0;
+    virtual ID3D12CommandAllocator *commandAllocator() const = 0;
+    virtual QD3D12GpuProfiler *gpuProfiler() const = 0;
+    virtual QSize size() const = 0;
+
+    virtual Fence *createFence() const = 0;
+    virtual void waitForGPU(Fence *f) const = 0;
+
+    virtual ID3D12Resource *backBufferRenderTarget() const = 0;
+    virtual D3D12_CPU_DESCRIPTOR_HANDLE backBufferRenderTargetCPUHandle() const = 0;
+    virtual D3D12_CPU_DESCRIPTOR_HANDLE depthStencilCPUHandle() const = 0;
+    virtual D3D12_CPU_DESCRIPTOR_HANDLE extraRenderTargetCPUHandle(int idx) const = 0;
+    virtual D3D12_CPU_DESCRIPTOR_HANDLE extraDepthStencilCPUHandle(int idx) const = 0;
+    virtual ID3D12Resource *createExtraRenderTargetAndView(D3D12_CPU_DESCRIPTOR_HANDLE viewHandle, const QSize &size,
+                                                           const float *clearColor, int samples) = 0;
+    virtual ID3D12Resource *createExtraDepthStencilAndView(D3D12_CPU_DESCRIPTOR_HANDLE viewHandle, const QSize &size,
+                                                           int samples) = 0;
+};
+
+// A benchmark scene reproduces the per-frame work of one of the examples.
+class BenchScene
+{
+public:
+    BenchScene();
+    virtual ~BenchScene();
+
+    static QStringList names();
+    static BenchScene *create(const QString &name);
+
+    virtual int extraRenderTargetCount() const { return 0; }
+
+    bool initialize(BenchTarget *target);
+    virtual void resize(const QSize &size);
+    void render();
+    void afterPresent();
+    void release();
+
+protected:
+    virtual bool initializeScene() = 0;
+    virtual void renderScene() = 0;
+    virtual void releaseScene() { }
+
+    ComPtr<ID3D12RootSignature> createRootSignature(const D3D12_ROOT_SIGNATURE_DESC &desc);
+    ComPtr<ID3D12RootSignature> createCbvRootSignature();
+    ComPtr<ID3D12RootSignature> createCbvSrvRootSignature(D3D12_FILTER filter);
+    ComPtr<ID3D12PipelineState> createPipelineState(ID3D12RootSignature *rootSignature,
+                                                    const D3D12_INPUT_ELEMENT_DESC *inputElements, int inputElementCount,
+                                                    const void *vs, size_t vsSize, const void *ps, size_t psSize,
+                                                    bool blend = false, int samples = 1);
+    ComPtr<ID3D12Resource> createUploadBuffer(quint32 size, const void *data = Q_NULLPTR);
+    ComPtr<ID3D12Resource> createTexture(const QImage &image, int mipLevels, int uploadedLevels,
+                                         D3D12_RESOURCE_FLAGS flags);
+    ComPtr<ID3D12DescriptorHeap> createShaderVisibleHeap(int descriptorCount);
+
+    void writeConstants(quint8 *p, const QMatrix4x4 &proj) const;
+    void setViewport(const QSize &viewportSize);
+    void beginBackBufferPass(const float *clearColor);
+    void endBackBufferPass();
+
+    BenchTarget *target;
+    BenchTarget::Fence *f;
+    ComPtr<ID3D12GraphicsCommandList> commandList;
+    ComPtr<ID3D12Resource> constantBuffer;
+    quint8 *cbPtr;
+    QVector<ComPtr<ID3D12Resource> > initResources; // kept alive until the initial upload has finished
+    QMatrix4x4 projection;
+    float rotationAngle;
+};
+
+#endif
@@ -0,0 +1,39 @@
+TEMPLATE = app
+QT += d3d12window
+
+SOURCES = main.cpp benchscene.cpp benchreport.cpp
+HEADERS = benchscene.h benchhost.h benchreport.h
+
+LIBS += -ld3d12 -ldxgi -lpsapi
+
+EXAMPLES = $$PWD/../../examples
+
+# The scenes share the shaders and the textures with the examples they reproduce.
+RESOURCES = $$EXAMPLES/hellotexture/hellotexture.qrc \
+            $$EXAMPLES/hellocompressedtexture/hellocompressedtexture.qrc
+
+SIMPLE = $$EXAMPLES/hellotriangle/shader.hlsl
+TEXTURE = $$EXAMPLES/hellotexture/shader.hlsl
+
+simple_vs.input = SIMPLE
+simple_vs.header = bench_simple_vs.h
+simple_vs.entry = VS_Simple
+simple_vs.type = vs_5_0
+
+simple_ps.input = SIMPLE
+simple_ps.header = bench_simple_ps.h
+simple_ps.entry = PS_Simple
+simple_ps.type = ps_5_0
+
+texture_vs.input = TEXTURE
+texture_vs.header = bench_texture_vs.h
+texture_vs.entry = VS_Texture
+texture_vs.type = vs_5_0
+
+texture_ps.input = TEXTURE
+texture_ps.header = bench_texture_ps.h
+texture_ps.entry = PS_Texture
+texture_ps.type = ps_5_0
+
+HLSL_SHADERS = simple_vs simple_ps texture_vs texture_ps
+load(hlsl)
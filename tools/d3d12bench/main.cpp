@@ -0,0 +1,181 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtD3D12Window module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QGuiApplication>
+#include <QCommandLineParser>
+#include <QTimer>
+#include <QScopedPointer>
+#include <QD3D12OffscreenRenderer>
+#include "benchhost.h"
+
+// Runs the scenes reproducing the examples for a fixed number of frames,
+// either in a window (vsync'ed presents) or headless via
+// QD3D12OffscreenRenderer, and reports CPU/GPU frame times, present
+// intervals and memory usage as CSV and/or JSON.
+
+static BenchResult runHeadless(const QString &name, const QSize &size, int warmup, int frames, bool software)
+{
+    BenchResult result;
+    result.scene = name;
+    result.mode = QStringLiteral("headless");
+
+    QScopedPointer<BenchScene> scene(BenchScene::create(name));
+    BenchHost<QD3D12OffscreenRenderer> host(scene.data(), warmup, frames, &result);
+    host.setSize(size);
+    host.setSoftwareRendering(software);
+    if (!host.create())
+        return result;
+
+    while (!host.isFinished()) {
+        if (!host.renderFrame()) {
+            result.ok = false;
+            break;
+        }
+    }
+
+    scene->release();
+    return result;
+}
+
+static BenchResult runWindowed(const QString &name, const QSize &size, int warmup, int frames, bool software,
+                               int timeoutMs)
+{
+    BenchResult result;
+    result.scene = name;
+    result.mode = QStringLiteral("window");
+
+    QScopedPointer<BenchScene> scene(BenchScene::create(name));
+    BenchHost<QD3D12Window> host(scene.data(), warmup, frames, &result);
+    QEventLoop loop;
+    host.setEventLoop(&loop);
+    if (software)
+        host.setAdapterPreference(QD3D12Adapter::Software);
+    host.resize(size);
+    host.show();
+
+    QTimer::singleShot(timeoutMs, &loop, &QEventLoop::quit);
+    loop.exec();
+
+    if (!host.isFinished()) {
+        qWarning("%s: timed out", qPrintable(name));
+        result.ok = false;
+    }
+
+    scene->release();
+    host.hide();
+    return result;
+}
+
+int main(int argc, char **argv)
+{
+    QGuiApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Runs the example scenes for a number of frames and reports timings."));
+    parser.addHelpOption();
+    QCommandLineOption framesOption(QStringLiteral("frames"), QStringLiteral("Number of measured frames per scene."),
+                                    QStringLiteral("count"), QStringLiteral("1000"));
+    parser.addOption(framesOption);
+    QCommandLineOption warmupOption(QStringLiteral("warmup"), QStringLiteral("Number of frames to skip before measuring."),
+                                    QStringLiteral("count"), QStringLiteral("60"));
+    parser.addOption(warmupOption);
+    QCommandLineOption sizeOption(QStringLiteral("size"), QStringLiteral("Render target size."),
+                                  QStringLiteral("WxH"), QStringLiteral("1280x720"));
+    parser.addOption(sizeOption);
+    QCommandLineOption sceneOption(QStringLiteral("scene"), QStringLiteral("Scene to run, can be given multiple times. Default: all."),
+                                   QStringLiteral("name"));
+    parser.addOption(sceneOption);
+    QCommandLineOption headlessOption(QStringLiteral("headless"), QStringLiteral("Render offscreen without a window."));
+    parser.addOption(headlessOption);
+    QCommandLineOption softwareOption(QStringLiteral("software"), QStringLiteral("Use the WARP software adapter."));
+    parser.addOption(softwareOption);
+    QCommandLineOption timeoutOption(QStringLiteral("timeout"), QStringLiteral("Give up on a windowed scene after this many seconds."),
+                                     QStringLiteral("seconds"), QStringLiteral("120"));
+    parser.addOption(timeoutOption);
+    QCommandLineOption csvOption(QStringLiteral("csv"), QStringLiteral("Write the results as CSV."), QStringLiteral("file"));
+    parser.addOption(csvOption);
+    QCommandLineOption jsonOption(QStringLiteral("json"), QStringLiteral("Write the results, including all samples, as JSON."),
+                                  QStringLiteral("file"));
+    parser.addOption(jsonOption);
+    QCommandLineOption listOption(QStringLiteral("list"), QStringLiteral("List the available scenes."));
+    parser.addOption(listOption);
+    parser.process(app);
+
+    if (parser.isSet(listOption)) {
+        foreach (const QString &name, BenchScene::names())
+            qDebug("%s", qPrintable(name));
+        return 0;
+    }
+
+    const int frames = qMax(1, parser.value(framesOption).toInt());
+    const int warmup = qMax(0, parser.value(warmupOption).toInt());
+    const int timeoutMs = qMax(1, parser.value(timeoutOption).toInt()) * 1000;
+    const bool headless = parser.isSet(headlessOption);
+    const bool software = parser.isSet(softwareOption);
+
+    QSize size(1280, 720);
+    const QStringList sz = parser.value(sizeOption).split(QLatin1Char('x'));
+    if (sz.count() == 2 && sz[0].toInt() > 0 && sz[1].toInt() > 0)
+        size = QSize(sz[0].toInt(), sz[1].toInt());
+    else
+        qWarning("Invalid size, using %dx%d", size.width(), size.height());
+
+    QStringList scenes = parser.values(sceneOption);
+    if (scenes.isEmpty())
+        scenes = BenchScene::names();
+
+    QVector<BenchResult> results;
+    foreach (const QString &name, scenes) {
+        if (!BenchScene::names().contains(name)) {
+            qWarning("Unknown scene %s", qPrintable(name));
+            continue;
+        }
+        results.append(headless ? runHeadless(name, size, warmup, frames, software)
+                                : runWindowed(name, size, warmup, frames, software, timeoutMs));
+    }
+
+    printSummary(results);
+
+    bool ok = true;
+    if (parser.isSet(csvOption))
+        ok &= writeCsv(parser.value(csvOption), results);
+    if (parser.isSet(jsonOption))
+        ok &= writeJson(parser.value(jsonOption), results);
+    foreach (const BenchResult &r, results)
+        ok &= r.ok;
+
+    return ok ? 0 : 1;
+}